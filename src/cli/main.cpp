@@ -31,6 +31,18 @@ void create_parser(QCommandLineParser &p) {
     // p.addOptions({}); available only from Qt 5.4+
     p.addOption({ "asm", "Treat provided file argument as assembler source." });
     p.addOption({ "pipelined", "Configure CPU to use five stage pipeline." });
+    p.addOption(
+        { "threaded-core",
+          "Use fast non-pipelined core executing translated basic blocks. Tracing reflects only "
+          "instructions executed outside of translated blocks." });
+    p.addOption(
+        { "headless",
+          "Run without per-event visualization signals. State is reported only at exit. Cannot "
+          "be combined with instruction tracing." });
+    p.addOption(
+        { "flat-ram",
+          "Store RAM in one contiguous lazily committed host allocation instead of sparse "
+          "sections." });
     p.addOption({ "no-delay-slot", "Disable jump delay slot." });
     p.addOption(
         { "hazard-unit", "Specify hazard unit implementation [none|stall|forward].", "HUKIND" });
@@ -70,6 +82,11 @@ void create_parser(QCommandLineParser &p) {
     p.addOption({ "dump-branch-predictor", "Dump branch predictor statistics at program exit." });
     p.addOption({ "dump-all", "Dump all available information at program exit." });
     p.addOption({ "load-range", "Load memory range.", "START,FNAME" });
+    p.addOption(
+        { "map-file",
+          "Map host file to physical address space without copying it. Range is read-only "
+          "unless rw is given, writes are then private and discarded on restart.",
+          "START,FNAME[,rw]" });
     p.addOption({ "expect-fail", "Expect that program causes CPU trap and fail if it doesn't." });
     p.addOption(
         { "fail-match",
@@ -81,20 +98,61 @@ void create_parser(QCommandLineParser &p) {
     p.addOption(
         { "d-cache",
           "Data cache. Format policy,sets,words_in_blocks,associativity[,writeback] where "
-          "policy is random/lru/lfu "
+          "policy is random/lru/lfu/plru/nmru/srrip/brrip/drrip/ship "
           "and writeback is optional wb/wt/wtna/wta",
           "DCACHE" });
     p.addOption(
         { "i-cache",
           "Instruction cache. Format policy,sets,words_in_blocks,associativity "
-          "where policy is random/lru/lfu",
+          "where policy is random/lru/lfu/plru/nmru/srrip/brrip/drrip/ship",
           "ICACHE" });
     p.addOption(
         { "l2-cache",
-          "L2 cache. Format policy,sets,words_in_blocks,associativity[,writeback] where "
-          "policy is random/lru/lfu "
-          "and writeback is optional wb/wt/wtna/wta",
+          "L2 cache. Format policy,sets,words_in_blocks,associativity[,writeback[,inclusion]] "
+          "where policy is random/lru/lfu/plru/nmru/srrip/brrip/drrip/ship, "
+          "writeback is optional wb/wt/wtna/wta and inclusion is optional "
+          "nine/inclusive/exclusive",
           "L2CACHE" });
+    p.addOption(
+        { "cache-level",
+          "Shared cache of any level, can be given repeatedly. Format level:cache where level is "
+          "2 or more and cache is formatted as l2-cache. Hierarchy extends to the highest "
+          "level given.",
+          "LEVEL:CACHE" });
+    p.addOption(
+        { "d-cache-prefetch",
+          "Data cache prefetcher. Format type[,degree] where type is "
+          "none/next-line/stride/stream and degree is number of blocks prefetched ahead "
+          "(depth of stream buffers)",
+          "PREFETCH" });
+    p.addOption(
+        { "i-cache-prefetch", "Instruction cache prefetcher. Format as d-cache-prefetch.",
+          "PREFETCH" });
+    p.addOption(
+        { "l2-cache-prefetch", "L2 cache prefetcher. Format as d-cache-prefetch.", "PREFETCH" });
+    p.addOption(
+        { "d-cache-buffers",
+          "Data cache victim cache and write buffer. Format victim[,write] where victim is "
+          "number of blocks of the victim cache and write is number of entries of the "
+          "coalescing write buffer (write through only), 0 for none.",
+          "BUFFERS" });
+    p.addOption(
+        { "i-cache-buffers", "Instruction cache victim cache. Format as d-cache-buffers.",
+          "BUFFERS" });
+    p.addOption(
+        { "l2-cache-buffers", "L2 cache victim cache and write buffer. Format as d-cache-buffers.",
+          "BUFFERS" });
+    p.addOption(
+        { "d-cache-sweep",
+          "Evaluate data cache configuration on accesses of this run, can be given repeatedly. "
+          "All configurations are evaluated in one pass at program exit. Format as d-cache.",
+          "DCACHE" });
+    p.addOption(
+        { "i-cache-sweep",
+          "Evaluate instruction cache configuration on accesses of this run, can be given "
+          "repeatedly. All configurations are evaluated in one pass at program exit. Format as "
+          "i-cache.",
+          "ICACHE" });
     p.addOption(
         { "branch-predictor",
           "Branch predictor. Format type,init_state,btb,bhr,bht\n"
@@ -109,6 +167,21 @@ void create_parser(QCommandLineParser &p) {
     p.addOption({ "write-time", "Memory read access time (cycles).", "WTIME" });
     p.addOption({ "burst-time", "Memory read access time (cycles).", "BTIME" });
     p.addOption({ "l2-time", "L2 cache access time (cycles).", "L2TIME" });
+    p.addOption(
+        { "cache-level-time",
+          "Shared cache access time (cycles), can be given repeatedly. Format level:cycles.",
+          "LEVEL:TIME" });
+    p.addOption(
+        { "memory-timing",
+          "Pipelined CPU stalls IF and MEM stages for memory access times, otherwise they only "
+          "affect cache statistics. Requires --pipelined." });
+    p.addOption(
+        { "dram",
+          "Banked DRAM timing model replaces memory access times. Format "
+          "channels,banks,row_bytes,page[,tRCD,tCAS,tRP[,queue]] where page is open/closed, "
+          "timings are in cycles and queue is number of posted writes. Only writes are queued "
+          "and scheduled FR-FCFS, reads are served at once.",
+          "DRAM" });
     p.addOption({ { "serial-in", "serin" }, "File connected to the serial port input.", "FNAME" });
     p.addOption(
         { { "serial-out", "serout" }, "File connected to the serial port output.", "FNAME" });
@@ -127,10 +200,9 @@ void create_parser(QCommandLineParser &p) {
     p.addOption({ "enable-interrupt", "Enable interrupts delivery to the run code." });
 }
 
-void configure_cache(CacheConfig &cacheconf, const QStringList &cachearg, const QString &which) {
-    if (cachearg.empty()) { return; }
+void parse_cache(CacheConfig &cacheconf, const QString &cachearg, const QString &which) {
     cacheconf.set_enabled(true);
-    QStringList pieces = cachearg.at(cachearg.size() - 1).split(",");
+    QStringList pieces = cachearg.split(",");
     if (pieces.size() < 3) {
         fprintf(
             stderr, "Parameters %s cache incorrect (correct lru,4,2,2,wb).\n", qPrintable(which));
@@ -147,6 +219,18 @@ void configure_cache(CacheConfig &cacheconf, const QStringList &cachearg, const
             cacheconf.set_replacement_policy(CacheConfig::RP_LRU);
         } else if (pieces.at(0).toLower() == "lfu") {
             cacheconf.set_replacement_policy(CacheConfig::RP_LFU);
+        } else if (pieces.at(0).toLower() == "plru") {
+            cacheconf.set_replacement_policy(CacheConfig::RP_PLRU);
+        } else if (pieces.at(0).toLower() == "nmru") {
+            cacheconf.set_replacement_policy(CacheConfig::RP_NMRU);
+        } else if (pieces.at(0).toLower() == "srrip") {
+            cacheconf.set_replacement_policy(CacheConfig::RP_SRRIP);
+        } else if (pieces.at(0).toLower() == "brrip") {
+            cacheconf.set_replacement_policy(CacheConfig::RP_BRRIP);
+        } else if (pieces.at(0).toLower() == "drrip") {
+            cacheconf.set_replacement_policy(CacheConfig::RP_DRRIP);
+        } else if (pieces.at(0).toLower() == "ship") {
+            cacheconf.set_replacement_policy(CacheConfig::RP_SHIP);
         } else {
             fprintf(stderr, "Policy for %s cache is incorrect.\n", qPrintable(which));
             exit(EXIT_FAILURE);
@@ -182,6 +266,173 @@ void configure_cache(CacheConfig &cacheconf, const QStringList &cachearg, const
             exit(EXIT_FAILURE);
         }
     }
+    if (pieces.size() > 4) {
+        if (pieces.at(4).toLower() == "nine") {
+            cacheconf.set_inclusion_policy(CacheConfig::IP_NINE);
+        } else if (pieces.at(4).toLower() == "inclusive") {
+            cacheconf.set_inclusion_policy(CacheConfig::IP_INCLUSIVE);
+        } else if (pieces.at(4).toLower() == "exclusive") {
+            cacheconf.set_inclusion_policy(CacheConfig::IP_EXCLUSIVE);
+        } else {
+            fprintf(
+                stderr,
+                "Inclusion policy for %s cache is incorrect (correct nine/inclusive/exclusive).\n",
+                qPrintable(which));
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/** Split level:value argument of shared cache level options. */
+unsigned parse_cache_level(const QString &arg, QString &value, const char *option) {
+    const int colon = arg.indexOf(':');
+    bool ok = colon > 0;
+    const unsigned level = ok ? arg.left(colon).toUInt(&ok) : 0;
+    if (!ok || level < 2) {
+        fprintf(stderr, "%s: level is incorrect (correct 2 or more).\n", option);
+        exit(EXIT_FAILURE);
+    }
+    value = arg.mid(colon + 1);
+    return level;
+}
+
+void configure_cache_levels(
+    MachineConfig &config,
+    const QStringList &cacheargs,
+    const QStringList &timeargs) {
+    QString value;
+    for (const QString &arg : cacheargs) {
+        const unsigned level = parse_cache_level(arg, value, "cache-level");
+        parse_cache(*config.access_cache_level(level), value, QString("level%1").arg(level));
+    }
+    for (const QString &arg : timeargs) {
+        const unsigned level = parse_cache_level(arg, value, "cache-level-time");
+        bool ok;
+        const unsigned time = value.toUInt(&ok);
+        if (!ok) {
+            fprintf(stderr, "cache-level-time: time is incorrect.\n");
+            exit(EXIT_FAILURE);
+        }
+        config.set_memory_access_time_level(level, time);
+    }
+}
+
+void configure_cache(CacheConfig &cacheconf, const QStringList &cachearg, const QString &which) {
+    if (cachearg.empty()) { return; }
+    parse_cache(cacheconf, cachearg.at(cachearg.size() - 1), which);
+}
+
+void configure_cache_prefetch(
+    CacheConfig &cacheconf,
+    const QStringList &prefetcharg,
+    const QString &which) {
+    if (prefetcharg.empty()) { return; }
+    const QStringList pieces = prefetcharg.at(prefetcharg.size() - 1).split(",");
+    const QString type = pieces.at(0).toLower();
+    if (type == "none") {
+        cacheconf.set_prefetch_policy(CacheConfig::PF_NONE);
+    } else if (type == "next-line") {
+        cacheconf.set_prefetch_policy(CacheConfig::PF_NEXT_LINE);
+    } else if (type == "stride") {
+        cacheconf.set_prefetch_policy(CacheConfig::PF_STRIDE);
+    } else if (type == "stream") {
+        cacheconf.set_prefetch_policy(CacheConfig::PF_STREAM);
+    } else {
+        fprintf(
+            stderr,
+            "Prefetcher for %s cache is incorrect (correct none/next-line/stride/stream).\n",
+            qPrintable(which));
+        exit(EXIT_FAILURE);
+    }
+    if (pieces.size() > 1) {
+        bool ok;
+        const unsigned degree = pieces.at(1).toUInt(&ok);
+        if (!ok || degree == 0) {
+            fprintf(stderr, "Prefetch degree for %s cache is incorrect.\n", qPrintable(which));
+            exit(EXIT_FAILURE);
+        }
+        cacheconf.set_prefetch_degree(degree);
+    }
+}
+
+void configure_cache_buffers(
+    CacheConfig &cacheconf,
+    const QStringList &buffersarg,
+    const QString &which) {
+    if (buffersarg.empty()) { return; }
+    const QStringList pieces = buffersarg.at(buffersarg.size() - 1).split(",");
+    bool ok;
+    const unsigned victim = pieces.at(0).toUInt(&ok);
+    if (!ok) {
+        fprintf(stderr, "Victim cache size for %s cache is incorrect.\n", qPrintable(which));
+        exit(EXIT_FAILURE);
+    }
+    cacheconf.set_victim_entries(victim);
+    if (pieces.size() > 1) {
+        const unsigned write = pieces.at(1).toUInt(&ok);
+        if (!ok) {
+            fprintf(stderr, "Write buffer size for %s cache is incorrect.\n", qPrintable(which));
+            exit(EXIT_FAILURE);
+        }
+        cacheconf.set_write_buffer_entries(write);
+    }
+}
+
+void configure_cache_sweep(
+    Reporter &r,
+    Cache *cache,
+    const QStringList &cacheargs,
+    const QString &name,
+    const QString &which) {
+    if (cacheargs.empty()) { return; }
+    std::vector<CacheConfig> configs;
+    for (const QString &cachearg : cacheargs) {
+        CacheConfig cacheconf;
+        parse_cache(cacheconf, cachearg, which);
+        configs.push_back(cacheconf);
+    }
+    r.add_cache_sweep(name, cache, std::move(configs));
+}
+
+void configure_dram(MachineConfig &config, const QStringList &dramarg) {
+    if (dramarg.empty()) { return; }
+    DramConfig *dram = config.access_dram();
+    const QStringList pieces = dramarg.at(dramarg.size() - 1).split(",");
+    if (pieces.size() != 4 && pieces.size() != 7 && pieces.size() != 8) {
+        fprintf(stderr, "Parameters for DRAM incorrect (correct channels,banks,row_bytes,page"
+                        "[,tRCD,tCAS,tRP[,queue]]).\n");
+        exit(EXIT_FAILURE);
+    }
+    std::vector<unsigned> numbers;
+    for (int i = 0; i < pieces.size(); i++) {
+        if (i == 3) { continue; }
+        bool ok;
+        const unsigned value = pieces.at(i).toUInt(&ok);
+        if (!ok || value == 0) {
+            fprintf(stderr, "DRAM parameter %d is incorrect.\n", i + 1);
+            exit(EXIT_FAILURE);
+        }
+        numbers.push_back(value);
+    }
+    const QString page = pieces.at(3).toLower();
+    if (page == "open") {
+        dram->set_page_policy(DramConfig::PAGE_OPEN);
+    } else if (page == "closed") {
+        dram->set_page_policy(DramConfig::PAGE_CLOSED);
+    } else {
+        fprintf(stderr, "DRAM page policy is incorrect (correct open/closed).\n");
+        exit(EXIT_FAILURE);
+    }
+    dram->set_enabled(true);
+    dram->set_channels(numbers[0]);
+    dram->set_banks(numbers[1]);
+    dram->set_row_size(numbers[2]);
+    if (numbers.size() > 3) {
+        dram->set_t_rcd(numbers[3]);
+        dram->set_t_cas(numbers[4]);
+        dram->set_t_rp(numbers[5]);
+    }
+    if (numbers.size() > 6) { dram->set_queue_size(numbers[6]); }
 }
 
 void configure_branch_predictor(MachineConfig &config, const QStringList &bpred) {
@@ -276,6 +527,25 @@ void parse_u32_option(
     }
 }
 
+void configure_mapped_files(MachineConfig &config, const QStringList &mappings) {
+    for (const QString &mapping : mappings) {
+        QStringList parts = mapping.split(',');
+        bool ok = parts.size() >= 2 && parts.size() <= 3;
+        MappedFileConfig file_config;
+        if (ok) { file_config.start = parts[0].toULongLong(&ok, 0); }
+        if (ok && parts.size() == 3) {
+            ok = parts[2] == "rw";
+            file_config.writable = true;
+        }
+        if (!ok) {
+            fprintf(stderr, "Map file specification error: %s\n", qPrintable(mapping));
+            exit(EXIT_FAILURE);
+        }
+        file_config.path = parts[1];
+        config.add_mapped_file(file_config);
+    }
+}
+
 void configure_machine(QCommandLineParser &parser, MachineConfig &config) {
     QStringList arguments = parser.positionalArguments();
     if (arguments.size() != 1) {
@@ -286,6 +556,10 @@ void configure_machine(QCommandLineParser &parser, MachineConfig &config) {
 
     config.set_delay_slot(!parser.isSet("no-delay-slot"));
     config.set_pipelined(parser.isSet("pipelined"));
+    config.set_threaded_core(parser.isSet("threaded-core"));
+    config.set_headless(parser.isSet("headless"));
+    config.set_flat_ram(parser.isSet("flat-ram"));
+    configure_mapped_files(config, parser.values("map-file"));
 
     auto hazard_unit_values = parser.values("hazard-unit");
     if (!hazard_unit_values.empty()) {
@@ -300,11 +574,29 @@ void configure_machine(QCommandLineParser &parser, MachineConfig &config) {
     parse_u32_option(parser, "burst-time", config, &MachineConfig::set_memory_access_time_burst);
     parse_u32_option(parser, "l2-time", config, &MachineConfig::set_memory_access_time_level2);
     if (!parser.values("burst-time").empty()) config.set_memory_access_enable_burst(true);
+    if (parser.isSet("memory-timing") && !config.pipelined()) {
+        fprintf(stderr, "Memory timing is supported only by the pipelined core (--pipelined).\n");
+        exit(EXIT_FAILURE);
+    }
+    config.set_memory_timing(parser.isSet("memory-timing"));
 
     configure_cache(*config.access_cache_data(), parser.values("d-cache"), "data");
     configure_cache(*config.access_cache_program(), parser.values("i-cache"), "instruction");
     configure_cache(*config.access_cache_level2(), parser.values("l2-cache"), "level2");
-
+    configure_cache_levels(config, parser.values("cache-level"), parser.values("cache-level-time"));
+    configure_cache_prefetch(
+        *config.access_cache_data(), parser.values("d-cache-prefetch"), "data");
+    configure_cache_prefetch(
+        *config.access_cache_program(), parser.values("i-cache-prefetch"), "instruction");
+    configure_cache_prefetch(
+        *config.access_cache_level2(), parser.values("l2-cache-prefetch"), "level2");
+    configure_cache_buffers(*config.access_cache_data(), parser.values("d-cache-buffers"), "data");
+    configure_cache_buffers(
+        *config.access_cache_program(), parser.values("i-cache-buffers"), "instruction");
+    configure_cache_buffers(
+        *config.access_cache_level2(), parser.values("l2-cache-buffers"), "level2");
+
+    configure_dram(config, parser.values("dram"));
     configure_branch_predictor(config, parser.values("branch-predictor"));
 
     config.set_osemu_enable(parser.isSet("os-emulation"));
@@ -352,6 +644,18 @@ void configure_machine(QCommandLineParser &parser, MachineConfig &config) {
 }
 
 void configure_tracer(QCommandLineParser &p, Tracer &tr) {
+    if (p.isSet("headless")) {
+        for (const char *opt :
+             { "trace-fetch", "trace-decode", "trace-execute", "trace-memory", "trace-writeback",
+               "trace-pc", "trace-wrmem", "trace-rdmem", "trace-exception", "trace-mode-change",
+               "trace-gp" }) {
+            if (p.isSet(opt)) {
+                fprintf(stderr, "Option --%s cannot be used together with --headless\n", opt);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
     if (p.isSet("trace-fetch")) { tr.trace_fetch = true; }
     if (p.isSet("pipelined")) { // Following are added only if we have stages
         if (p.isSet("trace-decode")) { tr.trace_decode = true; }
@@ -668,6 +972,10 @@ int main(int argc, char *argv[]) {
 
     Tracer tr(&machine);
     configure_tracer(p, tr);
+    // Steps retiring many instructions stop at the limit, so the tracer does not overshoot it.
+    machine.core_rw()->set_cycle_limit(tr.cycle_limit);
+    // Headless core notifies the tracer only when the cycle limit can have been reached.
+    if (config.headless()) { machine.core_rw()->set_headless(true, tr.cycle_limit); }
 
     configure_serial_port(p, machine.serial_port());
 
@@ -680,6 +988,10 @@ int main(int argc, char *argv[]) {
 
     Reporter r(&app, &machine);
     configure_reporter(p, r, machine.symbol_table());
+    configure_cache_sweep(
+        r, machine.cache_data_rw(), p.values("d-cache-sweep"), "d-cache", "data sweep");
+    configure_cache_sweep(
+        r, machine.cache_program_rw(), p.values("i-cache-sweep"), "i-cache", "instruction sweep");
 
     QObject::connect(&tr, &Tracer::cycle_limit_reached, &r, &Reporter::cycle_limit_reached);
 
@@ -2,6 +2,7 @@
 
 #include "utilandtext.h"
 
+#include <QJsonArray>
 #include <cinttypes>
 
 using namespace machine;
@@ -22,6 +23,15 @@ void Reporter::add_dump_range(Address start, size_t len, const QString &path_to_
     dump_ranges.append({ start, len, path_to_write });
 }
 
+void Reporter::add_cache_sweep(
+    const QString &cache_name,
+    Cache *cache,
+    std::vector<CacheConfig> configs) {
+    auto trace = std::make_unique<CacheTrace>();
+    cache->set_trace(trace.get());
+    cache_sweeps.push_back({ cache_name, cache, std::move(configs), std::move(trace) });
+}
+
 void Reporter::machine_exit() {
     report();
     if (e_fail != 0) {
@@ -67,15 +77,21 @@ void Reporter::report() {
     if (e_cycles) {
         QString cycle_count = QString::asprintf("%" PRIu32, machine->core()->get_cycle_count());
         QString stall_count = QString::asprintf("%" PRIu32, machine->core()->get_stall_count());
+        // Memory stalls exist only with memory timing, output stays the same without it.
+        const bool memory_timing = machine->config().memory_timing();
+        QString memory_stall_count
+            = QString::asprintf("%u", machine->core()->get_memory_stall_count());
         if (dump_format & DumpFormat::JSON) {
             QJsonObject temp = {};
             temp["cycles"] = cycle_count;
             temp["stalls"] = stall_count;
+            if (memory_timing) { temp["memory_stalls"] = memory_stall_count; }
             dump_data_json["cycles"] = temp;
         }
         if (dump_format & DumpFormat::CONSOLE) {
             printf("cycles: %s\n", qPrintable(cycle_count));
             printf("stalls: %s\n", qPrintable(stall_count));
+            if (memory_timing) { printf("memory-stalls: %s\n", qPrintable(memory_stall_count)); }
         }
     }
     for (const DumpRange &range : dump_ranges) {
@@ -102,6 +118,10 @@ void Reporter::report() {
 
     if (e_predictor) { report_predictor(); }
 
+    for (const CacheSweep &sweep : cache_sweeps) {
+        report_cache_sweep(sweep);
+    }
+
     if (dump_format & DumpFormat::JSON) {
         QFile file(dump_file_json);
         QByteArray bytes = QJsonDocument(dump_data_json).toJson(QJsonDocument::Indented);
@@ -168,9 +188,13 @@ void Reporter::report_caches() {
     printf("Cache statistics report:\n");
     report_cache("i-cache", *machine->cache_program());
     report_cache("d-cache", *machine->cache_data());
-    if (machine->config().cache_level2().enabled()) {
-        report_cache("l2-cache", *machine->cache_level2());
+    for (unsigned level = 2; level <= machine->config().cache_level_count(); level++) {
+        if (machine->config().cache_level(level).enabled()) {
+            const QByteArray name = QString("l%1-cache").arg(level).toLatin1();
+            report_cache(name.constData(), *machine->cache_level(level));
+        }
     }
+    if (machine->dram_controller() != nullptr) { report_dram(*machine->dram_controller()); }
 }
 
 void Reporter::report_cache(const char *cache_name, const Cache &cache) {
@@ -180,9 +204,41 @@ void Reporter::report_cache(const char *cache_name, const Cache &cache) {
         temp["reads"] = QString::asprintf("%" PRIu32, cache.get_read_count());
         temp["hit"] = QString::asprintf("%" PRIu32, cache.get_hit_count());
         temp["miss"] = QString::asprintf("%" PRIu32, cache.get_miss_count());
+        temp["miss_compulsory"]
+            = QString::asprintf("%" PRIu32, cache.get_compulsory_miss_count());
+        temp["miss_capacity"] = QString::asprintf("%" PRIu32, cache.get_capacity_miss_count());
+        temp["miss_conflict"] = QString::asprintf("%" PRIu32, cache.get_conflict_miss_count());
         temp["hit_rate"] = QString::asprintf("%.3lf", cache.get_hit_rate());
         temp["stalled_cycles"] = QString::asprintf("%" PRIu32, cache.get_stall_count());
         temp["improved_speed"] = QString::asprintf("%.3lf", cache.get_speed_improvement());
+        if (cache.get_config().prefetch_policy() != CacheConfig::PF_NONE) {
+            QJsonObject prefetch = {};
+            prefetch["issued"]
+                = QString::asprintf("%" PRIu32, cache.get_prefetch_issued_count());
+            prefetch["useful"]
+                = QString::asprintf("%" PRIu32, cache.get_prefetch_useful_count());
+            prefetch["late"] = QString::asprintf("%" PRIu32, cache.get_prefetch_late_count());
+            prefetch["polluting"]
+                = QString::asprintf("%" PRIu32, cache.get_prefetch_polluting_count());
+            temp["prefetch"] = prefetch;
+        }
+        if (cache.has_victim_buffer()) {
+            temp["victim_hits"] = QString::asprintf("%" PRIu32, cache.get_victim_hit_count());
+        }
+        if (cache.has_write_buffer()) {
+            QJsonObject buffer = {};
+            buffer["writes"]
+                = QString::asprintf("%" PRIu32, cache.get_write_buffer_write_count());
+            buffer["coalesced"]
+                = QString::asprintf("%" PRIu32, cache.get_write_buffer_coalesced_count());
+            buffer["stalled_cycles"]
+                = QString::asprintf("%" PRIu32, cache.get_write_buffer_stall_count());
+            buffer["avg_occupancy"]
+                = QString::asprintf("%.3lf", cache.get_write_buffer_average_occupancy());
+            buffer["max_occupancy"]
+                = QString::asprintf("%zu", cache.get_write_buffer_max_occupancy());
+            temp["write_buffer"] = buffer;
+        }
         caches[cache_name] = temp;
         dump_data_json["caches"] = caches;
     }
@@ -190,9 +246,139 @@ void Reporter::report_cache(const char *cache_name, const Cache &cache) {
         printf("%s:reads: %" PRIu32 "\n", cache_name, cache.get_read_count());
         printf("%s:hit: %" PRIu32 "\n", cache_name, cache.get_hit_count());
         printf("%s:miss: %" PRIu32 "\n", cache_name, cache.get_miss_count());
+        printf(
+            "%s:miss-compulsory: %" PRIu32 "\n", cache_name, cache.get_compulsory_miss_count());
+        printf("%s:miss-capacity: %" PRIu32 "\n", cache_name, cache.get_capacity_miss_count());
+        printf("%s:miss-conflict: %" PRIu32 "\n", cache_name, cache.get_conflict_miss_count());
         printf("%s:hit-rate: %.3lf\n", cache_name, cache.get_hit_rate());
         printf("%s:stalled-cycles: %" PRIu32 "\n", cache_name, cache.get_stall_count());
         printf("%s:improved-speed: %.3lf\n", cache_name, cache.get_speed_improvement());
+        if (cache.get_config().prefetch_policy() != CacheConfig::PF_NONE) {
+            printf(
+                "%s:prefetch-issued: %" PRIu32 "\n", cache_name,
+                cache.get_prefetch_issued_count());
+            printf(
+                "%s:prefetch-useful: %" PRIu32 "\n", cache_name,
+                cache.get_prefetch_useful_count());
+            printf("%s:prefetch-late: %" PRIu32 "\n", cache_name, cache.get_prefetch_late_count());
+            printf(
+                "%s:prefetch-polluting: %" PRIu32 "\n", cache_name,
+                cache.get_prefetch_polluting_count());
+        }
+        if (cache.has_victim_buffer()) {
+            printf("%s:victim-hits: %" PRIu32 "\n", cache_name, cache.get_victim_hit_count());
+        }
+        if (cache.has_write_buffer()) {
+            printf(
+                "%s:write-buffer-writes: %" PRIu32 "\n", cache_name,
+                cache.get_write_buffer_write_count());
+            printf(
+                "%s:write-buffer-coalesced: %" PRIu32 "\n", cache_name,
+                cache.get_write_buffer_coalesced_count());
+            printf(
+                "%s:write-buffer-stalled-cycles: %" PRIu32 "\n", cache_name,
+                cache.get_write_buffer_stall_count());
+            printf(
+                "%s:write-buffer-avg-occupancy: %.3lf\n", cache_name,
+                cache.get_write_buffer_average_occupancy());
+            printf(
+                "%s:write-buffer-max-occupancy: %zu\n", cache_name,
+                cache.get_write_buffer_max_occupancy());
+        }
+    }
+}
+
+void Reporter::report_dram(const DramController &dram) {
+    if (dump_format & DumpFormat::JSON) {
+        QJsonObject temp = {};
+        temp["reads"] = QString::asprintf("%" PRIu32, dram.get_read_count());
+        temp["writes"] = QString::asprintf("%" PRIu32, dram.get_write_count());
+        temp["row_hits"] = QString::asprintf("%" PRIu32, dram.get_row_hit_count());
+        temp["row_misses"] = QString::asprintf("%" PRIu32, dram.get_row_miss_count());
+        temp["row_conflicts"] = QString::asprintf("%" PRIu32, dram.get_row_conflict_count());
+        temp["queue_full"] = QString::asprintf("%" PRIu32, dram.get_queue_full_count());
+        temp["avg_read_latency"] = QString::asprintf("%.3lf", dram.get_average_read_latency());
+        temp["busy_cycles"] = QString::asprintf("%" PRIu64, dram.get_busy_cycles());
+        temp["bandwidth_utilization"]
+            = QString::asprintf("%.3lf", dram.get_bandwidth_utilization());
+        dump_data_json["dram"] = temp;
+    }
+    if (dump_format & DumpFormat::CONSOLE) {
+        printf("dram:reads: %" PRIu32 "\n", dram.get_read_count());
+        printf("dram:writes: %" PRIu32 "\n", dram.get_write_count());
+        printf("dram:row-hits: %" PRIu32 "\n", dram.get_row_hit_count());
+        printf("dram:row-misses: %" PRIu32 "\n", dram.get_row_miss_count());
+        printf("dram:row-conflicts: %" PRIu32 "\n", dram.get_row_conflict_count());
+        printf("dram:queue-full: %" PRIu32 "\n", dram.get_queue_full_count());
+        printf("dram:avg-read-latency: %.3lf\n", dram.get_average_read_latency());
+        printf("dram:busy-cycles: %" PRIu64 "\n", dram.get_busy_cycles());
+        printf("dram:bandwidth-utilization: %.3lf\n", dram.get_bandwidth_utilization());
+    }
+}
+
+/** Configuration in the format of cache command line options. */
+static QString cache_config_to_string(const CacheConfig &config) {
+    if (!config.enabled()) { return "disabled"; }
+    const char *policy = "";
+    switch (config.replacement_policy()) {
+    case CacheConfig::RP_RAND: policy = "random"; break;
+    case CacheConfig::RP_LRU: policy = "lru"; break;
+    case CacheConfig::RP_LFU: policy = "lfu"; break;
+    case CacheConfig::RP_PLRU: policy = "plru"; break;
+    case CacheConfig::RP_NMRU: policy = "nmru"; break;
+    case CacheConfig::RP_SRRIP: policy = "srrip"; break;
+    case CacheConfig::RP_BRRIP: policy = "brrip"; break;
+    case CacheConfig::RP_DRRIP: policy = "drrip"; break;
+    case CacheConfig::RP_SHIP: policy = "ship"; break;
+    }
+    const char *write = "";
+    switch (config.write_policy()) {
+    case CacheConfig::WP_THROUGH_NOALLOC: write = "wtna"; break;
+    case CacheConfig::WP_THROUGH_ALLOC: write = "wta"; break;
+    case CacheConfig::WP_BACK: write = "wb"; break;
+    }
+    return QString::asprintf(
+        "%s,%u,%u,%u,%s", policy, config.set_count(), config.block_size(), config.associativity(),
+        write);
+}
+
+void Reporter::report_cache_sweep(const CacheSweep &sweep) {
+    const std::vector<CacheReplayResult> results
+        = sweep.cache->make_trace_replay().run(*sweep.trace, sweep.configs);
+
+    if (dump_format & DumpFormat::JSON) {
+        QJsonObject sweeps = dump_data_json["cache_sweeps"].toObject();
+        QJsonArray rows;
+        for (const CacheReplayResult &result : results) {
+            QJsonObject temp = {};
+            temp["config"] = cache_config_to_string(result.config);
+            temp["reads"] = QString::asprintf("%" PRIu32, result.mem_reads);
+            temp["writes"] = QString::asprintf("%" PRIu32, result.mem_writes);
+            temp["hit"] = QString::asprintf("%" PRIu32, result.hits);
+            temp["miss"] = QString::asprintf("%" PRIu32, result.misses);
+            temp["hit_rate"] = QString::asprintf("%.3lf", result.hit_rate());
+            temp["stalled_cycles"] = QString::asprintf("%" PRIu32, result.stalled_cycles);
+            rows.append(temp);
+        }
+        if (sweep.trace->is_truncated()) { sweeps[sweep.name + "_truncated"] = true; }
+        sweeps[sweep.name] = rows;
+        dump_data_json["cache_sweeps"] = sweeps;
+    }
+    if (dump_format & DumpFormat::CONSOLE) {
+        printf(
+            "%s sweep over %zu accesses%s:\n", qPrintable(sweep.name), sweep.trace->size(),
+            sweep.trace->is_truncated() ? " (trace limit reached)" : "");
+        printf(
+            "%-24s %10s %10s %10s %10s %9s %14s\n", "config", "reads", "writes", "hit", "miss",
+            "hit-rate", "stalled-cycles");
+        for (const CacheReplayResult &result : results) {
+            printf(
+                "%-24s %10" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 " %9.3lf %14" PRIu32
+                "\n",
+                qPrintable(cache_config_to_string(result.config)), result.mem_reads,
+                result.mem_writes, result.hits, result.misses, result.hit_rate(),
+                result.stalled_cycles);
+        }
     }
 }
 
@@ -10,6 +10,8 @@
 #include <QJsonObject>
 #include <QObject>
 #include <QString>
+#include <memory>
+#include <vector>
 
 using machine::Address;
 
@@ -56,6 +58,15 @@ public:
     };
     void add_dump_range(Address start, size_t len, const QString &path_to_write);
 
+    /**
+     * Record accesses received by `cache` and report statistics of all
+     * `configs` on them at exit (see `machine::CacheTraceReplay`).
+     */
+    void add_cache_sweep(
+        const QString &cache_name,
+        machine::Cache *cache,
+        std::vector<machine::CacheConfig> configs);
+
 public slots:
     void cycle_limit_reached();
 
@@ -69,6 +80,14 @@ private:
     BORROWED machine::Machine *const machine;
     QVector<DumpRange> dump_ranges;
 
+    struct CacheSweep {
+        QString name;
+        BORROWED const machine::Cache *cache;
+        std::vector<machine::CacheConfig> configs;
+        std::unique_ptr<machine::CacheTrace> trace;
+    };
+    std::vector<CacheSweep> cache_sweeps;
+
     bool e_regs = false;
     bool e_cache_stats = false;
     bool e_cycles = false;
@@ -84,6 +103,8 @@ private:
     void report_csr_reg(size_t internal_id, bool last);
     void report_gp_reg(unsigned int i, bool last);
     void report_cache(const char *cache_name, const machine::Cache &cache);
+    void report_dram(const machine::DramController &dram);
+    void report_cache_sweep(const CacheSweep &sweep);
     void report_predictor();
 
     void exit(int retcode);
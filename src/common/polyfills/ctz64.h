@@ -0,0 +1,44 @@
+#ifndef CTZ64_H
+#define CTZ64_H
+
+#include <cstdint>
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+
+static inline uint32_t ctz64(uint64_t n) {
+    if (n == 0) { return 64; }
+    return __builtin_ctzll(n);
+}
+
+#else /* Fallback for generic compiler */
+
+static inline uint32_t ctz64(uint64_t n) {
+    if (n == 0) { return 64; }
+    uint32_t len = 0;
+    if ((n & 0xFFFFFFFF) == 0) {
+        len += 32;
+        n >>= 32;
+    }
+    if ((n & 0xFFFF) == 0) {
+        len += 16;
+        n >>= 16;
+    }
+    if ((n & 0xFF) == 0) {
+        len += 8;
+        n >>= 8;
+    }
+    if ((n & 0xF) == 0) {
+        len += 4;
+        n >>= 4;
+    }
+    if ((n & 0x3) == 0) {
+        len += 2;
+        n >>= 2;
+    }
+    if ((n & 0x1) == 0) { len += 1; }
+    return len;
+}
+
+#endif
+
+#endif // CTZ64_H
@@ -81,6 +81,7 @@ NewDialog::NewDialog(QWidget *parent, QSettings *settings) : QDialog(parent) {
     connect(
         ui->mem_time_level2, QOverload<int>::of(&QSpinBox::valueChanged), this,
         &NewDialog::mem_time_level2_change);
+    connect(ui->mem_timing, &QAbstractButton::clicked, this, &NewDialog::mem_timing_change);
 
     connect(ui->osemu_enable, &QAbstractButton::clicked, this, &NewDialog::osemu_enable_change);
     connect(
@@ -286,6 +287,7 @@ void NewDialog::isa_multiply_change(bool val) {
 void NewDialog::pipelined_change(bool val) {
     config->set_pipelined(val);
     ui->hazard_unit->setEnabled(config->pipelined());
+    ui->mem_timing->setEnabled(config->pipelined());
     switch_to_custom();
 }
 
@@ -350,6 +352,13 @@ void NewDialog::mem_time_level2_change(int v) {
     }
 }
 
+void NewDialog::mem_timing_change(bool v) {
+    if (config->memory_timing() != v) {
+        config->set_memory_timing(v);
+        switch_to_custom();
+    }
+}
+
 void NewDialog::osemu_enable_change(bool v) {
     config->set_osemu_enable(v);
 }
@@ -660,6 +669,7 @@ void NewDialog::config_gui() {
     ui->mem_time_burst->setValue((int)config->memory_access_time_burst());
     ui->mem_time_level2->setValue((int)config->memory_access_time_level2());
     ui->mem_enable_burst->setChecked((int)config->memory_access_enable_burst());
+    ui->mem_timing->setChecked(config->memory_timing());
     // Cache
     cache_handler_d->config_gui();
     cache_handler_p->config_gui();
@@ -675,6 +685,7 @@ void NewDialog::config_gui() {
     // Disable various sections according to configuration
     ui->delay_slot->setEnabled(false);
     ui->hazard_unit->setEnabled(config->pipelined());
+    ui->mem_timing->setEnabled(config->pipelined());
 }
 
 unsigned NewDialog::preset_number() {
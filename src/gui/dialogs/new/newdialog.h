@@ -45,6 +45,7 @@ private slots:
     void mem_enable_burst_change(bool);
     void mem_time_burst_change(int);
     void mem_time_level2_change(int);
+    void mem_timing_change(bool);
     void osemu_enable_change(bool);
     void osemu_known_syscall_stop_change(bool);
     void osemu_unknown_syscall_stop_change(bool);
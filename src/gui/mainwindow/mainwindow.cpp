@@ -323,7 +323,7 @@ void MainWindow::create_core(
     auto *new_machine = new machine::Machine(config, true, load_executable);
 
     if (keep_memory && (machine != nullptr)) {
-        new_machine->memory_rw()->reset(*machine->memory());
+        new_machine->reset_memory(*machine->memory());
     }
 
     // Remove old machine
@@ -16,6 +16,10 @@ CacheDock::CacheDock(QWidget *parent, const QString &type) : QDockWidget(parent)
     l_miss = new QLabel("0", top_form);
     l_miss->setTextFormat(Qt::PlainText);
     layout_top_form->addRow("Miss:", l_miss);
+    l_miss_classes = new QLabel("0 / 0 / 0", top_form);
+    l_miss_classes->setTextFormat(Qt::PlainText);
+    l_miss_classes->setToolTip("Compulsory / capacity / conflict misses");
+    layout_top_form->addRow("Miss 3C:", l_miss_classes);
     l_m_reads = new QLabel("0", top_form);
     l_m_reads->setTextFormat(Qt::PlainText);
     layout_top_form->addRow("Memory reads:", l_m_reads);
@@ -49,12 +53,16 @@ void CacheDock::setup(const machine::Cache *cache, bool cache_after_cache) {
     memory_writes = 0;
     hit = 0;
     miss = 0;
+    miss_compulsory = 0;
+    miss_capacity = 0;
+    miss_conflict = 0;
     stalled = 0;
     speed_improv = 0.0;
     hit_rate = 0.0;
 
     l_hit->setText("0");
     l_miss->setText("0");
+    l_miss_classes->setText("0 / 0 / 0");
     l_stalled->setText("0");
     l_m_reads->setText("0");
     l_m_writes->setText("0");
@@ -64,6 +72,7 @@ void CacheDock::setup(const machine::Cache *cache, bool cache_after_cache) {
     if (cache != nullptr) {
         connect(cache, &machine::Cache::hit_update, this, &CacheDock::hit_update);
         connect(cache, &machine::Cache::miss_update, this, &CacheDock::miss_update);
+        connect(cache, &machine::Cache::miss_classes_update, this, &CacheDock::miss_classes_update);
         connect(cache, &machine::Cache::memory_reads_update, this, &CacheDock::memory_reads_update);
         connect(
             cache, &machine::Cache::memory_writes_update, this, &CacheDock::memory_writes_update);
@@ -84,6 +93,8 @@ void CacheDock::paintEvent(QPaintEvent *event) {
     l_speed->setText(QString::number(speed_improv, 'f', 0) + QString("%"));
     l_hit->setText(QString::number(hit));
     l_miss->setText(QString::number(miss));
+    l_miss_classes->setText(
+        QString("%1 / %2 / %3").arg(miss_compulsory).arg(miss_capacity).arg(miss_conflict));
     l_m_reads->setText(QString::number(memory_reads));
     l_m_writes->setText(QString::number(memory_writes));
     QDockWidget::paintEvent(event);
@@ -103,6 +114,15 @@ void CacheDock::miss_update(unsigned val) {
     }
 }
 
+void CacheDock::miss_classes_update(unsigned compulsory, unsigned capacity, unsigned conflict) {
+    if (miss_compulsory != compulsory || miss_capacity != capacity || miss_conflict != conflict) {
+        miss_compulsory = compulsory;
+        miss_capacity = capacity;
+        miss_conflict = conflict;
+        l_miss_classes->update();
+    }
+}
+
 void CacheDock::memory_reads_update(unsigned val) {
     if (memory_reads != val) {
         memory_reads = val;
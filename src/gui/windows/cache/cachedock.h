@@ -21,6 +21,7 @@ public:
 private slots:
     void hit_update(unsigned);
     void miss_update(unsigned);
+    void miss_classes_update(unsigned compulsory, unsigned capacity, unsigned conflict);
     void memory_reads_update(unsigned val);
     void memory_writes_update(unsigned val);
     void statistics_update(unsigned stalled_cycles, double speed_improv, double hit_rate);
@@ -29,7 +30,7 @@ private:
     QVBoxLayout *layout_box;
     QWidget *top_widget, *top_form;
     QFormLayout *layout_top_form;
-    QLabel *l_hit, *l_miss, *l_stalled, *l_speed, *l_hit_rate;
+    QLabel *l_hit, *l_miss, *l_miss_classes, *l_stalled, *l_speed, *l_hit_rate;
     QLabel *no_cache;
     QLabel *l_m_reads, *l_m_writes;
     GraphicsView *graphicsview;
@@ -40,6 +41,9 @@ private:
     unsigned memory_writes = 0;
     unsigned hit = 0;
     unsigned miss = 0;
+    unsigned miss_compulsory = 0;
+    unsigned miss_capacity = 0;
+    unsigned miss_conflict = 0;
     unsigned stalled = 0;
     double speed_improv = 0.0;
     double hit_rate = 0.0;
@@ -51,6 +51,7 @@ static const std::unordered_map<unsigned, QString> STALL_TEXT_TABLE = {
     { 0, QStringLiteral("NORMAL") },
     { 1, QStringLiteral("STALL") },
     { 2, QStringLiteral("FORWARD") },
+    { 3, QStringLiteral("MEMORY") },
 };
 
 static const std::unordered_map<unsigned, QString> PRIVILEGE_TEXT_TABLE = {
@@ -61,6 +61,8 @@ void CsrDock::setup(machine::Machine *machine) {
     connect(csr_handle, &machine::CSR::ControlState::write_signal, this, &CsrDock::csr_changed);
     connect(csr_handle, &machine::CSR::ControlState::read_signal, this, &CsrDock::csr_read);
     connect(machine, &machine::Machine::tick, this, &CsrDock::clear_highlights);
+    // Counters are derived on read and do not signal their updates.
+    connect(machine, &machine::Machine::post_tick, this, &CsrDock::update_counters);
 }
 
 const char *CsrDock::sizeHintText() {
@@ -118,6 +120,14 @@ void CsrDock::clear_highlights() {
     csr_highlighted_any = false;
 }
 
+void CsrDock::update_counters() {
+    if (isHidden() || csr_handle == nullptr) { return; }
+    for (size_t i : { machine::CSR::Id::CYCLE, machine::CSR::Id::MCYCLE,
+                      machine::CSR::Id::MINSTRET }) {
+        labelVal(csr_view[i], csr_handle->read_internal(i).as_xlen(xlen));
+    }
+}
+
 void CsrDock::showEvent(QShowEvent *event) {
     // Slots are inactive when this widget is hidden
     reload();
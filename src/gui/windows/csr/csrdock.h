@@ -24,6 +24,7 @@ private slots:
     void csr_changed(std::size_t internal_reg_id, machine::RegisterValue val);
     void csr_read(std::size_t internal_reg_id, machine::RegisterValue val);
     void clear_highlights();
+    void update_counters();
 
 private:
     void showEvent(QShowEvent *event) override;
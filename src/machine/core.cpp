@@ -4,6 +4,7 @@
 #include "execute/alu.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cinttypes>
 
 LOG_CATEGORY("machine.core");
@@ -46,23 +47,51 @@ Core::Core(
     step_over_exception[EXCAUSE_INT_M] = false;
     step_over_exception[EXCAUSE_INT_S] = false;
     state.LoadReservedRange.reset();
+    if (control_state != nullptr) { control_state->attach_counters(&hw_counters); }
+}
+
+Core::~Core() {
+    if (control_state != nullptr) { control_state->attach_counters(nullptr); }
 }
 
 void Core::step(bool skip_break) {
-    emit step_started();
+    if (!headless) { emit step_started(); }
     state.cycle_count++;
     do_step(skip_break);
-    emit step_done(state);
+    if (!headless) {
+        emit step_done(state);
+    } else if (
+        step_done_interval != 0 && state.cycle_count - last_step_done_cycle >= step_done_interval) {
+        last_step_done_cycle = state.cycle_count;
+        emit step_done(state);
+    }
 }
 
 void Core::reset() {
     state.cycle_count = 0;
+    last_step_done_cycle = 0;
     state.stall_count = 0;
+    state.memory_stall_count = 0;
+    decode_cache.reset();
     do_reset();
     set_current_privilege(CSR::PrivilegeLevel::MACHINE);
     state.LoadReservedRange.reset();
 }
 
+void Core::set_headless(bool value, unsigned step_done_interval) {
+    headless = value;
+    this->step_done_interval = step_done_interval;
+    last_step_done_cycle = state.cycle_count;
+}
+
+bool Core::is_headless() const {
+    return headless;
+}
+
+void Core::set_cycle_limit(unsigned limit) {
+    cycle_limit = limit;
+}
+
 unsigned Core::get_cycle_count() const {
     return state.cycle_count;
 }
@@ -71,6 +100,10 @@ unsigned Core::get_stall_count() const {
     return state.stall_count;
 }
 
+unsigned Core::get_memory_stall_count() const {
+    return state.memory_stall_count;
+}
+
 Registers *Core::get_regs() const {
     return regs;
 }
@@ -95,6 +128,10 @@ const CoreState &Core::get_state() const {
     return state;
 }
 
+const DecodeCache &Core::get_decode_cache() const {
+    return decode_cache;
+}
+
 void Core::insert_hwbreak(Address address) {
     hw_breaks.insert(address, new hwBreak(address));
 }
@@ -295,6 +332,7 @@ enum ExceptionCause Core::memory_special(
         mem_data->sync();
         mem_program->sync();
         predictor->flush();
+        decode_cache.flush();
         break;
     case AC_LR32:
         if (!memread) { break; }
@@ -350,6 +388,7 @@ enum ExceptionCause Core::memory_special(
         mem_data->sfence_vma(vaddr, asid);
         mem_program->sfence_vma(vaddr, asid);
         predictor->flush();
+        decode_cache.flush();
         state.LoadReservedRange.reset();
         break;
     }
@@ -368,13 +407,16 @@ FetchState Core::fetch(PCInterstage pc, bool skip_break) {
     Instruction inst = Instruction::NOP;
     ExceptionCause excause = EXCAUSE_NONE;
 
-    try {
-        inst = Instruction(mem_program->read_u32(inst_addr));
-    } catch (const SimulatorExceptionPageFault &e) { excause = EXCAUSE_INSN_PAGE_FAULT; }
+    ExceptionCause fetch_fault = EXCAUSE_NONE;
+    inst = Instruction(mem_program->read_ctl(AC_U32, inst_addr, fetch_fault).as_u32());
+    if (fetch_fault != EXCAUSE_NONE) {
+        inst = Instruction::NOP;
+        excause = EXCAUSE_INSN_PAGE_FAULT;
+    }
 
     if (!skip_break && hw_breaks.contains(inst_addr)) { excause = EXCAUSE_HWBREAK; }
 
-    if (control_state != nullptr) { control_state->increment_internal(CSR::Id::MCYCLE, 1); }
+    hw_counters.cycle++;
 
     if (control_state != nullptr && excause == EXCAUSE_NONE) {
         excause = control_state->core_interrupt_request(get_current_privilege());
@@ -392,39 +434,26 @@ FetchState Core::fetch(PCInterstage pc, bool skip_break) {
 }
 
 DecodeState Core::decode(const FetchInterstage &dt) {
-    InstructionFlags flags;
     bool w_operation = this->xlen != Xlen::_64;
-    AluCombinedOp alu_op {};
-    AccessControl mem_ctl;
     ExceptionCause excause = dt.excause;
 
-    dt.inst.flags_alu_op_mem_ctl(flags, alu_op, mem_ctl);
-    CSR::PrivilegeLevel inst_xret_priv = CSR::PrivilegeLevel::UNPRIVILEGED;
-    if (flags & IMF_XRET) {
-        if (flags & IMF_PRIV_M) {
-            inst_xret_priv = CSR::PrivilegeLevel::MACHINE;
-        } else if (flags & IMF_PRIV_H) {
-            inst_xret_priv = CSR::PrivilegeLevel::HYPERVISOR;
-        } else if (flags & IMF_PRIV_S) {
-            inst_xret_priv = CSR::PrivilegeLevel::SUPERVISOR;
-        } else {
-            inst_xret_priv = CSR::PrivilegeLevel::UNPRIVILEGED;
-        }
-    }
+    const PredecodedInstruction &pre = decode_cache.lookup(dt.inst_addr, dt.inst);
+    const InstructionFlags flags = pre.flags;
+    const AluCombinedOp alu_op = pre.alu_op;
+    const AccessControl mem_ctl = pre.mem_ctl;
+    const CSR::PrivilegeLevel inst_xret_priv = pre.xret_privlev;
     if ((flags ^ check_inst_flags_val) & check_inst_flags_mask) { excause = EXCAUSE_INSN_ILLEGAL; }
 
-    RegisterId num_rs = (flags & (IMF_ALU_REQ_RS | IMF_ALU_RS_ID)) ? dt.inst.rs() : 0;
-    RegisterId num_rt = (flags & IMF_ALU_REQ_RT) ? dt.inst.rt() : 0;
-    RegisterId num_rd = (flags & IMF_REGWRITE) ? dt.inst.rd() : 0;
-    // When instruction does not specify register, it is set to x0 as operations on x0 have no
-    // side effects (not even visualization).
+    const RegisterId num_rs = pre.num_rs;
+    const RegisterId num_rt = pre.num_rt;
+    const RegisterId num_rd = pre.num_rd;
     RegisterValue val_rs
         = (flags & IMF_ALU_RS_ID) ? uint64_t(size_t(num_rs)) : regs->read_gp(num_rs);
     RegisterValue val_rt = regs->read_gp(num_rt);
-    RegisterValue immediate_val = dt.inst.immediate();
+    RegisterValue immediate_val = pre.immediate;
     const bool regwrite = flags & IMF_REGWRITE;
 
-    CSR::Address csr_address = (flags & IMF_CSR) ? dt.inst.csr_address() : CSR::Address(0);
+    CSR::Address csr_address = CSR::Address(pre.csr_address);
     RegisterValue csr_read_val = ((control_state != nullptr && (flags & IMF_CSR)))
                                      ? control_state->read(csr_address, get_current_privilege())
                                      : 0;
@@ -587,14 +616,16 @@ MemoryState Core::memory(const ExecuteInterstage &dt) {
                 excause = memory_special(
                     dt.memctl, dt.inst.rt(), memread, memwrite, towrite_val, dt.val_rt, mem_addr);
             } else if (is_regular_access(dt.memctl)) {
-                if (memwrite) { mem_data->write_ctl(dt.memctl, mem_addr, dt.val_rt); }
-                if (memread) { towrite_val = mem_data->read_ctl(dt.memctl, mem_addr); }
+                mem_data->set_access_pc(dt.inst_addr);
+                // Regular accesses report page faults by result, only the special ones throw.
+                if (memwrite) { mem_data->write_ctl(dt.memctl, mem_addr, dt.val_rt, excause); }
+                if (memread) { towrite_val = mem_data->read_ctl(dt.memctl, mem_addr, excause); }
             } else {
                 Q_ASSERT(dt.memctl == AC_NONE);
                 // AC_NONE is memory NOP
             }
-        } catch (const SimulatorExceptionPageFault &e) {
-            excause = e.get_cause();
+        } catch (const SimulatorExceptionPageFault &e) { excause = e.get_cause(); }
+        if (excause != EXCAUSE_NONE) {
             memread = false;
             memwrite = false;
             regwrite = false;
@@ -635,7 +666,7 @@ MemoryState Core::memory(const ExecuteInterstage &dt) {
 
     bool csr_written = false;
     if (control_state != nullptr && dt.is_valid && dt.excause == EXCAUSE_NONE) {
-        control_state->increment_internal(CSR::Id::MINSTRET, 1);
+        hw_counters.instret++;
         if (dt.csr_write) {
             control_state->write(dt.csr_address, dt.alu_val, get_current_privilege());
             csr_written = true;
@@ -765,6 +796,285 @@ void CoreSingle::do_reset() {
     prev_inst_addr = Address::null();
 }
 
+CoreThreaded::CoreThreaded(
+    Registers *regs,
+    BranchPredictor *predictor,
+    FrontendMemory *mem_program,
+    FrontendMemory *mem_data,
+    CSR::ControlState *control_state,
+    Xlen xlen,
+    ConfigIsaWord isa_word)
+    : CoreSingle(regs, predictor, mem_program, mem_data, control_state, xlen, isa_word) {}
+
+void CoreThreaded::invalidate_translations() {
+    // Blocks may be executing right now (e.g. a peripheral notification triggered by a store), so
+    // they are only marked here and released at the next safe point.
+    translations_stale = true;
+}
+
+void CoreThreaded::do_reset() {
+    CoreSingle::do_reset();
+    release_translations();
+}
+
+void CoreThreaded::release_translations() {
+    blocks.clear();
+    code_first = UINT64_MAX;
+    code_last = 0;
+    translations_stale = false;
+}
+
+void CoreThreaded::do_step(bool skip_break) {
+    if (translations_stale) { release_translations(); }
+    if (skip_break) {
+        // Single stepping and resume from a breakpoint always go through the generic path.
+        CoreSingle::do_step(skip_break);
+        after_generic_step();
+        return;
+    }
+
+    // Cycle of this step is already accounted by `Core::step`.
+    const unsigned cycles_before = state.cycle_count - 1;
+    unsigned step_limit = STEP_INSTRUCTION_LIMIT;
+    if (cycle_limit != 0) {
+        step_limit = cycle_limit > cycles_before ? std::min(step_limit, cycle_limit - cycles_before)
+                                                 : 1;
+    }
+
+    Address pc = regs->read_pc();
+    unsigned executed = 0;
+    bool generic_required = false;
+    // Counters are committed in bulk, nothing can observe them in the middle of the block.
+    auto commit = [&]() {
+        if (executed == 0) { return; }
+        state.cycle_count += executed;
+        hw_counters.cycle += executed;
+        hw_counters.instret += executed;
+        regs->write_pc(pc);
+    };
+
+    try {
+        ThreadedBlock *block = nullptr;
+        while (executed < step_limit && !generic_required && !translations_stale) {
+            block = find_block(block, pc);
+            if (block->ops.empty()) {
+                generic_required = true;
+                break;
+            }
+            const ThreadedOp *op = block->ops.data();
+            const ThreadedOp *const end = op + block->ops.size();
+            taken_next_pc = block->end_addr;
+            for (; op != end; ++op) {
+                // Block may be left in the middle, the PC of the next operation is already set.
+                if (executed == step_limit) { break; }
+                if (!hw_breaks.isEmpty() && hw_breaks.contains(op->inst_addr)) {
+                    generic_required = true;
+                    break;
+                }
+                if (control_state != nullptr
+                    && control_state->core_interrupt_request(get_current_privilege())
+                           != EXCAUSE_NONE) {
+                    generic_required = true;
+                    break;
+                }
+                if (!op->handler(*this, *op)) {
+                    generic_required = true;
+                    break;
+                }
+                executed++;
+                prev_inst_addr = op->inst_addr;
+                pc = (op + 1 == end) ? taken_next_pc : op->next_inst_addr;
+                if (translations_stale) { break; }
+            }
+        }
+    } catch (...) {
+        commit();
+        throw;
+    }
+
+    commit();
+    if (generic_required || executed == 0) {
+        // The cycle of the generic instruction is already accounted by `Core::step`.
+        CoreSingle::do_step(false);
+        after_generic_step();
+    } else {
+        state.cycle_count--;
+        state.pipeline = {};
+    }
+}
+
+void CoreThreaded::after_generic_step() {
+    const MemoryInterstage &mem = state.pipeline.memory.final;
+    const AccessControl memctl = state.pipeline.execute.final.memctl;
+    if (mem.excause != EXCAUSE_NONE || mem.csr_written || memctl == AC_CACHE_OP
+        || memctl == AC_SFENCE_VMA) {
+        // Privilege, address translation or code itself may have changed.
+        translations_stale = true;
+    } else if (state.pipeline.memory.internal.memwrite) {
+        check_code_write(mem.mem_addr.get_raw());
+    }
+}
+
+void CoreThreaded::check_code_write(uint64_t addr) {
+    if (addr <= code_last && addr + sizeof(uint64_t) > code_first) { translations_stale = true; }
+}
+
+CoreThreaded::ThreadedBlock *CoreThreaded::find_block(ThreadedBlock *prev, Address pc) {
+    ThreadedBlock **link = nullptr;
+    if (prev != nullptr) {
+        link = &prev->chain[pc == prev->end_addr ? 0 : 1];
+        if (*link != nullptr && (*link)->start_addr == pc) { return *link; }
+    }
+    auto &slot = blocks[pc.get_raw()];
+    if (slot == nullptr) {
+        slot = translate(pc);
+        // Running blocks are still referenced, so the limit is enforced at the next step.
+        if (blocks.size() > MAX_BLOCKS) { translations_stale = true; }
+    }
+    if (link != nullptr) { *link = slot.get(); }
+    return slot.get();
+}
+
+std::unique_ptr<CoreThreaded::ThreadedBlock> CoreThreaded::translate(Address start_addr) {
+    auto block = std::make_unique<ThreadedBlock>();
+    block->start_addr = start_addr;
+    Address addr = start_addr;
+    while (block->ops.size() < MAX_BLOCK_LENGTH) {
+        // Fetch problems are reported by the generic path once the instruction is reached.
+        Instruction inst;
+        ExceptionCause fault = EXCAUSE_NONE;
+        try {
+            inst = Instruction(
+                mem_program
+                    ->read_ctl(
+                        AC_U32, AddressWithMode(addr, make_access_mode(state, AccessOp::FETCH)),
+                        fault)
+                    .as_u32());
+        } catch (const SimulatorException &) { break; }
+        if (fault != EXCAUSE_NONE) { break; }
+        const PredecodedInstruction pre(inst);
+        const ThreadedHandler handler = select_handler(pre);
+        if (handler == nullptr) { break; }
+        block->ops.push_back(ThreadedOp {
+            .handler = handler,
+            .inst = inst,
+            .inst_addr = addr,
+            .next_inst_addr = addr + inst.size(),
+            .immediate = pre.immediate,
+            .aluop = pre.alu_op,
+            .alu_component = (pre.flags & IMF_MUL) ? AluComponent::MUL : AluComponent::ALU,
+            .memctl = pre.mem_ctl,
+            .num_rs = pre.num_rs,
+            .num_rt = pre.num_rt,
+            .num_rd = pre.num_rd,
+            .regwrite = bool(pre.flags & IMF_REGWRITE),
+            .alusrc = bool(pre.flags & IMF_ALUSRC),
+            .alu_pc = bool(pre.flags & IMF_PC_TO_ALU),
+            .alu_mod = bool(pre.flags & IMF_ALU_MOD),
+            .w_operation = xlen != Xlen::_64 || (pre.flags & IMF_FORCE_W_OP),
+            .branch_val = bool(pre.flags & IMF_BJ_NOT),
+        });
+        addr += inst.size();
+        if (pre.flags & (IMF_BRANCH | IMF_JUMP | IMF_BRANCH_JALR)) { break; }
+        // Do not fetch ahead into the next page, the walk could have side effects.
+        if ((addr.get_raw() & (PAGE_SIZE - 1)) == 0) { break; }
+    }
+    block->end_addr = addr;
+    if (!block->ops.empty()) {
+        code_first = std::min(code_first, start_addr.get_raw());
+        code_last = std::max(code_last, addr.get_raw() - 1);
+    }
+    return block;
+}
+
+CoreThreaded::ThreadedHandler CoreThreaded::select_handler(const PredecodedInstruction &pre) const {
+    const InstructionFlags flags = pre.flags;
+    if ((flags ^ check_inst_flags_val) & check_inst_flags_mask) { return nullptr; }
+    if (flags & (IMF_CSR | IMF_EXCEPTION | IMF_XRET | IMF_AMO | IMF_ALU_RS_ID)) { return nullptr; }
+    if (is_special_access(pre.mem_ctl)) { return nullptr; }
+    if (flags & IMF_BRANCH) { return &CoreThreaded::exec_branch; }
+    if (flags & IMF_BRANCH_JALR) { return &CoreThreaded::exec_jalr; }
+    if (flags & IMF_JUMP) { return &CoreThreaded::exec_jal; }
+    if (flags & IMF_MEMREAD) { return &CoreThreaded::exec_load; }
+    if (flags & IMF_MEMWRITE) { return &CoreThreaded::exec_store; }
+    return &CoreThreaded::exec_alu;
+}
+
+RegisterValue CoreThreaded::threaded_alu(const ThreadedOp &op) const {
+    const RegisterValue alu_fst
+        = op.alu_pc ? RegisterValue(op.inst_addr.get_raw()) : regs->read_gp(op.num_rs);
+    const RegisterValue alu_sec = op.alusrc ? op.immediate : regs->read_gp(op.num_rt);
+    return alu_combined_operate(
+        op.aluop, op.alu_component, op.w_operation, op.alu_mod, alu_fst, alu_sec);
+}
+
+bool CoreThreaded::exec_alu(CoreThreaded &core, const ThreadedOp &op) {
+    const RegisterValue alu_val = core.threaded_alu(op);
+    if (op.regwrite) { core.regs->write_gp(op.num_rd, alu_val); }
+    return true;
+}
+
+bool CoreThreaded::exec_load(CoreThreaded &core, const ThreadedOp &op) {
+    const auto mem_addr = AddressWithMode(
+        core.get_xlen_from_reg(core.threaded_alu(op)),
+        make_access_mode(core.state, AccessOp::READ));
+    ExceptionCause fault = EXCAUSE_NONE;
+    core.mem_data->set_access_pc(op.inst_addr);
+    const RegisterValue val = core.mem_data->read_ctl(op.memctl, mem_addr, fault);
+    if (fault != EXCAUSE_NONE) { return false; }
+    if (op.regwrite) { core.regs->write_gp(op.num_rd, val); }
+    return true;
+}
+
+bool CoreThreaded::exec_store(CoreThreaded &core, const ThreadedOp &op) {
+    const auto mem_addr = AddressWithMode(
+        core.get_xlen_from_reg(core.threaded_alu(op)),
+        make_access_mode(core.state, AccessOp::WRITE));
+    ExceptionCause fault = EXCAUSE_NONE;
+    core.mem_data->set_access_pc(op.inst_addr);
+    core.mem_data->write_ctl(op.memctl, mem_addr, core.regs->read_gp(op.num_rt), fault);
+    if (fault != EXCAUSE_NONE) { return false; }
+    core.check_code_write(mem_addr.get_raw());
+    return true;
+}
+
+bool CoreThreaded::exec_branch(CoreThreaded &core, const ThreadedOp &op) {
+    const RegisterValue alu_val = core.threaded_alu(op);
+    const Address target = op.inst_addr + op.immediate.as_i64();
+    const bool taken = !op.branch_val ^ !(alu_val == 0);
+    // Unaligned jump is reported by the generic path.
+    if (taken && !target.is_aligned<uint32_t>()) { return false; }
+    const Address predicted = core.predictor->predict_next_pc_address(op.inst, op.inst_addr);
+    core.predictor->update(
+        op.inst, op.inst_addr, target, BranchType::BRANCH,
+        taken ? BranchResult::TAKEN : BranchResult::NOT_TAKEN);
+    core.taken_next_pc = taken ? target : op.next_inst_addr;
+    if (core.taken_next_pc != predicted) { core.predictor->increment_mispredictions(); }
+    return true;
+}
+
+bool CoreThreaded::exec_jal(CoreThreaded &core, const ThreadedOp &op) {
+    const Address target = op.inst_addr + op.immediate.as_i64();
+    if (!target.is_aligned<uint32_t>()) { return false; }
+    const Address predicted = core.predictor->predict_next_pc_address(op.inst, op.inst_addr);
+    core.predictor->update(op.inst, op.inst_addr, target, BranchType::JUMP, BranchResult::TAKEN);
+    if (op.regwrite) { core.regs->write_gp(op.num_rd, op.next_inst_addr.get_raw()); }
+    core.taken_next_pc = target;
+    if (target != predicted) { core.predictor->increment_mispredictions(); }
+    return true;
+}
+
+bool CoreThreaded::exec_jalr(CoreThreaded &core, const ThreadedOp &op) {
+    const Address target = Address(core.get_xlen_from_reg(core.threaded_alu(op)));
+    if (!target.is_aligned<uint32_t>()) { return false; }
+    const Address predicted = core.predictor->predict_next_pc_address(op.inst, op.inst_addr);
+    core.predictor->update(op.inst, op.inst_addr, target, BranchType::JUMP, BranchResult::TAKEN);
+    if (op.regwrite) { core.regs->write_gp(op.num_rd, op.next_inst_addr.get_raw()); }
+    core.taken_next_pc = target;
+    if (target != predicted) { core.predictor->increment_mispredictions(); }
+    return true;
+}
+
 CorePipelined::CorePipelined(
     Registers *regs,
     BranchPredictor *predictor,
@@ -773,23 +1083,41 @@ CorePipelined::CorePipelined(
     CSR::ControlState *control_state,
     Xlen xlen,
     ConfigIsaWord isa_word,
-    MachineConfig::HazardUnit hazard_unit)
+    MachineConfig::HazardUnit hazard_unit,
+    bool memory_timing)
     : Core(regs, predictor, mem_program, mem_data, control_state, xlen, isa_word) {
     this->hazard_unit = hazard_unit;
+    this->memory_timing = memory_timing;
     reset();
 }
 
 void CorePipelined::do_step(bool skip_break) {
     Pipeline &p = state.pipeline;
 
+    if (memory_wait > 0) {
+        /* Data memory access is blocking, no stage advances and the state is kept. */
+        memory_wait--;
+        hw_counters.cycle++;
+        p.execute.internal.stall_status = 3; // for visualization
+        state.stall_count++;
+        state.memory_stall_count++;
+        return;
+    }
+    if (memory_timing) {
+        /* Accesses of debugger or GUI since the last cycle are not waited for. */
+        mem_data->take_access_latency();
+        mem_program->take_access_latency();
+    }
+
     const Address jump_branch_pc = mem_wb.inst_addr;
     const FetchInterstage saved_if_id = if_id;
 
     p.writeback = writeback(mem_wb);
     p.memory = memory(ex_mem);
+    if (memory_timing) { memory_wait = mem_data->take_access_latency(); }
     p.execute = execute(id_ex);
     p.decode = decode(if_id);
-    p.fetch = fetch(pc_if, skip_break);
+    p.fetch = fetch_with_latency(skip_break);
 
     bool exception_in_progress = mem_wb.excause != EXCAUSE_NONE;
     if (exception_in_progress) { ex_mem.flush(); }
@@ -811,6 +1139,7 @@ void CorePipelined::do_step(bool skip_break) {
         handle_exception(
             mem_wb.excause, mem_wb.inst, mem_wb.inst_addr, mem_wb.computed_next_inst_addr,
             jump_branch_pc, mem_wb.mem_addr);
+        cancel_fetch_wait();
     } else if (detect_mispredicted_jump() || mem_wb.csr_written) {
         /* If the jump was predicted incorrectly or csr register was written, we need to flush the
          * pipeline. */
@@ -821,9 +1150,14 @@ void CorePipelined::do_step(bool skip_break) {
          * To make the visualization cleaner we stop fetching (and PC update) until the exception
          * is handled. */
         pc_if.stop_if = true;
+        cancel_fetch_wait();
     } else if (stall || is_stall_requested()) {
         /* Fetch from the same PC is repeated due to stall in the pipeline. */
         handle_stall(saved_if_id);
+    } else if (fetch_wait > 0) {
+        /* IF waits for instruction memory, PC is kept. */
+        state.stall_count++;
+        state.memory_stall_count++;
     } else {
         /* Normal execution. */
         regs->write_pc(if_id.predicted_next_inst_addr);
@@ -835,6 +1169,28 @@ void CorePipelined::flush_and_continue_from_address(Address next_pc) {
     if_id.flush();
     id_ex.flush();
     ex_mem.flush();
+    cancel_fetch_wait();
+}
+
+FetchState CorePipelined::fetch_with_latency(bool skip_break) {
+    if (fetch_wait == 0) {
+        FetchState fetched = fetch(pc_if, skip_break);
+        if (memory_timing) { fetch_wait = mem_program->take_access_latency(); }
+        if (fetch_wait == 0) { return fetched; }
+        pending_fetch = fetched;
+    } else {
+        hw_counters.cycle++;
+        if (--fetch_wait == 0) { return pending_fetch; }
+    }
+    /* Fetched instruction is visualized, but IF/ID holds a bubble until memory responds. If the
+     * instruction is not accepted after the wait (stall), it is fetched again (now a hit). */
+    FetchState waiting = pending_fetch;
+    waiting.final.flush();
+    return waiting;
+}
+
+void CorePipelined::cancel_fetch_wait() {
+    fetch_wait = 0;
 }
 
 void CorePipelined::handle_stall(const FetchInterstage &saved_if_id) {
@@ -914,6 +1270,9 @@ bool CorePipelined::handle_data_hazards() {
 
 void CorePipelined::do_reset() {
     state.pipeline = {};
+    memory_wait = 0;
+    fetch_wait = 0;
+    pending_fetch = {};
 }
 
 bool StopExceptionHandler::handle_exception(
@@ -3,6 +3,7 @@
 
 #include "common/memory_ownership.h"
 #include "core/core_state.h"
+#include "core/decode_cache.h"
 #include "csr/controlstate.h"
 #include "instruction.h"
 #include "machineconfig.h"
@@ -15,6 +16,10 @@
 #include "simulator_exception.h"
 
 #include <QObject>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace machine {
 
@@ -35,12 +40,14 @@ public:
         CSR::ControlState *control_state,
         Xlen xlen,
         ConfigIsaWord isa_word);
+    ~Core() override;
 
     void step(bool skip_break = false);
     void reset(); // Reset core (only core, memory and registers has to be reset separately).
 
     unsigned get_cycle_count() const;
     unsigned get_stall_count() const;
+    unsigned get_memory_stall_count() const;
 
     Registers *get_regs() const;
     CSR::ControlState *get_control_state() const;
@@ -73,6 +80,21 @@ public:
      */
     uint64_t get_xlen_from_reg(RegisterValue reg) const;
 
+    const DecodeCache &get_decode_cache() const;
+
+    /**
+     * Headless core does not emit step_started and emits step_done only once per given number
+     * of cycles (never, when the interval is zero). Observers are expected to pull the state.
+     */
+    void set_headless(bool value, unsigned step_done_interval = 0);
+    bool is_headless() const;
+
+    /**
+     * Cores retiring many instructions in one step end the step at this cycle count, so a limit
+     * checked after each step is not overshot. Zero means no limit.
+     */
+    void set_cycle_limit(unsigned limit);
+
 protected:
     CoreState state {};
 
@@ -128,6 +150,14 @@ protected:
     QMap<Address, OWNED hwBreak *> hw_breaks {};
     QMap<ExceptionCause, OWNED ExceptionHandler *> ex_handlers;
     Box<ExceptionHandler> ex_default_handler;
+    /** Predecoded instruction templates, used by decode stage to skip instruction map walk. */
+    DecodeCache decode_cache;
+    /** Cycle and retired instruction counters, mcycle and minstret CSRs are derived from them. */
+    CSR::HardwareCounters hw_counters {};
+    bool headless = false;
+    unsigned step_done_interval = 0;
+    unsigned last_step_done_cycle = 0;
+    unsigned cycle_limit = 0;
 
     FetchState fetch(PCInterstage pc, bool skip_break);
     DecodeState decode(const FetchInterstage &);
@@ -166,10 +196,109 @@ protected:
     void do_step(bool skip_break) override;
     void do_reset() override;
 
-private:
     Address prev_inst_addr {};
 };
 
+/**
+ * Non-pipelined core executing translated basic blocks.
+ *
+ * Guest basic blocks are translated into arrays of operations with pre-bound handlers and
+ * executed without building the per-stage interstage structures. Successor blocks are chained
+ * directly. Any instruction which is not handled by a threaded handler (CSR access, system
+ * instructions, AMO, fences, illegal instructions), instruction with pending interrupt or
+ * hardware breakpoint and any memory access ending with page fault is executed by the generic
+ * path of `CoreSingle`, so the architectural state is the same as with `CoreSingle`.
+ *
+ * Instruction fetches are done once at translation time, therefore program cache and program
+ * TLB statistics do not match `CoreSingle`. Stage visualization and tracing reflect only
+ * instructions executed by the generic path. A single step may retire up to
+ * `STEP_INSTRUCTION_LIMIT` instructions, but it does not run past the cycle limit.
+ */
+class CoreThreaded : public CoreSingle {
+public:
+    CoreThreaded(
+        Registers *regs,
+        BranchPredictor *predictor,
+        FrontendMemory *mem_program,
+        FrontendMemory *mem_data,
+        CSR::ControlState *control_state,
+        Xlen xlen,
+        ConfigIsaWord isa_word);
+
+    /** Drops all translated blocks. Has to be called when code memory is modified externally. */
+    void invalidate_translations();
+
+    [[nodiscard]] size_t get_translated_block_count() const { return blocks.size(); }
+
+    static constexpr unsigned MAX_BLOCK_LENGTH = 64;
+    /** All blocks are dropped at the next step, when there are more of them. */
+    static constexpr size_t MAX_BLOCKS = 1024;
+    static constexpr unsigned STEP_INSTRUCTION_LIMIT = 1024;
+    /** Blocks never cross the boundary of the smallest page. */
+    static constexpr uint64_t PAGE_SIZE = 0x1000;
+
+protected:
+    void do_step(bool skip_break) override;
+    void do_reset() override;
+
+private:
+    struct ThreadedOp;
+    /** Returns false when the operation has to be executed by the generic path instead. */
+    using ThreadedHandler = bool (*)(CoreThreaded &core, const ThreadedOp &op);
+
+    struct ThreadedOp {
+        ThreadedHandler handler;
+        Instruction inst;
+        Address inst_addr;
+        Address next_inst_addr;
+        RegisterValue immediate;
+        AluCombinedOp aluop;
+        AluComponent alu_component;
+        AccessControl memctl;
+        RegisterId num_rs;
+        RegisterId num_rt;
+        RegisterId num_rd;
+        bool regwrite;
+        bool alusrc;
+        bool alu_pc;
+        bool alu_mod;
+        bool w_operation;
+        bool branch_val;
+    };
+
+    struct ThreadedBlock {
+        Address start_addr;
+        /** Address following the last operation of the block. */
+        Address end_addr;
+        std::vector<ThreadedOp> ops;
+        /** Chained successors, [0] for fall-through and [1] for the last taken target. */
+        std::array<ThreadedBlock *, 2> chain { nullptr, nullptr };
+    };
+
+    std::unordered_map<uint64_t, std::unique_ptr<ThreadedBlock>> blocks;
+    /** Address range covered by translated blocks, used to detect self-modifying code. */
+    uint64_t code_first = UINT64_MAX;
+    uint64_t code_last = 0;
+    bool translations_stale = false;
+    /** Next PC computed by the last control transfer operation. */
+    Address taken_next_pc;
+
+    void release_translations();
+    ThreadedBlock *find_block(ThreadedBlock *prev, Address pc);
+    std::unique_ptr<ThreadedBlock> translate(Address start_addr);
+    ThreadedHandler select_handler(const PredecodedInstruction &pre) const;
+    void after_generic_step();
+    void check_code_write(uint64_t addr);
+
+    RegisterValue threaded_alu(const ThreadedOp &op) const;
+    static bool exec_alu(CoreThreaded &core, const ThreadedOp &op);
+    static bool exec_load(CoreThreaded &core, const ThreadedOp &op);
+    static bool exec_store(CoreThreaded &core, const ThreadedOp &op);
+    static bool exec_branch(CoreThreaded &core, const ThreadedOp &op);
+    static bool exec_jal(CoreThreaded &core, const ThreadedOp &op);
+    static bool exec_jalr(CoreThreaded &core, const ThreadedOp &op);
+};
+
 class CorePipelined : public Core {
 public:
     CorePipelined(
@@ -182,7 +311,8 @@ public:
         ConfigIsaWord isa_word,
         // Default value is used to keep same interface as core single.
         // Forward was chosen as the most conservative variant (regarding correctness).
-        MachineConfig::HazardUnit hazard_unit = MachineConfig::HazardUnit::HU_STALL_FORWARD);
+        MachineConfig::HazardUnit hazard_unit = MachineConfig::HazardUnit::HU_STALL_FORWARD,
+        bool memory_timing = false);
 
 protected:
     void do_step(bool skip_break) override;
@@ -190,6 +320,18 @@ protected:
 
 private:
     MachineConfig::HazardUnit hazard_unit;
+    /** Stages wait for latency of memory accesses (see `FrontendMemory::take_access_latency`). */
+    bool memory_timing;
+    /** Remaining cycles the whole pipeline waits for data memory access of MEM stage. */
+    uint32_t memory_wait = 0;
+    /** Remaining cycles IF waits for instruction memory, `pending_fetch` is passed on then. */
+    uint32_t fetch_wait = 0;
+    FetchState pending_fetch;
+
+    /** IF stage including the wait for instruction memory. */
+    FetchState fetch_with_latency(bool skip_break);
+    /** Abandon instruction fetch in progress (pipeline flush). */
+    void cancel_fetch_wait();
 
     bool handle_data_hazards();
     bool detect_mispredicted_jump() const;
@@ -8,6 +8,7 @@
 #include "machine/predictor.h"
 
 #include <QVector>
+#include <algorithm>
 
 using std::vector;
 
@@ -664,6 +665,10 @@ void TestCore::pipecorestall_alu_forward_data() {
     core_alu_forward_data();
 }
 
+void TestCore::threadedcore_alu_forward_data() {
+    core_alu_forward_data();
+}
+
 static void run_code_fragment(
     Core &core,
     Registers &reg_init,
@@ -714,6 +719,24 @@ void TestCore::singlecore_alu_forward() {
     run_code_fragment(core, reg_init, reg_res, mem_init, mem_res, code);
 }
 
+void TestCore::threadedcore_alu_forward() {
+    QFETCH(QVector<uint32_t>, code);
+    QFETCH(Registers, reg_init);
+    QFETCH(Registers, reg_res);
+    Memory mem_init(LITTLE);
+    TrivialBus mem_init_frontend(&mem_init);
+    Memory mem_res(LITTLE);
+    TrivialBus mem_res_frontend(&mem_res);
+
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+
+    CoreThreaded core(
+        &reg_init, &predictor, &mem_init_frontend, &mem_init_frontend, &controlst, Xlen::_32,
+        config_isa_word_default);
+    run_code_fragment(core, reg_init, reg_res, mem_init, mem_res, code);
+}
+
 void TestCore::pipecore_alu_forward() {
     QFETCH(QVector<uint32_t>, code);
     QFETCH(Registers, reg_init);
@@ -942,6 +965,10 @@ void TestCore::pipecore_wb_memory_tests_data() {
     core_memory_tests_data();
 }
 
+void TestCore::threadedcore_memory_tests_data() {
+    core_memory_tests_data();
+}
+
 void TestCore::singlecore_memory_tests() {
     QFETCH(QVector<uint32_t>, code);
     QFETCH(Registers, reg_init);
@@ -960,6 +987,24 @@ void TestCore::singlecore_memory_tests() {
     run_code_fragment(core, reg_init, reg_res, mem_init, mem_res, code);
 }
 
+void TestCore::threadedcore_memory_tests() {
+    QFETCH(QVector<uint32_t>, code);
+    QFETCH(Registers, reg_init);
+    QFETCH(Registers, reg_res);
+    QFETCH(Memory, mem_init);
+    QFETCH(Memory, mem_res);
+    TrivialBus mem_init_frontend(&mem_init);
+    TrivialBus mem_res_frontend(&mem_res);
+
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+
+    CoreThreaded core(
+        &reg_init, &predictor, &mem_init_frontend, &mem_init_frontend, &controlst, Xlen::_32,
+        config_isa_word_default);
+    run_code_fragment(core, reg_init, reg_res, mem_init, mem_res, code);
+}
+
 void TestCore::pipecore_nc_memory_tests() {
     QFETCH(QVector<uint32_t>, code);
     QFETCH(Registers, reg_init);
@@ -1057,6 +1102,238 @@ void TestCore::pipecore_wb_memory_tests() {
     run_code_fragment(core, reg_init, reg_res, mem_init, mem_res, code);
 }
 
+void TestCore::pipecore_memory_timing() {
+    Memory memory_backend(LITTLE);
+    TrivialBus memory(&memory_backend);
+    CacheConfig cache_conf;
+    cache_conf.set_enabled(true);
+    cache_conf.set_set_count(4);
+    cache_conf.set_block_size(2);
+    cache_conf.set_associativity(1);
+    cache_conf.set_replacement_policy(CacheConfig::RP_LRU);
+    cache_conf.set_write_policy(CacheConfig::WP_BACK);
+    Cache d_cache(&memory, &cache_conf, 10, 10);
+
+    Registers registers {};
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+    CorePipelined core(
+        &registers, &predictor, &memory, &d_cache, &controlst, Xlen::_32, config_isa_word_default,
+        MachineConfig::HazardUnit::HU_STALL_FORWARD, true);
+
+    vector<QString> program { "addi x1, x0, 0x400", "addi x2, x0, 7", "sw x2, 0(x1)",
+                              "lw x10, 4(x1)",      "lw x11, 0(x1)",  "add x10, x10, x11" };
+    program.insert(program.end(), 64, "nop");
+    memory.write_u32(0x404_addr, 35);
+    compile_simple_program(memory, 0x200_addr, program);
+    for (size_t i = 0; i < 60; i++) {
+        core.step();
+    }
+
+    QCOMPARE(registers.read_gp(10).as_u32(), 42u);
+    // Instruction fetch has no latency, all memory stalls are spent on data cache misses.
+    QVERIFY(d_cache.get_stall_count() > 0);
+    QCOMPARE(core.get_memory_stall_count(), d_cache.get_stall_count());
+    QVERIFY(core.get_stall_count() > core.get_memory_stall_count());
+}
+
+void TestCore::pipecore_fetch_timing() {
+    CacheConfig cache_conf;
+    cache_conf.set_enabled(true);
+    cache_conf.set_set_count(4);
+    cache_conf.set_block_size(2);
+    cache_conf.set_associativity(1);
+    cache_conf.set_replacement_policy(CacheConfig::RP_LRU);
+    cache_conf.set_write_policy(CacheConfig::WP_BACK);
+
+    // No data hazards, every stall of the timed core waits for the instruction cache.
+    vector<QString> program { "addi x1, x0, 5", "addi x2, x0, 7", "add x10, x1, x2" };
+    program.insert(program.end(), 64, "nop");
+
+    struct Run {
+        uint32_t result;
+        unsigned cycles, stalls, memory_stalls, cache_stalls;
+    };
+    const auto run = [&](bool memory_timing) {
+        Memory memory_backend(LITTLE);
+        TrivialBus memory(&memory_backend);
+        compile_simple_program(memory, 0x200_addr, program);
+        Cache i_cache(&memory, &cache_conf, 10, 10);
+
+        Registers registers {};
+        BranchPredictor predictor {};
+        CSR::ControlState controlst {};
+        CorePipelined core(
+            &registers, &predictor, &i_cache, &memory, &controlst, Xlen::_32,
+            config_isa_word_default, MachineConfig::HazardUnit::HU_STALL_FORWARD, memory_timing);
+        while (registers.read_gp(10).as_u32() != 12 && core.get_cycle_count() < 200) {
+            core.step();
+        }
+        return Run { registers.read_gp(10).as_u32(), core.get_cycle_count(),
+                     core.get_stall_count(), core.get_memory_stall_count(),
+                     i_cache.get_stall_count() };
+    };
+
+    const Run untimed = run(false);
+    QCOMPARE(untimed.result, 12u);
+    QCOMPARE(untimed.memory_stalls, 0u);
+    QVERIFY(untimed.cache_stalls > 0);
+
+    const Run timed = run(true);
+    QCOMPARE(timed.result, 12u);
+    QVERIFY(timed.memory_stalls > 0);
+    QCOMPARE(timed.stalls, timed.memory_stalls);
+    // Fetch of a following instruction may still be waiting.
+    QVERIFY(timed.memory_stalls <= timed.cache_stalls);
+    QVERIFY(timed.cycles > untimed.cycles);
+}
+
+void TestCore::singlecore_decode_cache_self_modifying() {
+    Memory memory_backend(LITTLE);
+    TrivialBus memory(&memory_backend);
+    Registers registers {};
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+    CoreSingle core(
+        &registers, &predictor, &memory, &memory, &controlst, Xlen::_32, config_isa_word_default);
+
+    // The store replaces the first instruction by "addi x10, x10, 100".
+    compile_simple_program(memory, 0x200_addr, { "addi x10, x10, 1", "sw x4, 0(x5)" });
+    registers.write_gp(4, 0x06450513);
+    registers.write_gp(5, 0x200);
+    registers.write_pc(0x200_addr);
+    core.step();
+    core.step();
+    QCOMPARE(registers.read_gp(10).as_u32(), 1u);
+    QCOMPARE(memory.read_u32(0x200_addr), 0x06450513u);
+
+    // No fence.i, the cached template of the old word must not be used.
+    registers.write_pc(0x200_addr);
+    core.step();
+    QCOMPARE(registers.read_gp(10).as_u32(), 101u);
+    QCOMPARE(core.get_decode_cache().get_miss_count(), uint64_t(3));
+    QCOMPARE(core.get_decode_cache().get_hit_count(), uint64_t(0));
+
+    // Store of the same word keeps the new template.
+    core.step();
+    registers.write_pc(0x200_addr);
+    core.step();
+    QCOMPARE(registers.read_gp(10).as_u32(), 201u);
+    QCOMPARE(core.get_decode_cache().get_miss_count(), uint64_t(3));
+    QCOMPARE(core.get_decode_cache().get_hit_count(), uint64_t(2));
+}
+
+void TestCore::threadedcore_block_limit() {
+    Memory memory_backend(LITTLE);
+    TrivialBus memory(&memory_backend);
+    // Straight code of "addi x10, x10, 1" split into blocks of the maximal length, followed by
+    // "jal x0, 0" looping in place.
+    const uint32_t count = (CoreThreaded::MAX_BLOCKS + 16) * CoreThreaded::MAX_BLOCK_LENGTH;
+    const Address code_start = 0x1000_addr;
+    const Address code_end = code_start + count * 4;
+    for (uint32_t i = 0; i < count; i++) {
+        memory.write_u32(code_start + i * 4, 0x00150513);
+    }
+    memory.write_u32(code_end, 0x0000006f);
+
+    Registers registers {};
+    registers.write_pc(code_start);
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+    CoreThreaded core(
+        &registers, &predictor, &memory, &memory, &controlst, Xlen::_32, config_isa_word_default);
+    size_t max_blocks = 0;
+    for (int steps = 0; registers.read_pc() != code_end && steps < 1000; steps++) {
+        core.step();
+        max_blocks = std::max(max_blocks, core.get_translated_block_count());
+    }
+    QCOMPARE(registers.read_pc().get_raw(), code_end.get_raw());
+    QCOMPARE(registers.read_gp(10).as_u32(), count);
+    // Block translated over the limit is still executed before all are dropped.
+    QCOMPARE(max_blocks, CoreThreaded::MAX_BLOCKS + 1);
+    QVERIFY(core.get_translated_block_count() <= CoreThreaded::MAX_BLOCKS + 1);
+
+    core.reset();
+    QCOMPARE(core.get_translated_block_count(), size_t(0));
+}
+
+void TestCore::threadedcore_cycle_limit() {
+    Memory memory_backend(LITTLE);
+    TrivialBus memory(&memory_backend);
+    // Straight code of "addi x10, x10, 1", longer than a single step.
+    const Address code_start = 0x1000_addr;
+    for (uint32_t i = 0; i < 2 * CoreThreaded::STEP_INSTRUCTION_LIMIT; i++) {
+        memory.write_u32(code_start + i * 4, 0x00150513);
+    }
+
+    Registers registers {};
+    registers.write_pc(code_start);
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+    CoreThreaded core(
+        &registers, &predictor, &memory, &memory, &controlst, Xlen::_32, config_isa_word_default);
+    core.set_cycle_limit(100);
+    core.step();
+    QCOMPARE(core.get_cycle_count(), 100u);
+    QCOMPARE(registers.read_gp(10).as_u32(), 100u);
+
+    // Step has stopped in the middle of a block, the following one continues there. Past the
+    // limit, each step retires a single instruction.
+    core.step();
+    QCOMPARE(core.get_cycle_count(), 101u);
+    QCOMPARE(registers.read_gp(10).as_u32(), 101u);
+    QCOMPARE(registers.read_pc().get_raw(), (code_start + 101 * 4).get_raw());
+
+    core.set_cycle_limit(0);
+    core.step();
+    QCOMPARE(core.get_cycle_count(), 101u + CoreThreaded::STEP_INSTRUCTION_LIMIT);
+    QCOMPARE(registers.read_gp(10).as_u32(), 101u + CoreThreaded::STEP_INSTRUCTION_LIMIT);
+}
+
+void TestCore::singlecore_counters() {
+    Memory memory_backend(LITTLE);
+    TrivialBus memory(&memory_backend);
+    compile_simple_program(memory, 0x200_addr, vector<QString>(16, "nop"));
+    Registers registers {};
+    registers.write_pc(0x200_addr);
+    BranchPredictor predictor {};
+    CSR::ControlState controlst {};
+    const auto cycles
+        = [&controlst]() { return controlst.read_internal(CSR::Id::MCYCLE).as_u64(); };
+    const auto retired
+        = [&controlst]() { return controlst.read_internal(CSR::Id::MINSTRET).as_u64(); };
+    {
+        CoreSingle core(
+            &registers, &predictor, &memory, &memory, &controlst, Xlen::_32,
+            config_isa_word_default);
+        for (int i = 0; i < 3; i++) {
+            core.step();
+        }
+        QCOMPARE(cycles(), uint64_t(3));
+        QCOMPARE(retired(), uint64_t(3));
+        QCOMPARE(controlst.read_internal(CSR::Id::CYCLE).as_u64(), uint64_t(3));
+
+        // Software writes set the value, counting continues from it.
+        controlst.write(CSR::Address(0xB00), 100, CSR::PrivilegeLevel::MACHINE);
+        controlst.write(CSR::Address(0xB02), 50, CSR::PrivilegeLevel::MACHINE);
+        core.step();
+        core.step();
+        QCOMPARE(cycles(), uint64_t(102));
+        QCOMPARE(controlst.read_internal(CSR::Id::CYCLE).as_u64(), uint64_t(102));
+        QCOMPARE(retired(), uint64_t(52));
+
+        // Copy keeps the current values and does not count.
+        CSR::ControlState copy(controlst);
+        core.step();
+        QCOMPARE(cycles(), uint64_t(103));
+        QCOMPARE(copy.read_internal(CSR::Id::MCYCLE).as_u64(), uint64_t(102));
+        QCOMPARE(copy.read_internal(CSR::Id::MINSTRET).as_u64(), uint64_t(52));
+    }
+    // Destroyed core detaches, the values are kept.
+    QCOMPARE(cycles(), uint64_t(103));
+    QCOMPARE(retired(), uint64_t(53));
+}
+
 void extension_m_data() {
     QTest::addColumn<vector<QString>>("instructions");
     QTest::addColumn<Registers>("registers");
@@ -1110,6 +1387,10 @@ void TestCore::pipecore_extension_m_data() {
     extension_m_data();
 }
 
+void TestCore::threadedcore_extension_m_data() {
+    extension_m_data();
+}
+
 void TestCore::singlecore_extension_m() {
     test_program_with_single_result<CoreSingle>();
 }
@@ -1118,4 +1399,8 @@ void TestCore::pipecore_extension_m() {
     test_program_with_single_result<CorePipelined>();
 }
 
+void TestCore::threadedcore_extension_m() {
+    test_program_with_single_result<CoreThreaded>();
+}
+
 QTEST_APPLESS_MAIN(TestCore)
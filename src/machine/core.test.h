@@ -26,16 +26,26 @@ private slots:
     void pipecore_alu_forward_data();
     void pipecorestall_alu_forward();
     void pipecorestall_alu_forward_data();
+    void threadedcore_alu_forward();
+    void threadedcore_alu_forward_data();
     void singlecore_memory_tests_data();
     void pipecore_nc_memory_tests_data();
     void pipecore_wt_na_memory_tests_data();
     void pipecore_wt_a_memory_tests_data();
     void pipecore_wb_memory_tests_data();
+    void threadedcore_memory_tests_data();
     void singlecore_memory_tests();
     void pipecore_nc_memory_tests();
     void pipecore_wt_na_memory_tests();
     void pipecore_wt_a_memory_tests();
     void pipecore_wb_memory_tests();
+    void threadedcore_memory_tests();
+    void pipecore_memory_timing();
+    void pipecore_fetch_timing();
+    void singlecore_decode_cache_self_modifying();
+    void threadedcore_block_limit();
+    void threadedcore_cycle_limit();
+    void singlecore_counters();
 
     // Extensions:
     // =============================================================================================
@@ -43,8 +53,10 @@ private slots:
     // RV32M
     void singlecore_extension_m_data();
     void pipecore_extension_m_data();
+    void threadedcore_extension_m_data();
     void singlecore_extension_m();
     void pipecore_extension_m();
+    void threadedcore_extension_m();
 };
 
 #endif // CORE_TEST_H
@@ -17,6 +17,8 @@ struct CoreState {
     Pipeline pipeline = {};
     AddressRange LoadReservedRange;
     uint32_t stall_count = 0;
+    /** Part of `stall_count` spent waiting for memory (memory timing only). */
+    uint32_t memory_stall_count = 0;
     uint32_t cycle_count = 0;
     unsigned current_privilege_u = static_cast<unsigned>(CSR::PrivilegeLevel::MACHINE);
     unsigned current_asid_u = 0u;
@@ -0,0 +1,118 @@
+#ifndef QTRVSIM_DECODE_CACHE_H
+#define QTRVSIM_DECODE_CACHE_H
+
+#include "csr/address.h"
+#include "instruction.h"
+#include "memory/address.h"
+#include "registers.h"
+
+#include <array>
+#include <cstdint>
+
+namespace machine {
+
+/**
+ * Part of the decode stage result, which depends only on the instruction word.
+ *
+ * Everything that depends on the architectural state (register values, CSR values, current
+ * privilege level) is NOT part of this template and has to be resolved by the core on every
+ * decode.
+ */
+struct PredecodedInstruction {
+    /** Raw instruction word, this template was produced from. */
+    uint32_t inst_data = 0;
+    InstructionFlags flags = InstructionFlags(0);
+    AluCombinedOp alu_op {};
+    AccessControl mem_ctl = AC_NONE;
+    RegisterId num_rs = 0;
+    RegisterId num_rt = 0;
+    RegisterId num_rd = 0;
+    int32_t immediate = 0;
+    uint16_t csr_address = 0;
+    CSR::PrivilegeLevel xret_privlev = CSR::PrivilegeLevel::UNPRIVILEGED;
+
+    PredecodedInstruction() = default;
+
+    explicit PredecodedInstruction(const Instruction &inst) : inst_data(inst.data()) {
+        inst.flags_alu_op_mem_ctl(flags, alu_op, mem_ctl);
+        if (flags & IMF_XRET) {
+            if (flags & IMF_PRIV_M) {
+                xret_privlev = CSR::PrivilegeLevel::MACHINE;
+            } else if (flags & IMF_PRIV_H) {
+                xret_privlev = CSR::PrivilegeLevel::HYPERVISOR;
+            } else if (flags & IMF_PRIV_S) {
+                xret_privlev = CSR::PrivilegeLevel::SUPERVISOR;
+            }
+        }
+        // When instruction does not specify register, it is set to x0 as operations on x0 have
+        // no side effects (not even visualization).
+        num_rs = (flags & (IMF_ALU_REQ_RS | IMF_ALU_RS_ID)) ? inst.rs() : 0;
+        num_rt = (flags & IMF_ALU_REQ_RT) ? inst.rt() : 0;
+        num_rd = (flags & IMF_REGWRITE) ? inst.rd() : 0;
+        immediate = inst.immediate();
+        csr_address = (flags & IMF_CSR) ? inst.csr_address().data : 0;
+    }
+};
+
+/**
+ * Direct mapped cache of predecoded instructions used by the decode stage.
+ *
+ * Entries are indexed by the instruction address and tagged by both the address and the raw
+ * instruction word. As the template is a pure function of the instruction word, an entry can
+ * never be stale with respect to the memory content, even for self-modifying code or when
+ * the address translation changes. Explicit flush is still done on fence.i/sfence.vma and core
+ * reset to drop entries, which are not going to be used anymore.
+ */
+class DecodeCache {
+public:
+    static constexpr unsigned INDEX_BITS = 10;
+    static constexpr size_t SIZE = size_t(1) << INDEX_BITS;
+
+    /**
+     * Returns predecoded template for instruction at given address.
+     * The template is created on miss.
+     */
+    const PredecodedInstruction &lookup(Address inst_addr, const Instruction &inst) {
+        const uint64_t addr = inst_addr.get_raw();
+        Entry &entry = entries[(addr >> 2) & (SIZE - 1)];
+        if (!entry.valid || entry.addr != addr || entry.decoded.inst_data != inst.data()) {
+            entry.decoded = PredecodedInstruction(inst);
+            entry.addr = addr;
+            entry.valid = true;
+            miss_count++;
+        } else {
+            hit_count++;
+        }
+        return entry.decoded;
+    }
+
+    void flush() {
+        for (auto &entry : entries) {
+            entry.valid = false;
+        }
+    }
+
+    void reset() {
+        flush();
+        hit_count = 0;
+        miss_count = 0;
+    }
+
+    [[nodiscard]] uint64_t get_hit_count() const { return hit_count; }
+    [[nodiscard]] uint64_t get_miss_count() const { return miss_count; }
+
+private:
+    struct Entry {
+        uint64_t addr = 0;
+        bool valid = false;
+        PredecodedInstruction decoded {};
+    };
+
+    std::array<Entry, SIZE> entries {};
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+};
+
+} // namespace machine
+
+#endif // QTRVSIM_DECODE_CACHE_H
@@ -22,7 +22,12 @@ namespace machine { namespace CSR {
     ControlState::ControlState(const ControlState &other)
         : QObject(this->parent())
         , xlen(other.xlen)
-        , register_data(other.register_data) {}
+        , register_data(other.register_data) {
+        // Copy does not share the counter source, it keeps the current counter values.
+        register_data[Id::CYCLE] = other.read_internal(Id::CYCLE);
+        register_data[Id::MCYCLE] = other.read_internal(Id::MCYCLE);
+        register_data[Id::MINSTRET] = other.read_internal(Id::MINSTRET);
+    }
 
     void ControlState::reset() {
         std::transform(
@@ -42,6 +47,22 @@ namespace machine { namespace CSR {
             write_field_raw(Field::mstatus::UXL, 2);
             write_field_raw(Field::mstatus::SXL, 2);
         }
+
+        if (counters != nullptr) {
+            cycle_offset = register_data[Id::MCYCLE].as_u64() - counters->cycle;
+            instret_offset = register_data[Id::MINSTRET].as_u64() - counters->instret;
+        }
+    }
+
+    void ControlState::attach_counters(const HardwareCounters *source) {
+        register_data[Id::CYCLE] = read_internal(Id::CYCLE);
+        register_data[Id::MCYCLE] = read_internal(Id::MCYCLE);
+        register_data[Id::MINSTRET] = read_internal(Id::MINSTRET);
+        counters = source;
+        if (counters != nullptr) {
+            cycle_offset = register_data[Id::MCYCLE].as_u64() - counters->cycle;
+            instret_offset = register_data[Id::MINSTRET].as_u64() - counters->instret;
+        }
     }
 
     size_t ControlState::get_register_internal_id(Address address) {
@@ -66,7 +87,7 @@ namespace machine { namespace CSR {
                     .arg(address.data),
                 "");
         }
-        RegisterValue value = register_data[reg_id];
+        RegisterValue value = read_internal(reg_id);
         DEBUG("Read CSR[%u] == 0x%" PRIx64, address.data, value.as_u64());
         emit read_signal(reg_id, value);
         return value;
@@ -155,9 +176,18 @@ namespace machine { namespace CSR {
         Q_UNUSED(desc)
         reg = val;
         register_data[Id::CYCLE] = val;
+        if (counters != nullptr) { cycle_offset = val.as_u64() - counters->cycle; }
         write_signal(Id::CYCLE, register_data[Id::CYCLE]);
     }
 
+    void ControlState::minstret_wlrl_write_handler(
+        const RegisterDesc &desc,
+        RegisterValue &reg,
+        RegisterValue val) {
+        default_wlrl_write_handler(desc, reg, val);
+        if (counters != nullptr) { instret_offset = reg.as_u64() - counters->instret; }
+    }
+
     void ControlState::sstatus_wlrl_write_handler(
         const RegisterDesc &desc,
         RegisterValue &reg,
@@ -181,7 +211,10 @@ namespace machine { namespace CSR {
     }
 
     bool ControlState::operator==(const ControlState &other) const {
-        return register_data == other.register_data;
+        for (size_t i = 0; i < Id::_COUNT; i++) {
+            if (read_internal(i) != other.read_internal(i)) { return false; }
+        }
+        return true;
     }
 
     bool ControlState::operator!=(const ControlState &c) const {
@@ -348,6 +381,14 @@ namespace machine { namespace CSR {
     }
 
     RegisterValue ControlState::read_internal(size_t internal_id) const {
+        if (counters != nullptr) {
+            switch (internal_id) {
+            case Id::CYCLE:
+            case Id::MCYCLE: return counters->cycle + cycle_offset;
+            case Id::MINSTRET: return counters->instret + instret_offset;
+            default: break;
+            }
+        }
         return register_data[internal_id];
     }
 
@@ -358,7 +399,7 @@ namespace machine { namespace CSR {
         write_signal(internal_id, reg);
     }
     void ControlState::increment_internal(size_t internal_id, uint64_t amount) {
-        auto value = register_data[internal_id];
+        auto value = read_internal(internal_id);
         write_internal(internal_id, value.as_u64() + amount);
     }
 }} // namespace machine::CSR
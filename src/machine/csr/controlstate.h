@@ -74,6 +74,16 @@ namespace machine { namespace CSR {
 
     struct RegisterDesc;
 
+    /**
+     * Free running hardware event counters. They are owned by the core and incremented there
+     * by plain integer increments. Counter CSRs (mcycle, minstret and their shadows) are derived
+     * from them on read, see ControlState::attach_counters.
+     */
+    struct HardwareCounters {
+        uint64_t cycle = 0;
+        uint64_t instret = 0;
+    };
+
     struct RegisterFieldDesc {
         uint64_t decode(uint64_t val) const { return field.decode(val); }
         uint64_t encode(uint64_t val) const { return field.encode(val); }
@@ -123,6 +133,16 @@ namespace machine { namespace CSR {
          * amount. */
         void increment_internal(size_t internal_id, uint64_t amount);
 
+        /**
+         * Derive counter CSRs from counters owned by the core.
+         *
+         * Counter CSR value is computed on read as the source counter plus an offset, which is
+         * updated only by software visible writes. Therefore, counting does not go through write
+         * handlers and does not emit write_signal. Current values are kept when the source is
+         * changed. Pass nullptr to detach (values are then stored in the register data again).
+         */
+        void attach_counters(const HardwareCounters *source);
+
         /** Reset data to initial values */
         void reset();
 
@@ -174,6 +194,11 @@ namespace machine { namespace CSR {
          */
         std::array<RegisterValue, Id::_COUNT> register_data;
 
+        /** Source of counter CSRs. When null, counters are stored in register_data. */
+        const HardwareCounters *counters = nullptr;
+        uint64_t cycle_offset = 0;
+        uint64_t instret_offset = 0;
+
     public:
         void
         default_wlrl_write_handler(const RegisterDesc &desc, RegisterValue &reg, RegisterValue val);
@@ -186,6 +211,8 @@ namespace machine { namespace CSR {
         void
         mcycle_wlrl_write_handler(const RegisterDesc &desc, RegisterValue &reg, RegisterValue val);
         void
+        minstret_wlrl_write_handler(const RegisterDesc &desc, RegisterValue &reg, RegisterValue val);
+        void
         sstatus_wlrl_write_handler(const RegisterDesc &desc, RegisterValue &reg, RegisterValue val);
     };
 
@@ -329,7 +356,9 @@ namespace machine { namespace CSR {
           [Id::MCYCLE]
           = { "mcycle", 0xB00_csr, "Machine cycle counter.", 0,
               (register_storage_t)0xffffffffffffffff, &ControlState::mcycle_wlrl_write_handler },
-          [Id::MINSTRET] = { "minstret", 0xB02_csr, "Machine instructions-retired counter." },
+          [Id::MINSTRET]
+          = { "minstret", 0xB02_csr, "Machine instructions-retired counter.", 0,
+              (register_storage_t)0xffffffffffffffff, &ControlState::minstret_wlrl_write_handler },
           // Supervisor-level CSRs
           [Id::SSTATUS] = { "sstatus", 0x100_csr, "Supervisor status register.", 0, 0xffffffff,
                             &ControlState::sstatus_wlrl_write_handler },
@@ -1,11 +1,16 @@
 #include "machine.h"
 
+#include "common/logging.h"
+#include "program_image_cache.h"
 #include "programloader.h"
 
 #include <QTime>
+#include <algorithm>
 #include <qelapsedtimer.h>
 #include <utility>
 
+LOG_CATEGORY("machine.machine");
+
 using namespace machine;
 
 Machine::Machine(MachineConfig config, bool load_symtab, bool load_executable)
@@ -13,30 +18,27 @@ Machine::Machine(MachineConfig config, bool load_symtab, bool load_executable)
     , stat(ST_READY) {
     regs.reset(new Registers());
     if (load_executable) {
-        ProgramLoader program(machine_config.elf());
-        this->machine_config.set_simulated_endian(program.get_endian());
-        mem_program_only.reset(new Memory(machine_config.get_simulated_endian()));
-        program.to_memory(mem_program_only.data());
+        auto image = ProgramImageCache::instance().load(machine_config.elf());
+        this->machine_config.set_simulated_endian(image->endian);
+        // Sections of the cached image are shared copy-on-write.
+        mem_program_only.reset(new Memory(*image->memory));
 
-        if (program.get_architecture_type() == ARCH64)
+        if (image->architecture == ARCH64)
             this->machine_config.set_simulated_xlen(Xlen::_64);
         else
             this->machine_config.set_simulated_xlen(Xlen::_32);
 
-        if (load_symtab) { symtab.reset(program.get_symbol_table()); }
+        if (load_symtab) { shared_symtab = image->symbol_table; }
 
-        program_end = program.end();
-        if (program.get_executable_entry() != 0x0_addr) {
-            regs->write_pc(program.get_executable_entry());
-        }
+        program_end = image->end;
+        if (image->entry != 0x0_addr) { regs->write_pc(image->entry); }
         mem.reset(new Memory(*mem_program_only));
     } else {
         mem.reset(new Memory(machine_config.get_simulated_endian()));
     }
 
     data_bus.reset(new MemoryDataBus(machine_config.get_simulated_endian()));
-    data_bus->insert_device_to_range(mem.data(), 0x00000000_addr, 0xefffffff_addr, false);
-
+    // Peripherals go first, so a mapped file cannot take their place.
     setup_serial_port();
     setup_perip_spi_led();
     setup_lcd_display();
@@ -44,26 +46,57 @@ Machine::Machine(MachineConfig config, bool load_symtab, bool load_executable)
     setup_aclint_mswi();
     setup_aclint_sswi();
 
+    setup_mapped_files();
+    // RAM ranges of the physical address space, including mapped files within them.
+    std::vector<std::pair<Address, Address>> ram_ranges = { { 0x00000000_addr, 0xefffffff_addr } };
+    if (machine_config.flat_ram()) { setup_flat_ram(); }
+    if (flat_mem.isNull()) { insert_ram_range(mem.data(), 0x00000000_addr, 0xefffffff_addr); }
+    if (machine_config.get_simulated_xlen() == Xlen::_64) {
+        // Physical address space above the 32-bit peripheral window is RAM too. Memory offsets
+        // equal physical addresses, so the program image and page tables can be placed there.
+        ram_ranges.emplace_back(0x100000000_addr, Address((1ULL << MEMORY_ADDRESS_BITS) - 1));
+        insert_ram_range(mem.data(), ram_ranges.back().first, ram_ranges.back().second);
+    }
+
     unsigned access_time_read = machine_config.memory_access_time_read();
     unsigned access_time_write = machine_config.memory_access_time_write();
     unsigned access_time_burst = machine_config.memory_access_time_burst();
     bool access_enable_burst = machine_config.memory_access_enable_burst();
 
-    cch_level2.reset(new Cache(
-        data_bus.data(), &machine_config.cache_level2(), access_time_read, access_time_write,
-        access_time_burst, access_enable_burst));
-    if (machine_config.cache_level2().enabled()) {
-        access_time_read = machine_config.memory_access_time_level2();
-        access_time_write = machine_config.memory_access_time_level2();
+    FrontendMemory *last_level_mem = data_bus.data();
+    if (machine_config.dram().enabled()) {
+        // DRAM model replaces the flat memory access times.
+        // Peripherals are not behind the controller.
+        dram.reset(new DramController(data_bus.data(), &machine_config.dram(), ram_ranges));
+        last_level_mem = dram.data();
+        access_time_read = 1;
+        access_time_write = 1;
         access_time_burst = 0;
-        access_enable_burst = true;
+        access_enable_burst = false;
+    }
+    // Hierarchy is built from the last level up. Each cache pays access time of the nearest
+    // enabled level below it.
+    cch_shared.resize(machine_config.cache_level_count() - 1);
+    for (unsigned level = machine_config.cache_level_count(); level >= 2; level--) {
+        const CacheConfig &config = machine_config.cache_level(level);
+        cch_shared[level - 2].reset(new Cache(
+            last_level_mem, &config, access_time_read, access_time_write, access_time_burst,
+            access_enable_burst));
+        last_level_mem = cch_shared[level - 2].get();
+        if (config.enabled()) {
+            access_time_read = machine_config.memory_access_time_level(level);
+            access_time_write = machine_config.memory_access_time_level(level);
+            access_time_burst = 0;
+            access_enable_burst = true;
+        }
     }
     cch_program.reset(new Cache(
-        cch_level2.data(), &machine_config.cache_program(), access_time_read, access_time_write,
+        last_level_mem, &machine_config.cache_program(), access_time_read, access_time_write,
         access_time_burst, access_enable_burst));
     cch_data.reset(new Cache(
-        cch_level2.data(), &machine_config.cache_data(), access_time_read, access_time_write,
+        last_level_mem, &machine_config.cache_data(), access_time_read, access_time_write,
         access_time_burst, access_enable_burst));
+    link_cache_levels();
 
     controlst.reset(
         new CSR::ControlState(machine_config.get_simulated_xlen(), machine_config.get_isa_word()));
@@ -89,16 +122,30 @@ Machine::Machine(MachineConfig config, bool load_symtab, bool load_executable)
         machine_config.get_bp_init_state(), machine_config.get_bp_btb_bits(),
         machine_config.get_bp_bhr_bits(), machine_config.get_bp_bht_addr_bits()));
 
+    if (machine_config.memory_timing() && !machine_config.pipelined()) {
+        WARN("Memory timing is supported only by the pipelined core, it is ignored.");
+    }
     if (machine_config.pipelined()) {
         cr.reset(new CorePipelined(
             regs.data(), predictor.data(), tlb_program.data(), tlb_data.data(), controlst.data(),
             machine_config.get_simulated_xlen(), machine_config.get_isa_word(),
-            machine_config.hazard_unit()));
+            machine_config.hazard_unit(), machine_config.memory_timing()));
+    } else if (machine_config.threaded_core()) {
+        auto *threaded_core = new CoreThreaded(
+            regs.data(), predictor.data(), tlb_program.data(), tlb_data.data(), controlst.data(),
+            machine_config.get_simulated_xlen(), machine_config.get_isa_word());
+        connect(
+            data_bus.data(), &MemoryDataBus::external_change_notify, threaded_core,
+            [threaded_core]() { threaded_core->invalidate_translations(); });
+        cr.reset(threaded_core);
     } else {
         cr.reset(new CoreSingle(
             regs.data(), predictor.data(), tlb_program.data(), tlb_data.data(), controlst.data(),
             machine_config.get_simulated_xlen(), machine_config.get_isa_word()));
     }
+    if (dram) {
+        dram->set_clock([this]() { return static_cast<uint64_t>(cr->get_cycle_count()); });
+    }
     connect(
         this, &Machine::set_interrupt_signal, controlst.data(),
         &CSR::ControlState::set_interrupt_signal);
@@ -119,7 +166,135 @@ Machine::Machine(MachineConfig config, bool load_symtab, bool load_executable)
     set_stop_on_exception(EXCAUSE_INT_S, machine_config.osemu_interrupt_stop());
     set_step_over_exception(EXCAUSE_INT_M, false);
     set_step_over_exception(EXCAUSE_INT_S, false);
+
+    if (machine_config.headless()) {
+        setup_headless();
+    } else {
+        // Cache views are refreshed once per batch of steps and on pause (see `step_timer`).
+        cch_program->set_deferred_updates(true);
+        cch_data->set_deferred_updates(true);
+        for (auto &cache : cch_shared) {
+            cache->set_deferred_updates(true);
+        }
+    }
+}
+
+void Machine::setup_flat_ram() {
+    try {
+        // Only address space is reserved, host pages are committed on first touch.
+        flat_mem.reset(new FlatMemory(0xf0000000, machine_config.get_simulated_endian()));
+    } catch (const SimulatorExceptionRuntime &e) {
+        // Host cannot reserve the range (32-bit host), keep the sparse memory.
+        WARN("Flat RAM not available: %s", qPrintable(e.msg(false)));
+        return;
+    }
+    flat_mem->reset(*mem);
+    insert_ram_range(flat_mem.data(), 0x00000000_addr, 0xefffffff_addr);
+    // Only written pages are copied back to `mem` and reset on restart.
+    data_bus->set_dirty_tracking(true);
+}
+
+void Machine::collect_flat_changes() {
+    data_bus->collect_and_clear_dirty(0x00000000_addr, 0xefffffff_addr, [this](Address page) {
+        flat_mem->store_page(*mem, page.get_raw());
+        flat_mem_changed.mark(page.get_raw(), page.get_raw());
+    });
+}
+
+void Machine::reset_flat_ram() {
+    if (flat_mem_replaced) {
+        flat_mem->reset(*mem_program_only);
+        data_bus->collect_and_clear_dirty(0x00000000_addr, 0xefffffff_addr, [](Address) {});
+        flat_mem_changed.clear();
+        flat_mem_replaced = false;
+        return;
+    }
+    // `mem` is already reset, pages are not copied there.
+    data_bus->collect_and_clear_dirty(0x00000000_addr, 0xefffffff_addr, [this](Address page) {
+        flat_mem_changed.mark(page.get_raw(), page.get_raw());
+    });
+    flat_mem_changed.collect_and_clear(0x00000000, 0xefffffff, [this](uint64_t page) {
+        flat_mem->reset_page(*mem_program_only, page);
+    });
+}
+
+void Machine::setup_mapped_files() {
+    for (const MappedFileConfig &file_config : machine_config.mapped_files()) {
+        auto *file = new MappedFile(
+            file_config.path, file_config.writable, machine_config.get_simulated_endian());
+        const Address start_addr(file_config.start);
+        if (file->size() - 1 > ~file_config.start) {
+            delete file;
+            throw SIMULATOR_EXCEPTION(
+                Input, "Mapped file does not fit below the end of address space",
+                file_config.path);
+        }
+        const Address last_addr = start_addr + (file->size() - 1);
+        if (!memory_bus_insert_range(file, start_addr, last_addr, true)) {
+            delete file;
+            throw SIMULATOR_EXCEPTION(
+                Input, "Mapped file overlaps a peripheral or another mapped file",
+                file_config.path);
+        }
+        mapped_files.append(file);
+        mapped_ranges.emplace_back(start_addr, last_addr);
+    }
+    std::sort(mapped_ranges.begin(), mapped_ranges.end());
+}
+
+void Machine::insert_ram_range(BackendMemory *ram, Address start_addr, Address last_addr) {
+    // RAM offsets equal physical addresses, mapped files are left out of the range.
+    Address next = start_addr;
+    for (const auto &hole : mapped_ranges) {
+        if (hole.second < next || hole.first > last_addr) { continue; }
+        if (hole.first > next) {
+            data_bus->insert_device_to_range(ram, next, hole.first - 1, false, next.get_raw());
+        }
+        if (hole.second >= last_addr) { return; }
+        next = hole.second + 1;
+    }
+    data_bus->insert_device_to_range(ram, next, last_addr, false, next.get_raw());
 }
+
+void Machine::link_cache_levels() {
+    std::vector<const Cache *> upper = { cch_program.data(), cch_data.data() };
+    for (auto &cache : cch_shared) {
+        cache->set_upper_levels(upper);
+        upper.insert(upper.begin(), cache.get());
+    }
+    // Evicted blocks go to the nearest enabled level below, exclusive one takes them over.
+    const Cache *exclusive_lower = nullptr;
+    for (auto it = cch_shared.rbegin(); it != cch_shared.rend(); ++it) {
+        (*it)->set_exclusive_lower_level(exclusive_lower);
+        const CacheConfig &config = (*it)->get_config();
+        if (config.enabled()) {
+            exclusive_lower
+                = config.inclusion_policy() == CacheConfig::IP_EXCLUSIVE ? it->get() : nullptr;
+        }
+    }
+    cch_program->set_exclusive_lower_level(exclusive_lower);
+    cch_data->set_exclusive_lower_level(exclusive_lower);
+}
+
+void Machine::setup_headless() {
+    regs->set_headless(true);
+    cr->set_headless(true);
+    predictor->set_headless(true);
+    cch_program->set_headless(true);
+    cch_data->set_headless(true);
+    for (auto &cache : cch_shared) {
+        cache->set_headless(true);
+    }
+    tlb_program->set_headless(true);
+    tlb_data->set_headless(true);
+    ser_port->set_headless(true);
+    perip_spi_led->set_headless(true);
+    perip_lcd_display->set_headless(true);
+    aclint_mtimer->set_headless(true);
+    aclint_mswi->set_headless(true);
+    aclint_sswi->set_headless(true);
+}
+
 void Machine::setup_lcd_display() {
     perip_lcd_display = new LcdDisplay(machine_config.get_simulated_endian());
     memory_bus_insert_range(perip_lcd_display, 0xffe00000_addr, 0xffe4afff_addr, true);
@@ -194,10 +369,13 @@ Machine::~Machine() {
     mem.reset();
     cch_program.reset();
     cch_data.reset();
-    cch_level2.reset();
+    cch_shared.clear();
+    dram.reset();
     data_bus.reset();
+    flat_mem.reset();
     mem_program_only.reset();
     symtab.reset();
+    shared_symtab.reset();
     predictor.reset();
 }
 
@@ -223,11 +401,20 @@ const CSR::ControlState *Machine::control_state() {
 }
 
 const Memory *Machine::memory() {
+    // Flat RAM replaces the low part of `mem` on the bus, that part is stale.
+    if (!flat_mem.isNull()) { collect_flat_changes(); }
     return mem.data();
 }
 
-Memory *Machine::memory_rw() {
-    return mem.data();
+void Machine::reset_memory(const Memory &content) {
+    mem->reset(content);
+    if (!flat_mem.isNull()) {
+        flat_mem->reset(content);
+        // Pages written before are overwritten by the content.
+        data_bus->collect_and_clear_dirty(0x00000000_addr, 0xefffffff_addr, [](Address) {});
+        flat_mem_changed.clear();
+        flat_mem_replaced = true;
+    }
 }
 
 const Cache *Machine::cache_program() {
@@ -239,13 +426,25 @@ const Cache *Machine::cache_data() {
 }
 
 const Cache *Machine::cache_level2() {
-    return cch_level2.data();
+    return cache_level(2);
+}
+
+const Cache *Machine::cache_level(unsigned level) {
+    return cch_shared.at(level - 2).get();
+}
+
+const DramController *Machine::dram_controller() {
+    return dram.data();
 }
 
 const BranchPredictor *Machine::branch_predictor() {
     return predictor.data();
 }
 
+Cache *Machine::cache_program_rw() {
+    return cch_program.data();
+}
+
 Cache *Machine::cache_data_rw() {
     return cch_data.data();
 }
@@ -253,7 +452,9 @@ Cache *Machine::cache_data_rw() {
 void Machine::cache_sync() {
     if (!cch_program.isNull()) { cch_program->sync(); }
     if (!cch_data.isNull()) { cch_data->sync(); }
-    if (!cch_level2.isNull()) { cch_level2->sync(); }
+    for (auto &cache : cch_shared) {
+        cache->sync();
+    }
 }
 
 void Machine::tlb_sync() {
@@ -298,11 +499,17 @@ LcdDisplay *Machine::peripheral_lcd_display() {
 }
 
 SymbolTable *Machine::symbol_table_rw(bool create) {
+    if (symtab.isNull() && shared_symtab != nullptr) {
+        // First modification, the cached table must stay intact.
+        symtab.reset(shared_symtab->copy());
+        shared_symtab.reset();
+    }
     if (create && (symtab.isNull())) { symtab.reset(new SymbolTable); }
     return symtab.data();
 }
 
 const SymbolTable *Machine::symbol_table(bool create) {
+    if (shared_symtab != nullptr) { return shared_symtab.get(); }
     return symbol_table_rw(create);
 }
 
@@ -312,14 +519,17 @@ void Machine::set_symbol(
     uint32_t size,
     unsigned char info,
     unsigned char other) {
-    if (symtab.isNull()) { symtab.reset(new SymbolTable); }
-    symtab->set_symbol(name, value, size, info, other);
+    symbol_table_rw(true)->set_symbol(name, value, size, info, other);
 }
 
 const Core *Machine::core() {
     return cr.data();
 }
 
+Core *Machine::core_rw() {
+    return cr.data();
+}
+
 const CoreSingle *Machine::core_singe() {
     return machine_config.pipelined() ? nullptr : (const CoreSingle *)cr.data();
 }
@@ -359,6 +569,7 @@ void Machine::pause() {
     if (stat != ST_BUSY) { CTL_GUARD; }
     set_status(ST_READY);
     stop_core_clock();
+    publish_cache_updates();
     emit play_paused();
 }
 
@@ -366,7 +577,7 @@ void Machine::step_internal(bool skip_break) {
     CTL_GUARD;
     enum Status stat_prev = stat;
     set_status(ST_BUSY);
-    emit tick();
+    if (!machine_config.headless()) { emit tick(); }
     try {
         QElapsedTimer timer;
         timer.start();
@@ -377,6 +588,7 @@ void Machine::step_internal(bool skip_break) {
     } catch (SimulatorException &e) {
         stop_core_clock();
         set_status(ST_TRAPPED);
+        publish_cache_updates();
         emit program_trap(e);
         return;
     }
@@ -387,7 +599,15 @@ void Machine::step_internal(bool skip_break) {
     } else {
         if (stat == ST_BUSY) { set_status(stat_prev); }
     }
-    emit post_tick();
+    if (!machine_config.headless()) { emit post_tick(); }
+}
+
+void Machine::publish_cache_updates() {
+    cch_program->publish_updates();
+    cch_data->publish_updates();
+    for (auto &cache : cch_shared) {
+        cache->publish_updates();
+    }
 }
 
 void Machine::start_core_clock() {
@@ -412,6 +632,7 @@ void Machine::stop_core_clock() {
 
 void Machine::step() {
     step_internal(true);
+    publish_cache_updates();
 }
 
 void Machine::step_timer() {
@@ -423,6 +644,8 @@ void Machine::step_timer() {
     } else {
         step_internal();
     }
+    // Deferred cache notifications are published once per batch of steps.
+    publish_cache_updates();
     // Compute core frequency each 0x100 cycles
     auto total_cycle_count = cr->get_cycle_count();
     auto cycle_count = total_cycle_count - last_cycle_count;
@@ -438,10 +661,19 @@ void Machine::step_timer() {
 void Machine::restart() {
     pause();
     regs->reset();
-    if (!mem_program_only.isNull()) { mem->reset(*mem_program_only); }
+    if (!mem_program_only.isNull()) {
+        mem->reset(*mem_program_only);
+        if (!flat_mem.isNull()) { reset_flat_ram(); }
+    }
+    for (MappedFile *file : mapped_files) {
+        file->reset();
+    }
     cch_program->reset();
     cch_data->reset();
-    cch_level2->reset();
+    for (auto &cache : cch_shared) {
+        cache->reset();
+    }
+    if (dram) { dram->reset(); }
     cr->reset();
     set_status(ST_READY);
 }
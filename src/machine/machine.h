@@ -6,11 +6,14 @@
 #include "memory/backend/aclintmswi.h"
 #include "memory/backend/aclintmtimer.h"
 #include "memory/backend/aclintsswi.h"
+#include "memory/backend/flat_memory.h"
 #include "memory/backend/lcddisplay.h"
+#include "memory/backend/mapped_file.h"
 #include "memory/backend/peripheral.h"
 #include "memory/backend/peripspiled.h"
 #include "memory/backend/serialport.h"
 #include "memory/cache/cache.h"
+#include "memory/dram/dram_controller.h"
 #include "memory/memory_bus.h"
 #include "memory/tlb/tlb.h"
 #include "predictor.h"
@@ -21,7 +24,10 @@
 #include <QObject>
 #include <QTimer>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace machine {
 
@@ -36,12 +42,19 @@ public:
 
     const Registers *registers();
     const CSR::ControlState *control_state();
+    /** Content of RAM, active flat RAM is copied to it first (slow). */
     const Memory *memory();
-    Memory *memory_rw();
+    /** Replace content of RAM, including flat RAM when active. */
+    void reset_memory(const Memory &content);
     const Cache *cache_program();
     const Cache *cache_data();
     const Cache *cache_level2();
+    /** Shared cache of the level, from 2 to `MachineConfig::cache_level_count`. */
+    const Cache *cache_level(unsigned level);
+    /** @return null when DRAM timing model is not enabled */
+    const DramController *dram_controller();
     const BranchPredictor *branch_predictor();
+    Cache *cache_program_rw();
     Cache *cache_data_rw();
     void cache_sync();
     const TLB *get_tlb_program() const;
@@ -63,6 +76,7 @@ public:
         unsigned char info = 0,
         unsigned char other = 0);
     const Core *core();
+    Core *core_rw();
     const CoreSingle *core_singe();
     const CorePipelined *core_pipelined();
     bool executable_loaded() const;
@@ -95,7 +109,13 @@ public:
 
     Address virtual_to_physical(AddressWithMode v) {
         if (tlb_data) {
-            return tlb_data->translate_virtual_to_physical(v).phys;
+            auto tr = tlb_data->translate_virtual_to_physical(v);
+            if (tr.fault != EXCAUSE_NONE) {
+                throw SIMULATOR_EXCEPTION(
+                    PageFault, "Address translation failed", QString::number(v.get_raw(), 16),
+                    tr.fault);
+            }
+            return tr.phys;
         } else {
             return v;
         }
@@ -137,7 +157,22 @@ private:
      * simulation reset without repeated ELF file loading.
      */
     Box<Memory> mem_program_only;
+    /**
+     * Contiguous RAM connected to the bus instead of `mem` when enabled in
+     * config. `mem` then holds the loaded program image only.
+     */
+    Box<FlatMemory> flat_mem;
+    /**
+     * Pages of `flat_mem`, which may differ from `mem_program_only`. Pages
+     * written since are collected from `data_bus` (see `collect_flat_changes`).
+     */
+    DirtyPageMap flat_mem_changed;
+    /** Content of `flat_mem` was replaced, it is unknown which pages changed. */
+    bool flat_mem_replaced = false;
     Box<MemoryDataBus> data_bus;
+    // Mapped files are owned by data_bus, ranges are sorted by start address.
+    QVector<MappedFile *> mapped_files;
+    std::vector<std::pair<Address, Address>> mapped_ranges;
     // Peripherals are owned by data_bus
     SerialPort *ser_port = nullptr;
     PeripSpiLed *perip_spi_led = nullptr;
@@ -145,7 +180,9 @@ private:
     aclint::AclintMtimer *aclint_mtimer = nullptr;
     aclint::AclintMswi *aclint_mswi = nullptr;
     aclint::AclintSswi *aclint_sswi = nullptr;
-    Box<Cache> cch_level2;
+    Box<DramController> dram;
+    // Shared cache levels, index 0 is level 2.
+    std::vector<std::unique_ptr<Cache>> cch_shared;
     Box<Cache> cch_program;
     Box<Cache> cch_data;
     Box<TLB> tlb_data;
@@ -162,6 +199,8 @@ private:
     uint64_t last_cycle_count = 0;
 
     Box<SymbolTable> symtab;
+    /** Symbol table of the cached program image, replaced by a copy in `symtab` on change. */
+    std::shared_ptr<const SymbolTable> shared_symtab;
     Address program_end = 0xffff0000_addr;
     enum Status stat = ST_READY;
     void set_status(enum Status st);
@@ -171,6 +210,19 @@ private:
     void setup_aclint_mtime();
     void setup_aclint_mswi();
     void setup_aclint_sswi();
+    void setup_flat_ram();
+    /**
+     * Copy pages of `flat_mem` written since the last call to `mem` and
+     * remember them for restart.
+     */
+    void collect_flat_changes();
+    /** Reset pages of `flat_mem`, which may differ from `mem_program_only`. */
+    void reset_flat_ram();
+    void setup_mapped_files();
+    void insert_ram_range(BackendMemory *ram, Address start_addr, Address last_addr);
+    void setup_headless();
+    void link_cache_levels();
+    void publish_cache_updates();
 };
 
 } // namespace machine
@@ -10,6 +10,9 @@ using namespace machine;
 //////////////////////////////////////////////////////////////////////////////
 /// Default config of MachineConfig
 #define DF_PIPELINE             false
+#define DF_THREADED             false
+#define DF_HEADLESS             false
+#define DF_FLAT_RAM             false
 #define DF_DELAYSLOT            true
 #define DF_HUNIT                HU_STALL_FORWARD
 #define DF_EXEC_PROTEC          false
@@ -18,7 +21,9 @@ using namespace machine;
 #define DF_MEM_ACC_WRITE        10
 #define DF_MEM_ACC_BURST        0
 #define DF_MEM_ACC_LEVEL2       2
+#define DF_CACHE_LEVELS         3
 #define DF_MEM_ACC_BURST_ENABLE false
+#define DF_MEM_TIMING           false
 #define DF_ELF                  QString("")
 /// Default config of branch predictor
 #define DFC_BP_ENABLED       false
@@ -34,12 +39,28 @@ using namespace machine;
 #define DFC_TLB_REPLAC RP_LRU
 //////////////////////////////////////////////////////////////////////////////
 /// Default config of CacheConfig
-#define DFC_EN     false
-#define DFC_SETS   1
-#define DFC_BLOCKS 1
-#define DFC_ASSOC  1
-#define DFC_REPLAC RP_RAND
-#define DFC_WRITE  WP_THROUGH_NOALLOC
+#define DFC_EN              false
+#define DFC_SETS            1
+#define DFC_BLOCKS          1
+#define DFC_ASSOC           1
+#define DFC_REPLAC          RP_RAND
+#define DFC_WRITE           WP_THROUGH_NOALLOC
+#define DFC_PREFETCH        PF_NONE
+#define DFC_PREFETCH_DEGREE 1
+#define DFC_INCLUSION       IP_NINE
+#define DFC_VICTIM          0
+#define DFC_WRITE_BUFFER    0
+//////////////////////////////////////////////////////////////////////////////
+/// Default config of DramConfig
+#define DFD_EN          false
+#define DFD_CHANNELS    1
+#define DFD_BANKS       8
+#define DFD_ROW_SIZE    2048
+#define DFD_PAGE_POLICY PAGE_OPEN
+#define DFD_T_RCD       14
+#define DFD_T_CAS       14
+#define DFD_T_RP        14
+#define DFD_QUEUE_SIZE  8
 //////////////////////////////////////////////////////////////////////////////
 
 CacheConfig::CacheConfig() {
@@ -49,6 +70,11 @@ CacheConfig::CacheConfig() {
     d_associativity = DFC_ASSOC;
     replac_pol = DFC_REPLAC;
     write_pol = DFC_WRITE;
+    prefetch_pol = DFC_PREFETCH;
+    prefetch_deg = DFC_PREFETCH_DEGREE;
+    inclusion_pol = DFC_INCLUSION;
+    victim_n = DFC_VICTIM;
+    write_buffer_n = DFC_WRITE_BUFFER;
 }
 
 CacheConfig::CacheConfig(const CacheConfig *cc) {
@@ -58,6 +84,11 @@ CacheConfig::CacheConfig(const CacheConfig *cc) {
     d_associativity = cc->associativity();
     replac_pol = cc->replacement_policy();
     write_pol = cc->write_policy();
+    prefetch_pol = cc->prefetch_policy();
+    prefetch_deg = cc->prefetch_degree();
+    inclusion_pol = cc->inclusion_policy();
+    victim_n = cc->victim_entries();
+    write_buffer_n = cc->write_buffer_entries();
 }
 
 #define N(STR) (prefix + QString(STR))
@@ -69,6 +100,11 @@ CacheConfig::CacheConfig(const QSettings *sts, const QString &prefix) {
     d_associativity = sts->value(N("Associativity"), DFC_ASSOC).toUInt();
     replac_pol = (enum ReplacementPolicy)sts->value(N("Replacement"), DFC_REPLAC).toUInt();
     write_pol = (enum WritePolicy)sts->value(N("Write"), DFC_WRITE).toUInt();
+    prefetch_pol = (enum PrefetchPolicy)sts->value(N("Prefetch"), DFC_PREFETCH).toUInt();
+    prefetch_deg = sts->value(N("PrefetchDegree"), DFC_PREFETCH_DEGREE).toUInt();
+    inclusion_pol = (enum InclusionPolicy)sts->value(N("Inclusion"), DFC_INCLUSION).toUInt();
+    victim_n = sts->value(N("VictimEntries"), DFC_VICTIM).toUInt();
+    write_buffer_n = sts->value(N("WriteBufferEntries"), DFC_WRITE_BUFFER).toUInt();
 }
 
 void CacheConfig::store(QSettings *sts, const QString &prefix) const {
@@ -78,6 +114,11 @@ void CacheConfig::store(QSettings *sts, const QString &prefix) const {
     sts->setValue(N("Associativity"), associativity());
     sts->setValue(N("Replacement"), (unsigned)replacement_policy());
     sts->setValue(N("Write"), (unsigned)write_policy());
+    sts->setValue(N("Prefetch"), (unsigned)prefetch_policy());
+    sts->setValue(N("PrefetchDegree"), prefetch_degree());
+    sts->setValue(N("Inclusion"), (unsigned)inclusion_policy());
+    sts->setValue(N("VictimEntries"), victim_entries());
+    sts->setValue(N("WriteBufferEntries"), write_buffer_entries());
 }
 
 #undef N
@@ -122,6 +163,26 @@ void CacheConfig::set_write_policy(enum WritePolicy v) {
     write_pol = v;
 }
 
+void CacheConfig::set_prefetch_policy(enum PrefetchPolicy v) {
+    prefetch_pol = v;
+}
+
+void CacheConfig::set_prefetch_degree(unsigned v) {
+    prefetch_deg = v > 0 ? v : 1;
+}
+
+void CacheConfig::set_inclusion_policy(enum InclusionPolicy v) {
+    inclusion_pol = v;
+}
+
+void CacheConfig::set_victim_entries(unsigned v) {
+    victim_n = v;
+}
+
+void CacheConfig::set_write_buffer_entries(unsigned v) {
+    write_buffer_n = v;
+}
+
 bool CacheConfig::enabled() const {
     return en;
 }
@@ -146,10 +207,32 @@ enum CacheConfig::WritePolicy CacheConfig::write_policy() const {
     return write_pol;
 }
 
+enum CacheConfig::PrefetchPolicy CacheConfig::prefetch_policy() const {
+    return prefetch_pol;
+}
+
+unsigned CacheConfig::prefetch_degree() const {
+    return prefetch_deg;
+}
+
+enum CacheConfig::InclusionPolicy CacheConfig::inclusion_policy() const {
+    return inclusion_pol;
+}
+
+unsigned CacheConfig::victim_entries() const {
+    return victim_n;
+}
+
+unsigned CacheConfig::write_buffer_entries() const {
+    return write_buffer_n;
+}
+
 bool CacheConfig::operator==(const CacheConfig &c) const {
 #define CMP(GETTER) (GETTER)() == (c.GETTER)()
     return CMP(enabled) && CMP(set_count) && CMP(block_size) && CMP(associativity)
-           && CMP(replacement_policy) && CMP(write_policy);
+           && CMP(replacement_policy) && CMP(write_policy) && CMP(prefetch_policy)
+           && CMP(prefetch_degree) && CMP(inclusion_policy) && CMP(victim_entries)
+           && CMP(write_buffer_entries);
 #undef CMP
 }
 
@@ -158,6 +241,130 @@ bool CacheConfig::operator!=(const CacheConfig &c) const {
 }
 //////////////////////////////////////////////////////////////////////////////
 
+DramConfig::DramConfig() {
+    en = DFD_EN;
+    n_channels = DFD_CHANNELS;
+    n_banks = DFD_BANKS;
+    row_bytes = DFD_ROW_SIZE;
+    page_pol = DFD_PAGE_POLICY;
+    rcd = DFD_T_RCD;
+    cas = DFD_T_CAS;
+    rp = DFD_T_RP;
+    queue_len = DFD_QUEUE_SIZE;
+}
+
+#define N(STR) (prefix + QString(STR))
+
+DramConfig::DramConfig(const QSettings *sts, const QString &prefix) {
+    en = sts->value(N("Enabled"), DFD_EN).toBool();
+    n_channels = sts->value(N("Channels"), DFD_CHANNELS).toUInt();
+    n_banks = sts->value(N("Banks"), DFD_BANKS).toUInt();
+    row_bytes = sts->value(N("RowSize"), DFD_ROW_SIZE).toUInt();
+    page_pol = (enum PagePolicy)sts->value(N("PagePolicy"), DFD_PAGE_POLICY).toUInt();
+    rcd = sts->value(N("tRCD"), DFD_T_RCD).toUInt();
+    cas = sts->value(N("tCAS"), DFD_T_CAS).toUInt();
+    rp = sts->value(N("tRP"), DFD_T_RP).toUInt();
+    queue_len = sts->value(N("QueueSize"), DFD_QUEUE_SIZE).toUInt();
+}
+
+void DramConfig::store(QSettings *sts, const QString &prefix) const {
+    sts->setValue(N("Enabled"), enabled());
+    sts->setValue(N("Channels"), channels());
+    sts->setValue(N("Banks"), banks());
+    sts->setValue(N("RowSize"), row_size());
+    sts->setValue(N("PagePolicy"), (unsigned)page_policy());
+    sts->setValue(N("tRCD"), t_rcd());
+    sts->setValue(N("tCAS"), t_cas());
+    sts->setValue(N("tRP"), t_rp());
+    sts->setValue(N("QueueSize"), queue_size());
+}
+
+#undef N
+
+void DramConfig::set_enabled(bool v) {
+    en = v;
+}
+
+void DramConfig::set_channels(unsigned v) {
+    n_channels = v > 0 ? v : 1;
+}
+
+void DramConfig::set_banks(unsigned v) {
+    n_banks = v > 0 ? v : 1;
+}
+
+void DramConfig::set_row_size(unsigned v) {
+    row_bytes = v > 0 ? v : 1;
+}
+
+void DramConfig::set_page_policy(enum PagePolicy v) {
+    page_pol = v;
+}
+
+void DramConfig::set_t_rcd(unsigned v) {
+    rcd = v;
+}
+
+void DramConfig::set_t_cas(unsigned v) {
+    cas = v;
+}
+
+void DramConfig::set_t_rp(unsigned v) {
+    rp = v;
+}
+
+void DramConfig::set_queue_size(unsigned v) {
+    queue_len = v > 0 ? v : 1;
+}
+
+bool DramConfig::enabled() const {
+    return en;
+}
+
+unsigned DramConfig::channels() const {
+    return n_channels;
+}
+
+unsigned DramConfig::banks() const {
+    return n_banks;
+}
+
+unsigned DramConfig::row_size() const {
+    return row_bytes;
+}
+
+enum DramConfig::PagePolicy DramConfig::page_policy() const {
+    return page_pol;
+}
+
+unsigned DramConfig::t_rcd() const {
+    return rcd;
+}
+
+unsigned DramConfig::t_cas() const {
+    return cas;
+}
+
+unsigned DramConfig::t_rp() const {
+    return rp;
+}
+
+unsigned DramConfig::queue_size() const {
+    return queue_len;
+}
+
+bool DramConfig::operator==(const DramConfig &c) const {
+#define CMP(GETTER) (GETTER)() == (c.GETTER)()
+    return CMP(enabled) && CMP(channels) && CMP(banks) && CMP(row_size) && CMP(page_policy)
+           && CMP(t_rcd) && CMP(t_cas) && CMP(t_rp) && CMP(queue_size);
+#undef CMP
+}
+
+bool DramConfig::operator!=(const DramConfig &c) const {
+    return !operator==(c);
+}
+//////////////////////////////////////////////////////////////////////////////
+
 TLBConfig::TLBConfig() {
     vm_asid = 0;
     n_sets = DFC_TLB_SETS;
@@ -260,6 +467,9 @@ MachineConfig::MachineConfig() {
     simulated_xlen = Xlen::_32;
     isa_word = config_isa_word_default;
     pipeline = DF_PIPELINE;
+    threaded = DF_THREADED;
+    headless_mode = DF_HEADLESS;
+    flat_ram_enabled = DF_FLAT_RAM;
     delayslot = DF_DELAYSLOT;
     hunit = DF_HUNIT;
     exec_protect = DF_EXEC_PROTEC;
@@ -267,8 +477,8 @@ MachineConfig::MachineConfig() {
     mem_acc_read = DF_MEM_ACC_READ;
     mem_acc_write = DF_MEM_ACC_WRITE;
     mem_acc_burst = DF_MEM_ACC_BURST;
-    mem_acc_level2 = DF_MEM_ACC_LEVEL2;
     mem_acc_enable_burst = DF_MEM_ACC_BURST_ENABLE;
+    mem_timing = DF_MEM_TIMING;
     osem_enable = true;
     osem_known_syscall_stop = true;
     osem_unknown_syscall_stop = true;
@@ -279,7 +489,8 @@ MachineConfig::MachineConfig() {
     elf_path = DF_ELF;
     cch_program = CacheConfig();
     cch_data = CacheConfig();
-    cch_level2 = CacheConfig();
+    set_cache_level_count(DF_CACHE_LEVELS);
+    dram_config = DramConfig();
 
     // Branch predictor
     bp_enabled = DFC_BP_ENABLED;
@@ -301,6 +512,10 @@ MachineConfig::MachineConfig(const MachineConfig *config) {
     simulated_xlen = config->get_simulated_xlen();
     isa_word = config->get_isa_word();
     pipeline = config->pipelined();
+    threaded = config->threaded_core();
+    headless_mode = config->headless();
+    flat_ram_enabled = config->flat_ram();
+    mapped_file_list = config->mapped_files();
     delayslot = config->delay_slot();
     hunit = config->hazard_unit();
     exec_protect = config->memory_execute_protection();
@@ -308,8 +523,8 @@ MachineConfig::MachineConfig(const MachineConfig *config) {
     mem_acc_read = config->memory_access_time_read();
     mem_acc_write = config->memory_access_time_write();
     mem_acc_burst = config->memory_access_time_burst();
-    mem_acc_level2 = config->memory_access_time_level2();
     mem_acc_enable_burst = config->memory_access_enable_burst();
+    mem_timing = config->memory_timing();
     osem_enable = config->osemu_enable();
     osem_known_syscall_stop = config->osemu_known_syscall_stop();
     osem_unknown_syscall_stop = config->osemu_unknown_syscall_stop();
@@ -320,7 +535,9 @@ MachineConfig::MachineConfig(const MachineConfig *config) {
     elf_path = config->elf();
     cch_program = config->cache_program();
     cch_data = config->cache_data();
-    cch_level2 = config->cache_level2();
+    cch_shared = config->cch_shared;
+    mem_acc_shared = config->mem_acc_shared;
+    dram_config = config->dram();
 
     // Branch predictor
     bp_enabled = config->get_bp_enabled();
@@ -348,6 +565,7 @@ MachineConfig::MachineConfig(const QSettings *sts, const QString &prefix) {
     isa_word |= config_isa_word_default & config_isa_word_fixed;
     isa_word &= config_isa_word_default | ~config_isa_word_fixed;
     pipeline = sts->value(N("Pipelined"), DF_PIPELINE).toBool();
+    threaded = sts->value(N("ThreadedCore"), DF_THREADED).toBool();
     delayslot = sts->value(N("DelaySlot"), DF_DELAYSLOT).toBool();
     hunit = (enum HazardUnit)sts->value(N("HazardUnit"), DF_HUNIT).toUInt();
     exec_protect = sts->value(N("MemoryExecuteProtection"), DF_EXEC_PROTEC).toBool();
@@ -355,8 +573,8 @@ MachineConfig::MachineConfig(const QSettings *sts, const QString &prefix) {
     mem_acc_read = sts->value(N("MemoryRead"), DF_MEM_ACC_READ).toUInt();
     mem_acc_write = sts->value(N("MemoryWrite"), DF_MEM_ACC_WRITE).toUInt();
     mem_acc_burst = sts->value(N("MemoryBurst"), DF_MEM_ACC_BURST).toUInt();
-    mem_acc_level2 = sts->value(N("MemoryLevel2"), DF_MEM_ACC_LEVEL2).toUInt();
     mem_acc_enable_burst = sts->value(N("MemoryBurstEnable"), DF_MEM_ACC_BURST_ENABLE).toBool();
+    mem_timing = sts->value(N("MemoryTiming"), DF_MEM_TIMING).toBool();
     osem_enable = sts->value(N("OsemuEnable"), true).toBool();
     osem_known_syscall_stop = sts->value(N("OsemuKnownSyscallStop"), true).toBool();
     osem_unknown_syscall_stop = sts->value(N("OsemuUnknownSyscallStop"), true).toBool();
@@ -367,7 +585,14 @@ MachineConfig::MachineConfig(const QSettings *sts, const QString &prefix) {
     elf_path = sts->value(N("Elf"), DF_ELF).toString();
     cch_program = CacheConfig(sts, N("ProgramCache_"));
     cch_data = CacheConfig(sts, N("DataCache_"));
-    cch_level2 = CacheConfig(sts, N("Level2Cache_"));
+    set_cache_level_count(sts->value(N("CacheLevels"), DF_CACHE_LEVELS).toUInt());
+    for (unsigned level = 2; level <= cache_level_count(); level++) {
+        cch_shared[level - 2] = CacheConfig(sts, N(QString("Level%1Cache_").arg(level)));
+        mem_acc_shared[level - 2]
+            = sts->value(N(QString("MemoryLevel%1").arg(level)), mem_acc_shared[level - 2])
+                  .toUInt();
+    }
+    dram_config = DramConfig(sts, N("Dram_"));
 
     // Branch predictor
     bp_enabled = sts->value(N("BranchPredictor_Enabled"), DFC_BP_ENABLED).toBool();
@@ -390,13 +615,14 @@ void MachineConfig::store(QSettings *sts, const QString &prefix) {
     sts->setValue(N("XlenBits"), get_simulated_xlen() == Xlen::_64 ? 64 : 32);
     sts->setValue(N("IsaWord"), get_isa_word().toUnsigned());
     sts->setValue(N("Pipelined"), pipelined());
+    sts->setValue(N("ThreadedCore"), threaded_core());
     sts->setValue(N("DelaySlot"), delay_slot());
     sts->setValue(N("HazardUnit"), (unsigned)hazard_unit());
     sts->setValue(N("MemoryRead"), memory_access_time_read());
     sts->setValue(N("MemoryWrite"), memory_access_time_write());
     sts->setValue(N("MemoryBurst"), memory_access_time_burst());
-    sts->setValue(N("MemoryLevel2"), memory_access_time_level2());
     sts->setValue(N("MemoryBurstEnable"), memory_access_enable_burst());
+    sts->setValue(N("MemoryTiming"), memory_timing());
     sts->setValue(N("OsemuEnable"), osemu_enable());
     sts->setValue(N("OsemuKnownSyscallStop"), osemu_known_syscall_stop());
     sts->setValue(N("OsemuUnknownSyscallStop"), osemu_unknown_syscall_stop());
@@ -407,7 +633,12 @@ void MachineConfig::store(QSettings *sts, const QString &prefix) {
     sts->setValue(N("Elf"), elf_path);
     cch_program.store(sts, N("ProgramCache_"));
     cch_data.store(sts, N("DataCache_"));
-    cch_level2.store(sts, N("Level2Cache_"));
+    sts->setValue(N("CacheLevels"), cache_level_count());
+    for (unsigned level = 2; level <= cache_level_count(); level++) {
+        cache_level(level).store(sts, N(QString("Level%1Cache_").arg(level)));
+        sts->setValue(N(QString("MemoryLevel%1").arg(level)), memory_access_time_level(level));
+    }
+    dram_config.store(sts, N("Dram_"));
 
     // Branch predictor
     sts->setValue(N("BranchPredictor_Enabled"), get_bp_enabled());
@@ -444,13 +675,17 @@ void MachineConfig::preset(enum ConfigPresets p) {
         break;
     }
     // Some common configurations
+    set_threaded_core(DF_THREADED);
     set_memory_execute_protection(DF_EXEC_PROTEC);
     set_memory_write_protection(DF_WRITE_PROTEC);
     set_memory_access_time_read(DF_MEM_ACC_READ);
     set_memory_access_time_write(DF_MEM_ACC_WRITE);
     set_memory_access_time_burst(DF_MEM_ACC_BURST);
-    set_memory_access_time_level2(DF_MEM_ACC_LEVEL2);
+    for (unsigned level = 2; level <= cache_level_count(); level++) {
+        set_memory_access_time_level(level, DF_MEM_ACC_LEVEL2 * (level - 1));
+    }
     set_memory_access_enable_burst(DF_MEM_ACC_BURST_ENABLE);
+    set_memory_timing(DF_MEM_TIMING);
 
     // Branch predictor
     set_bp_enabled(DFC_BP_ENABLED);
@@ -462,7 +697,9 @@ void MachineConfig::preset(enum ConfigPresets p) {
 
     access_cache_program()->preset(p);
     access_cache_data()->preset(p);
-    access_cache_level2()->preset(p);
+    for (CacheConfig &cache : cch_shared) {
+        cache.preset(p);
+    }
 
     set_vm_enabled(DFC_VM_ENABLED);
     access_tlb_program()->preset(p);
@@ -475,7 +712,11 @@ void MachineConfig::preset(enum ConfigPresets p) {
     case CP_SINGLE:
     case CP_SINGLE_CACHE:
     case CP_PIPE_NO_HAZARD:
-    case CP_PIPE: access_cache_level2()->set_enabled(false); break;
+    case CP_PIPE:
+        for (CacheConfig &cache : cch_shared) {
+            cache.set_enabled(false);
+        }
+        break;
     }
 }
 
@@ -483,6 +724,26 @@ void MachineConfig::set_pipelined(bool v) {
     pipeline = v;
 }
 
+void MachineConfig::set_threaded_core(bool v) {
+    threaded = v;
+}
+
+void MachineConfig::set_headless(bool v) {
+    headless_mode = v;
+}
+
+void MachineConfig::set_flat_ram(bool v) {
+    flat_ram_enabled = v;
+}
+
+void MachineConfig::add_mapped_file(const MappedFileConfig &v) {
+    mapped_file_list.append(v);
+}
+
+void MachineConfig::clear_mapped_files() {
+    mapped_file_list.clear();
+}
+
 void MachineConfig::set_delay_slot(bool v) {
     delayslot = v;
 }
@@ -524,13 +785,22 @@ void MachineConfig::set_memory_access_time_burst(unsigned v) {
 }
 
 void MachineConfig::set_memory_access_time_level2(unsigned v) {
-    mem_acc_level2 = v;
+    set_memory_access_time_level(2, v);
+}
+
+void MachineConfig::set_memory_access_time_level(unsigned level, unsigned v) {
+    if (level > cache_level_count()) { set_cache_level_count(level); }
+    mem_acc_shared[level - 2] = v;
 }
 
 void MachineConfig::set_memory_access_enable_burst(bool v) {
     mem_acc_enable_burst = v;
 }
 
+void MachineConfig::set_memory_timing(bool v) {
+    mem_timing = v;
+}
+
 void MachineConfig::set_osemu_enable(bool v) {
     osem_enable = v;
 }
@@ -572,7 +842,27 @@ void MachineConfig::set_cache_data(const CacheConfig &c) {
 }
 
 void MachineConfig::set_cache_level2(const CacheConfig &c) {
-    cch_level2 = c;
+    set_cache_level(2, c);
+}
+
+void MachineConfig::set_cache_level_count(unsigned v) {
+    // Level 2 is always present (possibly disabled).
+    const unsigned shared = v > 2 ? v - 1 : 1;
+    // New levels are disabled, each level is slower than the previous one.
+    for (auto level = unsigned(cch_shared.size()) + 2; level < shared + 2; level++) {
+        mem_acc_shared.append(DF_MEM_ACC_LEVEL2 * (level - 1));
+    }
+    cch_shared.resize(shared);
+    mem_acc_shared.resize(shared);
+}
+
+void MachineConfig::set_cache_level(unsigned level, const CacheConfig &c) {
+    if (level > cache_level_count()) { set_cache_level_count(level); }
+    cch_shared[level - 2] = c;
+}
+
+void MachineConfig::set_dram(const DramConfig &c) {
+    dram_config = c;
 }
 
 void MachineConfig::set_simulated_endian(Endian endian) {
@@ -595,6 +885,23 @@ bool MachineConfig::pipelined() const {
     return pipeline;
 }
 
+bool MachineConfig::threaded_core() const {
+    // Threaded core replaces only the single cycle core
+    return !pipeline && threaded;
+}
+
+bool MachineConfig::headless() const {
+    return headless_mode;
+}
+
+bool MachineConfig::flat_ram() const {
+    return flat_ram_enabled;
+}
+
+const QVector<MappedFileConfig> &MachineConfig::mapped_files() const {
+    return mapped_file_list;
+}
+
 bool MachineConfig::delay_slot() const {
     // Delay slot is always on when pipeline is enabled
     return pipeline || delayslot;
@@ -626,13 +933,21 @@ unsigned MachineConfig::memory_access_time_burst() const {
 }
 
 unsigned MachineConfig::memory_access_time_level2() const {
-    return mem_acc_level2;
+    return memory_access_time_level(2);
+}
+
+unsigned MachineConfig::memory_access_time_level(unsigned level) const {
+    return mem_acc_shared.at(level - 2);
 }
 
 bool MachineConfig::memory_access_enable_burst() const {
     return mem_acc_enable_burst;
 }
 
+bool MachineConfig::memory_timing() const {
+    return mem_timing;
+}
+
 bool MachineConfig::osemu_enable() const {
     return osem_enable;
 }
@@ -670,7 +985,19 @@ const CacheConfig &MachineConfig::cache_data() const {
 }
 
 const CacheConfig &MachineConfig::cache_level2() const {
-    return cch_level2;
+    return cache_level(2);
+}
+
+unsigned MachineConfig::cache_level_count() const {
+    return cch_shared.size() + 1;
+}
+
+const CacheConfig &MachineConfig::cache_level(unsigned level) const {
+    return cch_shared.at(level - 2);
+}
+
+const DramConfig &MachineConfig::dram() const {
+    return dram_config;
 }
 
 CacheConfig *MachineConfig::access_cache_program() {
@@ -682,7 +1009,16 @@ CacheConfig *MachineConfig::access_cache_data() {
 }
 
 CacheConfig *MachineConfig::access_cache_level2() {
-    return &cch_level2;
+    return access_cache_level(2);
+}
+
+CacheConfig *MachineConfig::access_cache_level(unsigned level) {
+    if (level > cache_level_count()) { set_cache_level_count(level); }
+    return &cch_shared[level - 2];
+}
+
+DramConfig *MachineConfig::access_dram() {
+    return &dram_config;
 }
 
 TLBConfig *MachineConfig::access_tlb_program() {
@@ -782,14 +1118,17 @@ bool MachineConfig::get_vm_enabled() const {
 
 bool MachineConfig::operator==(const MachineConfig &c) const {
 #define CMP(GETTER) (GETTER)() == (c.GETTER)()
-    return CMP(pipelined) && CMP(delay_slot) && CMP(hazard_unit) && CMP(get_simulated_xlen)
-           && CMP(get_isa_word) && CMP(get_bp_enabled) && CMP(get_bp_type) && CMP(get_bp_init_state)
+    return CMP(pipelined) && CMP(threaded_core) && CMP(delay_slot) && CMP(hazard_unit)
+           && CMP(get_simulated_xlen) && CMP(get_isa_word) && CMP(get_bp_enabled)
+           && CMP(get_bp_type) && CMP(get_bp_init_state)
            && CMP(get_bp_btb_bits) && CMP(get_bp_bhr_bits) && CMP(get_bp_bht_addr_bits)
            && CMP(memory_execute_protection) && CMP(memory_write_protection)
            && CMP(memory_access_time_read) && CMP(memory_access_time_write)
-           && CMP(memory_access_time_burst) && CMP(memory_access_time_level2)
-           && CMP(memory_access_enable_burst) && CMP(elf) && CMP(cache_program) && CMP(cache_data)
-           && CMP(cache_level2) && CMP(get_vm_enabled) && CMP(tlbc_data) && CMP(tlbc_program);
+           && CMP(memory_access_time_burst) && CMP(memory_access_enable_burst)
+           && CMP(memory_timing) && CMP(elf) && CMP(cache_program) && CMP(cache_data)
+           && cch_shared == c.cch_shared && mem_acc_shared == c.mem_acc_shared && CMP(dram)
+           && CMP(get_vm_enabled) && CMP(tlbc_data) && CMP(tlbc_program) && CMP(flat_ram)
+           && CMP(mapped_files);
 #undef CMP
 }
 
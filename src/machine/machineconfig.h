@@ -7,6 +7,7 @@
 
 #include <QSettings>
 #include <QString>
+#include <QVector>
 
 namespace machine {
 
@@ -34,6 +35,21 @@ constexpr ConfigIsaWord config_isa_word_default
 constexpr ConfigIsaWord config_isa_word_fixed
     = ConfigIsaWord::byChar('E') | ConfigIsaWord::byChar('I');
 
+/**
+ * Host file mapped into the physical address space (see `MappedFile`).
+ */
+struct MappedFileConfig {
+    uint64_t start = 0;
+    QString path;
+    // Writes are private to the simulation and discarded on restart, otherwise the range is
+    // read-only.
+    bool writable = false;
+
+    bool operator==(const MappedFileConfig &c) const {
+        return start == c.start && path == c.path && writable == c.writable;
+    }
+};
+
 class CacheConfig {
 public:
     CacheConfig();
@@ -45,11 +61,15 @@ public:
     void preset(enum ConfigPresets);
 
     enum ReplacementPolicy {
-        RP_RAND, // Random
-        RP_LRU,  // Least recently used
-        RP_LFU,  // Least frequently used
-        RP_PLRU, // Pseudo Least recently used
-        RP_NMRU  // Not most recently used
+        RP_RAND,  // Random
+        RP_LRU,   // Least recently used
+        RP_LFU,   // Least frequently used
+        RP_PLRU,  // Pseudo Least recently used
+        RP_NMRU,  // Not most recently used
+        RP_SRRIP, // Static re-reference interval prediction
+        RP_BRRIP, // Bimodal re-reference interval prediction
+        RP_DRRIP, // Dynamic (set dueling) re-reference interval prediction
+        RP_SHIP   // Signature (instruction) based hit prediction
     };
 
     enum WritePolicy {
@@ -58,6 +78,20 @@ public:
         WP_BACK             // Write back
     };
 
+    enum PrefetchPolicy {
+        PF_NONE,      // Fill on demand only
+        PF_NEXT_LINE, // Following block on miss or on first use of prefetched block
+        PF_STRIDE,    // Stride detected per instruction address
+        PF_STREAM     // Stream buffers outside of the cache
+    };
+
+    /** Relation of content of a shared level to the levels above it. */
+    enum InclusionPolicy {
+        IP_NINE,      // Neither inclusive nor exclusive
+        IP_INCLUSIVE, // Eviction invalidates the block in levels above
+        IP_EXCLUSIVE  // Holds only blocks evicted from levels above (victim cache)
+    };
+
     // If cache should be used or not
     void set_enabled(bool);
     void set_set_count(unsigned);     // Number of sets
@@ -66,6 +100,11 @@ public:
                                       // ways)
     void set_replacement_policy(enum ReplacementPolicy);
     void set_write_policy(enum WritePolicy);
+    void set_prefetch_policy(enum PrefetchPolicy);
+    void set_prefetch_degree(unsigned); // Blocks prefetched ahead (stream buffer depth)
+    void set_inclusion_policy(enum InclusionPolicy); // Ignored for private (L1) caches
+    void set_victim_entries(unsigned);       // Blocks of the victim cache, 0 for none
+    void set_write_buffer_entries(unsigned); // Write buffer of write through, 0 for none
 
     bool enabled() const;
     unsigned set_count() const;
@@ -73,6 +112,11 @@ public:
     unsigned associativity() const;
     enum ReplacementPolicy replacement_policy() const;
     enum WritePolicy write_policy() const;
+    enum PrefetchPolicy prefetch_policy() const;
+    unsigned prefetch_degree() const;
+    enum InclusionPolicy inclusion_policy() const;
+    unsigned victim_entries() const;
+    unsigned write_buffer_entries() const;
 
     bool operator==(const CacheConfig &c) const;
     bool operator!=(const CacheConfig &c) const;
@@ -82,6 +126,10 @@ private:
     unsigned n_sets, n_blocks, d_associativity;
     enum ReplacementPolicy replac_pol;
     enum WritePolicy write_pol;
+    enum PrefetchPolicy prefetch_pol;
+    unsigned prefetch_deg;
+    enum InclusionPolicy inclusion_pol;
+    unsigned victim_n, write_buffer_n;
 };
 
 class TLBConfig {
@@ -126,6 +174,50 @@ private:
     enum ReplacementPolicy replac_pol = RP_RAND;
 };
 
+class DramConfig {
+public:
+    DramConfig();
+    explicit DramConfig(const QSettings *, const QString &prefix = "");
+
+    void store(QSettings *, const QString &prefix = "") const;
+
+    enum PagePolicy {
+        PAGE_OPEN,  // Row stays open in the row buffer until another row is accessed
+        PAGE_CLOSED // Row is precharged right after the access
+    };
+
+    // If DRAM controller is simulated, flat memory access times are used otherwise
+    void set_enabled(bool);
+    void set_channels(unsigned);
+    void set_banks(unsigned);    // Banks per channel
+    void set_row_size(unsigned); // Bytes in row buffer of a bank
+    void set_page_policy(enum PagePolicy);
+    void set_t_rcd(unsigned);      // Row activation to column access (cycles)
+    void set_t_cas(unsigned);      // Column access to data (cycles)
+    void set_t_rp(unsigned);       // Row precharge (cycles)
+    void set_queue_size(unsigned); // Posted writes waiting in the request queue
+
+    bool enabled() const;
+    unsigned channels() const;
+    unsigned banks() const;
+    unsigned row_size() const;
+    enum PagePolicy page_policy() const;
+    unsigned t_rcd() const;
+    unsigned t_cas() const;
+    unsigned t_rp() const;
+    unsigned queue_size() const;
+
+    bool operator==(const DramConfig &c) const;
+    bool operator!=(const DramConfig &c) const;
+
+private:
+    bool en;
+    unsigned n_channels, n_banks, row_bytes;
+    enum PagePolicy page_pol;
+    unsigned rcd, cas, rp;
+    unsigned queue_len;
+};
+
 class MachineConfig {
 public:
     MachineConfig();
@@ -141,6 +233,19 @@ public:
     // Configure if CPU is pipelined
     // In default disabled.
     void set_pipelined(bool);
+    // Configure if non-pipelined CPU executes translated basic blocks (fast threaded-code core).
+    // In default disabled. Ignored when pipeline is enabled.
+    void set_threaded_core(bool);
+    // Configure if machine runs without per-event visualization signals (batch simulation).
+    // In default disabled. Not stored in settings, it is a property of the frontend.
+    void set_headless(bool);
+    // Configure if RAM is stored in one contiguous lazily committed host allocation instead of
+    // the sparse section tree. In default disabled. Not stored in settings.
+    void set_flat_ram(bool);
+    // Map host files into the physical address space. RAM is not accessible where a file is
+    // mapped. Not stored in settings.
+    void add_mapped_file(const MappedFileConfig &);
+    void clear_mapped_files();
     // Configure if cpu should simulate delay slot in non-pipelined core
     // In default enabled. When disabled it also automatically disables
     // pipelining.
@@ -158,7 +263,13 @@ public:
     void set_memory_access_time_write(unsigned);
     void set_memory_access_time_burst(unsigned);
     void set_memory_access_time_level2(unsigned);
+    // Cycles to access shared cache level (from the level above it).
+    void set_memory_access_time_level(unsigned level, unsigned);
     void set_memory_access_enable_burst(bool);
+    // Configure if pipelined CPU waits for memory, caches and TLBs. Stages accessing memory are
+    // stalled for cycles reported as cache/TLB stalls. In default disabled, the memory access
+    // times only affect statistics then.
+    void set_memory_timing(bool);
     // Operating system and exceptions setup
     void set_osemu_enable(bool);
     void set_osemu_known_syscall_stop(bool);
@@ -175,12 +286,23 @@ public:
     void set_cache_program(const CacheConfig &);
     void set_cache_data(const CacheConfig &);
     void set_cache_level2(const CacheConfig &);
+    // Cache hierarchy consists of private program and data caches (level 1)
+    // and shared levels numbered from 2 up to `cache_level_count`. Disabled
+    // levels are skipped. Setting a level above the count extends the hierarchy.
+    void set_cache_level_count(unsigned);
+    void set_cache_level(unsigned level, const CacheConfig &);
+    // Configure DRAM controller between the last cache level and memory
+    void set_dram(const DramConfig &);
     void set_simulated_endian(Endian endian);
     void set_simulated_xlen(Xlen xlen);
     void set_isa_word(ConfigIsaWord bits);
     void modify_isa_word(ConfigIsaWord mask, ConfigIsaWord val);
 
     bool pipelined() const;
+    bool threaded_core() const;
+    bool headless() const;
+    bool flat_ram() const;
+    const QVector<MappedFileConfig> &mapped_files() const;
     bool delay_slot() const;
     enum HazardUnit hazard_unit() const;
     bool memory_execute_protection() const;
@@ -189,7 +311,9 @@ public:
     unsigned memory_access_time_write() const;
     unsigned memory_access_time_burst() const;
     unsigned memory_access_time_level2() const;
+    unsigned memory_access_time_level(unsigned level) const;
     bool memory_access_enable_burst() const;
+    bool memory_timing() const;
     bool osemu_enable() const;
     bool osemu_known_syscall_stop() const;
     bool osemu_unknown_syscall_stop() const;
@@ -201,6 +325,9 @@ public:
     const CacheConfig &cache_program() const;
     const CacheConfig &cache_data() const;
     const CacheConfig &cache_level2() const;
+    unsigned cache_level_count() const;
+    const CacheConfig &cache_level(unsigned level) const;
+    const DramConfig &dram() const;
     Endian get_simulated_endian() const;
     Xlen get_simulated_xlen() const;
     ConfigIsaWord get_isa_word() const;
@@ -230,6 +357,9 @@ public:
     CacheConfig *access_cache_program();
     CacheConfig *access_cache_data();
     CacheConfig *access_cache_level2();
+    /** Pointer is invalidated by change of the level count. */
+    CacheConfig *access_cache_level(unsigned level);
+    DramConfig *access_dram();
 
     TLBConfig *access_tlb_program();
     TLBConfig *access_tlb_data();
@@ -239,16 +369,25 @@ public:
 
 private:
     bool pipeline, delayslot;
+    bool threaded;
+    bool headless_mode;
+    bool flat_ram_enabled;
+    QVector<MappedFileConfig> mapped_file_list;
     enum HazardUnit hunit;
     bool exec_protect, write_protect;
-    unsigned mem_acc_read, mem_acc_write, mem_acc_burst, mem_acc_level2;
+    unsigned mem_acc_read, mem_acc_write, mem_acc_burst;
     bool mem_acc_enable_burst;
+    bool mem_timing;
     bool osem_enable, osem_known_syscall_stop, osem_unknown_syscall_stop;
     bool osem_interrupt_stop, osem_exception_stop;
     bool res_at_compile;
     QString osem_fs_root;
     QString elf_path;
-    CacheConfig cch_program, cch_data, cch_level2;
+    CacheConfig cch_program, cch_data;
+    // Shared cache levels and their access times, index 0 is level 2.
+    QVector<CacheConfig> cch_shared;
+    QVector<unsigned> mem_acc_shared;
+    DramConfig dram_config;
     Endian simulated_endian;
     Xlen simulated_xlen;
     ConfigIsaWord isa_word;
@@ -64,7 +64,7 @@ uint32_t AclintMswi::read_reg32(Offset source, AccessEffects type) const {
         value = mswi_value[source >> 2] ? 1 : 0;
     }
 
-    emit read_notification(source, value);
+    if (!headless) { emit read_notification(source, value); }
 
     return value;
 }
@@ -84,7 +84,7 @@ bool AclintMswi::write_reg32(Offset destination, uint32_t value) {
         printf("WARNING: ACLINT MSWI - read out of range (at 0x%zu).\n", destination);
     }
 
-    emit write_notification(destination, value);
+    if (!headless) { emit write_notification(destination, value); }
 
     return changed;
 }
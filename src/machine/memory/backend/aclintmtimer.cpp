@@ -111,7 +111,7 @@ uint64_t AclintMtimer::read_reg64(Offset source, AccessEffects type) const {
         value = mtimecmp_value[source >> 3];
     }
 
-    emit read_notification(source, value);
+    if (!headless) { emit read_notification(source, value); }
 
     return value;
 }
@@ -136,7 +136,7 @@ bool AclintMtimer::write_reg64(Offset destination, uint64_t value) {
         WARN("ACLINT MTIMER - read out of range (at 0x%zu).\n", destination);
     }
 
-    emit write_notification(destination, value);
+    if (!headless) { emit write_notification(destination, value); }
 
     return changed;
 }
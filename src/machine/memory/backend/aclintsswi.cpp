@@ -49,7 +49,7 @@ namespace machine { namespace aclint {
 
         if ((source >= ACLINT_SSWI_OFFSET) && (source < ACLINT_SSWI_OFFSET + 4 * sswi_count)) {}
 
-        emit read_notification(source, value);
+        if (!headless) { emit read_notification(source, value); }
 
         return value;
     }
@@ -67,7 +67,7 @@ namespace machine { namespace aclint {
             printf("WARNING: ACLINT SSWI - read out of range (at 0x%zu).\n", destination);
         }
 
-        emit write_notification(destination, value);
+        if (!headless) { emit write_notification(destination, value); }
 
         return changed;
     }
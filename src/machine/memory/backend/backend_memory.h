@@ -6,6 +6,7 @@
 #include "memory/memory_utils.h"
 
 #include <QObject>
+#include <functional>
 
 // Shortcut for enum class values, type is obvious from context.
 using ae = machine::AccessEffects;
@@ -88,12 +89,71 @@ public:
      */
     [[nodiscard]] virtual enum LocationStatus location_status(Offset offset) const = 0;
 
+    /**
+     * Direct host access to device storage.
+     *
+     * Devices, which store the range contiguously in the simulated machine
+     * endian and whose accesses have no side effects, may return a pointer to
+     * `size` bytes at `offset`. Otherwise (default) null is returned and the
+     * access has to go through `read` and `write`. Writes through the pointer
+     * bypass change detection, callers are responsible for it.
+     */
+    [[nodiscard]] virtual byte *direct_access(Offset offset, size_t size) const {
+        (void)offset;
+        (void)size;
+        return nullptr;
+    }
+
+    /**
+     * Report pages changed since the last call and forget them.
+     *
+     * Calls `visitor` with the offset of the first byte of each dirty page
+     * (see `DirtyPageMap::PAGE_SIZE`) overlapping `first` to `last`
+     * (inclusive). Devices without tracking report nothing (default), their
+     * changes are visible only through their own write path and external
+     * change notifications.
+     *
+     * @return  number of reported pages
+     */
+    virtual size_t collect_and_clear_dirty(
+        Offset first,
+        Offset last,
+        const std::function<void(Offset)> &visitor) {
+        (void)first;
+        (void)last;
+        (void)visitor;
+        return 0;
+    }
+
+    /**
+     * Start or stop dirty page tracking, it is off until a consumer asks for
+     * it. Stopping forgets the tracked pages.
+     *
+     * @return  true when the device tracks its pages itself (see
+     *          `collect_and_clear_dirty`), false for devices without tracking
+     *          (default)
+     */
+    virtual bool set_dirty_tracking(bool enable) {
+        (void)enable;
+        return false;
+    }
+
+    /**
+     * Headless device does not emit access notifications and visualization signals. Signals with
+     * functional effect (interrupts, character output, external change) are always emitted.
+     */
+    void set_headless(bool value) { headless = value; }
+    [[nodiscard]] bool is_headless() const { return headless; }
+
     /**
      * Endian of the simulated CPU/memory system.
      * @see BackendMemory docs
      */
     const Endian simulated_machine_endian;
 
+protected:
+    bool headless = false;
+
 signals:
     /**
      * Notify upper layer about a change in managed physical memory of periphery
@@ -0,0 +1,151 @@
+#include "memory/backend/flat_memory.h"
+
+#include "common/logging.h"
+#include "simulator_exception.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+#endif
+
+LOG_CATEGORY("machine.memory.flat");
+
+namespace machine {
+
+FlatMemory::FlatMemory(size_t size_bytes, Endian simulated_machine_endian)
+    : BackendMemory(simulated_machine_endian)
+    , storage_size(size_bytes) {
+    allocate();
+}
+
+FlatMemory::~FlatMemory() {
+    release();
+}
+
+void FlatMemory::allocate() {
+#if defined(__unix__) || defined(__APPLE__)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    #ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+    #endif
+    void *ptr = mmap(nullptr, storage_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (ptr != MAP_FAILED) {
+        storage = static_cast<byte *>(ptr);
+        mapped = true;
+        return;
+    }
+    WARN("Anonymous mapping of %zu bytes failed, falling back to heap", storage_size);
+#endif
+    storage = static_cast<byte *>(calloc(storage_size, 1));
+    mapped = false;
+    if (storage == nullptr) {
+        throw SIMULATOR_EXCEPTION(
+            Runtime, "Cannot allocate flat memory", QString::number(storage_size));
+    }
+}
+
+void FlatMemory::release() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (mapped) {
+        munmap(storage, storage_size);
+        storage = nullptr;
+        return;
+    }
+#endif
+    free(storage);
+    storage = nullptr;
+}
+
+void FlatMemory::reset() {
+    if (mapped) {
+        // Fresh mapping is zeroed and does not hold any committed pages.
+        release();
+        allocate();
+    } else {
+        memset(storage, 0, storage_size);
+    }
+}
+
+void FlatMemory::reset(const Memory &image) {
+    reset();
+    image.for_each_section([this](Offset base, const MemorySection &section) {
+        if (base >= storage_size) { return; }
+        const size_t n = std::min(section.length(), storage_size - base);
+        memcpy(storage + base, section.data(), n);
+    });
+}
+
+void FlatMemory::store(Memory &image) const {
+    for (size_t offset = 0; offset < storage_size; offset += DirtyPageMap::PAGE_SIZE) {
+        store_page(image, offset);
+    }
+}
+
+void FlatMemory::store_page(Memory &image, Offset page) const {
+    if (page >= storage_size) { return; }
+    const size_t n = std::min<size_t>(DirtyPageMap::PAGE_SIZE, storage_size - page);
+    byte buffer[DirtyPageMap::PAGE_SIZE];
+    // Missing sections of the image read as zero, untouched pages are not allocated there.
+    image.read(buffer, page, n, { .type = ae::INTERNAL });
+    if (memcmp(buffer, storage + page, n) != 0) {
+        image.write(page, storage + page, n, { .type = ae::INTERNAL });
+    }
+}
+
+void FlatMemory::reset_page(const Memory &image, Offset page) {
+    if (page >= storage_size) { return; }
+    const size_t n = std::min<size_t>(DirtyPageMap::PAGE_SIZE, storage_size - page);
+    image.read(storage + page, page, n, { .type = ae::INTERNAL });
+}
+
+WriteResult
+FlatMemory::write(Offset destination, const void *source, size_t size, WriteOptions options) {
+    UNUSED(options)
+
+    if (destination >= storage_size) {
+        throw SIMULATOR_EXCEPTION(
+            OutOfMemoryAccess, "Trying to write outside of the flat memory",
+            QString("Accessing using offset: ") + QString::number(destination));
+    }
+
+    const size_t available_size = std::min(size, storage_size - destination);
+
+    bool changed = memcmp(source, storage + destination, available_size) != 0;
+    if (changed) { memcpy(storage + destination, source, available_size); }
+
+    return { .n_bytes = available_size, .changed = changed };
+}
+
+ReadResult
+FlatMemory::read(void *destination, Offset source, size_t size, ReadOptions options) const {
+    UNUSED(options)
+
+    if (source >= storage_size) {
+        throw SIMULATOR_EXCEPTION(
+            OutOfMemoryAccess, "Trying to read outside of the flat memory",
+            QString("Accessing using offset: ") + QString::number(source));
+    }
+
+    size = std::min(size, storage_size - source);
+    memcpy(destination, storage + source, size);
+
+    return { .n_bytes = size };
+}
+
+LocationStatus FlatMemory::location_status(Offset offset) const {
+    UNUSED(offset)
+    return LOCSTAT_NONE;
+}
+
+byte *FlatMemory::direct_access(Offset offset, size_t size) const {
+    if (offset >= storage_size || size > storage_size - offset) { return nullptr; }
+    return storage + offset;
+}
+
+size_t FlatMemory::size() const {
+    return storage_size;
+}
+
+} // namespace machine
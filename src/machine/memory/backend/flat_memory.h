@@ -0,0 +1,75 @@
+#ifndef FLAT_MEMORY_H
+#define FLAT_MEMORY_H
+
+#include "common/endian.h"
+#include "memory/backend/backend_memory.h"
+#include "memory/backend/memory.h"
+#include "memory/dirty_page_map.h"
+#include "memory/memory_utils.h"
+
+#include <cstdint>
+
+namespace machine {
+
+/**
+ * RAM stored in a single contiguous host allocation.
+ *
+ * Unlike `Memory`, which allocates small sections in a lookup tree on demand,
+ * the whole range is reserved at once. Where available, anonymous `mmap` is
+ * used, so host pages are committed lazily on first touch and untouched parts
+ * of the range cost nothing. Accesses are a bounds check and a copy and the
+ * storage can be accessed directly (see `direct_access`).
+ *
+ * NOTE: Internal endian of memory must be the same as endian of the whole
+ * simulated machine. Therefore it does not have internal_endian field.
+ */
+class FlatMemory final : public BackendMemory {
+public:
+    FlatMemory(size_t size_bytes, Endian simulated_machine_endian);
+    ~FlatMemory() override;
+
+    FlatMemory(const FlatMemory &) = delete;
+    FlatMemory &operator=(const FlatMemory &) = delete;
+
+    /** Zero whole content and release committed host pages. */
+    void reset();
+    /** Reset content to the part of the image, which fits into the range. */
+    void reset(const Memory &image);
+    /**
+     * Copy whole content to the same offsets of the image. Whole range is
+     * compared, so it is slow, only pages which differ are written.
+     */
+    void store(Memory &image) const;
+    /**
+     * Copy page (see `DirtyPageMap::PAGE_SIZE`) starting at `page` to the same
+     * offset of the image, it is written only when it differs.
+     */
+    void store_page(Memory &image, Offset page) const;
+    /** Reset page starting at `page` to the same offset of the image. */
+    void reset_page(const Memory &image, Offset page);
+
+    WriteResult
+    write(Offset destination, const void *source, size_t size, WriteOptions options) override;
+
+    ReadResult
+    read(void *destination, Offset source, size_t size, ReadOptions options) const override;
+
+    [[nodiscard]] LocationStatus location_status(Offset offset) const override;
+
+    [[nodiscard]] byte *direct_access(Offset offset, size_t size) const override;
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    byte *storage = nullptr;
+    size_t storage_size;
+    /** Storage is obtained by mmap (otherwise calloc). */
+    bool mapped = false;
+
+    void allocate();
+    void release();
+};
+
+} // namespace machine
+
+#endif // FLAT_MEMORY_H
@@ -57,7 +57,7 @@ uint16_t LcdDisplay::read_raw_pixel(Offset source) const {
             (unsigned long)value);
     }
 
-    emit read_notification(source, value);
+    if (!headless) { emit read_notification(source, value); }
     return value;
 }
 
@@ -95,7 +95,7 @@ bool LcdDisplay::write_raw_pixel(Offset destination, uint16_t value) {
         g = ((pixel_data >> 5u) & 0x3fu) << 2u;
         b = ((pixel_data >> 0u) & 0x1fu) << 3u;
 
-        emit pixel_update(x, y, r, g, b);
+        if (!headless) { emit pixel_update(x, y, r, g, b); }
 
         if (++x >= fb_width) {
             x = 0;
@@ -103,7 +103,7 @@ bool LcdDisplay::write_raw_pixel(Offset destination, uint16_t value) {
         }
     }
 
-    emit write_notification(destination, value);
+    if (!headless) { emit write_notification(destination, value); }
 
     return true;
 }
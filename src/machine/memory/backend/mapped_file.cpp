@@ -0,0 +1,120 @@
+#include "memory/backend/mapped_file.h"
+
+#include "common/logging.h"
+#include "simulator_exception.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+LOG_CATEGORY("machine.memory.mapped_file");
+
+namespace machine {
+
+MappedFile::MappedFile(const QString &path, bool writable, Endian simulated_machine_endian)
+    : BackendMemory(simulated_machine_endian)
+    , file(path)
+    , writable(writable) {
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw SIMULATOR_EXCEPTION(Input, "Cannot open file to map", path);
+    }
+    storage_size = file.size();
+    if (storage_size == 0) { throw SIMULATOR_EXCEPTION(Input, "File to map is empty", path); }
+    map();
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+void MappedFile::map() {
+    // Private mapping is copy-on-write, file content is never modified.
+    uchar *ptr = file.map(
+        0, (qint64)storage_size, writable ? QFile::MapPrivateOption : QFile::NoOptions);
+    if (ptr != nullptr) {
+        storage = ptr;
+        mapped = true;
+        return;
+    }
+    WARN("Mapping of %s failed, reading it to memory", qPrintable(file.fileName()));
+    storage = static_cast<byte *>(malloc(storage_size));
+    mapped = false;
+    if (storage == nullptr) {
+        throw SIMULATOR_EXCEPTION(Runtime, "Cannot allocate memory for file", file.fileName());
+    }
+    file.seek(0);
+    if (file.read(reinterpret_cast<char *>(storage), (qint64)storage_size)
+        != (qint64)storage_size) {
+        // Destructor does not run when the constructor throws.
+        free(storage);
+        storage = nullptr;
+        throw SIMULATOR_EXCEPTION(Input, "Cannot read file to map", file.fileName());
+    }
+}
+
+void MappedFile::unmap() {
+    if (mapped) {
+        file.unmap(storage);
+    } else {
+        free(storage);
+    }
+    storage = nullptr;
+}
+
+void MappedFile::reset() {
+    if (!writable) { return; }
+    unmap();
+    map();
+}
+
+WriteResult
+MappedFile::write(Offset destination, const void *source, size_t size, WriteOptions options) {
+    UNUSED(options)
+
+    if (destination >= storage_size) {
+        throw SIMULATOR_EXCEPTION(
+            OutOfMemoryAccess, "Trying to write outside of the mapped file",
+            QString("Accessing using offset: ") + QString::number(destination));
+    }
+
+    const size_t available_size = std::min(size, storage_size - destination);
+    // Writes to read-only mapping are ignored.
+    if (!writable) { return { .n_bytes = available_size, .changed = false }; }
+
+    bool changed = memcmp(source, storage + destination, available_size) != 0;
+    if (changed) { memcpy(storage + destination, source, available_size); }
+
+    return { .n_bytes = available_size, .changed = changed };
+}
+
+ReadResult
+MappedFile::read(void *destination, Offset source, size_t size, ReadOptions options) const {
+    UNUSED(options)
+
+    if (source >= storage_size) {
+        throw SIMULATOR_EXCEPTION(
+            OutOfMemoryAccess, "Trying to read outside of the mapped file",
+            QString("Accessing using offset: ") + QString::number(source));
+    }
+
+    size = std::min(size, storage_size - source);
+    memcpy(destination, storage + source, size);
+
+    return { .n_bytes = size };
+}
+
+LocationStatus MappedFile::location_status(Offset offset) const {
+    UNUSED(offset)
+    return writable ? LOCSTAT_NONE : LOCSTAT_READ_ONLY;
+}
+
+byte *MappedFile::direct_access(Offset offset, size_t size) const {
+    if (!writable || offset >= storage_size || size > storage_size - offset) { return nullptr; }
+    return storage + offset;
+}
+
+size_t MappedFile::size() const {
+    return storage_size;
+}
+
+} // namespace machine
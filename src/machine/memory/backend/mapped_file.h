@@ -0,0 +1,67 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "common/endian.h"
+#include "memory/backend/backend_memory.h"
+#include "memory/memory_utils.h"
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+
+namespace machine {
+
+/**
+ * Content of a host file visible in the simulated physical address space.
+ *
+ * File is mapped into host memory (`QFile::map`), so it is paged in lazily on
+ * first access and no copy is made at startup. Read-only mapping ignores
+ * writes. Writable mapping is private (copy-on-write), the file itself is
+ * never modified and `reset` discards all writes. When the file cannot be
+ * mapped (e.g. it is not a regular file), it is read into a heap buffer.
+ *
+ * File is mapped byte by byte, the simulated endian is irrelevant for it.
+ */
+class MappedFile final : public BackendMemory {
+public:
+    /**
+     * @param path      host file to map, error is reported by `SimulatorExceptionInput`
+     * @param writable  allow private writes, otherwise the range is read-only
+     */
+    MappedFile(const QString &path, bool writable, Endian simulated_machine_endian);
+    ~MappedFile() override;
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /** Discard private writes, content is the file again. */
+    void reset();
+
+    WriteResult
+    write(Offset destination, const void *source, size_t size, WriteOptions options) override;
+
+    ReadResult
+    read(void *destination, Offset source, size_t size, ReadOptions options) const override;
+
+    [[nodiscard]] LocationStatus location_status(Offset offset) const override;
+
+    /** Provided for writable mapping only, read-only pages must not be written through it. */
+    [[nodiscard]] byte *direct_access(Offset offset, size_t size) const override;
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    QFile file;
+    const bool writable;
+    byte *storage = nullptr;
+    size_t storage_size = 0;
+    /** Storage is mapping of the file (otherwise heap buffer). */
+    bool mapped = false;
+
+    void map();
+    void unmap();
+};
+
+} // namespace machine
+
+#endif // MAPPED_FILE_H
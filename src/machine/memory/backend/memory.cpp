@@ -3,6 +3,8 @@
 #include "common/endian.h"
 #include "simulator_exception.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 namespace machine {
@@ -79,97 +81,208 @@ bool MemorySection::operator!=(const MemorySection &ms) const {
 
 // Settings sanity checks
 static_assert(MEMORY_SECTION_SIZE != 0, "Nonzero memory section size is required.");
-static_assert(MEMORY_TREE_ROW_SIZE != 0, "Nonzero memory tree row size is required.");
 static_assert(
-    ((32 - MEMORY_SECTION_BITS) % MEMORY_TREE_BITS) == 0,
-    "Number of bits in tree row has to be exact division of available number "
-    "of bits.");
+    MEMORY_ADDRESS_BITS > MEMORY_SECTION_BITS && MEMORY_ADDRESS_BITS <= 64,
+    "Address space has to be wider than a section and fit into 64 bits.");
 
 /**
- * Generate mask to get memory section index from address.
- *
- * Memory section of section_size 2^`section_size` separably addressable units
- * each of section_size 2^`unit_size` bytes.
- *
- * Example:
- *  `MemorySection` of 256x1B index is received as
- *  ```address & generate_mask(8, 0)```
+ * Index of the section (key in the section map) containing given offset.
  */
-constexpr uint64_t generate_mask(size_t section_size, size_t unit_size) {
-    return ((1U << section_size) - 1) << unit_size;
+constexpr uint64_t get_section_index(Offset offset) {
+    return uint64_t(offset) >> MEMORY_SECTION_BITS;
 }
 
-/**
- * Get index in row for given offset and row number i
- */
-constexpr size_t tree_row_bit_offset(size_t i) {
-    return 32 - MEMORY_TREE_BITS - i * MEMORY_TREE_BITS;
+static uint64_t allocate_memory_instance_id() {
+    static std::atomic<uint64_t> next_id { 1 };
+    return next_id++;
 }
 
-/*
- * Select branch index from memory tree.
- */
-constexpr size_t get_tree_row(size_t offset, size_t i) {
-    return (offset & generate_mask(MEMORY_TREE_BITS, tree_row_bit_offset(i)))
-           >> tree_row_bit_offset(i);
+Memory::Memory() : BackendMemory(BIG), instance_id(allocate_memory_instance_id()) {
+    // This is dummy constructor for qt internal uses only.
 }
 
-Memory::Memory() : BackendMemory(BIG) {
-    // This is dummy constructor for qt internal uses only.
-    this->mt_root = nullptr;
+Memory::Memory(Endian simulated_machine_endian)
+    : BackendMemory(simulated_machine_endian)
+    , instance_id(allocate_memory_instance_id()) {}
+
+Memory::Memory(const Memory &other)
+    : BackendMemory(other.simulated_machine_endian)
+    , instance_id(allocate_memory_instance_id()) {
+    copy_sections(other);
 }
 
-Memory::Memory(Endian simulated_machine_endian) : BackendMemory(simulated_machine_endian) {
-    this->mt_root = allocate_section_tree();
+Memory::~Memory() = default;
+
+void Memory::reset() {
+    mark_content_dirty();
+    sections.clear();
+    lazy.reset();
+    last_slot = nullptr;
+    private_sections.clear();
+    cow_source_id = 0;
+    epoch++;
 }
 
-Memory::Memory(const Memory &other) : BackendMemory(other.simulated_machine_endian) {
-    this->mt_root = copy_section_tree(other.get_memory_tree_root(), 0);
+void Memory::reset(const Memory &m) {
+    if (&m == this) { return; }
+    if (cow_source_id == m.instance_id && cow_source_epoch == m.epoch) {
+        // Source did not change since the copy, all other sections are still shared with it.
+        for (uint64_t index : private_sections) {
+            mark_section_dirty(index);
+            auto iter = m.sections.find(index);
+            if (iter == m.sections.end()) {
+                sections.erase(index);
+            } else {
+                sections[index] = iter->second;
+            }
+        }
+        private_sections.clear();
+        last_slot = nullptr;
+        epoch++;
+        return;
+    }
+    reset();
+    copy_sections(m);
+    mark_content_dirty();
 }
 
-Memory::~Memory() {
-    free_section_tree(this->mt_root, 0);
-    delete[] this->mt_root;
+void Memory::set_lazy_content(
+    std::vector<MemorySegment> segments,
+    std::shared_ptr<const void> owner) {
+    reset();
+    segments.erase(
+        std::remove_if(
+            segments.begin(), segments.end(),
+            [](const MemorySegment &segment) { return segment.size == 0; }),
+        segments.end());
+    std::sort(
+        segments.begin(), segments.end(),
+        [](const MemorySegment &a, const MemorySegment &b) { return a.offset < b.offset; });
+    if (!segments.empty()) {
+        lazy = std::make_shared<const LazyContent>(
+            LazyContent { std::move(segments), std::move(owner) });
+    }
+    mark_content_dirty();
 }
 
-void Memory::reset() {
-    free_section_tree(this->mt_root, 0);
-    delete[] this->mt_root;
-    this->mt_root = allocate_section_tree();
+void Memory::copy_sections(const Memory &other) {
+    // Sections are shared, they are copied on first write.
+    sections = other.sections;
+    lazy = other.lazy;
+    cow_source_id = other.instance_id;
+    cow_source_epoch = other.epoch;
 }
 
-void Memory::reset(const Memory &m) {
-    free_section_tree(this->mt_root, 0);
-    this->mt_root = copy_section_tree(m.get_memory_tree_root(), 0);
+void Memory::make_private(uint64_t index) const {
+    private_sections.push_back(index);
+    epoch++;
+}
+
+void Memory::mark_section_dirty(uint64_t index) {
+    if (!dirty_tracking) { return; }
+    const Offset first = Offset(index << MEMORY_SECTION_BITS);
+    dirty.mark(first, first + MEMORY_SECTION_SIZE - 1);
+}
+
+void Memory::mark_content_dirty() {
+    if (!dirty_tracking) { return; }
+    for (const auto &entry : sections) {
+        mark_section_dirty(entry.first);
+    }
+    if (lazy) {
+        for (const MemorySegment &segment : lazy->segments) {
+            dirty.mark(segment.offset, segment.offset + segment.size - 1);
+        }
+    }
+}
+
+bool Memory::lazy_covers(uint64_t index) const {
+    if (!lazy) { return false; }
+    // There are only a few segments (program headers), linear search is fine.
+    for (const MemorySegment &segment : lazy->segments) {
+        if (index >= get_section_index(segment.offset)
+            && index <= get_section_index(segment.offset + segment.size - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Memory::lazy_fill(uint64_t index, MemorySection &section) const {
+    const Offset first = Offset(index << MEMORY_SECTION_BITS);
+    const Offset last = first + MEMORY_SECTION_SIZE - 1;
+    for (const MemorySegment &segment : lazy->segments) {
+        const Offset segment_last = segment.offset + segment.size - 1;
+        if (segment.offset > last || segment_last < first) { continue; }
+        const Offset from = std::max(first, segment.offset);
+        const Offset to = std::min(last, segment_last);
+        section.write(from - first, segment.data + (from - segment.offset), to - from + 1, {});
+    }
+}
+
+const MemorySection *
+Memory::section_view(uint64_t index, std::unique_ptr<MemorySection> &scratch) const {
+    auto iter = sections.find(index);
+    if (iter != sections.end()) { return iter->second.get(); }
+    if (!lazy_covers(index)) { return nullptr; }
+    scratch = std::make_unique<MemorySection>(MEMORY_SECTION_SIZE, simulated_machine_endian);
+    lazy_fill(index, *scratch);
+    return scratch.get();
 }
 
 MemorySection *Memory::get_section(size_t offset, bool create) const {
-    union MemoryTree *w = this->mt_root;
-    size_t row_num;
-    // Walk memory tree branch from root to leaf and create new nodes when
-    // needed and requested (`create` flag).
-    for (size_t i = 0; i < (MEMORY_TREE_DEPTH - 1); i++) {
-        row_num = get_tree_row(offset, i);
-        if (w[row_num].subtree == nullptr) {
-            // We don't have this tree so allocate it.
-            if (!create) {
-                // If we shouldn't be creating it than just return// null.
-                return nullptr;
-            }
-            w[row_num].subtree = allocate_section_tree();
+    const uint64_t index = get_section_index(offset);
+    std::shared_ptr<MemorySection> *slot = last_slot;
+
+    if (slot == nullptr || last_index != index) {
+        auto iter = sections.find(index);
+        if (iter == sections.end()) {
+            const bool from_lazy = lazy_covers(index);
+            if (!create && !from_lazy) { return nullptr; }
+            auto section
+                = std::make_shared<MemorySection>(MEMORY_SECTION_SIZE, simulated_machine_endian);
+            // Lazy content is installed on the first touch, read or write.
+            if (from_lazy) { lazy_fill(index, *section); }
+            iter = sections.emplace(index, std::move(section)).first;
+            make_private(index);
         }
-        w = w[row_num].subtree;
+        slot = &iter->second;
+        last_index = index;
+        last_slot = slot;
     }
-    row_num = get_tree_row(offset, MEMORY_TREE_DEPTH - 1);
-    if (w[row_num].sec == nullptr) {
-        if (!create) { return nullptr; }
-        w[row_num].sec = new MemorySection(MEMORY_SECTION_SIZE, simulated_machine_endian);
+
+    if (create && slot->use_count() > 1) {
+        // Section is shared with a copy of the memory, unshare it before it is written.
+        *slot = std::make_shared<MemorySection>(**slot);
+        make_private(index);
+    }
+    return slot->get();
+}
+
+void Memory::for_each_section(
+    const std::function<void(Offset, const MemorySection &)> &visitor) const {
+    for (const auto &entry : sections) {
+        visitor(Offset(entry.first << MEMORY_SECTION_BITS), *entry.second);
+    }
+    if (!lazy) { return; }
+    std::unique_ptr<MemorySection> scratch;
+    bool any_visited = false;
+    uint64_t last_visited = 0;
+    for (const MemorySegment &segment : lazy->segments) {
+        uint64_t index = get_section_index(segment.offset);
+        // Segments are sorted, section shared by two of them is visited once.
+        if (any_visited && index <= last_visited) { index = last_visited + 1; }
+        for (; index <= get_section_index(segment.offset + segment.size - 1); index++) {
+            any_visited = true;
+            last_visited = index;
+            if (sections.count(index) != 0) { continue; }
+            visitor(Offset(index << MEMORY_SECTION_BITS), *section_view(index, scratch));
+        }
     }
-    return w[row_num].sec;
 }
 
 size_t get_section_offset_mask(size_t addr) {
-    return addr & generate_mask(MEMORY_SECTION_BITS, 0);
+    return addr & (MEMORY_SECTION_SIZE - 1);
 }
 
 WriteResult
@@ -178,7 +291,12 @@ Memory::write(Offset destination, const void *source, size_t size, WriteOptions
         destination, source, size, options,
         [this](Offset _destination, const void *_source, size_t _size, WriteOptions) {
             MemorySection *section = this->get_section(_destination, true);
-            return section->write(get_section_offset_mask(_destination), _source, _size, {});
+            WriteResult result
+                = section->write(get_section_offset_mask(_destination), _source, _size, {});
+            if (result.changed && dirty_tracking) {
+                dirty.mark(_destination, _destination + result.n_bytes - 1);
+            }
+            return result;
         });
 }
 
@@ -189,6 +307,8 @@ ReadResult Memory::read(void *destination, Offset source, size_t size, ReadOptio
             void *_destination, Offset _source, size_t _size, ReadOptions _options) -> ReadResult {
             MemorySection *section = this->get_section(_source, false);
             if (section == nullptr) {
+                // Bytes up to the end of the missing section read as zero.
+                _size = std::min(_size, MEMORY_SECTION_SIZE - get_section_offset_mask(_source));
                 memset(_destination, 0, _size);
                 // TODO Warning read of uninitialized memory
                 return { .n_bytes = _size };
@@ -199,82 +319,58 @@ ReadResult Memory::read(void *destination, Offset source, size_t size, ReadOptio
         });
 }
 
-uint32_t Memory::get_change_counter() const {
-    return change_counter;
-}
-
-bool Memory::operator==(const Memory &m) const {
-    return compare_section_tree(this->mt_root, m.get_memory_tree_root(), 0);
-}
-
-bool Memory::operator!=(const Memory &m) const {
-    return !this->operator==(m);
+size_t Memory::collect_and_clear_dirty(
+    Offset first,
+    Offset last,
+    const std::function<void(Offset)> &visitor) {
+    return dirty.collect_and_clear(first, last, [&visitor](uint64_t page) { visitor(page); });
 }
 
-const union machine::MemoryTree *Memory::get_memory_tree_root() const {
-    return this->mt_root;
-}
-
-union machine::MemoryTree *Memory::allocate_section_tree() {
-    auto *mt = new union MemoryTree[MEMORY_TREE_ROW_SIZE];
-    memset(mt, 0, sizeof *mt * MEMORY_TREE_ROW_SIZE);
-    return mt;
+bool Memory::set_dirty_tracking(bool enable) {
+    dirty_tracking = enable;
+    if (!enable) { dirty.clear(); }
+    return true;
 }
 
-void Memory::free_section_tree(union MemoryTree *mt, size_t depth) {
-    if (depth < (MEMORY_TREE_DEPTH - 1)) { // Following level is memory tree
-        for (size_t i = 0; i < MEMORY_TREE_ROW_SIZE; i++) {
-            if (mt[i].subtree != nullptr) {
-                free_section_tree(mt[i].subtree, depth + 1);
-                delete[] mt[i].subtree;
-            }
-        }
-    } else { // Following level is memory section
-        for (size_t i = 0; i < MEMORY_TREE_ROW_SIZE; i++) {
-            delete mt[i].sec;
-        }
-    }
+uint32_t Memory::get_change_counter() const {
+    return change_counter;
 }
 
-bool Memory::compare_section_tree(
-    const union MemoryTree *mt1,
-    const union MemoryTree *mt2,
-    size_t depth) {
-    if (depth < (MEMORY_TREE_DEPTH - 1)) { // Following level is memory tree
-        for (size_t i = 0; i < MEMORY_TREE_ROW_SIZE; i++) {
-            if (((mt1[i].subtree == nullptr || mt2[i].subtree == nullptr)
-                 && mt1[i].subtree != mt2[i].subtree)
-                || (mt1[i].subtree != nullptr && mt2[i].subtree != nullptr
-                    && !compare_section_tree(mt1[i].subtree, mt2[i].subtree, depth + 1))) {
-                return false;
-            }
-        }
-    } else { // Following level is memory section
-        for (size_t i = 0; i < MEMORY_TREE_ROW_SIZE; i++) {
-            if (((mt1[i].sec == nullptr || mt2[i].sec == nullptr) && mt1[i].sec != mt2[i].sec)
-                || (mt1[i].sec != nullptr && mt2[i].sec != nullptr && *mt1[i].sec != *mt2[i].sec)) {
+bool Memory::operator==(const Memory &m) const {
+    // Allocated sections are compared too, zero write differs from no write.
+    if (!lazy && !m.lazy) {
+        if (sections.size() != m.sections.size()) { return false; }
+        for (const auto &entry : sections) {
+            auto other = m.sections.find(entry.first);
+            if (other == m.sections.end()) { return false; }
+            // Shared section is trivially equal.
+            if (entry.second != other->second && *entry.second != *other->second) {
                 return false;
             }
         }
+        return true;
     }
-    return true;
+
+    // Sections of lazy content count as allocated, whether accessed or not.
+    std::unique_ptr<MemorySection> other_scratch;
+    size_t count = 0;
+    bool equal = true;
+    for_each_section([&](Offset offset, const MemorySection &section) {
+        count++;
+        if (!equal) { return; }
+        const MemorySection *other = m.section_view(get_section_index(offset), other_scratch);
+        equal = other != nullptr && (other == &section || *other == section);
+    });
+    if (!equal) { return false; }
+    size_t other_count = 0;
+    m.for_each_section([&other_count](Offset, const MemorySection &) { other_count++; });
+    return count == other_count;
 }
 
-union machine::MemoryTree *Memory::copy_section_tree(const union MemoryTree *mt, size_t depth) {
-    union MemoryTree *nmt = allocate_section_tree();
-    if (depth < (MEMORY_TREE_DEPTH - 1)) { // Following level is memory tree
-        for (size_t i = 0; i < MEMORY_TREE_ROW_SIZE; i++) {
-            if (mt[i].subtree != nullptr) {
-                nmt[i].subtree = copy_section_tree(mt[i].subtree, depth + 1);
-            }
-        }
-    } else { // Following level is memory section
-        for (size_t i = 0; i < MEMORY_TREE_ROW_SIZE; i++) {
-            if (mt[i].sec != nullptr) { nmt[i].sec = new MemorySection(*mt[i].sec); }
-        }
-    }
-    return nmt;
+bool Memory::operator!=(const Memory &m) const {
+    return !this->operator==(m);
 }
+
 LocationStatus Memory::location_status(Offset offset) const {
     UNUSED(offset)
     // Lazy allocation of memory is only internal implementation detail.
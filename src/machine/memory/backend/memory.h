@@ -5,12 +5,17 @@
 #include "machinedefs.h"
 #include "memory/address.h"
 #include "memory/backend/backend_memory.h"
+#include "memory/dirty_page_map.h"
 #include "memory/memory_utils.h"
 #include "simulator_exception.h"
 #include "utils.h"
 
 #include <QObject>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace machine {
 
@@ -46,22 +51,39 @@ private:
 /// Some optimisation options
 // How big memory sections will be in bits (2^8=256 bytes)
 constexpr size_t MEMORY_SECTION_BITS = 8;
-// How big one row of lookup tree will be in bits (2^4=16)
-constexpr size_t MEMORY_TREE_BITS = 4;
+// Width of the physical address space, which can be backed by memory. It
+// covers the 56-bit physical addresses of RV64.
+constexpr size_t MEMORY_ADDRESS_BITS = 56;
 //////////////////////////////////////////////////////////////////////////////
 // Size of one section
 constexpr size_t MEMORY_SECTION_SIZE = (1u << MEMORY_SECTION_BITS);
-// Size of one memory row
-constexpr size_t MEMORY_TREE_ROW_SIZE = (1u << MEMORY_TREE_BITS);
-// Depth of tree
-constexpr size_t MEMORY_TREE_DEPTH = ((32 - MEMORY_SECTION_BITS) / MEMORY_TREE_BITS);
-
-union MemoryTree {
-    union MemoryTree *subtree;
-    MemorySection *sec;
+
+/**
+ * Part of memory content provided by an external buffer.
+ * @see Memory::set_lazy_content
+ */
+struct MemorySegment {
+    Offset offset;
+    const byte *data;
+    size_t size;
 };
 
 /**
+ * Sparse memory covering the whole physical address space.
+ *
+ * Sections are allocated on first write and kept in a hash map indexed by
+ * section number, so lookup cost does not depend on the address width and
+ * RAM can be placed anywhere in the physical address space. The last used
+ * section is remembered to skip hashing for consecutive accesses.
+ *
+ * Copies share sections by reference count and a shared section is copied
+ * on its first write (copy-on-write). Memory remembers which sections it has
+ * written since it was copied from its source, so resetting it to the same
+ * unchanged source again only reverts those sections.
+ *
+ * Content can be also provided lazily by external buffers (e.g. loaded
+ * executable file). A section covered by them is filled on its first access.
+ *
  * NOTE: Internal endian of memory must be the same as endian of the whole
  * simulated machine. Therefore it does not have internal_endian field.
  */
@@ -73,13 +95,30 @@ public:
     explicit Memory(Endian simulated_machine_endian);
     Memory(const Memory &);
     ~Memory() override;
-    void reset(); // Reset whole content of memory (removes old tree and creates
-                  // new one)
+    void reset(); // Reset whole content of memory (removes all sections)
     void reset(const Memory &);
 
-    // returns section containing given address
+    /**
+     * Replace content of memory by segments, which are not copied up front.
+     *
+     * Sections are filled from the segments on first access, bytes outside of
+     * them are zero. Copies of the memory share the segments, `owner` keeps
+     * the segment data alive as long as any of them needs it.
+     */
+    void set_lazy_content(std::vector<MemorySegment> segments, std::shared_ptr<const void> owner);
+
+    // returns section containing given address, section returned with create
+    // set is not shared with any other memory and can be written
     [[nodiscard]] MemorySection *get_section(size_t offset, bool create) const;
 
+    /**
+     * Call `visitor` for each allocated section with offset of its first byte.
+     * Sections of lazy content are visited too, even if not accessed yet.
+     * Order of sections is not specified.
+     */
+    void for_each_section(
+        const std::function<void(Offset, const MemorySection &)> &visitor) const;
+
     WriteResult
     write(Offset destination, const void *source, size_t size, WriteOptions options) override;
 
@@ -88,19 +127,57 @@ public:
 
     [[nodiscard]] LocationStatus location_status(Offset offset) const override;
 
+    /**
+     * Pages changed by writes and resets since the last call.
+     * Memory created by copy starts with no dirty pages and tracking off.
+     */
+    size_t collect_and_clear_dirty(
+        Offset first,
+        Offset last,
+        const std::function<void(Offset)> &visitor) override;
+
+    bool set_dirty_tracking(bool enable) override;
+
     bool operator==(const Memory &) const;
     bool operator!=(const Memory &) const;
 
-    [[nodiscard]] const union MemoryTree *get_memory_tree_root() const;
-
 private:
-    union MemoryTree *mt_root;
+    using SectionMap = std::unordered_map<uint64_t, std::shared_ptr<MemorySection>>;
+    // Mutable as `get_section` is const and may allocate or unshare sections.
+    mutable SectionMap sections;
+    mutable uint64_t last_index = 0;
+    // Element references of the map are stable, slot stays valid until erased.
+    mutable std::shared_ptr<MemorySection> *last_slot = nullptr;
     uint32_t change_counter = 0;
-    static union MemoryTree *allocate_section_tree();
-    static void free_section_tree(union MemoryTree *, size_t depth);
-    static bool
-    compare_section_tree(const union MemoryTree *, const union MemoryTree *, size_t depth);
-    static union MemoryTree *copy_section_tree(const union MemoryTree *, size_t depth);
+    DirtyPageMap dirty;
+    bool dirty_tracking = false;
+
+    struct LazyContent {
+        // Sorted by offset, not empty
+        std::vector<MemorySegment> segments;
+        std::shared_ptr<const void> owner;
+    };
+    std::shared_ptr<const LazyContent> lazy;
+
+    // Copy-on-write bookkeeping
+    const uint64_t instance_id;
+    // Incremented whenever a section is allocated, unshared or dropped.
+    mutable uint64_t epoch = 0;
+    // Memory, this one was copied from, and its epoch at the time (0 is none).
+    uint64_t cow_source_id = 0;
+    uint64_t cow_source_epoch = 0;
+    // Sections allocated or unshared since the copy from the source.
+    mutable std::vector<uint64_t> private_sections;
+
+    void copy_sections(const Memory &);
+    void make_private(uint64_t index) const;
+    void mark_section_dirty(uint64_t index);
+    void mark_content_dirty();
+    [[nodiscard]] bool lazy_covers(uint64_t index) const;
+    void lazy_fill(uint64_t index, MemorySection &section) const;
+    // Section with given index without allocating it, null when there is no content.
+    [[nodiscard]] const MemorySection *
+    section_view(uint64_t index, std::unique_ptr<MemorySection> &scratch) const;
     [[nodiscard]] uint32_t get_change_counter() const;
 };
 } // namespace machine
@@ -2,11 +2,15 @@
 
 #include "common/endian.h"
 #include "machine/machinedefs.h"
+#include "machine/memory/backend/flat_memory.h"
+#include "machine/memory/backend/mapped_file.h"
 #include "machine/memory/backend/memory.h"
 #include "machine/memory/memory_bus.h"
 #include "machine/memory/memory_utils.h"
 #include "tests/utils/integer_decomposition.h"
 
+#include <QTemporaryFile>
+#include <algorithm>
 #include <cinttypes>
 
 using namespace machine;
@@ -369,4 +373,357 @@ void TestMemory::memory_memtest() {
     }
 }
 
+void TestMemory::memory_wide_address_data() {
+    prepare_endian_test();
+}
+
+void TestMemory::memory_wide_address() {
+    QFETCH(Endian, endian);
+    Memory mem(endian);
+
+    // Offsets differing only above 32 bits must not alias.
+    memory_write_u64(&mem, 0x20, 0x1111111111111111ULL);
+    memory_write_u64(&mem, 0x100000020, 0x2222222222222222ULL);
+    memory_write_u64(&mem, 0x00fffffffffffff8, 0x3333333333333333ULL);
+    QCOMPARE(memory_read_u64(&mem, 0x20), (uint64_t)0x1111111111111111ULL);
+    QCOMPARE(memory_read_u64(&mem, 0x100000020), (uint64_t)0x2222222222222222ULL);
+    QCOMPARE(memory_read_u64(&mem, 0x00fffffffffffff8), (uint64_t)0x3333333333333333ULL);
+    QCOMPARE(memory_read_u64(&mem, 0x200000020), (uint64_t)0);
+
+    // Read spanning an unallocated and an allocated section.
+    memory_write_u32(&mem, 0x1000, 0x44444444);
+    const uint64_t spanning = (endian == BIG) ? 0x44444444ULL : 0x44444444ULL << 32;
+    QCOMPARE(memory_read_u64(&mem, 0x1000 - 4), spanning);
+
+    // One device can back several bus ranges with identity offsets.
+    MemoryDataBus bus(endian);
+    QVERIFY(bus.insert_device_to_range(&mem, 0x0_addr, 0xefffffff_addr, false));
+    QVERIFY(bus.insert_device_to_range(
+        &mem, 0x100000000_addr, 0x00ffffffffffffff_addr, false, 0x100000000));
+    QCOMPARE(bus.read_u64(0x20_addr), (uint64_t)0x1111111111111111ULL);
+    QCOMPARE(bus.read_u64(0x100000020_addr), (uint64_t)0x2222222222222222ULL);
+    QCOMPARE(bus.read_u64(0x00fffffffffffff8_addr), (uint64_t)0x3333333333333333ULL);
+    QCOMPARE(bus.location_status(0xf0000000_addr), LOCSTAT_ILLEGAL);
+}
+
+void TestMemory::memory_copy_on_write_data() {
+    prepare_endian_test();
+}
+
+void TestMemory::memory_copy_on_write() {
+    QFETCH(Endian, endian);
+    Memory image(endian);
+    memory_write_u32(&image, 0x0, 0x11111111);
+    memory_write_u32(&image, 0x1000, 0x22222222);
+
+    Memory mem(image);
+    QCOMPARE(mem.get_section(0x0, false), image.get_section(0x0, false));
+    QCOMPARE(mem.get_section(0x1000, false), image.get_section(0x1000, false));
+
+    // Write unshares only the written section and does not leak to the image.
+    memory_write_u32(&mem, 0x0, 0x33333333);
+    memory_write_u32(&mem, 0x2000, 0x44444444);
+    QCOMPARE(memory_read_u32(&mem, 0x0), (uint32_t)0x33333333);
+    QCOMPARE(memory_read_u32(&image, 0x0), (uint32_t)0x11111111);
+    QCOMPARE(memory_read_u32(&image, 0x2000), (uint32_t)0);
+    QVERIFY(mem.get_section(0x0, false) != image.get_section(0x0, false));
+    QCOMPARE(mem.get_section(0x1000, false), image.get_section(0x1000, false));
+
+    // Write to the image does not leak to the copy either.
+    memory_write_u32(&image, 0x1000, 0x55555555);
+    QCOMPARE(memory_read_u32(&mem, 0x1000), (uint32_t)0x22222222);
+
+    // Reset to the unchanged source reverts written sections only.
+    Memory copy(image);
+    memory_write_u32(&copy, 0x0, 0x66666666);
+    memory_write_u32(&copy, 0x3000, 0x77777777);
+    copy.reset(image);
+    QVERIFY(copy == image);
+    QCOMPARE(copy.get_section(0x0, false), image.get_section(0x0, false));
+    QCOMPARE(copy.get_section(0x3000, false), (MemorySection *)nullptr);
+
+    // Reset to a changed source copies it again.
+    memory_write_u32(&copy, 0x0, 0x66666666);
+    memory_write_u32(&image, 0x4000, 0x88888888);
+    copy.reset(image);
+    QVERIFY(copy == image);
+    QCOMPARE(memory_read_u32(&copy, 0x4000), (uint32_t)0x88888888);
+}
+
+void TestMemory::memory_dirty_pages_data() {
+    prepare_endian_test();
+}
+
+void TestMemory::memory_dirty_pages() {
+    QFETCH(Endian, endian);
+    Memory mem(endian);
+    QVector<Offset> pages;
+    auto collect = [&pages](Offset page) { pages.append(page); };
+
+    // Nothing is tracked until a consumer enables it.
+    memory_write_u32(&mem, 0x20, 0x77777777);
+    QCOMPARE(mem.collect_and_clear_dirty(0x0, ~Offset(0), collect), (size_t)0);
+    QVERIFY(mem.set_dirty_tracking(true));
+
+    memory_write_u32(&mem, 0x10, 0x11111111);
+    memory_write_u64(&mem, 0x2ffc, 0x2222222222222222ULL); // Spans two pages
+    memory_write_u32(&mem, 0x100000000, 0x33333333);
+    QCOMPARE(mem.collect_and_clear_dirty(0x0, 0x2fff, collect), (size_t)2);
+    std::sort(pages.begin(), pages.end());
+    QCOMPARE(pages, QVector<Offset>({ 0x0, 0x2000 }));
+
+    // Collected pages are cleared, others are kept.
+    pages.clear();
+    QCOMPARE(mem.collect_and_clear_dirty(0x0, ~Offset(0), collect), (size_t)2);
+    std::sort(pages.begin(), pages.end());
+    QCOMPARE(pages, QVector<Offset>({ 0x3000, 0x100000000 }));
+    QCOMPARE(mem.collect_and_clear_dirty(0x0, ~Offset(0), collect), (size_t)0);
+
+    // Write of the same value is not a change.
+    memory_write_u32(&mem, 0x10, 0x11111111);
+    QCOMPARE(mem.collect_and_clear_dirty(0x0, ~Offset(0), collect), (size_t)0);
+
+    // Bus reports writes through it and pages changed directly in the device once.
+    MemoryDataBus bus(endian);
+    QVERIFY(bus.insert_device_to_range(&mem, 0x10000000_addr, 0x1fffffff_addr, false));
+    bus.set_dirty_tracking(true);
+    QVector<uint64_t> addresses;
+    auto collect_addr = [&addresses](Address page) { addresses.append(page.get_raw()); };
+    bus.write_u32(0x10001000_addr, 0x44444444);
+    memory_write_u32(&mem, 0x1004, 0x55555555);
+    memory_write_u32(&mem, 0x5000, 0x66666666);
+    QCOMPARE(bus.collect_and_clear_dirty(0x0_addr, 0xffffffff_addr, collect_addr), (size_t)2);
+    std::sort(addresses.begin(), addresses.end());
+    QCOMPARE(addresses, QVector<uint64_t>({ 0x10001000, 0x10005000 }));
+    QCOMPARE(bus.collect_and_clear_dirty(0x0_addr, 0xffffffff_addr, collect_addr), (size_t)0);
+
+    // Device page covers two bus pages of a range not aligned to pages, up to its end.
+    Memory shifted(endian);
+    MemoryDataBus shifted_bus(endian);
+    QVERIFY(shifted_bus.insert_device_to_range(&shifted, 0x2000_addr, 0x3fff_addr, false, 0x800));
+    shifted_bus.set_dirty_tracking(true);
+    memory_write_u32(&shifted, 0x1000, 0x77777777);
+    addresses.clear();
+    QCOMPARE(
+        shifted_bus.collect_and_clear_dirty(0x0_addr, 0xffffffff_addr, collect_addr), (size_t)2);
+    std::sort(addresses.begin(), addresses.end());
+    QCOMPARE(addresses, QVector<uint64_t>({ 0x2000, 0x3000 }));
+    memory_write_u32(&shifted, 0x2000, 0x77777777);
+    addresses.clear();
+    QCOMPARE(
+        shifted_bus.collect_and_clear_dirty(0x0_addr, 0xffffffff_addr, collect_addr), (size_t)1);
+    QCOMPARE(addresses, QVector<uint64_t>({ 0x3000 }));
+
+    // Reset marks all dropped sections.
+    mem.reset();
+    QCOMPARE(mem.collect_and_clear_dirty(0x0, ~Offset(0), collect), (size_t)6);
+}
+
+void TestMemory::memory_block_transfer_data() {
+    prepare_endian_test();
+}
+
+void TestMemory::memory_block_transfer() {
+    QFETCH(Endian, endian);
+    Memory mem(endian);
+    FlatMemory flat(0x10000, endian);
+    MemoryDataBus bus(endian);
+    QVERIFY(bus.insert_device_to_range(&mem, 0x0_addr, 0xffff_addr, false));
+    QVERIFY(bus.insert_device_to_range(&flat, 0x10000_addr, 0x1ffff_addr, false));
+
+    // Block spans several pages and both devices.
+    QVector<uint8_t> data(0x3000);
+    for (int i = 0; i < data.size(); i++) {
+        data[i] = uint8_t(i * 7);
+    }
+    QCOMPARE(bus.write_block(0xe800_addr, data.data(), data.size()), (size_t)data.size());
+    QVector<uint8_t> back(data.size());
+    QCOMPARE(bus.read_block(back.data(), 0xe800_addr, back.size()), (size_t)back.size());
+    QCOMPARE(back, data);
+    QCOMPARE(memory_read_u8(&mem, 0xe801), data[1]);
+    QCOMPARE(memory_read_u8(&flat, 0x1000), data[0x2800]);
+
+    // Nothing is mapped past the second device, the write stops there.
+    QCOMPARE(bus.write_block(0x1f800_addr, data.data(), 0x1000), (size_t)0x800);
+}
+
+void TestMemory::memory_bus_ranges() {
+    Memory first(LITTLE), second(LITTLE), low(LITTLE), high(LITTLE);
+    memory_write_u32(&first, 0x1000, 0x11111111);
+    memory_write_u32(&second, 0x0, 0x22222222);
+    memory_write_u32(&second, 0x40000, 0x33333333);
+    memory_write_u32(&low, 0x0, 0x44444444);
+    memory_write_u32(&high, 0x0, 0x55555555);
+    MemoryDataBus bus(LITTLE);
+
+    // Each lookup below is preceded by one of the same page, which stays in the lookup cache.
+    QVERIFY(bus.insert_device_to_range(&first, 0x0_addr, 0xffff_addr, false));
+    QCOMPARE(bus.read_u32(0x1000_addr), 0x11111111u);
+    QVERIFY(bus.remove_device(&first));
+    QCOMPARE(bus.read_u32(0x1000_addr), 0u);
+    QCOMPARE(bus.location_status(0x1000_addr), LOCSTAT_ILLEGAL);
+    QVERIFY(!bus.remove_device(&first));
+
+    // Page 0x41000 shares the lookup cache slot with page 0x1000.
+    QVERIFY(bus.insert_device_to_range(&second, 0x1000_addr, 0x41fff_addr, false));
+    QCOMPARE(bus.read_u32(0x1000_addr), 0x22222222u);
+    QCOMPARE(bus.read_u32(0x41000_addr), 0x33333333u);
+    QCOMPARE(bus.read_u32(0x1000_addr), 0x22222222u);
+
+    // Hole is filled by a later insertion.
+    QCOMPARE(bus.read_u32(0x42000_addr), 0u);
+    QVERIFY(bus.insert_device_to_range(&first, 0x42000_addr, 0x42fff_addr, false, 0x1000));
+    QCOMPARE(bus.read_u32(0x42000_addr), 0x11111111u);
+
+    // Ranges sharing a page are told apart.
+    QVERIFY(bus.remove_device(&second));
+    QVERIFY(bus.insert_device_to_range(&low, 0x1000_addr, 0x10ff_addr, false));
+    QVERIFY(bus.insert_device_to_range(&high, 0x1100_addr, 0x11ff_addr, false));
+    for (int i = 0; i < 2; i++) {
+        QCOMPARE(bus.read_u32(0x1000_addr), 0x44444444u);
+        QCOMPARE(bus.read_u32(0x1100_addr), 0x55555555u);
+    }
+    QCOMPARE(bus.read_u32(0x1200_addr), 0u);
+    QCOMPARE(bus.read_u32(0x41000_addr), 0u);
+}
+
+void TestMemory::memory_lazy_content_data() {
+    prepare_endian_test();
+}
+
+void TestMemory::memory_lazy_content() {
+    QFETCH(Endian, endian);
+    std::vector<byte> text(0x300), data(0x10);
+    for (size_t i = 0; i < text.size(); i++) {
+        text[i] = byte(i);
+    }
+    std::fill(data.begin(), data.end(), 0xaa);
+
+    // Segments share the section at 0x1300.
+    Memory image(endian);
+    image.set_lazy_content(
+        { { 0x1308, data.data(), data.size() }, { 0x1000, text.data(), text.size() } }, nullptr);
+
+    Memory eager(endian);
+    eager.write(0x1000, text.data(), text.size(), {});
+    eager.write(0x1308, data.data(), data.size(), {});
+    QVERIFY(image == eager);
+
+    size_t visited = 0;
+    image.for_each_section([&visited](Offset, const MemorySection &) { visited++; });
+    QCOMPARE(visited, (size_t)4);
+
+    QCOMPARE(memory_read_u8(&image, 0x1002), (uint8_t)0x02);
+    QCOMPARE(memory_read_u8(&image, 0x1308), (uint8_t)0xaa);
+    QCOMPARE(memory_read_u8(&image, 0x1318), (uint8_t)0);
+
+    // Copy shares the lazy content, written section does not leak to the image.
+    Memory mem(image);
+    memory_write_u8(&mem, 0x1210, 0x55);
+    QCOMPARE(memory_read_u8(&mem, 0x1210), (uint8_t)0x55);
+    QCOMPARE(memory_read_u8(&image, 0x1210), (uint8_t)0x10);
+    QVERIFY(mem != image);
+    mem.reset(image);
+    QVERIFY(mem == image);
+    QCOMPARE(memory_read_u8(&mem, 0x1210), (uint8_t)0x10);
+}
+
+void TestMemory::flat_memory_data() {
+    prepare_endian_test();
+}
+
+void TestMemory::flat_memory() {
+    QFETCH(Endian, endian);
+    constexpr size_t size = 1024 * 1024;
+    FlatMemory flat(size, endian);
+    Memory reference(endian);
+
+    // Uninitialized memory should read as zero
+    QCOMPARE(memory_read_u64(&flat, 0x0), (uint64_t)0);
+    QCOMPARE(memory_read_u64(&flat, size - 8), (uint64_t)0);
+
+    // Content and endian handling matches the sparse memory.
+    memory_write_u64(&flat, 0x20, 0x2324252627282930ULL);
+    memory_write_u64(&reference, 0x20, 0x2324252627282930ULL);
+    for (size_t i = 0; i < 8; ++i) {
+        QCOMPARE(memory_read_u8(&flat, 0x20 + i), memory_read_u8(&reference, 0x20 + i));
+    }
+
+    // Direct access is limited to the range.
+    QVERIFY(flat.direct_access(0x20, 8) != nullptr);
+    QCOMPARE(*flat.direct_access(0x21, 1), memory_read_u8(&reference, 0x21));
+    QCOMPARE(flat.direct_access(size - 4, 8), (byte *)nullptr);
+    QCOMPARE(flat.direct_access(size, 1), (byte *)nullptr);
+
+    // Bus uses direct access and still reports changes.
+    MemoryDataBus bus(endian);
+    bus.insert_device_to_range(&flat, 0x0_addr, Address(size - 1), false);
+    QCOMPARE(bus.direct_access(0x20_addr, 8), flat.direct_access(0x20, 8));
+    QCOMPARE(bus.read_u64(0x20_addr), (uint64_t)0x2324252627282930ULL);
+    uint32_t change_counter = bus.get_change_counter();
+    QVERIFY(!bus.write_u32(0x20_addr, bus.read_u32(0x20_addr)));
+    QCOMPARE(bus.get_change_counter(), change_counter);
+    QVERIFY(bus.write_u32(0x40_addr, 0x11223344));
+    QCOMPARE(bus.get_change_counter(), change_counter + 1);
+    QCOMPARE(bus.read_u32(0x40_addr), (uint32_t)0x11223344);
+
+    // Reset from image copies only the part within range.
+    memory_write_u32(&reference, size + 0x100, 0xdeadbeef);
+    flat.reset(reference);
+    QCOMPARE(memory_read_u32(&flat, 0x40), (uint32_t)0);
+    QCOMPARE(memory_read_u64(&flat, 0x20), memory_read_u64(&reference, 0x20));
+
+    // Store replaces the part within range and keeps the rest of the image.
+    memory_write_u32(&flat, 0x3000, 0x55667788);
+    memory_write_u32(&flat, 0x20, 0);
+    flat.store(reference);
+    QCOMPARE(memory_read_u32(&reference, 0x3000), (uint32_t)0x55667788);
+    QCOMPARE(memory_read_u32(&reference, 0x20), (uint32_t)0);
+    QCOMPARE(memory_read_u32(&reference, size + 0x100), (uint32_t)0xdeadbeef);
+
+    // Single pages are stored and reset, other pages are kept.
+    memory_write_u32(&flat, 0x5000, 0x12345678);
+    memory_write_u32(&flat, 0x7ffc, 0x9abcdef0);
+    flat.store_page(reference, 0x5000);
+    QCOMPARE(memory_read_u32(&reference, 0x5000), (uint32_t)0x12345678);
+    QCOMPARE(memory_read_u32(&reference, 0x7ffc), (uint32_t)0);
+    flat.reset_page(reference, 0x7000);
+    QCOMPARE(memory_read_u32(&flat, 0x7ffc), (uint32_t)0);
+    QCOMPARE(memory_read_u32(&flat, 0x5000), (uint32_t)0x12345678);
+    memory_write_u32(&reference, 0x5000, 0);
+    flat.reset_page(reference, 0x5000);
+    QCOMPARE(memory_read_u32(&flat, 0x5000), (uint32_t)0);
+    QCOMPARE(memory_read_u32(&flat, 0x3000), (uint32_t)0x55667788);
+
+    flat.reset();
+    QCOMPARE(memory_read_u64(&flat, 0x20), (uint64_t)0);
+}
+
+void TestMemory::mapped_file() {
+    QTemporaryFile host_file;
+    QVERIFY(host_file.open());
+    const QByteArray content("0123456789abcdef");
+    host_file.write(content);
+    host_file.flush();
+
+    MappedFile read_only(host_file.fileName(), false, LITTLE);
+    QCOMPARE(read_only.size(), (size_t)content.size());
+    QCOMPARE(memory_read_u8(&read_only, 0x3), (uint8_t)'3');
+    QCOMPARE(read_only.location_status(0x0), LOCSTAT_READ_ONLY);
+    // Writes to read-only mapping are ignored.
+    memory_write_u8(&read_only, 0x3, 'x');
+    QCOMPARE(memory_read_u8(&read_only, 0x3), (uint8_t)'3');
+    QCOMPARE(read_only.direct_access(0x0, 1), (byte *)nullptr);
+
+    // Writes to private mapping do not reach the file and are discarded by reset.
+    MappedFile writable(host_file.fileName(), true, LITTLE);
+    memory_write_u8(&writable, 0xa, 'x');
+    QCOMPARE(memory_read_u8(&writable, 0xa), (uint8_t)'x');
+    QCOMPARE(memory_read_u8(&read_only, 0xa), (uint8_t)'a');
+    writable.reset();
+    QCOMPARE(memory_read_u8(&writable, 0xa), (uint8_t)'a');
+    host_file.seek(0);
+    QCOMPARE(host_file.readAll(), content);
+}
+
 QTEST_APPLESS_MAIN(TestMemory)
@@ -22,6 +22,20 @@ private slots:
     static void memory_read_ctl();
     static void memory_memtest_data();
     static void memory_memtest();
+    static void memory_wide_address_data();
+    static void memory_wide_address();
+    static void memory_copy_on_write_data();
+    static void memory_copy_on_write();
+    static void memory_dirty_pages_data();
+    static void memory_dirty_pages();
+    static void memory_block_transfer_data();
+    static void memory_block_transfer();
+    static void memory_bus_ranges();
+    static void memory_lazy_content_data();
+    static void memory_lazy_content();
+    static void flat_memory_data();
+    static void flat_memory();
+    static void mapped_file();
 };
 
 #endif // MEMORY_TEST_H
@@ -16,7 +16,7 @@ SimplePeripheral::write(Offset destination, const void *source, size_t size, Wri
 
     // Write to dummy periphery is nop
 
-    emit write_notification(destination, size);
+    if (!headless) { emit write_notification(destination, size); }
 
     return { size, false };
 }
@@ -27,7 +27,7 @@ SimplePeripheral::read(void *destination, Offset source, size_t size, ReadOption
 
     memset(destination, 0x12, size); // Random value
 
-    emit read_notification(source, size);
+    if (!headless) { emit read_notification(source, size); }
 
     return { size };
 }
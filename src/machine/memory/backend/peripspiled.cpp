@@ -55,7 +55,7 @@ uint32_t PeripSpiLed::read_reg(Offset source) const {
         }
     }();
 
-    emit read_notification(source, value);
+    if (!headless) { emit read_notification(source, value); }
 
     return value;
 }
@@ -68,7 +68,7 @@ bool PeripSpiLed::write_reg(Offset destination, uint32_t value) {
         case SPILED_REG_LED_LINE_o: {
             if (spiled_reg_led_line != value) {
                 spiled_reg_led_line = value;
-                emit led_line_changed(spiled_reg_led_line);
+                if (!headless) { emit led_line_changed(spiled_reg_led_line); }
                 return true;
             }
             return false;
@@ -76,14 +76,14 @@ bool PeripSpiLed::write_reg(Offset destination, uint32_t value) {
         case SPILED_REG_LED_RGB1_o:
             if (spiled_reg_led_rgb1 != value) {
                 spiled_reg_led_rgb1 = value;
-                emit led_rgb1_changed(spiled_reg_led_rgb1);
+                if (!headless) { emit led_rgb1_changed(spiled_reg_led_rgb1); }
                 return true;
             }
             return false;
         case SPILED_REG_LED_RGB2_o:
             if (spiled_reg_led_rgb2 != value) {
                 spiled_reg_led_rgb2 = value;
-                emit led_rgb2_changed(spiled_reg_led_rgb2);
+                if (!headless) { emit led_rgb2_changed(spiled_reg_led_rgb2); }
                 return true;
             }
             return false;
@@ -94,7 +94,7 @@ bool PeripSpiLed::write_reg(Offset destination, uint32_t value) {
         }
     }();
 
-    emit write_notification(destination, value);
+    if (!headless) { emit write_notification(destination, value); }
 
     return changed;
 }
@@ -126,7 +126,7 @@ uint32_t SerialPort::read_reg(Offset source, AccessEffects type) const {
     default: WARN("Serial port - read out of range (at 0x%zu).\n", source); break;
     }
 
-    emit read_notification(source, value);
+    if (!headless) { emit read_notification(source, value); }
 
     return value;
 }
@@ -155,7 +155,7 @@ bool SerialPort::write_reg(Offset destination, uint32_t value) {
         }
     }();
 
-    emit write_notification(destination, value);
+    if (!headless) { emit write_notification(destination, value); }
 
     return changed;
 }
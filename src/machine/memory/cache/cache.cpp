@@ -1,7 +1,9 @@
 #include "memory/cache/cache.h"
 
+#include "common/polyfills/ctz64.h"
 #include "memory/cache/cache_types.h"
 
+#include <algorithm>
 #include <cstddef>
 
 using ae = machine::AccessEffects; // For enum values, type is obvious from
@@ -19,45 +21,74 @@ Cache::Cache(
     : FrontendMemory(memory->simulated_machine_endian)
     , cache_config(config)
     , mem(memory)
-    , uncached_start(0xf0000000_addr)
-    , uncached_last(0xfffffffe_addr)
     , access_pen_r(memory_access_penalty_r)
     , access_pen_w(memory_access_penalty_w)
     , access_pen_b(memory_access_penalty_b)
     , access_ena_b(memory_access_enable_b)
-    , replacement_policy(CachePolicy::get_policy_instance(config)) {
+    , replacement_policy(CachePolicy::get_policy_instance(config))
+    , prefetcher(CachePrefetcher::get_prefetcher_instance(config)) {
     // Skip memory allocation if cache is disabled
     if (!config->enabled()) { return; }
 
-    dt.resize(
-        config->associativity(),
-        std::vector<CacheLine>(
-            config->set_count(), { .valid = false,
-                                   .dirty = false,
-                                   .tag = 0,
-                                   .data = std::vector<uint32_t>(config->block_size()) }));
+    const size_t line_count = size_t(config->associativity()) * config->set_count();
+    tags.assign(line_count, INVALID_TAG);
+    dirty.assign(line_count, false);
+    data.assign(line_count * config->block_size(), 0);
+    if (prefetcher != nullptr && !prefetcher->is_buffered()) {
+        prefetched.assign(line_count, false);
+        prefetch_issued_at.assign(line_count, 0);
+        pollution_tags.assign(line_count, INVALID_TAG);
+    }
+    miss_classifier = std::make_unique<CacheMissClassifier>(line_count);
+    if (config->victim_entries() > 0) {
+        victim_buffer
+            = std::make_unique<CacheVictimBuffer>(config->victim_entries(), config->block_size());
+        victim_block.resize(config->block_size());
+    }
+    if (config->write_buffer_entries() > 0 && config->write_policy() != CacheConfig::WP_BACK) {
+        write_buffer = std::make_unique<CacheWriteBuffer>(
+            config->write_buffer_entries(), config->block_size(), access_pen_w,
+            access_ena_b ? access_pen_b : access_pen_w);
+    }
 }
 
 Cache::~Cache() = default;
 
 WriteResult
 Cache::write(AddressWithMode destination, const void *source, size_t size, WriteOptions options) {
+    // Internal writes go through the cache as any other, they are part of the trace too.
+    if (trace != nullptr) { trace->record(destination, size, WRITE, access_pc); }
     if (!cache_config.enabled() || is_in_uncached_area(destination)
         || is_in_uncached_area(destination + size)) {
         mem_writes++;
-        emit memory_writes_update(mem_writes);
+        if (notify_each_access()) { emit memory_writes_update(mem_writes); }
         update_all_statistics();
         return mem->write(destination, source, size, options);
     }
 
+    demand_clock++;
+    if (is_exclusive()) {
+        // Misses and write through are passed below by the access itself.
+        const bool changed
+            = access_exclusive(destination, const_cast<void *>(source), size, WRITE);
+        if (prefetcher != nullptr) { run_prefetcher(destination); }
+        return { .n_bytes = size, .changed = changed };
+    }
+
     // FIXME: Get rid of the cast
     // access is mostly the same for read and write but one needs to write
     // to the address
     const bool changed = access(destination, const_cast<void *>(source), size, WRITE);
+    if (prefetcher != nullptr) { run_prefetcher(destination); }
 
     if (cache_config.write_policy() != CacheConfig::WP_BACK) {
-        mem_writes++;
-        emit memory_writes_update(mem_writes);
+        if (write_buffer != nullptr) {
+            // Data go below at once, the buffer accounts the time of the write.
+            write_buffer->write(destination, size, demand_clock);
+        } else {
+            mem_writes++;
+        }
+        if (notify_each_access()) { emit memory_writes_update(get_write_count()); }
         update_all_statistics();
         return mem->write(destination, source, size, options);
     }
@@ -66,11 +97,18 @@ Cache::write(AddressWithMode destination, const void *source, size_t size, Write
 }
 
 ReadResult Cache::read(void *destination, AddressWithMode source, size_t size, ReadOptions options) const {
+    if (trace != nullptr && options.type != ae::INTERNAL) {
+        trace->record(source, size, READ, access_pc);
+    }
     if (!cache_config.enabled() || is_in_uncached_area(source)
         || is_in_uncached_area(source + size)) {
         mem_reads++;
-        emit memory_reads_update(mem_reads);
+        if (notify_each_access()) { emit memory_reads_update(mem_reads); }
         update_all_statistics();
+        if (const byte *host = mem->direct_access(source, size)) {
+            memcpy(destination, host, size);
+            return { .n_bytes = size };
+        }
         return mem->read(destination, source, size, options);
     }
 
@@ -80,28 +118,85 @@ ReadResult Cache::read(void *destination, AddressWithMode source, size_t size, R
         } else {
             internal_read(source, destination, size);
         }
-        return {};
+        return { .n_bytes = size };
     }
 
-    access(source, destination, size, READ);
+    demand_clock++;
+    if (is_exclusive()) {
+        access_exclusive(source, destination, size, READ);
+    } else {
+        access(source, destination, size, READ);
+    }
+    if (prefetcher != nullptr) { run_prefetcher(source); }
 
-    return {};
+    return { .n_bytes = size };
 }
-bool Cache::is_in_uncached_area(Address source) const {
-    return (source >= uncached_start && source <= uncached_last);
+bool Cache::is_in_uncached_area(Address source) {
+    return (source >= 0xf0000000_addr && source <= 0xfffffffe_addr);
+}
+
+void Cache::set_trace(CacheTrace *trace) {
+    this->trace = trace;
+}
+
+void Cache::set_access_pc(Address pc) {
+    access_pc = pc;
+    mem->set_access_pc(pc);
+}
+
+uint32_t Cache::take_access_latency(bool below_cache) {
+    const uint32_t stalls = get_stall_count();
+    const uint32_t latency = stalls - latency_mark;
+    latency_mark = stalls;
+    const uint32_t below = mem->take_access_latency(true);
+    if (below_cache && !cache_config.enabled()) { return below; }
+    return latency + below;
+}
+
+CacheTraceReplay Cache::make_trace_replay() const {
+    return CacheTraceReplay(access_pen_r, access_pen_w, access_pen_b, access_ena_b);
+}
+
+void Cache::set_upper_levels(std::vector<const Cache *> caches) {
+    upper_levels = std::move(caches);
+}
+
+void Cache::set_exclusive_lower_level(const Cache *cache) {
+    exclusive_lower = cache;
+}
+
+bool Cache::is_inclusive() const {
+    return !upper_levels.empty()
+           && cache_config.inclusion_policy() == CacheConfig::IP_INCLUSIVE;
+}
+
+bool Cache::is_exclusive() const {
+    return !upper_levels.empty()
+           && cache_config.inclusion_policy() == CacheConfig::IP_EXCLUSIVE;
 }
 
 void Cache::flush() {
+    if (trace != nullptr) { trace->record_flush(); }
     if (!cache_config.enabled()) { return; }
 
     for (size_t assoc_index = 0; assoc_index < cache_config.associativity(); assoc_index += 1) {
         for (size_t set_index = 0; set_index < cache_config.set_count(); set_index += 1) {
-            if (dt[assoc_index][set_index].valid) {
+            if (tags[line_index(assoc_index, set_index)] != INVALID_TAG) {
                 kick(assoc_index, set_index);
-                emit cache_update(assoc_index, set_index, 0, false, false, 0, nullptr, false);
+                if (notify_each_access()) {
+                    emit cache_update(assoc_index, set_index, 0, false, false, 0, nullptr, false);
+                } else if (deferred_updates) {
+                    mark_set_changed(set_index);
+                }
             }
         }
     }
+    if (victim_buffer != nullptr) {
+        for (size_t index = 0; index < victim_buffer->size(); index++) {
+            if (victim_buffer->is_valid(index)) { retire_victim(index); }
+        }
+    }
+    if (write_buffer != nullptr) { write_buffer->drain(); }
     change_counter++;
     update_all_statistics();
 }
@@ -114,11 +209,8 @@ void Cache::sync() {
 void Cache::reset() {
     // Set all cells to invalid
     if (cache_config.enabled()) {
-        for (auto &set : dt) {
-            for (auto &block : set) {
-                block.valid = false;
-            }
-        }
+        std::fill(tags.begin(), tags.end(), INVALID_TAG);
+        std::fill(dirty.begin(), dirty.end(), false);
         // Note: We don't have to zero replacement policy data as those are
         // zeroed when first used on invalid cell.
     }
@@ -131,12 +223,44 @@ void Cache::reset() {
     mem_writes = 0;
     burst_reads = 0;
     burst_writes = 0;
+    latency_mark = 0;
+    prefetch_issued = 0;
+    prefetch_useful = 0;
+    prefetch_late = 0;
+    prefetch_polluting = 0;
+    prefetch_reads = 0;
+    prefetch_burst_reads = 0;
+    prefetch_late_cycles = 0;
+    victim_hits = 0;
+    miss_compulsory = 0;
+    miss_capacity = 0;
+    miss_conflict = 0;
+    demand_clock = 0;
+    prefetch_trigger = false;
+    if (prefetcher != nullptr) {
+        prefetcher->reset();
+        std::fill(prefetched.begin(), prefetched.end(), false);
+        std::fill(pollution_tags.begin(), pollution_tags.end(), INVALID_TAG);
+    }
+    if (miss_classifier != nullptr) { miss_classifier->reset(); }
+    if (victim_buffer != nullptr) { victim_buffer->reset(); }
+    if (write_buffer != nullptr) { write_buffer->reset(); }
 
     emit hit_update(get_hit_count());
     emit miss_update(get_miss_count());
+    emit miss_classes_update(miss_compulsory, miss_capacity, miss_conflict);
     emit memory_reads_update(get_read_count());
     emit memory_writes_update(get_write_count());
-    update_all_statistics();
+    if (!headless) {
+        emit statistics_update(get_stall_count(), get_speed_improvement(), get_hit_rate());
+    }
+
+    // Whole content is sent below, nothing is left to publish.
+    for (size_t row : changed_set_list) {
+        changed_sets[row] = false;
+    }
+    changed_set_list.clear();
+    last_access.reset();
 
     if (cache_config.enabled()) {
         for (size_t assoc_index = 0; assoc_index < cache_config.associativity(); assoc_index++) {
@@ -149,9 +273,16 @@ void Cache::reset() {
 
 void Cache::internal_read(Address source, void *destination, size_t size) const {
     CacheLocation loc = compute_location(source);
-    for (size_t assoc_index = 0; assoc_index < cache_config.associativity(); assoc_index++) {
-        if (dt[assoc_index][loc.row].valid && dt[assoc_index][loc.row].tag == loc.tag) {
-            memcpy(destination, (byte *)&dt[assoc_index][loc.row].data[loc.col] + loc.byte, size);
+    const size_t way = find_block_index(loc);
+    if (way < cache_config.associativity()) {
+        memcpy(
+            destination, (byte *)&line_data(line_index(way, loc.row))[loc.col] + loc.byte, size);
+        return;
+    }
+    if (victim_buffer != nullptr) {
+        const size_t index = victim_buffer->find(calc_base_address(loc.tag, loc.row));
+        if (index < victim_buffer->size()) {
+            memcpy(destination, (byte *)&victim_buffer->data(index)[loc.col] + loc.byte, size);
             return;
         }
     }
@@ -166,6 +297,17 @@ bool Cache::access(Address address, void *buffer, size_t size, AccessType access
     // ULONG_MAX / BLOCK_ITEM_SIZE and update can take forever
     if (size == 0) return false;
 
+    const CacheMissClassifier::MissClass miss_class
+        = miss_classifier->access(calc_base_address(loc.tag, loc.row));
+
+    // Block swapped in from the victim buffer is a refill for the replacement policy.
+    bool refill = false;
+    if (way >= cache_config.associativity() && victim_buffer != nullptr) {
+        way = take_victim(loc);
+        refill = way < cache_config.associativity();
+        if (refill) { victim_hits++; }
+    }
+
     // search failed - cache miss
     if (way >= cache_config.associativity()) {
         // if write through we do not need to allocate cache line does not
@@ -173,7 +315,9 @@ bool Cache::access(Address address, void *buffer, size_t size, AccessType access
         if (access_type == WRITE
             && cache_config.write_policy() == CacheConfig::WP_THROUGH_NOALLOC) {
             miss_write++;
-            emit miss_update(get_miss_count());
+            count_miss_class(miss_class);
+            if (!pollution_tags.empty()) { check_prefetch_pollution(loc); }
+            if (notify_each_access()) { emit miss_update(get_miss_count()); }
             update_all_statistics();
 
             const size_t size_overflow = calculate_overflow_to_next_blocks(size, loc);
@@ -194,41 +338,71 @@ bool Cache::access(Address address, void *buffer, size_t size, AccessType access
             way < cache_config.associativity(), "Probably unimplemented replacement policy");
     }
 
-    struct CacheLine &cd = dt[way][loc.row];
+    const size_t line = line_index(way, loc.row);
+    uint32_t *const line_words = line_data(line);
+    const bool valid = tags[line] != INVALID_TAG;
 
     // Update statistics and otherwise read from memory
-    if (cd.valid) {
+    if (valid) {
         if (access_type == WRITE) {
             hit_write++;
         } else {
             hit_read++;
         }
-        emit hit_update(get_hit_count());
+        if (notify_each_access()) { emit hit_update(get_hit_count()); }
         update_all_statistics();
+        if (!prefetched.empty() && prefetched[line]) {
+            prefetched[line] = false;
+            count_prefetch_use(prefetch_issued_at[line]);
+            prefetch_trigger = true;
+        }
     } else {
-        if (access_type == WRITE) {
-            miss_write++;
+        const Address block_addr = calc_base_address(loc.tag, loc.row);
+        const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+        // Block waiting in a prefetch buffer is a hit, its memory read was already issued.
+        uint64_t issued_at = 0;
+        const bool buffered = prefetcher != nullptr && prefetcher->is_buffered()
+                              && prefetcher->take(block_addr, issued_at);
+        if (buffered) {
+            if (access_type == WRITE) {
+                hit_write++;
+            } else {
+                hit_read++;
+            }
+            if (notify_each_access()) { emit hit_update(get_hit_count()); }
+            count_prefetch_use(issued_at);
         } else {
-            miss_read++;
+            if (access_type == WRITE) {
+                miss_write++;
+            } else {
+                miss_read++;
+            }
+            count_miss_class(miss_class);
+            if (notify_each_access()) { emit miss_update(get_miss_count()); }
+            if (!pollution_tags.empty()) { check_prefetch_pollution(loc); }
         }
-        emit miss_update(get_miss_count());
+        prefetch_trigger = true;
 
-        mem->read(
-            cd.data.data(), calc_base_address(loc.tag, loc.row),
-            cache_config.block_size() * BLOCK_ITEM_SIZE, { .type = ae::REGULAR });
+        if (const byte *host = mem->direct_access(block_addr, block_bytes)) {
+            memcpy(line_words, host, block_bytes);
+        } else {
+            mem->read(line_words, block_addr, block_bytes, { .type = ae::REGULAR });
+        }
 
-        cd.valid = true;
-        cd.dirty = false;
-        cd.tag = loc.tag;
+        dirty[line] = false;
+        tags[line] = loc.tag;
 
         change_counter += cache_config.block_size();
-        mem_reads += cache_config.block_size();
-        burst_reads += cache_config.block_size() - 1;
-        emit memory_reads_update(mem_reads);
+        if (!buffered) {
+            mem_reads += cache_config.block_size();
+            burst_reads += cache_config.block_size() - 1;
+            if (notify_each_access()) { emit memory_reads_update(mem_reads); }
+        }
         update_all_statistics();
     }
 
-    replacement_policy->update_stats(way, loc.row, cd.valid);
+    replacement_policy->update_stats(
+        way, loc.row, true, { .pc = access_pc, .fill = !valid || refill });
 
     const size_t size_overflow = calculate_overflow_to_next_blocks(size, loc);
     const size_t size_within_block = size - size_overflow;
@@ -236,20 +410,25 @@ bool Cache::access(Address address, void *buffer, size_t size, AccessType access
     bool changed = false;
 
     if (access_type == READ) {
-        memcpy(buffer, (byte *)&cd.data[loc.col] + loc.byte, size_within_block);
+        memcpy(buffer, (byte *)&line_words[loc.col] + loc.byte, size_within_block);
     } else if (access_type == WRITE) {
-        cd.dirty = true;
-        changed = memcmp((byte *)&cd.data[loc.col] + loc.byte, buffer, size_within_block) != 0;
+        dirty[line] = true;
+        changed = memcmp((byte *)&line_words[loc.col] + loc.byte, buffer, size_within_block) != 0;
         if (changed) {
-            memcpy(((byte *)&cd.data[loc.col]) + loc.byte, buffer, size_within_block);
+            memcpy(((byte *)&line_words[loc.col]) + loc.byte, buffer, size_within_block);
             change_counter++;
         }
     }
     const auto last_affected_col
         = (loc.col * BLOCK_ITEM_SIZE + loc.byte + size_within_block - 1) / BLOCK_ITEM_SIZE;
-    for (auto col = loc.col; col <= last_affected_col; col++) {
-        emit cache_update(
-            way, loc.row, col, cd.valid, cd.dirty, cd.tag, cd.data.data(), access_type);
+    if (notify_each_access()) {
+        for (auto col = loc.col; col <= last_affected_col; col++) {
+            emit cache_update(
+                way, loc.row, col, true, dirty[line], tags[line], line_words, access_type);
+        }
+    } else if (deferred_updates) {
+        mark_set_changed(loc.row);
+        last_access = { way, loc.row, last_affected_col, access_type == WRITE };
     }
 
     if (size_overflow > 0) {
@@ -269,36 +448,472 @@ size_t Cache::calculate_overflow_to_next_blocks(size_t access_size, const CacheL
 }
 
 size_t Cache::find_block_index(const CacheLocation &loc) const {
-    uint32_t index = 0;
-    while (index < cache_config.associativity()
-           and (!dt[index][loc.row].valid or dt[index][loc.row].tag != loc.tag)) {
-        index++;
+    const size_t associativity = cache_config.associativity();
+    const uint64_t *set_tags = &tags[line_index(0, loc.row)];
+    // Compare all ways of a chunk into a match mask, without early exit, so the inner loop has
+    // no data dependent branch.
+    for (size_t base = 0; base < associativity; base += 64) {
+        const size_t count = std::min(associativity - base, size_t(64));
+        uint64_t match = 0;
+        for (size_t way = 0; way < count; way++) {
+            match |= uint64_t(set_tags[base + way] == loc.tag) << way;
+        }
+        if (match != 0) { return base + ctz64(match); }
     }
-    return index;
+    return associativity;
 }
 
 void Cache::kick(size_t way, size_t row) const {
-    struct CacheLine &cd = dt[way][row];
-    if (cd.dirty && cache_config.write_policy() == CacheConfig::WP_BACK) {
-        mem->write(
-            calc_base_address(cd.tag, row), cd.data.data(),
-            cache_config.block_size() * BLOCK_ITEM_SIZE, {});
-        mem_writes += cache_config.block_size();
-        burst_writes += cache_config.block_size() - 1;
-        emit memory_writes_update(mem_writes);
-    }
-    cd.valid = false;
-    cd.dirty = false;
+    const size_t line = line_index(way, row);
+    const bool valid = tags[line] != INVALID_TAG;
+    const Address block = calc_base_address(valid ? tags[line] : 0, row);
+    const bool write_back = dirty[line] && cache_config.write_policy() == CacheConfig::WP_BACK;
+    tags[line] = INVALID_TAG;
+    dirty[line] = false;
+    if (!prefetched.empty()) { prefetched[line] = false; }
+
+    change_counter++;
 
+    replacement_policy->update_stats(way, row, false, {});
+
+    if (!valid) { return; }
+    if (victim_buffer != nullptr) {
+        // Block stays in this level, only the oldest victim leaves it.
+        const size_t index = victim_buffer->select();
+        if (victim_buffer->is_valid(index)) { retire_victim(index); }
+        victim_buffer->insert(index, block, line_data(line), write_back);
+    } else {
+        evict_block(block, line_data(line), write_back);
+    }
+}
+
+void Cache::evict_block(Address block, const uint32_t *words, bool write_back) const {
+    const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+    if (exclusive_lower != nullptr) {
+        // Clean blocks move down too, exclusive level holds only evicted blocks.
+        exclusive_lower->insert_victim(block, words, block_bytes, write_back);
+    } else if (write_back) {
+        mem->write(block, words, block_bytes, {});
+    }
+    if (write_back) { count_mem_write(block_bytes); }
+
+    // Block is not present anymore, dirty data from above skip this level and go below.
+    if (is_inclusive()) {
+        for (const Cache *upper : upper_levels) {
+            upper->back_invalidate(block, block_bytes, this);
+        }
+    }
+}
+
+size_t Cache::take_victim(const CacheLocation &loc) const {
+    const size_t index = victim_buffer->find(calc_base_address(loc.tag, loc.row));
+    if (index >= victim_buffer->size()) { return cache_config.associativity(); }
+
+    // Entry is released first, block evicted from the set takes its place.
+    const bool was_dirty = victim_buffer->is_dirty(index);
+    std::copy_n(victim_buffer->data(index), victim_block.size(), victim_block.begin());
+    victim_buffer->remove(index);
+
+    const size_t way = replacement_policy->select_way_to_evict(loc.row);
+    kick(way, loc.row);
+    const size_t line = line_index(way, loc.row);
+    std::copy(victim_block.begin(), victim_block.end(), line_data(line));
+    tags[line] = loc.tag;
+    dirty[line] = was_dirty;
+    change_counter += cache_config.block_size();
+    return way;
+}
+
+void Cache::retire_victim(size_t index) const {
+    const Address block = victim_buffer->block(index);
+    const bool write_back = victim_buffer->is_dirty(index);
+    victim_buffer->remove(index);
+    evict_block(block, victim_buffer->data(index), write_back);
+}
+
+void Cache::invalidate_line(size_t way, size_t row) const {
+    const size_t line = line_index(way, row);
+    tags[line] = INVALID_TAG;
+    dirty[line] = false;
+    if (!prefetched.empty()) { prefetched[line] = false; }
     change_counter++;
+    replacement_policy->update_stats(way, row, false, {});
+    if (notify_each_access()) {
+        emit cache_update(way, row, 0, false, false, 0, nullptr, false);
+    } else if (deferred_updates) {
+        mark_set_changed(row);
+    }
+}
+
+bool Cache::access_exclusive(
+    Address address,
+    void *buffer,
+    size_t size,
+    AccessType access_type) const {
+    if (size == 0) { return false; }
+    const CacheLocation loc = compute_location(address);
+    size_t way = find_block_index(loc);
+    const size_t size_overflow = calculate_overflow_to_next_blocks(size, loc);
+    const size_t size_within_block = size - size_overflow;
+    bool changed = false;
+    const CacheMissClassifier::MissClass miss_class
+        = miss_classifier->access(calc_base_address(loc.tag, loc.row));
+
+    // Block swapped in from the victim buffer is a refill for the replacement policy.
+    bool refill = false;
+    if (way >= cache_config.associativity() && victim_buffer != nullptr) {
+        way = take_victim(loc);
+        refill = way < cache_config.associativity();
+        if (refill) { victim_hits++; }
+    }
+
+    if (way >= cache_config.associativity()) {
+        if (access_type == WRITE) {
+            miss_write++;
+        } else {
+            miss_read++;
+        }
+        count_miss_class(miss_class);
+        if (notify_each_access()) { emit miss_update(get_miss_count()); }
+        if (!pollution_tags.empty()) { check_prefetch_pollution(loc); }
+        prefetch_trigger = true;
+        if (access_type == READ) {
+            mem->read(buffer, address, size_within_block, { .type = ae::REGULAR });
+            count_mem_read(size_within_block);
+        } else {
+            changed = mem->write(address, buffer, size_within_block, {}).changed;
+            count_mem_write(size_within_block);
+        }
+        update_all_statistics();
+    } else {
+        const size_t line = line_index(way, loc.row);
+        uint32_t *const line_words = line_data(line);
+        byte *const location = (byte *)&line_words[loc.col] + loc.byte;
+        if (access_type == WRITE) {
+            hit_write++;
+        } else {
+            hit_read++;
+        }
+        if (notify_each_access()) { emit hit_update(get_hit_count()); }
+        update_all_statistics();
+        if (!prefetched.empty() && prefetched[line]) {
+            prefetched[line] = false;
+            count_prefetch_use(prefetch_issued_at[line]);
+            prefetch_trigger = true;
+        }
+
+        if (access_type == READ) {
+            memcpy(buffer, location, size_within_block);
+            // Block moves to the level above, it does not know it is dirty.
+            if (dirty[line] && cache_config.write_policy() == CacheConfig::WP_BACK) {
+                const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+                mem->write(calc_base_address(loc.tag, loc.row), line_words, block_bytes, {});
+                count_mem_write(block_bytes);
+            }
+            invalidate_line(way, loc.row);
+        } else {
+            changed = memcmp(location, buffer, size_within_block) != 0;
+            if (changed) {
+                memcpy(location, buffer, size_within_block);
+                change_counter++;
+            }
+            dirty[line] = true;
+            if (cache_config.write_policy() != CacheConfig::WP_BACK) {
+                mem->write(address, buffer, size_within_block, {});
+                count_mem_write(size_within_block);
+            }
+            replacement_policy->update_stats(
+                way, loc.row, true, { .pc = access_pc, .fill = refill });
+            if (notify_each_access()) {
+                emit cache_update(way, loc.row, loc.col, true, true, loc.tag, line_words, true);
+            } else if (deferred_updates) {
+                mark_set_changed(loc.row);
+            }
+        }
+    }
 
-    replacement_policy->update_stats(way, row, false);
+    if (size_overflow > 0) {
+        changed |= access_exclusive(
+            address + size_within_block, (byte *)buffer + size_within_block, size_overflow,
+            access_type);
+    }
+    return changed;
+}
+
+void Cache::insert_victim(Address address, const uint32_t *words, size_t size, bool is_dirty)
+    const {
+    const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+    for (size_t done = 0; done < size;) {
+        const Address piece = address + done;
+        const CacheLocation loc = compute_location(piece);
+        const size_t offset = loc.col * BLOCK_ITEM_SIZE + loc.byte;
+        const size_t piece_size = std::min(size - done, block_bytes - offset);
+        const byte *const piece_data = (const byte *)words + done;
+
+        size_t way = find_block_index(loc);
+        bool refill = false;
+        if (way >= cache_config.associativity() && victim_buffer != nullptr) {
+            way = take_victim(loc);
+            refill = way < cache_config.associativity();
+        }
+        const bool fill = way >= cache_config.associativity();
+        if (fill) {
+            way = replacement_policy->select_way_to_evict(loc.row);
+            kick(way, loc.row);
+        }
+        const size_t line = line_index(way, loc.row);
+        uint32_t *const line_words = line_data(line);
+        if (fill) {
+            if (piece_size < block_bytes) {
+                // Victim covers only part of the block, the rest is read below.
+                mem->read(line_words, piece - offset, block_bytes, { .type = ae::REGULAR });
+                count_mem_read(block_bytes);
+            }
+            tags[line] = loc.tag;
+            dirty[line] = false;
+        }
+        memcpy((byte *)line_words + offset, piece_data, piece_size);
+        if (is_dirty) {
+            if (cache_config.write_policy() == CacheConfig::WP_BACK) {
+                dirty[line] = true;
+            } else {
+                mem->write(piece, piece_data, piece_size, {});
+                count_mem_write(piece_size);
+            }
+        }
+        change_counter++;
+        replacement_policy->update_stats(
+            way, loc.row, true, { .pc = access_pc, .fill = fill || refill });
+        if (notify_each_access()) {
+            emit cache_update(way, loc.row, 0, true, dirty[line], loc.tag, line_words, true);
+        } else if (deferred_updates) {
+            mark_set_changed(loc.row);
+        }
+        done += piece_size;
+    }
+}
+
+void Cache::back_invalidate(Address start, size_t size, const Cache *lower) const {
+    if (!cache_config.enabled()) { return; }
+    const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+    for (Address block = start - start.get_raw() % block_bytes; block < start + size;
+         block += block_bytes) {
+        const CacheLocation loc = compute_location(block);
+        const size_t way = find_block_index(loc);
+        if (way >= cache_config.associativity()) {
+            if (victim_buffer == nullptr) { continue; }
+            const size_t index = victim_buffer->find(block);
+            if (index < victim_buffer->size()) {
+                const bool was_dirty = victim_buffer->is_dirty(index);
+                victim_buffer->remove(index);
+                if (was_dirty) {
+                    lower->merge_from_upper(block, victim_buffer->data(index), block_bytes);
+                }
+            }
+            continue;
+        }
+        const size_t line = line_index(way, loc.row);
+        if (dirty[line] && cache_config.write_policy() == CacheConfig::WP_BACK) {
+            lower->merge_from_upper(block, line_data(line), block_bytes);
+        }
+        invalidate_line(way, loc.row);
+    }
+    update_all_statistics();
+}
+
+void Cache::merge_from_upper(Address address, const uint32_t *words, size_t size) const {
+    const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+    for (size_t done = 0; done < size;) {
+        const Address piece = address + done;
+        const CacheLocation loc = compute_location(piece);
+        const size_t offset = loc.col * BLOCK_ITEM_SIZE + loc.byte;
+        const size_t piece_size = std::min(size - done, block_bytes - offset);
+        const byte *const piece_data = (const byte *)words + done;
+
+        const size_t way = find_block_index(loc);
+        if (way < cache_config.associativity()
+            && cache_config.write_policy() == CacheConfig::WP_BACK) {
+            const size_t line = line_index(way, loc.row);
+            memcpy((byte *)line_data(line) + offset, piece_data, piece_size);
+            dirty[line] = true;
+            change_counter++;
+            if (deferred_updates) { mark_set_changed(loc.row); }
+        } else {
+            if (way < cache_config.associativity()) {
+                const size_t line = line_index(way, loc.row);
+                memcpy((byte *)line_data(line) + offset, piece_data, piece_size);
+            }
+            mem->write(piece, piece_data, piece_size, {});
+            count_mem_write(piece_size);
+        }
+        done += piece_size;
+    }
+}
+
+void Cache::count_miss_class(CacheMissClassifier::MissClass miss_class) const {
+    switch (miss_class) {
+    case CacheMissClassifier::MC_COMPULSORY: miss_compulsory++; break;
+    case CacheMissClassifier::MC_CAPACITY: miss_capacity++; break;
+    case CacheMissClassifier::MC_CONFLICT: miss_conflict++; break;
+    }
+    if (notify_each_access()) {
+        emit miss_classes_update(miss_compulsory, miss_capacity, miss_conflict);
+    }
+}
+
+void Cache::count_mem_write(size_t size) const {
+    const size_t words = (size + BLOCK_ITEM_SIZE - 1) / BLOCK_ITEM_SIZE;
+    mem_writes += words;
+    burst_writes += words - 1;
+    if (notify_each_access()) { emit memory_writes_update(mem_writes); }
+}
+
+void Cache::count_mem_read(size_t size) const {
+    const size_t words = (size + BLOCK_ITEM_SIZE - 1) / BLOCK_ITEM_SIZE;
+    mem_reads += words;
+    burst_reads += words - 1;
+    if (notify_each_access()) { emit memory_reads_update(mem_reads); }
+}
+
+void Cache::run_prefetcher(Address address) const {
+    prefetch_requests.clear();
+    prefetcher->observe(access_pc, address, prefetch_trigger, demand_clock, prefetch_requests);
+    prefetch_trigger = false;
+    for (Address block : prefetch_requests) {
+        prefetch_block(block);
+    }
+}
+
+void Cache::prefetch_block(Address block) const {
+    const size_t block_bytes = cache_config.block_size() * BLOCK_ITEM_SIZE;
+    if (is_in_uncached_area(block) || is_in_uncached_area(block + (block_bytes - 1))) {
+        return;
+    }
+    if (prefetcher->is_buffered()) {
+        // Block is held by the prefetcher, only the memory read is accounted.
+        prefetch_issued++;
+        count_prefetch_read();
+        return;
+    }
+
+    const CacheLocation loc = compute_location(block);
+    if (find_block_index(loc) < cache_config.associativity()) { return; }
+    if (victim_buffer != nullptr && victim_buffer->find(block) < victim_buffer->size()) { return; }
+
+    const size_t way = replacement_policy->select_way_to_evict(loc.row);
+    const size_t line = line_index(way, loc.row);
+    pollution_tags[line] = tags[line];
+    kick(way, loc.row);
+
+    uint32_t *const line_words = line_data(line);
+    if (const byte *host = mem->direct_access(block, block_bytes)) {
+        memcpy(line_words, host, block_bytes);
+    } else {
+        mem->read(line_words, block, block_bytes, { .type = ae::REGULAR });
+    }
+    tags[line] = loc.tag;
+    dirty[line] = false;
+    prefetched[line] = true;
+    prefetch_issued_at[line] = demand_clock;
+    replacement_policy->update_stats(
+        way, loc.row, true, { .pc = access_pc, .fill = true, .prefetch = true });
+
+    change_counter += cache_config.block_size();
+    prefetch_issued++;
+    count_prefetch_read();
+    if (notify_each_access()) {
+        emit cache_update(way, loc.row, 0, true, false, loc.tag, line_words, false);
+    } else if (deferred_updates) {
+        mark_set_changed(loc.row);
+    }
+}
+
+void Cache::count_prefetch_use(uint64_t issued_at) const {
+    prefetch_useful++;
+    const uint64_t elapsed = demand_clock - issued_at;
+    if (elapsed < block_transfer_time()) {
+        // Demand access waits for the rest of the transfer.
+        prefetch_late++;
+        prefetch_late_cycles += block_transfer_time() - elapsed;
+    }
+}
+
+void Cache::count_prefetch_read() const {
+    count_mem_read(cache_config.block_size() * BLOCK_ITEM_SIZE);
+    prefetch_reads += cache_config.block_size();
+    prefetch_burst_reads += cache_config.block_size() - 1;
+}
+
+void Cache::check_prefetch_pollution(const CacheLocation &loc) const {
+    uint64_t *const set_pollution = &pollution_tags[line_index(0, loc.row)];
+    for (size_t way = 0; way < cache_config.associativity(); way++) {
+        if (set_pollution[way] == loc.tag) {
+            set_pollution[way] = INVALID_TAG;
+            prefetch_polluting++;
+            return;
+        }
+    }
+}
+
+uint64_t Cache::block_transfer_time() const {
+    const uint64_t following = cache_config.block_size() - 1;
+    return access_pen_r + following * (access_ena_b ? access_pen_b : access_pen_r);
 }
 
 void Cache::update_all_statistics() const {
+    if (!notify_each_access()) { return; }
     emit statistics_update(get_stall_count(), get_speed_improvement(), get_hit_rate());
 }
 
+void Cache::set_deferred_updates(bool value) {
+    if (!value && deferred_updates) { publish_updates(); }
+    deferred_updates = value;
+    changed_sets.assign(value && cache_config.enabled() ? cache_config.set_count() : 0, false);
+    changed_set_list.clear();
+    last_access.reset();
+}
+
+void Cache::mark_set_changed(size_t row) const {
+    if (!changed_sets[row]) {
+        changed_sets[row] = true;
+        changed_set_list.push_back(row);
+    }
+}
+
+void Cache::publish_updates() const {
+    if (headless || !deferred_updates) { return; }
+    emit hit_update(get_hit_count());
+    emit miss_update(get_miss_count());
+    emit miss_classes_update(miss_compulsory, miss_capacity, miss_conflict);
+    emit memory_reads_update(get_read_count());
+    emit memory_writes_update(get_write_count());
+    emit statistics_update(get_stall_count(), get_speed_improvement(), get_hit_rate());
+
+    for (size_t row : changed_set_list) {
+        changed_sets[row] = false;
+        for (size_t way = 0; way < cache_config.associativity(); way++) {
+            const size_t line = line_index(way, row);
+            if (tags[line] == INVALID_TAG) {
+                emit cache_update(way, row, 0, false, false, 0, nullptr, false);
+            } else {
+                emit cache_update(
+                    way, row, 0, true, dirty[line], tags[line], line_data(line), false);
+            }
+        }
+    }
+    changed_set_list.clear();
+    // Repeated last access restores its highlight in the view.
+    if (last_access) {
+        const size_t line = line_index(last_access->way, last_access->row);
+        if (tags[line] != INVALID_TAG) {
+            emit cache_update(
+                last_access->way, last_access->row, last_access->col, true, dirty[line],
+                tags[line], line_data(line), last_access->write);
+        }
+        last_access.reset();
+    }
+}
+
 Address Cache::calc_base_address(size_t tag, size_t row) const {
     return Address(
         (tag * cache_config.set_count() + row) * cache_config.block_size() * BLOCK_ITEM_SIZE);
@@ -323,19 +938,35 @@ CacheLocation Cache::compute_location(Address address) const {
              .byte = byte };
 }
 
+byte *Cache::direct_access(Address address, size_t size) const {
+    // Traced accesses have to pass through `read` and `write`.
+    if (size == 0 || trace != nullptr) { return nullptr; }
+    if (!cache_config.enabled()
+        || (is_in_uncached_area(address) && is_in_uncached_area(address + (size - 1)))) {
+        return mem->direct_access(address, size);
+    }
+    return nullptr;
+}
+
 enum LocationStatus Cache::location_status(Address address) const {
     const CacheLocation loc = compute_location(address);
 
     if (cache_config.enabled()) {
-        for (auto const &set : dt) {
-            auto const &block = set[loc.row];
-
-            if (block.valid && block.tag == loc.tag) {
-                if (block.dirty && cache_config.write_policy() == CacheConfig::WP_BACK) {
-                    return (enum LocationStatus)(LOCSTAT_CACHED | LOCSTAT_DIRTY);
-                } else {
-                    return LOCSTAT_CACHED;
-                }
+        const size_t way = find_block_index(loc);
+        if (way < cache_config.associativity()) {
+            if (dirty[line_index(way, loc.row)]
+                && cache_config.write_policy() == CacheConfig::WP_BACK) {
+                return (enum LocationStatus)(LOCSTAT_CACHED | LOCSTAT_DIRTY);
+            } else {
+                return LOCSTAT_CACHED;
+            }
+        }
+        if (victim_buffer != nullptr) {
+            const size_t index = victim_buffer->find(calc_base_address(loc.tag, loc.row));
+            if (index < victim_buffer->size()) {
+                return victim_buffer->is_dirty(index)
+                           ? (enum LocationStatus)(LOCSTAT_CACHED | LOCSTAT_DIRTY)
+                           : LOCSTAT_CACHED;
             }
         }
     }
@@ -363,16 +994,23 @@ uint32_t Cache::get_read_count() const {
 }
 
 uint32_t Cache::get_write_count() const {
+    // Words still waiting in the write buffer are written too, the data are already below.
+    if (write_buffer != nullptr) { return mem_writes + write_buffer->get_buffered_words(); }
     return mem_writes;
 }
 
 uint32_t Cache::get_stall_count() const {
-    uint32_t st_cycles = mem_reads * (access_pen_r - 1) + mem_writes * (access_pen_w - 1);
+    // Prefetch reads overlap with execution, only late use of their blocks waits.
+    const uint32_t demand_reads = mem_reads - prefetch_reads;
+    const uint32_t demand_burst_reads = burst_reads - prefetch_burst_reads;
+    uint32_t st_cycles = demand_reads * (access_pen_r - 1) + mem_writes * (access_pen_w - 1);
     st_cycles += (miss_read + miss_write) * cache_config.block_size();
     if (access_ena_b) {
-        st_cycles -= burst_reads * (access_pen_r - access_pen_b)
+        st_cycles -= demand_burst_reads * (access_pen_r - access_pen_b)
                      + burst_writes * (access_pen_w - access_pen_b);
     }
+    st_cycles += prefetch_late_cycles;
+    if (write_buffer != nullptr) { st_cycles += write_buffer->get_stall_count(); }
     return st_cycles;
 }
 
@@ -385,16 +1023,71 @@ double Cache::get_speed_improvement() const {
     if (cache_config.write_policy() == CacheConfig::WP_BACK) {
         lookup_time += hit_write + miss_write;
     }
-    mem_access_time = mem_reads * access_pen_r + mem_writes * access_pen_w;
+    mem_access_time
+        = (mem_reads - prefetch_reads) * access_pen_r + mem_writes * access_pen_w;
     if (access_ena_b) {
-        mem_access_time -= burst_reads * (access_pen_r - access_pen_b)
+        mem_access_time -= (burst_reads - prefetch_burst_reads) * (access_pen_r - access_pen_b)
                            + burst_writes * (access_pen_w - access_pen_b);
     }
+    mem_access_time += prefetch_late_cycles;
+    if (write_buffer != nullptr) { mem_access_time += write_buffer->get_stall_count(); }
     return (
         (double)((miss_read + hit_read) * access_pen_r + (miss_write + hit_write) * access_pen_w)
         / (double)(lookup_time + mem_access_time) * 100);
 }
 
+uint32_t Cache::get_prefetch_issued_count() const {
+    return prefetch_issued;
+}
+
+uint32_t Cache::get_prefetch_useful_count() const {
+    return prefetch_useful;
+}
+
+uint32_t Cache::get_prefetch_late_count() const {
+    return prefetch_late;
+}
+
+uint32_t Cache::get_prefetch_polluting_count() const {
+    return prefetch_polluting;
+}
+
+uint32_t Cache::get_compulsory_miss_count() const {
+    return miss_compulsory;
+}
+
+uint32_t Cache::get_capacity_miss_count() const {
+    return miss_capacity;
+}
+
+uint32_t Cache::get_conflict_miss_count() const {
+    return miss_conflict;
+}
+
+uint32_t Cache::get_victim_hit_count() const {
+    return victim_hits;
+}
+
+uint32_t Cache::get_write_buffer_write_count() const {
+    return write_buffer != nullptr ? write_buffer->get_write_count() : 0;
+}
+
+uint32_t Cache::get_write_buffer_coalesced_count() const {
+    return write_buffer != nullptr ? write_buffer->get_coalesced_count() : 0;
+}
+
+uint32_t Cache::get_write_buffer_stall_count() const {
+    return write_buffer != nullptr ? write_buffer->get_stall_count() : 0;
+}
+
+double Cache::get_write_buffer_average_occupancy() const {
+    return write_buffer != nullptr ? write_buffer->get_average_occupancy() : 0.0;
+}
+
+size_t Cache::get_write_buffer_max_occupancy() const {
+    return write_buffer != nullptr ? write_buffer->get_max_occupancy() : 0;
+}
+
 double Cache::get_hit_rate() const {
     uint32_t comp = hit_read + hit_write + miss_read + miss_write;
     if (comp == 0) { return 0.0; }
@@ -2,12 +2,18 @@
 #define CACHE_H
 
 #include "machineconfig.h"
+#include "memory/cache/cache_buffers.h"
+#include "memory/cache/cache_miss_classifier.h"
 #include "memory/cache/cache_policy.h"
+#include "memory/cache/cache_prefetcher.h"
+#include "memory/cache/cache_trace.h"
 #include "memory/cache/cache_types.h"
 #include "memory/frontend_memory.h"
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace machine {
 
@@ -39,14 +45,13 @@ public:
      * @param simulated_endian          endian of the simulated CPU/memory
      * system
      * @param config                    cache configuration struct
-     * @param memory_access_penalty_r   cycles to perform read (stats only)
-     * @param memory_access_penalty_w   cycles to perform write (stats only)
-     * @param memory_access_penalty_b   cycles to perform burst access (stats
-     *                                  only)
+     * @param memory_access_penalty_r   cycles to perform read
+     * @param memory_access_penalty_w   cycles to perform write
+     * @param memory_access_penalty_b   cycles to perform burst access
      *
-     * NOTE: Memory access penalties apply only to statistics and are not taken
-     * into account during simulation itself. There is no point in doing so
-     * without superscalar execution.
+     * NOTE: Memory access penalties apply to statistics. Simulation itself
+     * takes them into account only with memory timing of the pipelined core
+     * (see `take_access_latency`).
      */
     Cache(
         FrontendMemory *memory,
@@ -79,15 +84,104 @@ public:
                                           // comare with no used cache
     double get_hit_rate() const;          // Usage efficiency in percents
 
+    /** Misses by cause (see `CacheMissClassifier`), they sum to `get_miss_count`. */
+    uint32_t get_compulsory_miss_count() const;
+    uint32_t get_capacity_miss_count() const;
+    uint32_t get_conflict_miss_count() const;
+
+    /**
+     * Prefetch statistics. Prefetch memory reads are part of `get_read_count`,
+     * they overlap with execution and they do not stall. Demand access using
+     * a block of a late prefetch stalls for the rest of its transfer
+     * (see `get_stall_count`).
+     *
+     * Issued prefetch is useful, when a demand access uses the block before
+     * it is evicted. Useful prefetch is late, when it is used earlier than
+     * a block transfer takes (in demand accesses of this cache, at most one
+     * per cycle). Polluting prefetch evicted a block, which missed later.
+     * Demand miss served by a stream buffer is counted as a hit.
+     */
+    uint32_t get_prefetch_issued_count() const;
+    uint32_t get_prefetch_useful_count() const;
+    uint32_t get_prefetch_late_count() const;
+    uint32_t get_prefetch_polluting_count() const;
+
+    /**
+     * Victim cache and write buffer statistics (see `CacheVictimBuffer` and
+     * `CacheWriteBuffer`). Demand miss served by the victim cache is counted
+     * as a hit. Words written by the write buffer are part of
+     * `get_write_count`, writer stalls on a full buffer are part of
+     * `get_stall_count`.
+     */
+    bool has_victim_buffer() const { return victim_buffer != nullptr; }
+    bool has_write_buffer() const { return write_buffer != nullptr; }
+    uint32_t get_victim_hit_count() const;
+    uint32_t get_write_buffer_write_count() const;
+    uint32_t get_write_buffer_coalesced_count() const;
+    uint32_t get_write_buffer_stall_count() const;
+    double get_write_buffer_average_occupancy() const;
+    size_t get_write_buffer_max_occupancy() const;
+
     void reset(); // Reset whole state of cache
 
+    /**
+     * In deferred mode, accesses only update counters and remember changed
+     * sets, no signals are emitted. Visualization is brought up to date by
+     * `publish_updates`, which is expected to be called once per GUI frame
+     * (or when the simulation stops).
+     */
+    void set_deferred_updates(bool value);
+    /** Emit coalesced statistics and content of sets changed since the last call. */
+    void publish_updates() const;
+
     const CacheConfig &get_config() const;
 
     enum LocationStatus location_status(Address address) const override;
 
+    /**
+     * Forwarded only when the range is not cached (cache disabled or uncached area)
+     * and no trace is recorded.
+     */
+    byte *direct_access(Address address, size_t size) const override;
+
+    void set_access_pc(Address pc) override;
+
+    /**
+     * Stall cycles (see `get_stall_count`) since the previous call, including
+     * the memory below. Disabled cache below another cache adds nothing, its
+     * accesses are already paid by penalties of the cache above.
+     */
+    uint32_t take_access_latency(bool below_cache = false) override;
+
+    /** Peripheral area is never cached, accesses go directly to memory. */
+    static bool is_in_uncached_area(Address source);
+
+    /**
+     * Record accesses received by this cache to `trace`
+     * (nullptr stops recording). Trace is not owned by the cache.
+     */
+    void set_trace(CacheTrace *trace);
+
+    /** Replay engine using memory access penalties of this cache. */
+    CacheTraceReplay make_trace_replay() const;
+
+    /**
+     * Caches of the levels above this shared level, nearest level first.
+     * Inclusion policy of the configuration applies only to a cache with upper
+     * levels (see `CacheConfig::InclusionPolicy`). Inclusive cache invalidates
+     * its evicted blocks above, dirty data found there are merged on the way
+     * down. Exclusive cache gives up blocks read by the levels above and it is
+     * filled only by blocks evicted from them (see `set_exclusive_lower_level`).
+     */
+    void set_upper_levels(std::vector<const Cache *> caches);
+
+    /** Next enabled level below is exclusive, evicted blocks are moved to it. */
+    void set_exclusive_lower_level(const Cache *cache);
+
 signals:
     void hit_update(uint32_t) const;
     void miss_update(uint32_t) const;
+    void miss_classes_update(uint32_t compulsory, uint32_t capacity, uint32_t conflict) const;
     void statistics_update(uint32_t stalled_cycles, double speed_improv, double hit_rate) const;
     void cache_update(
         size_t way,
@@ -104,16 +198,72 @@ signals:
 private:
     const CacheConfig cache_config;
     FrontendMemory *const mem;
-    const Address uncached_start;
-    const Address uncached_last;
     const uint32_t access_pen_r, access_pen_w, access_pen_b;
     const bool access_ena_b;
     const std::unique_ptr<CachePolicy> replacement_policy;
+    const std::unique_ptr<CachePrefetcher> prefetcher;
+    /** Allocated only when configured (write buffer only with write through). */
+    std::unique_ptr<CacheVictimBuffer> victim_buffer;
+    std::unique_ptr<CacheWriteBuffer> write_buffer;
+    std::unique_ptr<CacheMissClassifier> miss_classifier;
+    /** Block moved out of the victim buffer by `take_victim`. */
+    mutable std::vector<uint32_t> victim_block;
+    CacheTrace *trace = nullptr;
+    Address access_pc;
+    /** Stall count at the previous `take_access_latency`. */
+    uint32_t latency_mark = 0;
+    std::vector<const Cache *> upper_levels;
+    const Cache *exclusive_lower = nullptr;
 
-    mutable std::vector<std::vector<CacheLine>> dt;
+    /**
+     * Line storage is set-major: lines of one set are adjacent, line index is
+     * `row * associativity + way`. Tag of an invalid line is `INVALID_TAG`,
+     * so the lookup compares a contiguous array of tags into a match mask.
+     * Blocks of all lines share one data arena.
+     */
+    static constexpr uint64_t INVALID_TAG = ~uint64_t(0);
+    mutable std::vector<uint64_t> tags;
+    mutable std::vector<bool> dirty;
+    mutable std::vector<uint32_t> data;
+
+    size_t line_index(size_t way, size_t row) const {
+        return row * cache_config.associativity() + way;
+    }
+    uint32_t *line_data(size_t line) const { return &data[line * cache_config.block_size()]; }
+
+    /**
+     * Prefetch state of lines, allocated only with prefetcher filling the
+     * cache. Line is `prefetched` until its first demand use. Tag of the block
+     * evicted by prefetch into the line is kept in `pollution_tags`, until
+     * the block misses or another prefetch evicts from the line.
+     */
+    mutable std::vector<bool> prefetched;
+    mutable std::vector<uint64_t> prefetch_issued_at;
+    mutable std::vector<uint64_t> pollution_tags;
+    /** Demand accesses served, time base of prefetch statistics. */
+    mutable uint64_t demand_clock = 0;
+    /** Set by `access` when the prefetcher should be triggered. */
+    mutable bool prefetch_trigger = false;
+    mutable std::vector<Address> prefetch_requests;
+
+    bool deferred_updates = false;
+    /** Sets changed in deferred mode, `changed_set_list` avoids a scan of all sets. */
+    mutable std::vector<bool> changed_sets;
+    mutable std::vector<size_t> changed_set_list;
+    struct LastAccess {
+        size_t way, row, col;
+        bool write;
+    };
+    mutable std::optional<LastAccess> last_access;
 
     mutable uint32_t hit_read = 0, miss_read = 0, hit_write = 0, miss_write = 0, mem_reads = 0,
                      mem_writes = 0, burst_reads = 0, burst_writes = 0, change_counter = 0;
+    mutable uint32_t prefetch_issued = 0, prefetch_useful = 0, prefetch_late = 0,
+                     prefetch_polluting = 0;
+    /** Part of `mem_reads` and `burst_reads` issued by prefetch, cycles waited for late ones. */
+    mutable uint32_t prefetch_reads = 0, prefetch_burst_reads = 0, prefetch_late_cycles = 0;
+    mutable uint32_t victim_hits = 0;
+    mutable uint32_t miss_compulsory = 0, miss_capacity = 0, miss_conflict = 0;
 
     void internal_read(Address source, void *destination, size_t size) const;
 
@@ -121,10 +271,72 @@ private:
 
     void kick(size_t way, size_t row) const;
 
+    /**
+     * Block leaves this level: it moves to the exclusive level below or it is
+     * written back, copies in inclusive levels above are invalidated.
+     */
+    void evict_block(Address block, const uint32_t *words, bool write_back) const;
+
+    /**
+     * Missing block found in the victim buffer is swapped with a block of its set.
+     * @return  way holding the block, associativity when not found
+     */
+    size_t take_victim(const CacheLocation &loc) const;
+
+    /** Entry of the victim buffer is released, its block leaves this level. */
+    void retire_victim(size_t index) const;
+
+    /** Drop line without writing it back, content view is notified. */
+    void invalidate_line(size_t way, size_t row) const;
+
+    bool is_inclusive() const;
+    bool is_exclusive() const;
+
+    /** Access of exclusive cache, misses are passed below without allocation. */
+    bool access_exclusive(Address address, void *buffer, size_t size, AccessType access_type) const;
+
+    /** Place block evicted from the level above into this exclusive cache. */
+    void insert_victim(Address address, const uint32_t *words, size_t size, bool is_dirty) const;
+
+    /** Invalidate blocks overlapping the range, dirty data are merged to `lower`. */
+    void back_invalidate(Address start, size_t size, const Cache *lower) const;
+
+    /** Store dirty data invalidated above, to the present blocks or to memory below. */
+    void merge_from_upper(Address address, const uint32_t *words, size_t size) const;
+
+    /** Account `size` bytes written to or read from the memory below. */
+    void count_mem_write(size_t size) const;
+    void count_mem_read(size_t size) const;
+
+    /** Account a demand miss of the given cause. */
+    void count_miss_class(CacheMissClassifier::MissClass miss_class) const;
+
+    /** Pass demand access to the prefetcher and issue the requested blocks. */
+    void run_prefetcher(Address address) const;
+
+    void prefetch_block(Address block) const;
+
+    /** Update statistics of a demand use of a prefetched block. */
+    void count_prefetch_use(uint64_t issued_at) const;
+
+    /** Account memory read of a prefetched block. */
+    void count_prefetch_read() const;
+
+    /** Check whether a demand miss was caused by a block evicted by prefetch. */
+    void check_prefetch_pollution(const CacheLocation &loc) const;
+
+    /** Cycles of a block transfer from memory. */
+    uint64_t block_transfer_time() const;
+
     Address calc_base_address(size_t tag, size_t row) const;
 
     void update_all_statistics() const;
 
+    /** Signals are emitted on each access (not headless and not deferred). */
+    bool notify_each_access() const { return !headless && !deferred_updates; }
+
+    void mark_set_changed(size_t row) const;
+
     CacheLocation compute_location(Address address) const;
 
     /**
@@ -136,7 +348,6 @@ private:
      */
     size_t find_block_index(const CacheLocation &loc) const;
 
-    bool is_in_uncached_area(Address source) const;
 
     /**
      * RW access to cache may span multiple blocks but it needs to be
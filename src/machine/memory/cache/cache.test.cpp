@@ -4,6 +4,8 @@
 #include "machine/memory/backend/memory.h"
 #include "machine/memory/cache/cache.h"
 #include "machine/memory/cache/cache_policy.h"
+#include "machine/memory/cache/cache_trace.h"
+#include "machine/memory/dram/dram_controller.h"
 #include "machine/memory/memory_bus.h"
 #include "tests/data/cache_test_performance_data.h"
 
@@ -137,6 +139,489 @@ void TestCache::cache() {
     // Verify counts
     QCOMPARE(cache.get_hit_count(), hit);
     QCOMPARE(cache.get_miss_count(), miss);
+
+    // Block transfers through the cache report all bytes.
+    uint32_t block[2];
+    QCOMPARE(cache.read_block(block, 0x200_addr, sizeof(block), ae::INTERNAL), sizeof(block));
+    QCOMPARE(cache.read_block(block, 0x200_addr, sizeof(block)), sizeof(block));
+    QCOMPARE(cache.write_block(0x700_addr, block, sizeof(block)), sizeof(block));
+}
+
+void TestCache::cache_deferred_updates() {
+    CacheConfig cache_c;
+    cache_c.set_write_policy(CacheConfig::WP_BACK);
+    cache_c.set_enabled(true);
+    cache_c.set_set_count(4);
+    cache_c.set_block_size(2);
+    cache_c.set_associativity(2);
+
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    Cache cache(&m_frontend, &cache_c);
+    cache.set_deferred_updates(true);
+    QSignalSpy cache_spy(&cache, &Cache::cache_update);
+    QSignalSpy hit_spy(&cache, &Cache::hit_update);
+
+    memory_write_u32(&m, 0x200, 0x24);
+    for (int i = 0; i < 4; i++) {
+        QCOMPARE(cache.read_u32(0x200_addr), (uint32_t)0x24);
+    }
+    cache.write_u32(0x204_addr, 0x66);
+    QCOMPARE(cache.get_hit_count(), 4u);
+    QCOMPARE(cache.get_miss_count(), 1u);
+    QCOMPARE(cache_spy.count(), 0);
+    QCOMPARE(hit_spy.count(), 0);
+
+    // Each way of the single changed set and the repeated last access.
+    cache.publish_updates();
+    QCOMPARE(cache_spy.count(), 3);
+    QCOMPARE(hit_spy.count(), 1);
+    QCOMPARE(hit_spy.at(0).at(0).toUInt(), 4u);
+
+    cache.publish_updates();
+    QCOMPARE(cache_spy.count(), 3);
+    QCOMPARE(hit_spy.count(), 2);
+}
+
+void TestCache::cache_trace_replay() {
+    std::vector<CacheConfig> configs;
+    for (auto policy : { CacheConfig::RP_LRU, CacheConfig::RP_LFU, CacheConfig::RP_PLRU }) {
+        for (auto write : { CacheConfig::WP_BACK, CacheConfig::WP_THROUGH_ALLOC,
+                            CacheConfig::WP_THROUGH_NOALLOC }) {
+            for (unsigned associativity : { 1, 2, 4 }) {
+                CacheConfig cache_c;
+                cache_c.set_enabled(true);
+                cache_c.set_replacement_policy(policy);
+                cache_c.set_write_policy(write);
+                cache_c.set_set_count(4);
+                cache_c.set_block_size(2);
+                cache_c.set_associativity(associativity);
+                configs.push_back(cache_c);
+            }
+        }
+    }
+    // Buffers change the statistics of LRU configurations too.
+    for (unsigned associativity : { 1, 2 }) {
+        CacheConfig cache_c;
+        cache_c.set_enabled(true);
+        cache_c.set_replacement_policy(CacheConfig::RP_LRU);
+        cache_c.set_write_policy(CacheConfig::WP_BACK);
+        cache_c.set_set_count(4);
+        cache_c.set_block_size(2);
+        cache_c.set_associativity(associativity);
+        cache_c.set_victim_entries(2);
+        configs.push_back(cache_c);
+        cache_c.set_victim_entries(0);
+        cache_c.set_write_policy(CacheConfig::WP_THROUGH_ALLOC);
+        cache_c.set_write_buffer_entries(2);
+        configs.push_back(cache_c);
+    }
+
+    // Deterministic pseudo-random accesses, including unaligned ones and flushes.
+    auto run = [](Cache &cache) {
+        uint32_t state = 1;
+        for (int i = 0; i < 2000; i++) {
+            state = state * 1103515245 + 12345;
+            const Address address((state >> 8) % 0x400);
+            if (i % 500 == 499) {
+                cache.flush();
+            } else if (state & 0x80000000) {
+                cache.write_u32(address, i);
+            } else {
+                (void)cache.read_u16(address);
+            }
+        }
+    };
+
+    CacheTrace trace;
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>> expected;
+    for (const CacheConfig &cache_c : configs) {
+        Memory m(BIG);
+        TrivialBus m_frontend(&m);
+        Cache cache(&m_frontend, &cache_c, 3, 4, 1, true);
+        if (expected.empty()) { cache.set_trace(&trace); }
+        run(cache);
+        cache.set_trace(nullptr);
+        expected.emplace_back(
+            cache.get_hit_count(), cache.get_miss_count(), cache.get_read_count(),
+            cache.get_write_count(), cache.get_stall_count());
+    }
+
+    const auto results = CacheTraceReplay(3, 4, 1, true).run(trace, configs);
+    QCOMPARE(results.size(), configs.size());
+    for (size_t i = 0; i < configs.size(); i++) {
+        QCOMPARE(results[i].config, configs[i]);
+        QCOMPARE(
+            std::make_tuple(
+                results[i].hits, results[i].misses, results[i].mem_reads, results[i].mem_writes,
+                results[i].stalled_cycles),
+            expected[i]);
+    }
+}
+
+void TestCache::cache_prefetch() {
+    CacheConfig cache_c;
+    cache_c.set_enabled(true);
+    cache_c.set_replacement_policy(CacheConfig::RP_LRU);
+    cache_c.set_write_policy(CacheConfig::WP_BACK);
+    cache_c.set_set_count(4);
+    cache_c.set_block_size(2);
+    cache_c.set_associativity(2);
+
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    for (uint32_t i = 0; i < 0x400; i += 4) {
+        memory_write_u32(&m, i, i * 3);
+    }
+
+    {
+        // Each block is prefetched on the first use of the previous one,
+        // transfer of 4 cycles is longer than 2 accesses to a block.
+        cache_c.set_prefetch_policy(CacheConfig::PF_NEXT_LINE);
+        Cache cache(&m_frontend, &cache_c, 3, 4, 1, true);
+        for (uint32_t i = 0; i < 0x100; i += 4) {
+            QCOMPARE(cache.read_u32(Address(i)), i * 3);
+        }
+        QCOMPARE(cache.get_miss_count(), 1u);
+        QCOMPARE(cache.get_hit_count(), 63u);
+        // Prefetched blocks are read from memory too.
+        QCOMPARE(cache.get_read_count(), 2u + 32 * 2);
+        QCOMPARE(cache.get_prefetch_issued_count(), 32u);
+        QCOMPARE(cache.get_prefetch_useful_count(), 31u);
+        QCOMPARE(cache.get_prefetch_late_count(), 31u);
+        QCOMPARE(cache.get_prefetch_polluting_count(), 0u);
+        // Demand miss costs 4 cycles, each late block is used 2 of 4 transfer cycles early.
+        QCOMPARE(cache.get_stall_count(), 4 + 31 * 2u);
+    }
+    {
+        // Stride is confirmed by the 4th access, following ones hit.
+        cache_c.set_prefetch_policy(CacheConfig::PF_STRIDE);
+        Cache cache(&m_frontend, &cache_c);
+        CacheTrace trace;
+        cache.set_trace(&trace);
+        for (uint32_t i = 0; i < 0x400; i += 0x20) {
+            cache.set_access_pc(0x1000_addr);
+            QCOMPARE(cache.read_u32(Address(i)), i * 3);
+            // Other instruction does not disturb the stream.
+            cache.set_access_pc(0x1004_addr);
+            cache.write_u32(0x3fc_addr, i);
+        }
+        QCOMPARE(cache.get_miss_count(), 5u);
+        QCOMPARE(cache.get_prefetch_issued_count(), 29u);
+        QCOMPARE(cache.get_prefetch_useful_count(), 28u);
+        QCOMPARE(cache.get_prefetch_late_count(), 0u);
+        QCOMPARE(cache.get_prefetch_polluting_count(), 0u);
+
+        const auto results = cache.make_trace_replay().run(trace, { cache_c });
+        QCOMPARE(results.at(0).hits, cache.get_hit_count());
+        QCOMPARE(results.at(0).misses, cache.get_miss_count());
+    }
+    {
+        // Misses are served by the stream buffer, which stays 2 blocks ahead.
+        cache_c.set_prefetch_policy(CacheConfig::PF_STREAM);
+        cache_c.set_prefetch_degree(2);
+        Cache cache(&m_frontend, &cache_c);
+        for (uint32_t i = 0; i < 0x100; i += 4) {
+            QCOMPARE(cache.read_u32(Address(i)), i * 3);
+        }
+        QCOMPARE(cache.get_miss_count(), 1u);
+        QCOMPARE(cache.get_hit_count(), 63u);
+        QCOMPARE(cache.get_read_count(), 2u + 33 * 2);
+        QCOMPARE(cache.get_prefetch_issued_count(), 33u);
+        QCOMPARE(cache.get_prefetch_useful_count(), 31u);
+        QCOMPARE(cache.get_prefetch_polluting_count(), 0u);
+    }
+    {
+        // Single line cache, prefetch evicts the block which is used again.
+        cache_c.set_prefetch_policy(CacheConfig::PF_NEXT_LINE);
+        cache_c.set_prefetch_degree(1);
+        cache_c.set_set_count(1);
+        cache_c.set_block_size(1);
+        cache_c.set_associativity(1);
+        Cache cache(&m_frontend, &cache_c);
+        QCOMPARE(cache.read_u32(0x10_addr), 0x30u);
+        QCOMPARE(cache.read_u32(0x10_addr), 0x30u);
+        QCOMPARE(cache.get_miss_count(), 2u);
+        QCOMPARE(cache.get_prefetch_issued_count(), 2u);
+        QCOMPARE(cache.get_prefetch_useful_count(), 0u);
+        QCOMPARE(cache.get_prefetch_polluting_count(), 1u);
+    }
+}
+
+void TestCache::cache_rrip_data() {
+    QTest::addColumn<CacheConfig>("cache_c");
+    QTest::addColumn<uint32_t>("scan_hits");
+    QTest::addColumn<uint32_t>("thrash_hits");
+
+    CacheConfig cache_c;
+    cache_c.set_enabled(true);
+    cache_c.set_write_policy(CacheConfig::WP_BACK);
+    cache_c.set_block_size(1);
+    cache_c.set_associativity(4);
+    // Scan evicts reused blocks from LRU, cyclic working set larger than
+    // the cache thrashes LRU and SRRIP.
+    const std::tuple<const char *, CacheConfig::ReplacementPolicy, uint32_t, uint32_t> rows[] = {
+        { "LRU", CacheConfig::RP_LRU, 40, 0 },        { "SRRIP", CacheConfig::RP_SRRIP, 76, 0 },
+        { "BRRIP", CacheConfig::RP_BRRIP, 78, 3646 }, { "DRRIP", CacheConfig::RP_DRRIP, 76, 3534 },
+        { "SHiP", CacheConfig::RP_SHIP, 78, 3648 },
+    };
+    for (const auto &row : rows) {
+        cache_c.set_replacement_policy(std::get<1>(row));
+        QTest::newRow(std::get<0>(row)) << cache_c << std::get<2>(row) << std::get<3>(row);
+    }
+}
+
+void TestCache::cache_rrip() {
+    QFETCH(CacheConfig, cache_c);
+    QFETCH(uint32_t, scan_hits);
+    QFETCH(uint32_t, thrash_hits);
+
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    {
+        // Two reused blocks and a scan of 6 blocks loaded by another instruction.
+        cache_c.set_set_count(1);
+        Cache cache(&m_frontend, &cache_c);
+        for (uint32_t i = 0; i < 20; i++) {
+            cache.set_access_pc(0x100_addr);
+            for (uint32_t j = 0; j < 4; j++) {
+                (void)cache.read_u32(Address((j % 2) * 4));
+            }
+            cache.set_access_pc(0x200_addr);
+            for (uint32_t j = 0; j < 6; j++) {
+                (void)cache.read_u32(Address(0x1000 + (i * 6 + j) * 4));
+            }
+        }
+        QCOMPARE(cache.get_hit_count(), scan_hits);
+        QCOMPARE(cache.get_miss_count(), 200 - scan_hits);
+    }
+    {
+        // Loop over 5 blocks per set of a 4-way cache.
+        cache_c.set_set_count(64);
+        Cache cache(&m_frontend, &cache_c);
+        cache.set_access_pc(0x300_addr);
+        for (uint32_t i = 0; i < 20; i++) {
+            for (uint32_t j = 0; j < 5 * 64; j++) {
+                (void)cache.read_u32(Address(j * 4));
+            }
+        }
+        QCOMPARE(cache.get_hit_count(), thrash_hits);
+        QCOMPARE(cache.get_miss_count(), 6400 - thrash_hits);
+    }
+}
+
+void TestCache::cache_inclusion() {
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    CacheConfig l1_c;
+    l1_c.set_enabled(true);
+    l1_c.set_set_count(4);
+    l1_c.set_block_size(1);
+    l1_c.set_associativity(1);
+    l1_c.set_write_policy(CacheConfig::WP_BACK);
+    CacheConfig l2_c;
+    l2_c.set_enabled(true);
+    l2_c.set_set_count(1);
+    l2_c.set_block_size(1);
+    l2_c.set_associativity(2);
+    l2_c.set_replacement_policy(CacheConfig::RP_LRU);
+    l2_c.set_write_policy(CacheConfig::WP_BACK);
+    {
+        // Block evicted from L2 leaves L1 too, its dirty data reach memory.
+        l2_c.set_inclusion_policy(CacheConfig::IP_INCLUSIVE);
+        Cache l2(&m_frontend, &l2_c);
+        Cache l1(&l2, &l1_c);
+        l2.set_upper_levels({ &l1 });
+        l1.write_u32(0x0_addr, 0x11);
+        (void)l1.read_u32(0x4_addr);
+        QVERIFY(l1.location_status(0x0_addr) & LOCSTAT_CACHED);
+        (void)l1.read_u32(0x8_addr);
+        QVERIFY(!(l1.location_status(0x0_addr) & LOCSTAT_CACHED));
+        QCOMPARE(m_frontend.read_u32(0x0_addr), 0x11u);
+        QCOMPARE(l1.read_u32(0x0_addr), 0x11u);
+    }
+    {
+        // L2 holds only blocks evicted from L1, block read by L1 leaves L2.
+        l1_c.set_set_count(1);
+        l2_c.set_inclusion_policy(CacheConfig::IP_EXCLUSIVE);
+        Cache l2(&m_frontend, &l2_c);
+        Cache l1(&l2, &l1_c);
+        l2.set_upper_levels({ &l1 });
+        l1.set_exclusive_lower_level(&l2);
+        l1.write_u32(0x0_addr, 0x22);
+        (void)l1.read_u32(0x4_addr);
+        QCOMPARE(l2.get_miss_count(), 2u);
+        QVERIFY(l2.location_status(0x0_addr) & LOCSTAT_DIRTY);
+        QCOMPARE(l1.read_u32(0x0_addr), 0x22u);
+        QCOMPARE(l2.get_hit_count(), 1u);
+        QVERIFY(!(l2.location_status(0x0_addr) & LOCSTAT_CACHED));
+        QVERIFY(l2.location_status(0x4_addr) & LOCSTAT_CACHED);
+        QCOMPARE(m_frontend.read_u32(0x0_addr), 0x22u);
+    }
+}
+
+void TestCache::cache_buffers() {
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    CacheConfig cache_c;
+    cache_c.set_enabled(true);
+    cache_c.set_set_count(1);
+    cache_c.set_block_size(1);
+    cache_c.set_associativity(1);
+    cache_c.set_write_policy(CacheConfig::WP_BACK);
+    cache_c.set_victim_entries(2);
+    {
+        // Conflicting block comes back from the victim cache, the oldest victim leaves.
+        Cache cache(&m_frontend, &cache_c);
+        cache.write_u32(0x0_addr, 0x33);
+        (void)cache.read_u32(0x4_addr);
+        QCOMPARE(cache.read_u32(0x0_addr), 0x33u);
+        QCOMPARE(cache.get_hit_count(), 1u);
+        QCOMPARE(cache.get_victim_hit_count(), 1u);
+        QVERIFY(cache.location_status(0x4_addr) & LOCSTAT_CACHED);
+        (void)cache.read_u32(0x8_addr);
+        (void)cache.read_u32(0xc_addr);
+        QVERIFY(!(cache.location_status(0x4_addr) & LOCSTAT_CACHED));
+        QVERIFY(cache.location_status(0x0_addr) & LOCSTAT_DIRTY);
+        QCOMPARE(cache.get_read_count(), 4u);
+        QCOMPARE(m_frontend.read_u32(0x0_addr), 0u);
+        cache.flush();
+        QCOMPARE(m_frontend.read_u32(0x0_addr), 0x33u);
+        QCOMPARE(cache.get_write_count(), 1u);
+    }
+    {
+        // Writes to the entry waiting behind the head coalesce, full buffer stalls the writer.
+        cache_c.set_victim_entries(0);
+        cache_c.set_block_size(4);
+        cache_c.set_write_policy(CacheConfig::WP_THROUGH_NOALLOC);
+        cache_c.set_write_buffer_entries(2);
+        Cache cache(&m_frontend, &cache_c, 1, 10);
+        cache.write_u32(0x0_addr, 0x1);
+        cache.write_u32(0x4_addr, 0x2);
+        cache.write_u32(0x8_addr, 0x3);
+        cache.write_u32(0x10_addr, 0x4);
+        QCOMPARE(m_frontend.read_u32(0x10_addr), 0x4u);
+        QCOMPARE(cache.get_write_buffer_write_count(), 4u);
+        QCOMPARE(cache.get_write_buffer_coalesced_count(), 1u);
+        QCOMPARE(cache.get_write_buffer_stall_count(), 11 - 4u);
+        QCOMPARE(cache.get_write_buffer_max_occupancy(), size_t(2));
+        QCOMPARE(cache.get_write_buffer_average_occupancy(), 1.25);
+        // Words waiting in the buffer are already counted as memory writes.
+        QCOMPARE(cache.get_write_count(), 4u);
+        cache.flush();
+        QCOMPARE(cache.get_write_count(), 4u);
+    }
+}
+
+void TestCache::cache_miss_classes() {
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    CacheConfig cache_c;
+    cache_c.set_enabled(true);
+    cache_c.set_set_count(2);
+    cache_c.set_block_size(1);
+    cache_c.set_associativity(1);
+    Cache cache(&m_frontend, &cache_c);
+    // 0x0 and 0x8 share a set, both fit into a fully associative cache.
+    (void)cache.read_u32(0x0_addr);
+    (void)cache.read_u32(0x8_addr);
+    (void)cache.read_u32(0x0_addr);
+    QCOMPARE(cache.get_compulsory_miss_count(), 2u);
+    QCOMPARE(cache.get_conflict_miss_count(), 1u);
+    // Third block pushes 0x8 out of the fully associative cache as well.
+    (void)cache.read_u32(0x4_addr);
+    (void)cache.read_u32(0x8_addr);
+    QCOMPARE(cache.get_compulsory_miss_count(), 3u);
+    QCOMPARE(cache.get_capacity_miss_count(), 1u);
+    QCOMPARE(cache.get_conflict_miss_count(), 1u);
+    QCOMPARE(cache.get_miss_count(), 5u);
+    cache.reset();
+    (void)cache.read_u32(0x0_addr);
+    QCOMPARE(cache.get_compulsory_miss_count(), 1u);
+}
+
+void TestCache::cache_dram() {
+    Memory m(BIG);
+    TrivialBus m_frontend(&m);
+    DramConfig config;
+    config.set_enabled(true);
+    {
+        // Sequential reads stay in the open rows of banks 0 and 1.
+        DramController dram(&m_frontend, &config);
+        for (uint32_t i = 0; i < 512; i++) {
+            (void)dram.read_u32(Address(i * 8));
+        }
+        QCOMPARE(dram.get_row_miss_count(), 2u);
+        QCOMPARE(dram.get_row_hit_count(), 510u);
+        QCOMPARE(dram.get_row_conflict_count(), 0u);
+        QCOMPARE(dram.take_access_latency(), 2 * (14 + 14 + 1) + 510 * (14 + 1u));
+        QCOMPARE(dram.get_busy_cycles(), uint64_t(512));
+    }
+    {
+        // Stride of all banks hits different rows of bank 0.
+        DramController dram(&m_frontend, &config);
+        for (uint32_t i = 0; i < 16; i++) {
+            (void)dram.read_u32(Address(i * 2048 * 8));
+        }
+        QCOMPARE(dram.get_row_miss_count(), 1u);
+        QCOMPARE(dram.get_row_conflict_count(), 15u);
+        QCOMPARE(dram.take_access_latency(), (14 + 14 + 1) + 15 * (14 + 14 + 14 + 1u));
+    }
+    {
+        // Closed page waits for precharge instead of hitting the row.
+        config.set_page_policy(DramConfig::PAGE_CLOSED);
+        DramController dram(&m_frontend, &config);
+        for (uint32_t i = 0; i < 4; i++) {
+            (void)dram.read_u32(Address(i * 8));
+        }
+        QCOMPARE(dram.get_row_miss_count(), 4u);
+        QCOMPARE(dram.take_access_latency(), (14 + 14 + 1) + 3 * (14 + 14 + 14 + 1u));
+        config.set_page_policy(DramConfig::PAGE_OPEN);
+    }
+    {
+        // Writes are posted, only the write overflowing the queue is waited for.
+        DramController dram(&m_frontend, &config);
+        for (uint32_t i = 0; i < 8; i++) {
+            dram.write_u32(Address(i * 8), i);
+        }
+        QCOMPARE(dram.take_access_latency(), 0u);
+        dram.write_u32(Address(8 * 8), 8);
+        QCOMPARE(dram.get_queue_full_count(), 1u);
+        QCOMPARE(dram.take_access_latency(), 14 + 14 + 1u);
+        QCOMPARE(dram.read_u32(Address(8 * 8)), 8u);
+        QCOMPARE(dram.get_row_hit_count(), 1u);
+        QCOMPARE(dram.get_write_count(), 9u);
+        QCOMPARE(dram.get_read_count(), 1u);
+    }
+    {
+        // Idle controller skips the open row write waiting for its bank.
+        DramController dram(&m_frontend, &config);
+        uint64_t time = 0;
+        dram.set_clock([&time]() { return time; });
+        const uint64_t writes[][2] = { { 0, 0 }, { 10, 2048 }, { 20, 8 }, { 21, 4096 } };
+        for (const auto &write : writes) {
+            time = write[0];
+            dram.write_u32(Address(write[1]), 1);
+        }
+        // Banks 0 and 1 are written, bank 0 is busy until cycle 29.
+        QCOMPARE(dram.get_row_miss_count(), 2u);
+        time = 25;
+        dram.write_u32(Address(6144), 1);
+        QCOMPARE(dram.get_row_miss_count(), 3u);
+        QCOMPARE(dram.get_row_hit_count(), 0u);
+        QCOMPARE(dram.take_access_latency(), 0u);
+    }
+    {
+        // Only RAM ranges are timed, peripherals and their RV64 mirrors are not.
+        DramController dram(
+            &m_frontend, &config,
+            { { 0x0_addr, 0xefffffff_addr }, { 0x100000000_addr, 0xffffffffffffff_addr } });
+        (void)dram.read_u32(0xffffc000_addr);
+        (void)dram.read_u32(0xffffffffffffc000_addr);
+        QCOMPARE(dram.get_read_count(), 0u);
+        (void)dram.read_u32(0x100000000_addr);
+        QCOMPARE(dram.get_read_count(), 1u);
+    }
 }
 
 void TestCache::cache_correctness_data() {
@@ -8,6 +8,15 @@ class TestCache : public QObject {
 private slots:
     static void cache_data();
     static void cache();
+    static void cache_deferred_updates();
+    static void cache_trace_replay();
+    static void cache_prefetch();
+    static void cache_rrip_data();
+    static void cache_rrip();
+    static void cache_inclusion();
+    static void cache_buffers();
+    static void cache_miss_classes();
+    static void cache_dram();
     static void cache_correctness_data();
     static void cache_correctness();
 };
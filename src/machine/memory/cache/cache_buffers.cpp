@@ -0,0 +1,165 @@
+#include "memory/cache/cache_buffers.h"
+
+#include "memory/cache/cache.h"
+
+#include <algorithm>
+
+namespace machine {
+
+CacheVictimBuffer::CacheVictimBuffer(size_t entries, size_t block_words)
+    : block_words(block_words)
+    , blocks(entries, INVALID_BLOCK)
+    , dirty(entries, false)
+    , words(entries * block_words, 0)
+    , inserted_at(entries, 0) {}
+
+size_t CacheVictimBuffer::find(Address block) const {
+    return std::find(blocks.begin(), blocks.end(), block.get_raw()) - blocks.begin();
+}
+
+size_t CacheVictimBuffer::occupancy() const {
+    return blocks.size() - std::count(blocks.begin(), blocks.end(), INVALID_BLOCK);
+}
+
+size_t CacheVictimBuffer::select() const {
+    size_t oldest = 0;
+    for (size_t index = 0; index < blocks.size(); index++) {
+        if (blocks[index] == INVALID_BLOCK) { return index; }
+        if (inserted_at[index] < inserted_at[oldest]) { oldest = index; }
+    }
+    return oldest;
+}
+
+void CacheVictimBuffer::insert(
+    size_t index,
+    Address block,
+    const uint32_t *block_data,
+    bool is_dirty) {
+    blocks[index] = block.get_raw();
+    dirty[index] = is_dirty;
+    inserted_at[index] = insert_count++;
+    std::copy_n(block_data, block_words, data(index));
+}
+
+void CacheVictimBuffer::remove(size_t index) {
+    blocks[index] = INVALID_BLOCK;
+    dirty[index] = false;
+}
+
+void CacheVictimBuffer::reset() {
+    std::fill(blocks.begin(), blocks.end(), INVALID_BLOCK);
+    std::fill(dirty.begin(), dirty.end(), false);
+    insert_count = 0;
+}
+
+CacheWriteBuffer::CacheWriteBuffer(
+    size_t entries,
+    size_t block_words,
+    uint32_t first_word_time,
+    uint32_t next_word_time)
+    : capacity(entries)
+    , block_words(block_words)
+    , first_word_time(first_word_time)
+    , next_word_time(next_word_time) {}
+
+uint32_t CacheWriteBuffer::write(Address address, size_t size, uint64_t now) {
+    if (size == 0) { return 0; }
+    const uint32_t stalled_before = stalled_cycles;
+    uint64_t time = now + stalled_cycles;
+    advance(time);
+
+    writes++;
+    occupancy_sum += entries.size();
+    max_occupancy = std::max(max_occupancy, entries.size());
+
+    const uint64_t block_bytes = block_words * BLOCK_ITEM_SIZE;
+    const uint64_t first = address.get_raw();
+    const uint64_t last = first + size - 1;
+    for (uint64_t block = first / block_bytes; block <= last / block_bytes; block++) {
+        const size_t first_word
+            = block == first / block_bytes ? first % block_bytes / BLOCK_ITEM_SIZE : 0;
+        const size_t last_word
+            = block == last / block_bytes ? last % block_bytes / BLOCK_ITEM_SIZE : block_words - 1;
+        write_block(block, first_word, last_word, time);
+    }
+    return stalled_cycles - stalled_before;
+}
+
+void CacheWriteBuffer::write_block(
+    uint64_t block,
+    size_t first_word,
+    size_t last_word,
+    uint64_t &time) {
+    Entry *target = nullptr;
+    // Head is already being written.
+    for (size_t index = 1; index < entries.size(); index++) {
+        if (entries[index].block == block) {
+            target = &entries[index];
+            coalesced++;
+            break;
+        }
+    }
+    if (target == nullptr) {
+        if (entries.size() >= capacity) {
+            stalled_cycles += head_done - time;
+            time = head_done;
+            advance(time);
+        }
+        entries.push_back({ block, time, std::vector<bool>(block_words, false), 0 });
+        target = &entries.back();
+    }
+    for (size_t word = first_word; word <= last_word; word++) {
+        if (!target->written[word]) {
+            target->written[word] = true;
+            target->words++;
+        }
+    }
+    if (entries.size() == 1) { head_done = time + write_time(entries.front()); }
+}
+
+void CacheWriteBuffer::advance(uint64_t time) {
+    while (!entries.empty() && head_done <= time) {
+        drained_words += entries.front().words;
+        entries.pop_front();
+        if (!entries.empty()) {
+            head_done = std::max(head_done, entries.front().arrival) + write_time(entries.front());
+        }
+    }
+}
+
+uint64_t CacheWriteBuffer::write_time(const Entry &entry) const {
+    return first_word_time + (entry.words - 1) * next_word_time;
+}
+
+void CacheWriteBuffer::drain() {
+    for (const Entry &entry : entries) {
+        drained_words += entry.words;
+    }
+    entries.clear();
+}
+
+void CacheWriteBuffer::reset() {
+    entries.clear();
+    head_done = 0;
+    writes = 0;
+    coalesced = 0;
+    stalled_cycles = 0;
+    drained_words = 0;
+    occupancy_sum = 0;
+    max_occupancy = 0;
+}
+
+uint32_t CacheWriteBuffer::get_buffered_words() const {
+    uint32_t words = drained_words;
+    for (const Entry &entry : entries) {
+        words += entry.words;
+    }
+    return words;
+}
+
+double CacheWriteBuffer::get_average_occupancy() const {
+    if (writes == 0) { return 0.0; }
+    return (double)occupancy_sum / writes;
+}
+
+} // namespace machine
@@ -0,0 +1,143 @@
+#ifndef CACHE_BUFFERS_H
+#define CACHE_BUFFERS_H
+
+#include "memory/address.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace machine {
+
+/**
+ * Victim cache
+ *
+ *  Small fully associative buffer of blocks evicted from a cache
+ *  (see `CacheConfig::set_victim_entries`). Block found in the buffer on a miss
+ *  is moved back to the cache without memory access. Blocks are only inserted
+ *  and taken out, so the oldest entry is also the least recently used one.
+ *  It is replaced by a new victim and the cache then evicts it as usual.
+ */
+class CacheVictimBuffer {
+public:
+    /**
+     * @param entries       number of blocks
+     * @param block_words   size of cache block in `uint32_t` units
+     */
+    CacheVictimBuffer(size_t entries, size_t block_words);
+
+    /** @return index of the entry holding the block, `size()` when not present */
+    [[nodiscard]] size_t find(Address block) const;
+
+    [[nodiscard]] size_t size() const { return blocks.size(); }
+    [[nodiscard]] size_t occupancy() const;
+
+    [[nodiscard]] bool is_valid(size_t index) const { return blocks[index] != INVALID_BLOCK; }
+    [[nodiscard]] Address block(size_t index) const { return Address(blocks[index]); }
+    [[nodiscard]] bool is_dirty(size_t index) const { return dirty[index]; }
+    [[nodiscard]] uint32_t *data(size_t index) { return &words[index * block_words]; }
+    [[nodiscard]] const uint32_t *data(size_t index) const { return &words[index * block_words]; }
+    void set_dirty(size_t index) { dirty[index] = true; }
+
+    /** Entry for the next victim, a free one or the oldest one. */
+    [[nodiscard]] size_t select() const;
+
+    /** Content of the entry is replaced, valid entry has to be evicted first. */
+    void insert(size_t index, Address block, const uint32_t *block_data, bool is_dirty);
+
+    /** Entry becomes free, its data stay readable until the next `insert`. */
+    void remove(size_t index);
+
+    void reset();
+
+private:
+    static constexpr uint64_t INVALID_BLOCK = ~uint64_t(0);
+
+    const size_t block_words;
+    std::vector<uint64_t> blocks;
+    std::vector<bool> dirty;
+    std::vector<uint32_t> words;
+    std::vector<uint64_t> inserted_at;
+    uint64_t insert_count = 0;
+};
+
+/**
+ * Coalescing write buffer of a write through cache
+ *
+ *  Timing model only, data are written below at once by the cache
+ *  (see `CacheConfig::set_write_buffer_entries`). Each entry collects writes
+ *  to one block. Entries drain to memory in order, one at a time. The entry at
+ *  the head is being written, it takes no more writes. Writer stalls only
+ *  when all entries are occupied, until the head is written.
+ *
+ *  Time is counted in demand accesses of the cache, at most one per cycle
+ *  (same base as prefetch statistics), plus the cycles stalled here.
+ */
+class CacheWriteBuffer {
+public:
+    /**
+     * @param entries           number of blocks waiting to be written
+     * @param block_words       size of cache block in `uint32_t` units
+     * @param first_word_time   cycles to write the first word of an entry
+     * @param next_word_time    cycles to write each following word of an entry
+     */
+    CacheWriteBuffer(
+        size_t entries,
+        size_t block_words,
+        uint32_t first_word_time,
+        uint32_t next_word_time);
+
+    /**
+     * Record a write, it may span blocks.
+     * @param now   demand access count of the cache
+     * @return      stall cycles of the writer
+     */
+    uint32_t write(Address address, size_t size, uint64_t now);
+
+    /** Everything waiting is written (see `Cache::flush`). */
+    void drain();
+
+    void reset();
+
+    uint32_t get_write_count() const { return writes; }          // Writes entering the buffer
+    uint32_t get_coalesced_count() const { return coalesced; }   // Writes merged into an entry
+    uint32_t get_stall_count() const { return stalled_cycles; }  // Writer waiting for an entry
+    uint32_t get_drained_words() const { return drained_words; } // Words written below
+    uint32_t get_buffered_words() const;                         // Also words waiting in the buffer
+    double get_average_occupancy() const;                        // Entries seen by a write
+    size_t get_max_occupancy() const { return max_occupancy; }
+
+private:
+    struct Entry {
+        uint64_t block;
+        uint64_t arrival;
+        std::vector<bool> written;
+        size_t words;
+    };
+
+    const size_t capacity;
+    const size_t block_words;
+    const uint32_t first_word_time, next_word_time;
+
+    std::deque<Entry> entries;
+    /** Time when the head entry is written. */
+    uint64_t head_done = 0;
+
+    uint32_t writes = 0;
+    uint32_t coalesced = 0;
+    uint32_t stalled_cycles = 0;
+    uint32_t drained_words = 0;
+    uint64_t occupancy_sum = 0;
+    size_t max_occupancy = 0;
+
+    uint64_t write_time(const Entry &entry) const;
+    /** Retire entries written until `time`, start writing of the next one. */
+    void advance(uint64_t time);
+    /** Store words of one block to a coalescing entry or to a new one. */
+    void write_block(uint64_t block, size_t first_word, size_t last_word, uint64_t &time);
+};
+
+} // namespace machine
+
+#endif // CACHE_BUFFERS_H
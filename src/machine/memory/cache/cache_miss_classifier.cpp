@@ -0,0 +1,37 @@
+#include "memory/cache/cache_miss_classifier.h"
+
+#include <iterator>
+
+namespace machine {
+
+CacheMissClassifier::CacheMissClassifier(size_t capacity) : capacity(capacity) {
+    shadow.reserve(capacity);
+}
+
+CacheMissClassifier::MissClass CacheMissClassifier::access(Address block) {
+    const uint64_t key = block.get_raw();
+    const auto found = shadow.find(key);
+    if (found != shadow.end()) {
+        lru.splice(lru.begin(), lru, found->second);
+        return MC_CONFLICT;
+    }
+
+    if (shadow.size() >= capacity) {
+        // Node of the least recently used block is reused.
+        shadow.erase(lru.back());
+        lru.splice(lru.begin(), lru, std::prev(lru.end()));
+        lru.front() = key;
+    } else {
+        lru.push_front(key);
+    }
+    shadow.emplace(key, lru.begin());
+    return seen.insert(key).second ? MC_COMPULSORY : MC_CAPACITY;
+}
+
+void CacheMissClassifier::reset() {
+    seen.clear();
+    lru.clear();
+    shadow.clear();
+}
+
+} // namespace machine
@@ -0,0 +1,53 @@
+#ifndef CACHE_MISS_CLASSIFIER_H
+#define CACHE_MISS_CLASSIFIER_H
+
+#include "memory/address.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace machine {
+
+/**
+ * 3C miss classification
+ *
+ *  Miss is compulsory on the first access to a block. Following misses are
+ *  capacity misses, when a fully associative LRU cache of the same capacity
+ *  (shadow cache) misses too, and conflict misses otherwise. The shadow cache
+ *  sees the same demand accesses as the classified cache, lookup and update
+ *  take constant time, so classification is always on.
+ */
+class CacheMissClassifier {
+public:
+    enum MissClass {
+        MC_COMPULSORY, // Block was never accessed
+        MC_CAPACITY,   // Fully associative cache misses too
+        MC_CONFLICT    // Fully associative cache holds the block
+    };
+
+    /** @param capacity  number of blocks of the classified cache */
+    explicit CacheMissClassifier(size_t capacity);
+
+    /**
+     * Record demand access to the block.
+     * @param block     base address of the block
+     * @return          class of the miss, used only when the cache missed
+     */
+    MissClass access(Address block);
+
+    void reset();
+
+private:
+    const size_t capacity;
+    std::unordered_set<uint64_t> seen;
+    /** Shadow cache content, most recently used first. */
+    std::list<uint64_t> lru;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> shadow;
+};
+
+} // namespace machine
+
+#endif // CACHE_MISS_CLASSIFIER_H
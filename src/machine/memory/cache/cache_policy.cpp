@@ -3,6 +3,7 @@
 #include "simulator_exception.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 
@@ -21,6 +22,18 @@ std::unique_ptr<CachePolicy> CachePolicy::get_policy_instance(const CacheConfig
             return std::make_unique<CachePolicyPLRU>(config->associativity(), config->set_count());
         case CacheConfig::RP_NMRU:
             return std::make_unique<CachePolicyNMRU>(config->associativity(), config->set_count());
+        case CacheConfig::RP_SRRIP:
+            return std::make_unique<CachePolicyRRIP>(
+                config->associativity(), config->set_count(), CachePolicyRRIP::STATIC);
+        case CacheConfig::RP_BRRIP:
+            return std::make_unique<CachePolicyRRIP>(
+                config->associativity(), config->set_count(), CachePolicyRRIP::BIMODAL);
+        case CacheConfig::RP_DRRIP:
+            return std::make_unique<CachePolicyRRIP>(
+                config->associativity(), config->set_count(), CachePolicyRRIP::DYNAMIC);
+        case CacheConfig::RP_SHIP:
+            return std::make_unique<CachePolicyRRIP>(
+                config->associativity(), config->set_count(), CachePolicyRRIP::SIGNATURE);
         }
     } else {
         // Disabled cache will never use it.
@@ -41,7 +54,12 @@ CachePolicyLRU::CachePolicyLRU(size_t associativity, size_t set_count)
     }
 }
 
-void CachePolicyLRU::update_stats(size_t way, size_t row, bool is_valid) {
+void CachePolicyLRU::update_stats(
+    size_t way,
+    size_t row,
+    bool is_valid,
+    const CachePolicyAccess &access) {
+    UNUSED(access)
     // The following code is essentially a single pass of bubble sort (with
     // temporary variable instead of inplace swapping) adding one element to
     // back or front (respectively) of a sorted array. The sort stops, when the
@@ -79,7 +97,12 @@ CachePolicyLFU::CachePolicyLFU(size_t associativity, size_t set_count) {
     stats.resize(set_count, std::vector<uint32_t>(associativity, 0));
 }
 
-void CachePolicyLFU::update_stats(size_t way, size_t row, bool is_valid) {
+void CachePolicyLFU::update_stats(
+    size_t way,
+    size_t row,
+    bool is_valid,
+    const CachePolicyAccess &access) {
+    UNUSED(access)
     auto &stat_item = stats.at(row).at(way);
 
     if (is_valid) {
@@ -120,7 +143,12 @@ CachePolicyRAND::CachePolicyRAND(size_t associativity) : associativity(associati
     std::srand(1); // NOLINT(cert-msc51-cpp)
 }
 
-void CachePolicyRAND::update_stats(size_t way, size_t row, bool is_valid) {
+void CachePolicyRAND::update_stats(
+    size_t way,
+    size_t row,
+    bool is_valid,
+    const CachePolicyAccess &access) {
+    UNUSED(access)
     UNUSED(way) UNUSED(row) UNUSED(is_valid)
     // NOP
 }
@@ -139,7 +167,12 @@ CachePolicyPLRU::CachePolicyPLRU(size_t associativity, size_t set_count)
     }
 }
 
-void CachePolicyPLRU::update_stats(size_t way, size_t row, bool is_valid) {
+void CachePolicyPLRU::update_stats(
+    size_t way,
+    size_t row,
+    bool is_valid,
+    const CachePolicyAccess &access) {
+    UNUSED(access)
     UNUSED(is_valid)
     // PLRU use a set of binary tree structured pointers to keep track of
     // the least recently used block, the number of pointers for each
@@ -180,7 +213,12 @@ CachePolicyNMRU::CachePolicyNMRU(size_t associativity, size_t set_count)
     std::srand(1); // NOLINT(cert-msc51-cpp)
 }
 
-void CachePolicyNMRU::update_stats(size_t way, size_t row, bool is_valid) {
+void CachePolicyNMRU::update_stats(
+    size_t way,
+    size_t row,
+    bool is_valid,
+    const CachePolicyAccess &access) {
+    UNUSED(access)
     UNUSED(is_valid)
     auto &row_ptr = mru_ptr.at(row); // Set currently accessed block to most recently used
     row_ptr = way;
@@ -193,4 +231,93 @@ size_t CachePolicyNMRU::select_way_to_evict(size_t row) const {
     idx = (idx < row_ptr) ? idx : idx + 1;
     return idx;
 }
+
+CachePolicyRRIP::CachePolicyRRIP(size_t associativity, size_t set_count, InsertionMode mode)
+    : rrpv(associativity * set_count, RRPV_INVALID)
+    , associativity(associativity)
+    , duel_period(std::min(DUEL_PERIOD, set_count))
+    , mode(mode) {
+    if (mode == SIGNATURE) {
+        // Unknown signatures start as reused, so SHiP starts as SRRIP.
+        shct.assign(SHCT_SIZE, 1);
+        signatures.assign(associativity * set_count, 0);
+        trained.assign(associativity * set_count, false);
+        reused.assign(associativity * set_count, false);
+    }
+}
+
+size_t CachePolicyRRIP::select_way_to_evict(size_t row) const {
+    uint8_t *const set = &rrpv.at(row * associativity);
+    const uint8_t oldest = *std::max_element(set, set + associativity);
+    if (oldest < RRPV_DISTANT) {
+        // Age the whole set at once, as repeated increments would do.
+        for (size_t way = 0; way < associativity; way++) {
+            set[way] += RRPV_DISTANT - oldest;
+        }
+    }
+    return std::find(set, set + associativity, std::max(oldest, RRPV_DISTANT)) - set;
+}
+
+void CachePolicyRRIP::update_stats(
+    size_t way,
+    size_t row,
+    bool is_valid,
+    const CachePolicyAccess &access) {
+    const size_t line = row * associativity + way;
+    if (!is_valid) {
+        // Block of a trained signature leaves the cache without reuse.
+        if (mode == SIGNATURE && trained.at(line)) {
+            uint8_t &counter = shct.at(signatures.at(line));
+            if (!reused.at(line) && counter > 0) { counter--; }
+            trained.at(line) = false;
+        }
+        rrpv.at(line) = RRPV_INVALID;
+        return;
+    }
+    if (!access.fill) {
+        rrpv.at(line) = 0;
+        if (mode == SIGNATURE && trained.at(line)) {
+            uint8_t &counter = shct.at(signatures.at(line));
+            if (counter < SHCT_MAX) { counter++; }
+            reused.at(line) = true;
+        }
+        return;
+    }
+    rrpv.at(line) = insertion_rrpv(line, row, access);
+}
+
+uint8_t CachePolicyRRIP::insertion_rrpv(size_t line, size_t row, const CachePolicyAccess &access) {
+    switch (mode) {
+    case STATIC: return RRPV_LONG;
+    case BIMODAL: return bimodal_rrpv();
+    case DYNAMIC: {
+        const size_t role = row % duel_period;
+        if (role == 0) {
+            if (!access.prefetch && psel < PSEL_MAX) { psel++; }
+            return RRPV_LONG;
+        }
+        if (role == duel_period - 1) {
+            if (!access.prefetch && psel > 0) { psel--; }
+            return bimodal_rrpv();
+        }
+        return psel > PSEL_MAX / 2 ? bimodal_rrpv() : RRPV_LONG;
+    }
+    case SIGNATURE: {
+        // Prefetched blocks are not attributed to the instruction.
+        trained.at(line) = !access.prefetch;
+        reused.at(line) = false;
+        if (access.prefetch) { return RRPV_LONG; }
+        const uint64_t pc = access.pc.get_raw();
+        signatures.at(line) = ((pc >> 1) ^ (pc >> 11)) % SHCT_SIZE;
+        return shct.at(signatures.at(line)) == 0 ? RRPV_DISTANT : RRPV_LONG;
+    }
+    }
+
+    Q_UNREACHABLE();
+}
+
+uint8_t CachePolicyRRIP::bimodal_rrpv() {
+    bimodal_count = (bimodal_count + 1) % BIMODAL_THROTTLE;
+    return bimodal_count == 0 ? RRPV_LONG : RRPV_DISTANT;
+}
 } // namespace machine
@@ -2,16 +2,30 @@
 #define CACHE_POLICY_H
 
 #include "machineconfig.h"
+#include "memory/address.h"
 #include "memory/cache/cache_types.h"
 
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <vector>
 
 using std::size_t;
 
 namespace machine {
 
+/**
+ * Metadata of an access, which made a block valid.
+ */
+struct CachePolicyAccess {
+    /** Instruction performing the access, null when unknown. */
+    Address pc;
+    /** Block was brought into the cache by this access (miss or prefetch), otherwise hit. */
+    bool fill = false;
+    /** Block was brought into the cache by prefetcher, not by demand access. */
+    bool prefetch = false;
+};
+
 /**
  * Cache replacement policy interface.
  *
@@ -27,8 +41,10 @@ public:
      * @param way           associativity way
      * @param row           cache row (index of block/set)
      * @param is_valid      is cache data valid (as in `cd.valid`)
+     * @param access        access which made the block valid (ignored when invalidated)
      */
-    virtual void update_stats(size_t way, size_t row, bool is_valid) = 0;
+    virtual void
+    update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) = 0;
 
     virtual ~CachePolicy() = default;
 
@@ -53,7 +69,7 @@ public:
 
     [[nodiscard]] size_t select_way_to_evict(size_t row) const final;
 
-    void update_stats(size_t way, size_t row, bool is_valid) final;
+    void update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) final;
 
 private:
     /**
@@ -80,7 +96,7 @@ public:
 
     [[nodiscard]] size_t select_way_to_evict(size_t row) const final;
 
-    void update_stats(size_t way, size_t row, bool is_valid) final;
+    void update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) final;
 
 private:
     std::vector<std::vector<uint32_t>> stats;
@@ -95,7 +111,7 @@ public:
 
     [[nodiscard]] size_t select_way_to_evict(size_t row) const final;
 
-    void update_stats(size_t way, size_t row, bool is_valid) final;
+    void update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) final;
 
 private:
     size_t associativity;
@@ -117,7 +133,7 @@ public:
 
     [[nodiscard]] size_t select_way_to_evict(size_t row) const final;
 
-    void update_stats(size_t way, size_t row, bool is_valid) final;
+    void update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) final;
 
 private:
     /**
@@ -145,7 +161,7 @@ public:
 
     [[nodiscard]] size_t select_way_to_evict(size_t row) const final;
 
-    void update_stats(size_t way, size_t row, bool is_valid) final;
+    void update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) final;
 
 private:
     /**
@@ -154,6 +170,71 @@ private:
     std::vector<uint32_t> mru_ptr;
     const size_t associativity;
 };
+
+/**
+ * Re-reference interval prediction (RRIP)
+ *
+ *  Each line holds a 2-bit prediction of the re-reference interval (RRPV).
+ *  Hit predicts near re-reference. Victim is a line predicted to be
+ *  re-referenced in distant future, the set is aged until there is one.
+ *  Insertion mode selects the prediction for a new block:
+ *   - STATIC (SRRIP) predicts long interval, so blocks of a scan are evicted
+ *     before the reused ones,
+ *   - BIMODAL (BRRIP) predicts distant interval except for every 32nd fill,
+ *     which keeps part of a working set larger than the cache,
+ *   - DYNAMIC (DRRIP) duels SRRIP and BRRIP on leader sets and follows
+ *     the one with fewer misses,
+ *   - SIGNATURE (SHiP) predicts distant interval for blocks filled by
+ *     instructions, whose blocks were not reused recently.
+ *
+ *  Bimodal throttle is a counter (not random), so results are reproducible.
+ */
+class CachePolicyRRIP final : public CachePolicy {
+public:
+    enum InsertionMode { STATIC, BIMODAL, DYNAMIC, SIGNATURE };
+
+    /**
+     * @param associativity     degree of assiciaivity
+     * @param set_count         number of blocks / rows in a way (or sets in
+     * cache)
+     * @param mode              prediction of newly inserted blocks
+     */
+    CachePolicyRRIP(size_t associativity, size_t set_count, InsertionMode mode);
+
+    [[nodiscard]] size_t select_way_to_evict(size_t row) const final;
+
+    void update_stats(size_t way, size_t row, bool is_valid, const CachePolicyAccess &access) final;
+
+private:
+    static constexpr uint8_t RRPV_DISTANT = 3;
+    static constexpr uint8_t RRPV_LONG = RRPV_DISTANT - 1;
+    /** Invalid lines are above distant, so they are evicted first without aging. */
+    static constexpr uint8_t RRPV_INVALID = RRPV_DISTANT + 1;
+    static constexpr uint32_t BIMODAL_THROTTLE = 32;
+    /** Each period of sets contains one SRRIP and one BRRIP leader set. */
+    static constexpr size_t DUEL_PERIOD = 32;
+    static constexpr uint32_t PSEL_MAX = 1023;
+    static constexpr size_t SHCT_SIZE = 1024;
+    static constexpr uint8_t SHCT_MAX = 7;
+
+    uint8_t insertion_rrpv(size_t line, size_t row, const CachePolicyAccess &access);
+    uint8_t bimodal_rrpv();
+
+    /** Line index is `row * associativity + way`, aged by eviction. */
+    mutable std::vector<uint8_t> rrpv;
+    const size_t associativity;
+    const size_t duel_period;
+    const InsertionMode mode;
+    uint32_t bimodal_count = 0;
+    /** Policy selection counter, high value means that SRRIP leaders miss more. */
+    uint32_t psel = PSEL_MAX / 2;
+
+    /** Signature history counter table and signatures of lines (SHiP only). */
+    std::vector<uint8_t> shct;
+    std::vector<uint16_t> signatures;
+    std::vector<bool> trained;
+    std::vector<bool> reused;
+};
 } // namespace machine
 
 #endif // CACHE_POLICY_H
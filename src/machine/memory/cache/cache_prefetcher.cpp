@@ -0,0 +1,166 @@
+#include "cache_prefetcher.h"
+
+#include "memory/cache/cache.h"
+
+#include <algorithm>
+
+namespace machine {
+
+std::unique_ptr<CachePrefetcher>
+CachePrefetcher::get_prefetcher_instance(const CacheConfig *config) {
+    if (!config->enabled()) {
+        // Disabled cache will never use it.
+        return { nullptr };
+    }
+    const size_t block_bytes = config->block_size() * BLOCK_ITEM_SIZE;
+    switch (config->prefetch_policy()) {
+    case CacheConfig::PF_NONE: return { nullptr };
+    case CacheConfig::PF_NEXT_LINE:
+        return std::make_unique<CachePrefetcherNextLine>(block_bytes, config->prefetch_degree());
+    case CacheConfig::PF_STRIDE:
+        return std::make_unique<CachePrefetcherStride>(block_bytes, config->prefetch_degree());
+    case CacheConfig::PF_STREAM:
+        return std::make_unique<CachePrefetcherStream>(block_bytes, config->prefetch_degree());
+    }
+
+    Q_UNREACHABLE();
+}
+
+bool CachePrefetcher::take(Address block, uint64_t &issued_at) {
+    (void)block;
+    (void)issued_at;
+    return false;
+}
+
+CachePrefetcherNextLine::CachePrefetcherNextLine(size_t block_bytes, size_t degree)
+    : block_bytes(block_bytes)
+    , degree(degree) {}
+
+void CachePrefetcherNextLine::observe(
+    Address pc,
+    Address address,
+    bool trigger,
+    uint64_t now,
+    std::vector<Address> &requests) {
+    (void)pc;
+    (void)now;
+    if (!trigger) { return; }
+    const Address block = address - address.get_raw() % block_bytes;
+    for (size_t i = 1; i <= degree; i++) {
+        requests.push_back(block + i * block_bytes);
+    }
+}
+
+void CachePrefetcherNextLine::reset() {}
+
+CachePrefetcherStride::CachePrefetcherStride(size_t block_bytes, size_t degree)
+    : block_bytes(block_bytes)
+    , degree(degree) {}
+
+void CachePrefetcherStride::observe(
+    Address pc,
+    Address address,
+    bool trigger,
+    uint64_t now,
+    std::vector<Address> &requests) {
+    (void)trigger;
+    (void)now;
+    // Instructions are at least 2 bytes aligned (compressed extension).
+    Entry &entry = table[(pc.get_raw() >> 1) % TABLE_SIZE];
+    if (!entry.valid || entry.pc != pc.get_raw()) {
+        entry = { .pc = pc.get_raw(),
+                  .last_address = address.get_raw(),
+                  .stride = 0,
+                  .confidence = 0,
+                  .valid = true };
+        return;
+    }
+
+    const auto stride = static_cast<int64_t>(address.get_raw() - entry.last_address);
+    entry.last_address = address.get_raw();
+    if (stride == entry.stride && stride != 0) {
+        entry.confidence = std::min<uint8_t>(entry.confidence + 1, CONFIDENCE_MAX);
+    } else if (entry.confidence > 0) {
+        // Single irregular access (e.g. loop exit) does not forget the stride.
+        entry.confidence--;
+        return;
+    } else {
+        entry.stride = stride;
+        return;
+    }
+    if (entry.confidence < CONFIDENCE_THRESHOLD) { return; }
+
+    const uint64_t accessed_block = address.get_raw() / block_bytes;
+    uint64_t last_block = accessed_block;
+    for (size_t i = 1; i <= degree; i++) {
+        const uint64_t target = address.get_raw() + entry.stride * static_cast<int64_t>(i);
+        const uint64_t block = target / block_bytes;
+        // Strides shorter than block would request the same block repeatedly.
+        if (block == last_block || block == accessed_block) { continue; }
+        requests.push_back(Address(block * block_bytes));
+        last_block = block;
+    }
+}
+
+void CachePrefetcherStride::reset() {
+    table.fill({});
+}
+
+CachePrefetcherStream::CachePrefetcherStream(size_t block_bytes, size_t depth)
+    : block_bytes(block_bytes)
+    , depth(depth) {}
+
+bool CachePrefetcherStream::take(Address block, uint64_t &issued_at) {
+    for (Buffer &buffer : buffers) {
+        if (!buffer.entries.empty() && buffer.entries.front().block == block) {
+            issued_at = buffer.entries.front().issued_at;
+            buffer.entries.pop_front();
+            taken_from = &buffer;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CachePrefetcherStream::observe(
+    Address pc,
+    Address address,
+    bool trigger,
+    uint64_t now,
+    std::vector<Address> &requests) {
+    (void)pc;
+    // Only misses reach the buffers.
+    if (!trigger) { return; }
+    const Address block = address - address.get_raw() % block_bytes;
+
+    if (taken_from != nullptr) {
+        Buffer &buffer = *taken_from;
+        taken_from = nullptr;
+        const Address next
+            = (buffer.entries.empty() ? block : buffer.entries.back().block) + block_bytes;
+        buffer.entries.push_back({ next, now });
+        buffer.last_use = now;
+        requests.push_back(next);
+        return;
+    }
+
+    Buffer &victim = *std::min_element(
+        buffers.begin(), buffers.end(),
+        [](const Buffer &a, const Buffer &b) { return a.last_use < b.last_use; });
+    victim.entries.clear();
+    victim.last_use = now;
+    for (size_t i = 1; i <= depth; i++) {
+        victim.entries.push_back({ block + i * block_bytes, now });
+        requests.push_back(block + i * block_bytes);
+    }
+}
+
+void CachePrefetcherStream::reset() {
+    for (Buffer &buffer : buffers) {
+        buffer.entries.clear();
+        buffer.last_use = 0;
+    }
+    taken_from = nullptr;
+}
+
+} // namespace machine
@@ -0,0 +1,186 @@
+#ifndef CACHE_PREFETCHER_H
+#define CACHE_PREFETCHER_H
+
+#include "machineconfig.h"
+#include "memory/address.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace machine {
+
+/**
+ * Hardware prefetch engine interface.
+ *
+ * Prefetcher observes demand accesses of a cache and proposes blocks to be
+ * fetched ahead of use. Blocks are identified by their base address. Cache
+ * filters out the blocks already present and accounts statistics
+ * (see `Cache::get_prefetch_issued_count`).
+ */
+class CachePrefetcher {
+public:
+    /**
+     * To be called by cache after each demand access.
+     * @param pc            address of the accessing instruction, null when unknown
+     * @param address       accessed address
+     * @param trigger       demand miss (also one served by prefetcher buffer)
+     *                      or first demand hit of a prefetched block
+     * @param now           demand access count of the cache (time of issue)
+     * @param requests      base addresses of proposed blocks are appended
+     */
+    virtual void observe(
+        Address pc,
+        Address address,
+        bool trigger,
+        uint64_t now,
+        std::vector<Address> &requests)
+        = 0;
+
+    /**
+     * Prefetched blocks are kept by the prefetcher instead of the cache
+     * (see `take`).
+     */
+    [[nodiscard]] virtual bool is_buffered() const { return false; }
+
+    /**
+     * To be called by cache on demand miss, buffered prefetchers only.
+     * @param block         base address of the missed block
+     * @param issued_at     time of issue of the prefetch, set when found
+     * @return              true when the block was waiting in a buffer, it is
+     *                      moved to the cache without memory access
+     */
+    virtual bool take(Address block, uint64_t &issued_at);
+
+    virtual void reset() = 0;
+
+    virtual ~CachePrefetcher() = default;
+
+    /** @return null when the cache is disabled or prefetch is not configured */
+    static std::unique_ptr<CachePrefetcher> get_prefetcher_instance(const CacheConfig *config);
+};
+
+/**
+ * Next line (tagged) prefetch
+ *
+ *  Following blocks are requested on a demand miss and on the first demand
+ *  hit of a prefetched block, so sequential access keeps ahead of use.
+ */
+class CachePrefetcherNextLine final : public CachePrefetcher {
+public:
+    /**
+     * @param block_bytes   size of cache block in bytes
+     * @param degree        number of blocks requested ahead
+     */
+    CachePrefetcherNextLine(size_t block_bytes, size_t degree);
+
+    void observe(
+        Address pc,
+        Address address,
+        bool trigger,
+        uint64_t now,
+        std::vector<Address> &requests) final;
+
+    void reset() final;
+
+private:
+    const size_t block_bytes;
+    const size_t degree;
+};
+
+/**
+ * Stride prefetch (reference prediction table)
+ *
+ *  Table indexed by instruction address remembers the last address and
+ *  stride of each load/store. Once the same stride is seen repeatedly,
+ *  next `degree` addresses along the stride are requested.
+ */
+class CachePrefetcherStride final : public CachePrefetcher {
+public:
+    /**
+     * @param block_bytes   size of cache block in bytes
+     * @param degree        number of strides requested ahead
+     */
+    CachePrefetcherStride(size_t block_bytes, size_t degree);
+
+    void observe(
+        Address pc,
+        Address address,
+        bool trigger,
+        uint64_t now,
+        std::vector<Address> &requests) final;
+
+    void reset() final;
+
+private:
+    static constexpr size_t TABLE_SIZE = 64;
+    static constexpr uint8_t CONFIDENCE_MAX = 3;
+    /** Prefetch is issued when the stride was confirmed this many times. */
+    static constexpr uint8_t CONFIDENCE_THRESHOLD = 2;
+
+    struct Entry {
+        uint64_t pc = 0;
+        uint64_t last_address = 0;
+        int64_t stride = 0;
+        uint8_t confidence = 0;
+        bool valid = false;
+    };
+
+    std::array<Entry, TABLE_SIZE> table;
+    const size_t block_bytes;
+    const size_t degree;
+};
+
+/**
+ * Stream buffers
+ *
+ *  Miss allocates the least recently used buffer and fills it with `degree`
+ *  following blocks. Miss matching the head of a buffer is served from it and
+ *  the buffer requests one more block to stay `degree` blocks ahead. Blocks
+ *  in buffers do not occupy (nor pollute) the cache.
+ */
+class CachePrefetcherStream final : public CachePrefetcher {
+public:
+    /**
+     * @param block_bytes   size of cache block in bytes
+     * @param depth         number of blocks in each buffer
+     */
+    CachePrefetcherStream(size_t block_bytes, size_t depth);
+
+    void observe(
+        Address pc,
+        Address address,
+        bool trigger,
+        uint64_t now,
+        std::vector<Address> &requests) final;
+
+    [[nodiscard]] bool is_buffered() const final { return true; }
+
+    bool take(Address block, uint64_t &issued_at) final;
+
+    void reset() final;
+
+private:
+    static constexpr size_t BUFFER_COUNT = 4;
+
+    struct Entry {
+        Address block;
+        uint64_t issued_at;
+    };
+    struct Buffer {
+        std::deque<Entry> entries;
+        uint64_t last_use = 0;
+    };
+
+    std::array<Buffer, BUFFER_COUNT> buffers;
+    /** Buffer which served the last `take`, it is refilled by following `observe`. */
+    Buffer *taken_from = nullptr;
+    const size_t block_bytes;
+    const size_t depth;
+};
+
+} // namespace machine
+
+#endif // CACHE_PREFETCHER_H
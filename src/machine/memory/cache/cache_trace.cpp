@@ -0,0 +1,308 @@
+#include "memory/cache/cache_trace.h"
+
+#include "memory/cache/cache.h"
+#include "memory/frontend_memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+#ifndef __EMSCRIPTEN__
+    #include <thread>
+#endif
+
+namespace machine {
+
+namespace {
+
+/** Backing memory of replayed caches, content does not influence statistics. */
+class NullMemory final : public FrontendMemory {
+public:
+    NullMemory() : FrontendMemory(NATIVE_ENDIAN) {}
+
+    WriteResult write(AddressWithMode, const void *, size_t size, WriteOptions) override {
+        return { .n_bytes = size, .changed = false };
+    }
+
+    ReadResult read(void *destination, AddressWithMode, size_t size, ReadOptions) const override {
+        memset(destination, 0, size);
+        return { .n_bytes = size };
+    }
+
+    [[nodiscard]] uint32_t get_change_counter() const override { return 0; }
+};
+
+/** Run jobs on all host cores, first exception is passed to the caller. */
+void run_parallel(const std::vector<std::function<void()>> &jobs) {
+    std::atomic<size_t> next { 0 };
+    std::exception_ptr error;
+    std::mutex error_lock;
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < jobs.size();) {
+            try {
+                jobs[i]();
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if (!error) { error = std::current_exception(); }
+            }
+        }
+    };
+#ifndef __EMSCRIPTEN__
+    const size_t thread_count
+        = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), jobs.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+#else
+    worker();
+#endif
+    if (error) { std::rethrow_exception(error); }
+}
+
+} // namespace
+
+double CacheReplayResult::hit_rate() const {
+    const uint32_t comp = hits + misses;
+    if (comp == 0) { return 0.0; }
+    return (double)hits / (double)comp * 100.0;
+}
+
+CacheTraceReplay::CacheTraceReplay(
+    uint32_t memory_access_penalty_r,
+    uint32_t memory_access_penalty_w,
+    uint32_t memory_access_penalty_b,
+    bool memory_access_enable_b)
+    : access_pen_r(memory_access_penalty_r)
+    , access_pen_w(memory_access_penalty_w)
+    , access_pen_b(memory_access_penalty_b)
+    , access_ena_b(memory_access_enable_b) {}
+
+std::vector<CacheReplayResult>
+CacheTraceReplay::run(const CacheTrace &trace, const std::vector<CacheConfig> &configs) const {
+    std::vector<CacheReplayResult> results(configs.size());
+    std::map<std::pair<unsigned, unsigned>, std::vector<size_t>> lru_groups;
+    std::vector<std::function<void()>> parallel_jobs;
+    std::vector<size_t> sequential;
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        const CacheConfig &config = configs[i];
+        results[i].config = config;
+        if (!config.enabled()) {
+            parallel_jobs.emplace_back([&, i]() { replay_model(trace, configs[i], results[i]); });
+        } else if (
+            config.replacement_policy() == CacheConfig::RP_LRU
+            && config.write_policy() != CacheConfig::WP_THROUGH_NOALLOC
+            && config.prefetch_policy() == CacheConfig::PF_NONE && config.victim_entries() == 0
+            && config.write_buffer_entries() == 0) {
+            lru_groups[{ config.set_count(), config.block_size() }].push_back(i);
+        } else if (
+            config.replacement_policy() == CacheConfig::RP_RAND
+            || config.replacement_policy() == CacheConfig::RP_NMRU) {
+            sequential.push_back(i);
+        } else {
+            parallel_jobs.emplace_back([&, i]() { replay_model(trace, configs[i], results[i]); });
+        }
+    }
+    for (const auto &group : lru_groups) {
+        const std::vector<size_t> &members = group.second;
+        parallel_jobs.emplace_back(
+            [&]() { replay_stack_distance(trace, configs, members, results); });
+    }
+
+    run_parallel(parallel_jobs);
+    for (size_t i : sequential) {
+        replay_model(trace, configs[i], results[i]);
+    }
+    return results;
+}
+
+void CacheTraceReplay::replay_stack_distance(
+    const CacheTrace &trace,
+    const std::vector<CacheConfig> &configs,
+    const std::vector<size_t> &group,
+    std::vector<CacheReplayResult> &results) const {
+    const unsigned set_count = configs[group.front()].set_count();
+    const unsigned block_size = configs[group.front()].block_size();
+    const uint64_t block_bytes = block_size * BLOCK_ITEM_SIZE;
+    size_t max_assoc = 0;
+    for (size_t i : group) {
+        max_assoc = std::max<size_t>(max_assoc, configs[i].associativity());
+    }
+
+    /**
+     * LRU stack of a set, most recently used block first. Block at depth `d`
+     * is present in all caches with associativity above `d`. Block written
+     * since `max_depth` was last reset is dirty in caches with associativity
+     * above `max_depth`, so it is written back by each cache it leaves
+     * afterwards.
+     */
+    struct StackEntry {
+        uint64_t tag;
+        bool written;
+        size_t max_depth;
+    };
+    std::vector<std::vector<StackEntry>> stacks(set_count);
+    // Index `max_assoc` counts blocks not present in any of the caches.
+    std::vector<uint64_t> distances(max_assoc + 1, 0);
+    // Write-backs in cache of associativity equal to the index.
+    std::vector<uint64_t> writebacks(max_assoc + 1, 0);
+    // Write-backs on flush, counted in caches of associativity equal to the index and above.
+    std::vector<uint64_t> flush_writebacks(max_assoc + 2, 0);
+    uint64_t block_accesses = 0, uncached_reads = 0, uncached_writes = 0, cached_writes = 0;
+
+    auto push_down = [&](StackEntry &entry, size_t new_depth) {
+        if (new_depth > entry.max_depth) {
+            // Entry leaves cache of associativity `new_depth` for the first time since written.
+            if (entry.written) { writebacks[new_depth]++; }
+            entry.max_depth = new_depth;
+        }
+    };
+
+    for (const CacheTraceEntry &access : trace.get_entries()) {
+        if (access.kind == CacheTraceEntry::FLUSH) {
+            for (auto &stack : stacks) {
+                for (size_t depth = 0; depth < stack.size(); depth++) {
+                    const StackEntry &entry = stack[depth];
+                    if (entry.written) {
+                        flush_writebacks[std::max(depth, entry.max_depth) + 1]++;
+                    }
+                }
+                stack.clear();
+            }
+            continue;
+        }
+        const bool write = access.kind == CacheTraceEntry::WRITE;
+        const Address address(access.address);
+        if (Cache::is_in_uncached_area(address)
+            || Cache::is_in_uncached_area(address + access.size)) {
+            (write ? uncached_writes : uncached_reads)++;
+            continue;
+        }
+        if (write) { cached_writes++; }
+        if (access.size == 0) { continue; }
+
+        const uint64_t first_block = access.address / block_bytes;
+        const uint64_t last_block = (access.address + access.size - 1) / block_bytes;
+        for (uint64_t block = first_block; block <= last_block; block++) {
+            const uint64_t tag = block / set_count;
+            auto &stack = stacks[block % set_count];
+            block_accesses++;
+
+            size_t depth = 0;
+            while (depth < stack.size() && stack[depth].tag != tag) {
+                depth++;
+            }
+            const bool found = depth < stack.size();
+            distances[found ? depth : max_assoc]++;
+            StackEntry accessed = found ? stack[depth] : StackEntry { tag, false, 0 };
+            if (!found) {
+                if (stack.size() < max_assoc) {
+                    stack.push_back(accessed);
+                } else {
+                    push_down(stack.back(), max_assoc);
+                }
+                depth = stack.size() - 1;
+            }
+            for (size_t k = depth; k > 0; k--) {
+                stack[k] = stack[k - 1];
+                push_down(stack[k], k);
+            }
+            if (write) {
+                // Write allocates, block is dirty in all caches.
+                accessed.written = true;
+                accessed.max_depth = 0;
+            }
+            stack[0] = accessed;
+        }
+    }
+
+    for (size_t assoc = 1; assoc <= max_assoc; assoc++) {
+        flush_writebacks[assoc] += flush_writebacks[assoc - 1];
+        writebacks[assoc] += flush_writebacks[assoc];
+    }
+
+    for (size_t i : group) {
+        const CacheConfig &config = configs[i];
+        const size_t assoc = config.associativity();
+        uint64_t hits = 0;
+        for (size_t d = 0; d < assoc; d++) {
+            hits += distances[d];
+        }
+        const uint64_t misses = block_accesses - hits;
+
+        Counters counters;
+        counters.hits = hits;
+        counters.misses = misses;
+        counters.mem_reads = misses * block_size + uncached_reads;
+        counters.burst_reads = misses * (block_size - 1);
+        if (config.write_policy() == CacheConfig::WP_BACK) {
+            counters.mem_writes = writebacks[assoc] * block_size + uncached_writes;
+            counters.burst_writes = writebacks[assoc] * (block_size - 1);
+        } else {
+            counters.mem_writes = cached_writes + uncached_writes;
+        }
+        results[i] = make_result(config, counters);
+    }
+}
+
+void CacheTraceReplay::replay_model(
+    const CacheTrace &trace,
+    const CacheConfig &config,
+    CacheReplayResult &result) const {
+    NullMemory memory;
+    Cache cache(&memory, &config, access_pen_r, access_pen_w, access_pen_b, access_ena_b);
+    cache.set_headless(true);
+    std::vector<byte> buffer;
+
+    for (const CacheTraceEntry &access : trace.get_entries()) {
+        if (buffer.size() < access.size) { buffer.resize(access.size); }
+        const AddressWithMode address(access.address);
+        cache.set_access_pc(Address(access.pc));
+        if (access.kind == CacheTraceEntry::FLUSH) {
+            cache.flush();
+        } else if (access.kind == CacheTraceEntry::WRITE) {
+            cache.write(address, buffer.data(), access.size, { .type = ae::REGULAR });
+        } else {
+            cache.read(buffer.data(), address, access.size, { .type = ae::REGULAR });
+        }
+    }
+
+    result.config = config;
+    result.hits = cache.get_hit_count();
+    result.misses = cache.get_miss_count();
+    result.mem_reads = cache.get_read_count();
+    result.mem_writes = cache.get_write_count();
+    result.stalled_cycles = cache.get_stall_count();
+}
+
+CacheReplayResult
+CacheTraceReplay::make_result(const CacheConfig &config, const Counters &counters) const {
+    // Same as `Cache::get_stall_count`.
+    uint32_t st_cycles = counters.mem_reads * (access_pen_r - 1)
+                         + counters.mem_writes * (access_pen_w - 1)
+                         + counters.misses * config.block_size();
+    if (access_ena_b) {
+        st_cycles -= counters.burst_reads * (access_pen_r - access_pen_b)
+                     + counters.burst_writes * (access_pen_w - access_pen_b);
+    }
+
+    CacheReplayResult result;
+    result.config = config;
+    result.hits = counters.hits;
+    result.misses = counters.misses;
+    result.mem_reads = counters.mem_reads;
+    result.mem_writes = counters.mem_writes;
+    result.stalled_cycles = st_cycles;
+    return result;
+}
+
+} // namespace machine
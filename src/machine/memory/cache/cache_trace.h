@@ -0,0 +1,137 @@
+#ifndef CACHE_TRACE_H
+#define CACHE_TRACE_H
+
+#include "machineconfig.h"
+#include "memory/address.h"
+#include "memory/cache/cache_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace machine {
+
+struct CacheTraceEntry {
+    enum Kind : uint8_t { READ, WRITE, FLUSH };
+
+    uint64_t address;
+    /** Instruction performing the access, zero when unknown (see `Cache::set_access_pc`). */
+    uint64_t pc;
+    uint32_t size;
+    Kind kind;
+};
+
+/**
+ * Sequence of accesses received by a cache (see `Cache::set_trace`).
+ * Internal reads (debugger and views) are not part of the simulated program
+ * behavior, they are not recorded.
+ *
+ * Every non-internal access reaching the recording cache is recorded, also
+ * when the cache is disabled, so the trace can be replayed on any other
+ * configuration (see `CacheTraceReplay`). Recording stops after `limit`
+ * entries, results then cover only the beginning of the run.
+ */
+class CacheTrace {
+public:
+    /** Entry takes 24 bytes, default limit keeps the trace under 400 MiB. */
+    static constexpr size_t DEFAULT_LIMIT = size_t(1) << 24;
+
+    explicit CacheTrace(size_t limit = DEFAULT_LIMIT) : limit(limit) {}
+
+    void record(Address address, size_t size, AccessType type, Address pc = Address::null()) {
+        if (is_full()) { return; }
+        entries.push_back({ address.get_raw(), pc.get_raw(), static_cast<uint32_t>(size),
+                            type == WRITE ? CacheTraceEntry::WRITE : CacheTraceEntry::READ });
+    }
+    /** Whole cache is written back and invalidated (see `Cache::flush`). */
+    void record_flush() {
+        if (is_full()) { return; }
+        entries.push_back({ 0, 0, 0, CacheTraceEntry::FLUSH });
+    }
+
+    [[nodiscard]] const std::vector<CacheTraceEntry> &get_entries() const { return entries; }
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    /** Some accesses were not recorded because of the limit. */
+    [[nodiscard]] bool is_truncated() const { return truncated; }
+    void clear() {
+        entries.clear();
+        truncated = false;
+    }
+
+private:
+    const size_t limit;
+    std::vector<CacheTraceEntry> entries;
+    bool truncated = false;
+
+    bool is_full() {
+        if (entries.size() < limit) { return false; }
+        truncated = true;
+        return true;
+    }
+};
+
+/** Statistics of a single configuration, same meaning as the `Cache` getters. */
+struct CacheReplayResult {
+    CacheConfig config;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t mem_reads = 0;
+    uint32_t mem_writes = 0;
+    uint32_t stalled_cycles = 0;
+
+    [[nodiscard]] double hit_rate() const;
+};
+
+/**
+ * Evaluates many cache configurations on a recorded trace in one pass.
+ *
+ * LRU configurations with write allocation and without prefetch, victim cache
+ * or write buffer, which share set count and block size, are evaluated
+ * together by stack distance (Mattson) analysis. Single walk over the trace
+ * yields statistics for all their associativities. Other configurations are
+ * replayed by `Cache` models in parallel. Random policies share the global random generator, so they are
+ * replayed sequentially to stay reproducible.
+ *
+ * Results match statistics of `Cache` with the same configuration and
+ * memory access penalties on the same accesses.
+ */
+class CacheTraceReplay {
+public:
+    /** Penalties have the same meaning as in `Cache` constructor. */
+    explicit CacheTraceReplay(
+        uint32_t memory_access_penalty_r = 1,
+        uint32_t memory_access_penalty_w = 1,
+        uint32_t memory_access_penalty_b = 0,
+        bool memory_access_enable_b = false);
+
+    /** @return  results in the order of `configs` */
+    [[nodiscard]] std::vector<CacheReplayResult>
+    run(const CacheTrace &trace, const std::vector<CacheConfig> &configs) const;
+
+private:
+    const uint32_t access_pen_r, access_pen_w, access_pen_b;
+    const bool access_ena_b;
+
+    struct Counters {
+        uint32_t hits = 0, misses = 0, mem_reads = 0, mem_writes = 0, burst_reads = 0,
+                 burst_writes = 0;
+    };
+
+    void replay_stack_distance(
+        const CacheTrace &trace,
+        const std::vector<CacheConfig> &configs,
+        const std::vector<size_t> &group,
+        std::vector<CacheReplayResult> &results) const;
+
+    void replay_model(
+        const CacheTrace &trace,
+        const CacheConfig &config,
+        CacheReplayResult &result) const;
+
+    [[nodiscard]] CacheReplayResult
+    make_result(const CacheConfig &config, const Counters &counters) const;
+};
+
+} // namespace machine
+
+#endif // CACHE_TRACE_H
@@ -16,15 +16,6 @@ struct CacheLocation {
     uint64_t byte;
 };
 
-/**
- * Single cache line. Appropriate cache block is stored in `data`.
- */
-struct CacheLine {
-    bool valid, dirty;
-    uint64_t tag;
-    std::vector<uint32_t> data;
-};
-
 /**
  * This is preferred over bool (write = true|false) for better readability.
  */
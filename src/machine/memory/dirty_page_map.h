@@ -0,0 +1,100 @@
+#ifndef DIRTY_PAGE_MAP_H
+#define DIRTY_PAGE_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace machine {
+
+/**
+ * Sparse bitmap of modified pages.
+ *
+ * Pages are tracked by one bit, grouped to 64-bit words, which are kept in a
+ * hash map, so any part of the 64-bit offset space can be tracked. Words are
+ * never removed (except on `clear`), so once a region has been changed,
+ * further marking and collection do not allocate.
+ */
+class DirtyPageMap {
+public:
+    static constexpr unsigned PAGE_BITS = 12;
+    static constexpr uint64_t PAGE_SIZE = 1ULL << PAGE_BITS;
+
+    /** Mark all pages overlapping bytes `first` to `last` (inclusive). */
+    void mark(uint64_t first, uint64_t last) {
+        for (uint64_t page = first >> PAGE_BITS; page <= last >> PAGE_BITS; ++page) {
+            const uint64_t index = page / WORD_BITS;
+            if (last_word == nullptr || last_word_index != index) {
+                last_word = &words[index];
+                last_word_index = index;
+            }
+            *last_word |= 1ULL << (page % WORD_BITS);
+        }
+    }
+
+    /**
+     * Call `visitor` with the first byte offset of each dirty page overlapping
+     * bytes `first` to `last` (inclusive) and clear those pages.
+     * Order of pages is not specified.
+     *
+     * @return  number of reported pages
+     */
+    size_t collect_and_clear(
+        uint64_t first,
+        uint64_t last,
+        const std::function<void(uint64_t)> &visitor) {
+        const uint64_t first_page = first >> PAGE_BITS;
+        const uint64_t last_page = last >> PAGE_BITS;
+        const uint64_t first_index = first_page / WORD_BITS;
+        const uint64_t last_index = last_page / WORD_BITS;
+        size_t count = 0;
+
+        auto collect_word = [&](uint64_t index, uint64_t &word) {
+            uint64_t mask = ~0ULL;
+            if (index == first_index) { mask &= ~0ULL << (first_page % WORD_BITS); }
+            if (index == last_index) { mask &= ~0ULL >> (WORD_BITS - 1 - last_page % WORD_BITS); }
+            uint64_t hits = word & mask;
+            word &= ~hits;
+            for (uint64_t page = index * WORD_BITS; hits != 0; ++page, hits >>= 1) {
+                if (hits & 1) {
+                    visitor(page << PAGE_BITS);
+                    count++;
+                }
+            }
+        };
+
+        if (last_index - first_index >= words.size()) {
+            // Range is wider than the tracked part, walk the tracked words only.
+            for (auto &entry : words) {
+                if (entry.first >= first_index && entry.first <= last_index) {
+                    collect_word(entry.first, entry.second);
+                }
+            }
+        } else {
+            for (uint64_t index = first_index; index <= last_index; ++index) {
+                auto iter = words.find(index);
+                if (iter != words.end()) { collect_word(index, iter->second); }
+            }
+        }
+        return count;
+    }
+
+    /** Forget all pages, releases the storage. */
+    void clear() {
+        words.clear();
+        last_word = nullptr;
+    }
+
+private:
+    static constexpr unsigned WORD_BITS = 64;
+
+    std::unordered_map<uint64_t, uint64_t> words;
+    // Element references of the map are stable, pointer stays valid until clear.
+    uint64_t last_word_index = 0;
+    uint64_t *last_word = nullptr;
+};
+
+} // namespace machine
+
+#endif // DIRTY_PAGE_MAP_H
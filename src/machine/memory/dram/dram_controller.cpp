@@ -0,0 +1,229 @@
+#include "memory/dram/dram_controller.h"
+
+#include <algorithm>
+
+namespace machine {
+
+DramController::DramController(
+    FrontendMemory *memory,
+    const DramConfig *config,
+    std::vector<std::pair<Address, Address>> timed_ranges)
+    : FrontendMemory(memory->simulated_machine_endian)
+    , dram_config(*config)
+    , mem(memory)
+    , timed_ranges(std::move(timed_ranges)) {
+    reset();
+}
+
+WriteResult DramController::write(
+    AddressWithMode destination,
+    const void *source,
+    size_t size,
+    WriteOptions options) {
+    if (options.type == ae::REGULAR && is_timed(destination)) {
+        advance_clock();
+        writes++;
+        write_queue.push_back({ destination, size, now });
+        if (write_queue.size() > dram_config.queue_size()) {
+            // Writer waits until the scheduled write leaves the queue.
+            queue_full++;
+            const size_t index = select_write();
+            const Request request = write_queue[index];
+            write_queue.erase(write_queue.begin() + index);
+            wait_until(serve(request.address, request.size, now));
+        }
+    }
+    return mem->write(destination, source, size, options);
+}
+
+ReadResult
+DramController::read(void *destination, AddressWithMode source, size_t size, ReadOptions options)
+    const {
+    if (options.type == ae::REGULAR && is_timed(source)) {
+        advance_clock();
+        reads++;
+        // Reads are not queued, they bypass posted writes (see class doc).
+        const uint64_t done = serve(source, size, now);
+        read_latency += done - now;
+        wait_until(done);
+    }
+    return mem->read(destination, source, size, options);
+}
+
+uint32_t DramController::get_change_counter() const {
+    return mem->get_change_counter();
+}
+
+void DramController::sync() {
+    mem->sync();
+}
+
+enum LocationStatus DramController::location_status(Address address) const {
+    return mem->location_status(address);
+}
+
+void DramController::set_access_pc(Address pc) {
+    mem->set_access_pc(pc);
+}
+
+uint32_t DramController::take_access_latency(bool below_cache) {
+    (void)below_cache;
+    const uint32_t waited = latency;
+    latency = 0;
+    return waited + mem->take_access_latency();
+}
+
+void DramController::set_clock(std::function<uint64_t()> clock) {
+    this->clock = std::move(clock);
+}
+
+const DramConfig &DramController::get_config() const {
+    return dram_config;
+}
+
+uint32_t DramController::get_read_count() const {
+    return reads;
+}
+
+uint32_t DramController::get_write_count() const {
+    return writes;
+}
+
+uint32_t DramController::get_row_hit_count() const {
+    return row_hits;
+}
+
+uint32_t DramController::get_row_miss_count() const {
+    return row_misses;
+}
+
+uint32_t DramController::get_row_conflict_count() const {
+    return row_conflicts;
+}
+
+uint32_t DramController::get_queue_full_count() const {
+    return queue_full;
+}
+
+double DramController::get_average_read_latency() const {
+    if (reads == 0) { return 0.0; }
+    return (double)read_latency / reads;
+}
+
+uint64_t DramController::get_busy_cycles() const {
+    return busy_cycles;
+}
+
+uint64_t DramController::get_elapsed_cycles() const {
+    return clock ? std::max(now, clock()) : now;
+}
+
+double DramController::get_bandwidth_utilization() const {
+    const uint64_t elapsed = get_elapsed_cycles();
+    if (elapsed == 0) { return 0.0; }
+    return 100.0 * (double)busy_cycles / ((double)elapsed * (double)dram_config.channels());
+}
+
+void DramController::reset() {
+    channels.assign(dram_config.channels(), Channel {});
+    for (Channel &channel : channels) {
+        channel.banks.assign(dram_config.banks(), Bank {});
+    }
+    write_queue.clear();
+    now = 0;
+    latency = 0;
+    reads = 0;
+    writes = 0;
+    row_hits = 0;
+    row_misses = 0;
+    row_conflicts = 0;
+    queue_full = 0;
+    read_latency = 0;
+    busy_cycles = 0;
+}
+
+DramController::Location DramController::locate(Address address) const {
+    const uint64_t chunk = address.get_raw() / dram_config.row_size();
+    const uint64_t bank_chunk = chunk / dram_config.channels();
+    return { .channel = chunk % dram_config.channels(),
+             .bank = bank_chunk % dram_config.banks(),
+             .row = bank_chunk / dram_config.banks() };
+}
+
+DramController::Bank &DramController::bank_of(const Location &loc) const {
+    return channels[loc.channel].banks[loc.bank];
+}
+
+uint64_t DramController::serve(Address address, size_t size, uint64_t earliest) const {
+    const Location loc = locate(address);
+    Channel &channel = channels[loc.channel];
+    Bank &bank = bank_of(loc);
+
+    uint64_t access = dram_config.t_cas();
+    if (bank.open_row == loc.row) {
+        row_hits++;
+    } else if (bank.open_row == NO_ROW) {
+        row_misses++;
+        access += dram_config.t_rcd();
+    } else {
+        row_conflicts++;
+        access += dram_config.t_rp() + dram_config.t_rcd();
+    }
+
+    const uint64_t transfer = (size + BUS_BYTES - 1) / BUS_BYTES;
+    const uint64_t start = std::max(earliest, bank.ready_at);
+    const uint64_t done = std::max(start + access, channel.bus_free_at) + transfer;
+    channel.bus_free_at = done;
+    busy_cycles += transfer;
+
+    if (dram_config.page_policy() == DramConfig::PAGE_OPEN) {
+        bank.open_row = loc.row;
+        bank.ready_at = done;
+    } else {
+        bank.open_row = NO_ROW;
+        bank.ready_at = done + dram_config.t_rp();
+    }
+    return done;
+}
+
+uint64_t DramController::start_of(const Request &request) const {
+    return std::max(request.arrival, bank_of(locate(request.address)).ready_at);
+}
+
+size_t DramController::select_write(uint64_t before) const {
+    size_t oldest = write_queue.size();
+    for (size_t i = 0; i < write_queue.size(); i++) {
+        if (start_of(write_queue[i]) >= before) { continue; }
+        const Location loc = locate(write_queue[i].address);
+        if (bank_of(loc).open_row == loc.row) { return i; }
+        if (oldest == write_queue.size()) { oldest = i; }
+    }
+    return oldest;
+}
+
+void DramController::issue_idle_writes() const {
+    // Write waiting for a busy bank does not hold back writes to other banks.
+    for (size_t index; (index = select_write(now)) < write_queue.size();) {
+        const Request request = write_queue[index];
+        write_queue.erase(write_queue.begin() + index);
+        serve(request.address, request.size, start_of(request));
+    }
+}
+
+void DramController::advance_clock() const {
+    if (clock) { now = std::max(now, clock()); }
+    issue_idle_writes();
+}
+
+void DramController::wait_until(uint64_t time) const {
+    latency += time - now;
+    now = time;
+}
+
+bool DramController::is_timed(Address address) const {
+    return std::any_of(timed_ranges.begin(), timed_ranges.end(), [address](const auto &range) {
+        return address >= range.first && address <= range.second;
+    });
+}
+
+} // namespace machine
@@ -0,0 +1,157 @@
+#ifndef DRAM_CONTROLLER_H
+#define DRAM_CONTROLLER_H
+
+#include "machineconfig.h"
+#include "memory/frontend_memory.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace machine {
+
+/**
+ * Timing model of a banked DRAM behind the last cache level.
+ *
+ * Data are passed to the memory below unchanged, the controller only accounts
+ * time. Address is split to row buffer sized chunks, consecutive chunks are
+ * interleaved over channels and then over banks of a channel. Each bank keeps
+ * the row in its row buffer open (open page policy) or precharges it right
+ * after the access (closed page policy). Access to the open row costs tCAS,
+ * access to a precharged bank tRCD + tCAS and access to another row tRP +
+ * tRCD + tCAS. Data are then transferred over the data bus of the channel,
+ * which serves one request at a time (`BUS_BYTES` per cycle).
+ *
+ * Only writes are scheduled. They are posted to the request queue and
+ * scheduled first-ready first-come-first-serve (FR-FCFS): the oldest write to
+ * an open row goes first, the oldest write otherwise. Queued writes are issued
+ * while the controller is idle. The writer waits only when the queue is full.
+ * Reads are not queued. The requester waits for the data, so there is never
+ * more than one read to choose from. A read is served at once, before all
+ * queued writes (data of a queued write are forwarded in hardware).
+ *
+ * Only the RAM ranges given by the owner are timed. Other addresses
+ * (peripherals) are accessed without delay.
+ */
+class DramController : public FrontendMemory {
+    Q_OBJECT
+public:
+    /**
+     * @param memory        memory holding the data
+     * @param config        DRAM configuration
+     * @param timed_ranges  first and last addresses of RAM ranges, whole
+     *                      address space by default
+     */
+    DramController(
+        FrontendMemory *memory,
+        const DramConfig *config,
+        std::vector<std::pair<Address, Address>> timed_ranges
+        = { { 0x0_addr, Address(~uint64_t(0)) } });
+
+    WriteResult
+    write(AddressWithMode destination, const void *source, size_t size, WriteOptions options) override;
+
+    ReadResult
+    read(void *destination, AddressWithMode source, size_t size, ReadOptions options) const override;
+
+    uint32_t get_change_counter() const override;
+
+    void sync() override;
+
+    enum LocationStatus location_status(Address address) const override;
+
+    void set_access_pc(Address pc) override;
+
+    /** Cycles requesters waited since the previous call. */
+    uint32_t take_access_latency(bool below_cache = false) override;
+
+    /**
+     * Simulation time in cycles, used to let the controller run while the
+     * requesters do not wait for it. Without a clock, time advances only
+     * while requests are waited for.
+     */
+    void set_clock(std::function<uint64_t()> clock);
+
+    const DramConfig &get_config() const;
+
+    uint32_t get_read_count() const;          // Read requests
+    uint32_t get_write_count() const;         // Write requests
+    uint32_t get_row_hit_count() const;       // Requests to the open row
+    uint32_t get_row_miss_count() const;      // Requests to a precharged bank
+    uint32_t get_row_conflict_count() const;  // Requests closing another row
+    uint32_t get_queue_full_count() const;    // Writes waiting for a free queue entry
+    double get_average_read_latency() const;  // Cycles from request to data
+    uint64_t get_busy_cycles() const;         // Data transfer cycles of all channels
+    uint64_t get_elapsed_cycles() const;      // Time of the controller
+    double get_bandwidth_utilization() const; // Busy data buses in percents of time
+
+    void reset();
+
+    /** Data bus width of a channel in bytes transferred per cycle. */
+    static constexpr size_t BUS_BYTES = 8;
+
+private:
+    const DramConfig dram_config;
+    FrontendMemory *const mem;
+    const std::vector<std::pair<Address, Address>> timed_ranges;
+    std::function<uint64_t()> clock;
+
+    static constexpr uint64_t NO_ROW = ~uint64_t(0);
+
+    struct Location {
+        size_t channel;
+        size_t bank;
+        uint64_t row;
+    };
+    struct Bank {
+        uint64_t open_row = NO_ROW;
+        uint64_t ready_at = 0;
+    };
+    struct Channel {
+        std::vector<Bank> banks;
+        uint64_t bus_free_at = 0;
+    };
+    struct Request {
+        Address address;
+        size_t size;
+        uint64_t arrival;
+    };
+
+    mutable std::vector<Channel> channels;
+    mutable std::deque<Request> write_queue;
+    mutable uint64_t now = 0;
+    /** Waited cycles not yet taken by `take_access_latency`. */
+    mutable uint32_t latency = 0;
+
+    mutable uint32_t reads = 0;
+    mutable uint32_t writes = 0;
+    mutable uint32_t row_hits = 0;
+    mutable uint32_t row_misses = 0;
+    mutable uint32_t row_conflicts = 0;
+    mutable uint32_t queue_full = 0;
+    mutable uint64_t read_latency = 0;
+    mutable uint64_t busy_cycles = 0;
+
+    Location locate(Address address) const;
+    Bank &bank_of(const Location &loc) const;
+    /** @return cycle, when the data transfer is finished */
+    uint64_t serve(Address address, size_t size, uint64_t earliest) const;
+    /** Cycle, when the request can start in its bank. */
+    uint64_t start_of(const Request &request) const;
+    /**
+     * FR-FCFS choice from writes, which can start before `before`.
+     * @return  index in the write queue, its size when there is no such write
+     */
+    size_t select_write(uint64_t before = ~uint64_t(0)) const;
+    /** Issue writes, which could have started before now. */
+    void issue_idle_writes() const;
+    void advance_clock() const;
+    void wait_until(uint64_t time) const;
+    bool is_timed(Address address) const;
+};
+
+} // namespace machine
+
+#endif // DRAM_CONTROLLER_H
@@ -2,6 +2,9 @@
 
 #include "common/endian.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace machine {
 
 bool FrontendMemory::write_u8(AddressWithMode address, uint8_t value, AccessEffects type) {
@@ -37,28 +40,53 @@ uint64_t FrontendMemory::read_u64(AddressWithMode address, AccessEffects type) c
 }
 
 void FrontendMemory::write_ctl(enum AccessControl ctl, AddressWithMode offset, RegisterValue value) {
+    ExceptionCause fault = EXCAUSE_NONE;
+    write_ctl(ctl, offset, value, fault);
+    if (fault != EXCAUSE_NONE) {
+        throw SIMULATOR_EXCEPTION(
+            PageFault, "Address translation failed", QString::number(offset.get_raw(), 16),
+            fault);
+    }
+}
+
+RegisterValue FrontendMemory::read_ctl(enum AccessControl ctl, AddressWithMode address) const {
+    ExceptionCause fault = EXCAUSE_NONE;
+    RegisterValue value = read_ctl(ctl, address, fault);
+    if (fault != EXCAUSE_NONE) {
+        throw SIMULATOR_EXCEPTION(
+            PageFault, "Address translation failed", QString::number(address.get_raw(), 16),
+            fault);
+    }
+    return value;
+}
+
+void FrontendMemory::write_ctl(
+    enum AccessControl ctl,
+    AddressWithMode offset,
+    RegisterValue value,
+    ExceptionCause &fault) {
     switch (ctl) {
     case AC_NONE: {
         break;
     }
     case AC_I8:
     case AC_U8: {
-        write_u8(offset, value.as_u8());
+        write_generic<uint8_t>(offset, value.as_u8(), ae::REGULAR, &fault);
         break;
     }
     case AC_I16:
     case AC_U16: {
-        write_u16(offset, value.as_u16());
+        write_generic<uint16_t>(offset, value.as_u16(), ae::REGULAR, &fault);
         break;
     }
     case AC_I32:
     case AC_U32: {
-        write_u32(offset, value.as_u32());
+        write_generic<uint32_t>(offset, value.as_u32(), ae::REGULAR, &fault);
         break;
     }
     case AC_I64:
     case AC_U64: {
-        write_u64(offset, value.as_u64());
+        write_generic<uint64_t>(offset, value.as_u64(), ae::REGULAR, &fault);
         break;
     }
     default: {
@@ -69,17 +97,20 @@ void FrontendMemory::write_ctl(enum AccessControl ctl, AddressWithMode offset, R
     }
 }
 
-RegisterValue FrontendMemory::read_ctl(enum AccessControl ctl, AddressWithMode address) const {
+RegisterValue FrontendMemory::read_ctl(
+    enum AccessControl ctl,
+    AddressWithMode address,
+    ExceptionCause &fault) const {
     switch (ctl) {
     case AC_NONE: return 0;
-    case AC_I8: return (int8_t)read_u8(address);
-    case AC_U8: return read_u8(address);
-    case AC_I16: return (int16_t)read_u16(address);
-    case AC_U16: return read_u16(address);
-    case AC_I32: return (int32_t)read_u32(address);
-    case AC_U32: return read_u32(address);
-    case AC_I64: return (int64_t)read_u64(address);
-    case AC_U64: return read_u64(address);
+    case AC_I8: return (int8_t)read_generic<uint8_t>(address, ae::REGULAR, &fault);
+    case AC_U8: return read_generic<uint8_t>(address, ae::REGULAR, &fault);
+    case AC_I16: return (int16_t)read_generic<uint16_t>(address, ae::REGULAR, &fault);
+    case AC_U16: return read_generic<uint16_t>(address, ae::REGULAR, &fault);
+    case AC_I32: return (int32_t)read_generic<uint32_t>(address, ae::REGULAR, &fault);
+    case AC_U32: return read_generic<uint32_t>(address, ae::REGULAR, &fault);
+    case AC_I64: return (int64_t)read_generic<uint64_t>(address, ae::REGULAR, &fault);
+    case AC_U64: return read_generic<uint64_t>(address, ae::REGULAR, &fault);
     default: {
         throw SIMULATOR_EXCEPTION(
             UnknownMemoryControl, "Trying to read from memory with unknown ctl",
@@ -101,10 +132,80 @@ LocationStatus FrontendMemory::location_status(Address address) const {
     return LOCSTAT_NONE;
 }
 
+byte *FrontendMemory::direct_access(Address address, size_t size) const {
+    (void)address;
+    (void)size;
+    return nullptr;
+}
+
+void FrontendMemory::set_access_pc(Address pc) {
+    (void)pc;
+}
+
+uint32_t FrontendMemory::take_access_latency(bool below_cache) {
+    (void)below_cache;
+    return 0;
+}
+
+size_t FrontendMemory::read_block(
+    void *destination,
+    AddressWithMode source,
+    size_t size,
+    AccessEffects type) const {
+    auto *dst = static_cast<byte *>(destination);
+    size_t done = 0;
+    while (done < size) {
+        const AddressWithMode address(source + done, source.access_mode());
+        const size_t chunk = std::min(
+            size - done, BLOCK_CHUNK_SIZE - (address.get_raw() & (BLOCK_CHUNK_SIZE - 1)));
+        if (const byte *host = direct_access(address, chunk)) {
+            memcpy(dst + done, host, chunk);
+        } else {
+            ReadResult result = read(dst + done, address, chunk, { .type = type });
+            done += result.n_bytes;
+            if (result.fault != EXCAUSE_NONE || result.n_bytes < chunk) { return done; }
+            continue;
+        }
+        done += chunk;
+    }
+    return done;
+}
+
+size_t FrontendMemory::write_block(
+    AddressWithMode destination,
+    const void *source,
+    size_t size,
+    AccessEffects type) {
+    const auto *src = static_cast<const byte *>(source);
+    size_t done = 0;
+    while (done < size) {
+        const AddressWithMode address(destination + done, destination.access_mode());
+        const size_t chunk = std::min(
+            size - done, BLOCK_CHUNK_SIZE - (address.get_raw() & (BLOCK_CHUNK_SIZE - 1)));
+        // Writes always go through the chain, so changes are detected.
+        WriteResult result = write(address, src + done, chunk, { .type = type });
+        done += result.n_bytes;
+        if (result.fault != EXCAUSE_NONE || result.n_bytes < chunk) { break; }
+    }
+    return done;
+}
+
 template<typename T>
-T FrontendMemory::read_generic(AddressWithMode address, AccessEffects type) const {
+T FrontendMemory::read_generic(
+    AddressWithMode address,
+    AccessEffects type,
+    ExceptionCause *fault) const {
     T value;
-    read(&value, address, sizeof(T), { .type = type });
+    ReadResult result = read(&value, address, sizeof(T), { .type = type });
+    if (result.fault != EXCAUSE_NONE) {
+        if (fault == nullptr) {
+            throw SIMULATOR_EXCEPTION(
+                PageFault, "Address translation failed", QString::number(address.get_raw(), 16),
+                result.fault);
+        }
+        *fault = result.fault;
+        return 0;
+    }
     // When cross-simulating (BIG simulator on LITTLE host machine and vice
     // versa) data needs to be swapped before writing to memory and after
     // reading from memory to achieve correct results of misaligned reads. See
@@ -132,10 +233,23 @@ T FrontendMemory::read_generic(AddressWithMode address, AccessEffects type) cons
 }
 
 template<typename T>
-bool FrontendMemory::write_generic(AddressWithMode address, const T value, AccessEffects type) {
+bool FrontendMemory::write_generic(
+    AddressWithMode address,
+    const T value,
+    AccessEffects type,
+    ExceptionCause *fault) {
     // See example in read_generic for byteswap explanation.
     const T swapped_value = byteswap_if(value, this->simulated_machine_endian != NATIVE_ENDIAN);
-    return write(address, &swapped_value, sizeof(T), { .type = type }).changed;
+    WriteResult result = write(address, &swapped_value, sizeof(T), { .type = type });
+    if (result.fault != EXCAUSE_NONE) {
+        if (fault == nullptr) {
+            throw SIMULATOR_EXCEPTION(
+                PageFault, "Address translation failed", QString::number(address.get_raw(), 16),
+                result.fault);
+        }
+        *fault = result.fault;
+    }
+    return result.changed;
 }
 FrontendMemory::FrontendMemory(Endian simulated_endian)
     : simulated_machine_endian(simulated_endian) {}
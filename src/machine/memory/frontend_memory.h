@@ -82,10 +82,84 @@ public:
      */
     [[nodiscard]] RegisterValue read_ctl(enum AccessControl control_signal, AddressWithMode source) const;
 
+    /**
+     * Variants of `write_ctl` and `read_ctl` reporting address translation
+     * faults by result instead of throwing page fault exception.
+     *
+     * Memory is not accessed past the faulting page and read returns zero.
+     * @param fault     set to the page fault cause, untouched on success
+     */
+    void write_ctl(
+        enum AccessControl control_signal,
+        AddressWithMode destination,
+        RegisterValue value,
+        ExceptionCause &fault);
+    [[nodiscard]] RegisterValue read_ctl(
+        enum AccessControl control_signal,
+        AddressWithMode source,
+        ExceptionCause &fault) const;
+
     virtual void sync();
     virtual void sfence_vma(uint64_t vaddr, uint64_t asid);
     [[nodiscard]] virtual LocationStatus location_status(Address address) const;
     [[nodiscard]] virtual uint32_t get_change_counter() const = 0;
+
+    /**
+     * Host pointer to memory content of the whole range, when it can be accessed directly.
+     *
+     * Only components, which do not hold state for the range (memory bus, disabled cache,
+     * TLB with translation off), can provide it, default is null.
+     * @see BackendMemory::direct_access
+     */
+    [[nodiscard]] virtual byte *direct_access(Address address, size_t size) const;
+
+    /**
+     * Address of the instruction performing following accesses.
+     *
+     * Used by cache prefetchers to tell access streams apart, components
+     * forward it to the memory below, default ignores it.
+     */
+    virtual void set_access_pc(Address pc);
+
+    /**
+     * Cycles accesses of this component and the memory below it waited since
+     * the previous call (memory timing of pipelined core). Default is zero.
+     *
+     * @param below_cache   caller is a cache, whose access penalties already
+     *                      describe this component
+     */
+    virtual uint32_t take_access_latency(bool below_cache = false);
+
+    /** Size of chunks used by block transfers, no chunk crosses a page boundary. */
+    static constexpr size_t BLOCK_CHUNK_SIZE = 4096;
+
+    /**
+     * Copy a block of simulated memory to host buffer or back.
+     *
+     * Intended for bulk transfers done on behalf of the program (e.g. emulated syscalls). Block
+     * is transferred by page chunks through regular `read` and `write`, so address translation
+     * and caches are honored. Chunks are read directly when the chain allows `direct_access`.
+     *
+     * @return  number of transferred bytes, less than size when a page fault was hit
+     */
+    size_t read_block(
+        void *destination,
+        AddressWithMode source,
+        size_t size,
+        AccessEffects type = ae::REGULAR) const;
+    size_t write_block(
+        AddressWithMode destination,
+        const void *source,
+        size_t size,
+        AccessEffects type = ae::REGULAR);
+
+    /**
+     * Headless component does not emit per access visualization signals. Observers have to pull
+     * the state (statistics) themselves. Signals with functional effect are always emitted.
+     */
+    void set_headless(bool value) { headless = value; }
+    [[nodiscard]] bool is_headless() const { return headless; }
+
     /**
      * Write byte sequence to memory
      *
@@ -120,6 +194,9 @@ public:
      */
     const Endian simulated_machine_endian;
 
+protected:
+    bool headless = false;
+
 signals:
     /**
      * Signal used to propagate a change up through the hierarchy.
@@ -143,10 +220,14 @@ private:
      * @param address       emulated address to read from
      * @param type          read by visualization etc (type ae::INTERNAL) should
      *                      not cause certain effects (counter increments...)
+     * @param fault         where to report page fault, exception is thrown if null
      * @return              requested data with type T
      */
     template<typename T>
-    T read_generic(AddressWithMode address, AccessEffects type) const;
+    T read_generic(
+        AddressWithMode address,
+        AccessEffects type,
+        ExceptionCause *fault = nullptr) const;
 
     /**
      * Write to any type from memory
@@ -160,10 +241,15 @@ private:
      * @param value         value of type T to be written
      * @param type          read by visualization etc (type ae::INTERNAL).
      * should not cause certain effects (counter increments...)
+     * @param fault         where to report page fault, exception is thrown if null
      * @return              true when memory before and after write differs
      */
     template<typename T>
-    bool write_generic(AddressWithMode address, T value, AccessEffects type);
+    bool write_generic(
+        AddressWithMode address,
+        T value,
+        AccessEffects type,
+        ExceptionCause *fault = nullptr);
 };
 
 } // namespace machine
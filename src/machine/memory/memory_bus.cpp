@@ -3,6 +3,8 @@
 #include "common/endian.h"
 #include "memory/memory_utils.h"
 
+#include <algorithm>
+
 using namespace machine;
 
 MemoryDataBus::MemoryDataBus(Endian simulated_endian) : FrontendMemory(simulated_endian) {};
@@ -39,10 +41,24 @@ WriteResult MemoryDataBus::write_single(
         // just ignore the write.
         return (WriteResult) { .n_bytes = 0, .changed = false };
     }
-    WriteResult result
-        = range->device->write(destination - range->start_addr, source, size, options);
+    const Offset offset = range->to_offset(destination);
+    if (byte *host = range->device->direct_access(offset, size)) {
+        // Direct access does not detect changes, do it here.
+        if (memcmp(host, source, size) == 0) { return { .n_bytes = size, .changed = false }; }
+        memcpy(host, source, size);
+        change_counter++;
+        // Device does not see writes through the pointer.
+        if (dirty_tracking) { dirty.mark(destination.get_raw(), destination.get_raw() + size - 1); }
+        return { .n_bytes = size, .changed = true };
+    }
+    WriteResult result = range->device->write(offset, source, size, options);
 
-    if (result.changed) { change_counter++; }
+    if (result.changed) {
+        change_counter++;
+        if (dirty_tracking && !range->device_tracks_dirty) {
+            dirty.mark(destination.get_raw(), destination.get_raw() + result.n_bytes - 1);
+        }
+    }
 
     return result;
 }
@@ -70,7 +86,12 @@ ReadResult MemoryDataBus::read_single(
         return (ReadResult) { .n_bytes = size };
     }
 
-    return p_range->device->read(destination, source - p_range->start_addr, size, options);
+    const Offset offset = p_range->to_offset(source);
+    if (const byte *host = p_range->device->direct_access(offset, size)) {
+        memcpy(destination, host, size);
+        return { .n_bytes = size };
+    }
+    return p_range->device->read(destination, offset, size, options);
 }
 
 uint32_t MemoryDataBus::get_change_counter() const {
@@ -80,33 +101,88 @@ uint32_t MemoryDataBus::get_change_counter() const {
 enum LocationStatus MemoryDataBus::location_status(Address address) const {
     const RangeDesc *range = find_range(address);
     if (range == nullptr) { return LOCSTAT_ILLEGAL; }
-    return range->device->location_status(address - range->start_addr);
+    return range->device->location_status(range->to_offset(address));
+}
+
+byte *MemoryDataBus::direct_access(Address address, size_t size) const {
+    const RangeDesc *range = find_range(address);
+    if (range == nullptr || size == 0 || address + (size - 1) > range->last_addr) {
+        return nullptr;
+    }
+    return range->device->direct_access(range->to_offset(address), size);
+}
+
+size_t MemoryDataBus::collect_and_clear_dirty(
+    Address first,
+    Address last,
+    const std::function<void(Address)> &visitor) {
+    // Merge pages tracked by the devices, so each page is reported once.
+    for (auto iter = ranges_by_addr.lowerBound(first);
+         iter != ranges_by_addr.end() && iter.value()->start_addr <= last; iter++) {
+        const RangeDesc *range = iter.value();
+        const Address from = std::max(first, range->start_addr);
+        const Address to = std::min(last, range->last_addr);
+        range->device->collect_and_clear_dirty(
+            range->to_offset(from), range->to_offset(to), [this, range](Offset page) {
+                // Device page may span two bus pages, when the range is not page aligned.
+                const Offset page_first = std::max(page, range->device_offset);
+                const Offset page_last = page + DirtyPageMap::PAGE_SIZE - 1;
+                const Address address_first
+                    = range->start_addr + (page_first - range->device_offset);
+                const Address address_last = std::min(
+                    range->start_addr + (page_last - range->device_offset), range->last_addr);
+                dirty.mark(address_first.get_raw(), address_last.get_raw());
+            });
+    }
+    return dirty.collect_and_clear(
+        first.get_raw(), last.get_raw(), [&visitor](uint64_t page) { visitor(Address(page)); });
+}
+
+void MemoryDataBus::set_dirty_tracking(bool enable) {
+    dirty_tracking = enable;
+    if (!enable) { dirty.clear(); }
+    for (const RangeDesc *range : ranges_by_addr) {
+        range->device_tracks_dirty = range->device->set_dirty_tracking(enable);
+    }
 }
 
 const MemoryDataBus::RangeDesc *MemoryDataBus::find_range(Address address) const {
-    // lowerBound finds range what has highest key (which is range->last_addr)
-    // less then or equal to address.
-    // See comment in insert_device_to_range for description, why this works.
-    auto iter = ranges_by_addr.lowerBound(address);
-    if (iter == ranges_by_addr.end()) { return nullptr; }
+    const size_t slot = (address.get_raw() >> LOOKUP_PAGE_BITS) % LOOKUP_CACHE_SIZE;
+    const RangeDesc *cached = lookup_cache[slot];
+    if (cached != nullptr && cached->contains(address)) { return cached; }
+
+    // Find the last range starting at or before the address.
+    auto iter = std::upper_bound(
+        sorted_ranges.begin(), sorted_ranges.end(), address,
+        [](Address addr, const RangeDesc *range) { return addr < range->start_addr; });
+    if (iter == sorted_ranges.begin()) { return nullptr; }
 
-    const RangeDesc *range = iter.value();
-    if (address >= range->start_addr && address <= range->last_addr) { return range; }
+    const RangeDesc *range = *(iter - 1);
+    if (!range->contains(address)) { return nullptr; }
 
-    return nullptr;
+    lookup_cache[slot] = range;
+    return range;
+}
+
+void MemoryDataBus::rebuild_lookup() {
+    // Ranges do not overlap, so the order by last address is the order by start address.
+    sorted_ranges.assign(ranges_by_addr.cbegin(), ranges_by_addr.cend());
+    lookup_cache.fill(nullptr);
 }
 
 bool MemoryDataBus::insert_device_to_range(
     BackendMemory *device,
     Address start_addr,
     Address last_addr,
-    bool move_ownership) {
+    bool move_ownership,
+    Offset device_offset) {
     auto iter = ranges_by_addr.lowerBound(start_addr);
     if (iter != ranges_by_addr.end() && iter.value()->overlaps(start_addr, last_addr)) {
         // Some part of requested range in already taken.
         return false;
     }
-    auto *range = new RangeDesc(device, start_addr, last_addr, move_ownership);
+    auto *range = new RangeDesc(device, start_addr, last_addr, move_ownership, device_offset);
+    if (dirty_tracking) { range->device_tracks_dirty = device->set_dirty_tracking(true); }
 
     // Why are we using last address as key?
     //
@@ -119,6 +195,7 @@ bool MemoryDataBus::insert_device_to_range(
     // searched address for case that range is not present.
     ranges_by_addr.insert(last_addr, range);
     ranges_by_device.insert(device, range);
+    rebuild_lookup();
     connect(
         device, &BackendMemory::external_backend_change_notify, this,
         &MemoryDataBus::range_backend_external_change);
@@ -132,6 +209,7 @@ bool MemoryDataBus::remove_device(BackendMemory *device) {
     }
 
     ranges_by_addr.remove(range->last_addr);
+    rebuild_lookup();
     if (range->owns_device) { delete range->device; }
     delete range;
 
@@ -158,12 +236,19 @@ void MemoryDataBus::range_backend_external_change(
 
     // We only use device here for lookup, so const_cast is safe as find takes
     // it by const reference .
-    for (auto i = ranges_by_device.find(const_cast<BackendMemory *>(device));
-         i != ranges_by_device.end(); i++) {
+    auto *key = const_cast<BackendMemory *>(device);
+    for (auto i = ranges_by_device.find(key); i != ranges_by_device.end() && i.key() == key;
+         i++) {
         const RangeDesc *range = i.value();
-        emit external_change_notify(
-            this, range->start_addr + start_offset,
-            std::max(range->start_addr + last_offset, range->last_addr), type);
+        if (last_offset < range->device_offset) { continue; }
+        const Offset first = std::max(start_offset, range->device_offset) - range->device_offset;
+        const Offset last = last_offset - range->device_offset;
+        const Address last_addr = std::min(range->start_addr + last, range->last_addr);
+        if (range->start_addr + first > last_addr) { continue; }
+        if (dirty_tracking && !range->device_tracks_dirty) {
+            dirty.mark((range->start_addr + first).get_raw(), last_addr.get_raw());
+        }
+        emit external_change_notify(this, range->start_addr + first, last_addr, type);
     }
 }
 
@@ -171,11 +256,13 @@ MemoryDataBus::RangeDesc::RangeDesc(
     BackendMemory *device,
     Address start_addr,
     Address last_addr,
-    bool owns_device)
+    bool owns_device,
+    Offset device_offset)
     : device(device)
     , start_addr(start_addr)
     , last_addr(last_addr)
-    , owns_device(owns_device) {}
+    , owns_device(owns_device)
+    , device_offset(device_offset) {}
 
 bool MemoryDataBus::RangeDesc::contains(Address address) const {
     return start_addr <= address && address <= last_addr;
@@ -185,6 +272,10 @@ bool MemoryDataBus::RangeDesc::overlaps(Address start, Address last) const {
     return contains(start) || contains(last);
 }
 
+Offset MemoryDataBus::RangeDesc::to_offset(Address address) const {
+    return Offset(address - start_addr) + device_offset;
+}
+
 TrivialBus::TrivialBus(BackendMemory *backend_memory)
     : FrontendMemory(backend_memory->simulated_machine_endian)
     , device(backend_memory) {}
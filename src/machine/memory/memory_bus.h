@@ -4,13 +4,17 @@
 #include "common/endian.h"
 #include "machinedefs.h"
 #include "memory/backend/backend_memory.h"
+#include "memory/dirty_page_map.h"
 #include "memory/frontend_memory.h"
 #include "simulator_exception.h"
 #include "utils.h"
 
 #include <QMultiMap>
 #include <QObject>
+#include <array>
 #include <cstdint>
+#include <functional>
+#include <vector>
 
 namespace machine {
 
@@ -74,6 +78,9 @@ public:
      * @param move_ownership    if true, bus will be responsible for for
      *                          device destruction
      *                          TODO: consider replace with a smartpointer
+     * @param device_offset     offset within the device, where the range
+     *                          starts, allows to map parts of a single device
+     *                          to multiple ranges
      * @return                  result of connection, it will fail if range is
      *                          already occupied
      */
@@ -81,7 +88,8 @@ public:
         BackendMemory *device,
         Address start_addr,
         Address last_addr,
-        bool move_ownership);
+        bool move_ownership,
+        Offset device_offset = 0);
 
     /**
      * Disconnect a device by a pointer to it.
@@ -105,6 +113,38 @@ public:
 
     enum LocationStatus location_status(Address address) const override;
 
+    /**
+     * Direct pointer into the device, when the whole range belongs to a single
+     * device supporting it.
+     *
+     * @see BackendMemory::direct_access
+     */
+    byte *direct_access(Address address, size_t size) const override;
+
+    /**
+     * Report pages changed since the last call and forget them.
+     * Nothing is tracked until `set_dirty_tracking` is enabled.
+     *
+     * Changes are collected from dirty tracking of the devices themselves
+     * (see `BackendMemory::collect_and_clear_dirty`). Bus marks only what
+     * such devices do not see, direct access writes, and all changes of
+     * devices without tracking. Visitor is
+     * called with the address of the first byte of each dirty page
+     * overlapping `first` to `last` (inclusive), order is not specified.
+     *
+     * @return  number of reported pages
+     */
+    size_t collect_and_clear_dirty(
+        Address first,
+        Address last,
+        const std::function<void(Address)> &visitor);
+
+    /**
+     * Start or stop dirty page tracking of the bus and of all its devices,
+     * including devices inserted later. Stopping forgets the tracked pages.
+     */
+    void set_dirty_tracking(bool enable);
+
 private slots:
     /**
      * Receive external changes in underlying memory devices.
@@ -124,6 +164,20 @@ private:
      */
     QMap<Address, const RangeDesc *> ranges_by_addr;
     mutable uint32_t change_counter = 0;
+    DirtyPageMap dirty;
+    bool dirty_tracking = false;
+
+    /*
+     * Lookup structures used by `find_range`, rebuilt by `rebuild_lookup`
+     * whenever ranges change.
+     * Sorted array is searched by bisection, lookup cache remembers the last
+     * found range for each (hashed) bus page, so the peripheral and RAM
+     * accesses of a polling loop do not evict each other.
+     */
+    static constexpr unsigned LOOKUP_PAGE_BITS = 12;
+    static constexpr size_t LOOKUP_CACHE_SIZE = 64;
+    std::vector<const RangeDesc *> sorted_ranges;
+    mutable std::array<const RangeDesc *, LOOKUP_CACHE_SIZE> lookup_cache {};
 
     /**
      * Helper to write into single range. Used by `write`.
@@ -150,6 +204,8 @@ private:
      * Get range (or nullptr) for arbitrary address (not just start or last).
      */
     const MemoryDataBus::RangeDesc *find_range(Address address) const;
+
+    void rebuild_lookup();
 };
 
 /**
@@ -157,7 +213,12 @@ private:
  */
 class MemoryDataBus::RangeDesc {
 public:
-    RangeDesc(BackendMemory *device, Address start_addr, Address last_addr, bool owns_device);
+    RangeDesc(
+        BackendMemory *device,
+        Address start_addr,
+        Address last_addr,
+        bool owns_device,
+        Offset device_offset);
 
     /**
      * Tells, whether given address belongs to this range.
@@ -170,10 +231,18 @@ public:
      */
     [[nodiscard]] bool overlaps(Address start, Address last) const;
 
+    /**
+     * Offset within the device for given address of the range.
+     */
+    [[nodiscard]] Offset to_offset(Address address) const;
+
     BackendMemory *const device; // TODO consider a shared pointer
     const Address start_addr;
     const Address last_addr;
     const bool owns_device;
+    const Offset device_offset;
+    /** Device tracks its own dirty pages, see `set_dirty_tracking`. */
+    mutable bool device_tracks_dirty = false;
 };
 
 /**
@@ -60,13 +60,25 @@ struct ReadResult {
      */
     size_t n_bytes = 0;
 
+    /**
+     * Page fault cause, when address translation of the access failed.
+     *
+     * Frontend memory reports translation faults by result, the access then
+     *  stops at the faulting page and n_bytes counts bytes transferred before it.
+     */
+    ExceptionCause fault = EXCAUSE_NONE;
+
     inline ReadResult operator+(const ReadResult &other) const {
         return {
             this->n_bytes + other.n_bytes,
+            (this->fault != EXCAUSE_NONE) ? this->fault : other.fault,
         };
     }
 
-    inline void operator+=(const ReadResult &other) { this->n_bytes += other.n_bytes; }
+    inline void operator+=(const ReadResult &other) {
+        this->n_bytes += other.n_bytes;
+        if (this->fault == EXCAUSE_NONE) { this->fault = other.fault; }
+    }
 };
 
 struct WriteResult {
@@ -84,16 +96,24 @@ struct WriteResult {
      */
     bool changed = false;
 
+    /**
+     * Page fault cause, when address translation of the access failed.
+     * @see ReadResult::fault
+     */
+    ExceptionCause fault = EXCAUSE_NONE;
+
     inline WriteResult operator+(const WriteResult &other) const {
         return {
             this->n_bytes + other.n_bytes,
             this->changed || other.changed,
+            (this->fault != EXCAUSE_NONE) ? this->fault : other.fault,
         };
     }
 
     inline void operator+=(const WriteResult &other) {
         this->n_bytes += other.n_bytes;
         this->changed |= other.changed;
+        if (this->fault == EXCAUSE_NONE) { this->fault = other.fault; }
     }
 };
 
@@ -74,23 +74,27 @@ void TLB::on_csr_write(size_t internal_id, RegisterValue val) {
 
 void TLB::flush_single(VirtualAddress va, uint16_t asid) {
     uint64_t vpn = va.get_raw() >> 12;
-    size_t s = set_index(vpn);
     bool any_invalidated = false;
     const char *tag = type == PROGRAM ? "I" : "D";
 
-    for (size_t w = 0; w < associativity_; w++) {
-        auto &e = table[s][w];
-        if (e.valid && e.vpn == vpn && (e.asid == asid || asid == 0)) {
-            uint16_t old_asid = e.asid;
-            uint64_t old_vpn = e.vpn;
-            e.valid = false;
-            DEBUG(
-                "TLB[%s]: flushed VA=0x%llx ASID=%u (wildcard=%s)", tag,
-                (unsigned long long)va.get_raw(), asid, (asid == 0 ? "true" : "false"));
-            emit tlb_update(
-                static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid, old_vpn, 0ull,
-                false, false, false, false, false, false, false);
-            any_invalidated = true;
+    for (unsigned lvl = 0; lvl <= max_level(); lvl++) {
+        size_t s = set_index(vpn, lvl);
+        for (size_t w = 0; w < associativity_; w++) {
+            auto &e = table[s][w];
+            if (e.valid && e.level == lvl && e.covers(vpn) && (e.asid == asid || asid == 0)) {
+                uint16_t old_asid = e.asid;
+                uint64_t old_vpn = e.vpn;
+                e.valid = false;
+                DEBUG(
+                    "TLB[%s]: flushed VA=0x%llx ASID=%u (wildcard=%s)", tag,
+                    (unsigned long long)va.get_raw(), asid, (asid == 0 ? "true" : "false"));
+                if (!headless) {
+                    emit tlb_update(
+                        static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid,
+                        old_vpn, 0ull, false, false, false, false, false, false, false);
+                }
+                any_invalidated = true;
+            }
         }
     }
 
@@ -110,9 +114,11 @@ void TLB::flush_all_entries() {
                 uint16_t old_asid = e.asid;
                 uint64_t old_vpn = e.vpn;
                 e.valid = false;
-                emit tlb_update(
-                    static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid, old_vpn,
-                    0ull, false, false, false, false, false, false, false);
+                if (!headless) {
+                    emit tlb_update(
+                        static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid,
+                        old_vpn, 0ull, false, false, false, false, false, false, false);
+                }
             }
         }
     }
@@ -130,9 +136,11 @@ void TLB::flush_by_asid(uint16_t asid) {
                 uint16_t old_asid = e.asid;
                 uint64_t old_vpn = e.vpn;
                 e.valid = false;
-                emit tlb_update(
-                    static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid, old_vpn,
-                    0ull, false, false, false, false, false, false, false);
+                if (!headless) {
+                    emit tlb_update(
+                        static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid,
+                        old_vpn, 0ull, false, false, false, false, false, false, false);
+                }
                 any_invalidated = true;
             }
         }
@@ -148,13 +156,15 @@ void TLB::flush_by_vpn(uint64_t vpn) {
     for (size_t s = 0; s < num_sets_; ++s) {
         for (size_t w = 0; w < associativity_; ++w) {
             auto &e = table[s][w];
-            if (e.valid && e.vpn == vpn) {
+            if (e.valid && e.covers(vpn)) {
                 uint16_t old_asid = e.asid;
                 uint64_t old_vpn = e.vpn;
                 e.valid = false;
-                emit tlb_update(
-                    static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid, old_vpn,
-                    0ull, false, false, false, false, false, false, false);
+                if (!headless) {
+                    emit tlb_update(
+                        static_cast<unsigned>(w), static_cast<unsigned>(s), false, old_asid,
+                        old_vpn, 0ull, false, false, false, false, false, false, false);
+                }
                 any_invalidated = true;
             }
         }
@@ -171,6 +181,9 @@ void TLB::sync() {
 }
 
 void TLB::sfence_vma(uint64_t vaddr, uint64_t asid) {
+    // Cached non-leaf steps are not tracked per address space, drop them on any fence.
+    pwc.flush();
+
     if (vaddr == 0 && asid == 0) {
         flush_all_entries();
         return;
@@ -205,75 +218,85 @@ TLB::TranslationResult TLB::translate_virtual_to_physical(AddressWithMode vaddr)
 
     constexpr unsigned PAGE_SHIFT = 12;
     constexpr uint64_t PAGE_MASK = (1ULL << PAGE_SHIFT) - 1;
-    constexpr size_t PAGE_BYTES = (1ULL << PAGE_SHIFT);
 
     uint64_t off = virt & PAGE_MASK;
     uint64_t vpn = virt >> PAGE_SHIFT;
-    size_t s = set_index(vpn);
     const char *tag = (type == PROGRAM ? "I" : "D");
 
-    // Check TLB hit
-    for (size_t w = 0; w < associativity_; w++) {
-        auto &e = table[s][w];
-        if (e.valid && e.vpn == vpn && e.asid == asid) {
+    // Check TLB hit, entries of each page size live in the set selected by their own VPN bits
+    for (unsigned lvl = 0; lvl <= max_level(); lvl++) {
+        size_t s = set_index(vpn, lvl);
+        for (size_t w = 0; w < associativity_; w++) {
+            auto &e = table[s][w];
+            if (!e.valid || e.level != lvl || !e.covers(vpn) || e.asid != asid) { continue; }
             if (!check_permissions(e, current_sstatus_raw, mode.priv(), mode.opkind())) {
-                throw SIMULATOR_EXCEPTION(
-                    PageFault, "TLB: access fault on TLB hit", "",
-                    get_current_cause(mode.opkind()));
+                DEBUG("TLB[%s]: access fault on TLB hit", tag);
+                return { vaddr, 0, nullptr, get_current_cause(mode.opkind()) };
             }
 
             repl_policy->notify_access(s, w, /*valid=*/true);
             uint64_t pbase = e.phys.get_raw() & ~PAGE_MASK;
+            uint64_t page_off = ((vpn & e.vpn_mask) << PAGE_SHIFT) + off;
+            uint64_t page_bytes = (e.vpn_mask + 1) << PAGE_SHIFT;
             hit_count_++;
-            emit hit_update(hit_count_);
-            emit tlb_update(
-                static_cast<unsigned>(w), static_cast<unsigned>(s), true, e.asid, e.vpn, pbase,
-                e.r(), e.w(), e.x(), e.u(), e.g(), e.a(), e.d());
+            if (lvl > 0) { superpage_hit_count_++; }
+            if (!headless) {
+                emit hit_update(hit_count_);
+                emit tlb_update(
+                    static_cast<unsigned>(w), static_cast<unsigned>(s), true, e.asid, e.vpn,
+                    pbase, e.r(), e.w(), e.x(), e.u(), e.g(), e.a(), e.d());
+            }
             update_all_statistics();
-            return { Address { pbase + off }, static_cast<size_t>(PAGE_BYTES - off), &e};
+            return { Address { pbase + page_off }, static_cast<size_t>(page_bytes - page_off), &e };
         }
     }
 
     // TLB miss -> resolve with page table walker
     VirtualAddress va { virt };
 
-    PageTableWalker walker(pt_walk_mem);
+    PageTableWalker walker(pt_walk_mem, &pwc);
     WalkResult res;
 
     switch (xlen) {
     case Xlen::_32:
-        walker.set_pte_factory(PageTableWalker::sv32_pte_factory());
         res = walker.walk<Sv32Pte, 1>(va, current_satp_raw, current_sstatus_raw, mode);
         break;
     case Xlen::_64:
-        walker.set_pte_factory(PageTableWalker::sv39_pte_factory());
         res = walker.walk<Sv39Pte, 2>(va, current_satp_raw, current_sstatus_raw, mode);
         break;
     default:
-        walker.set_pte_factory(PageTableWalker::sv32_pte_factory());
         res = walker.walk<Sv32Pte, 1>(va, current_satp_raw, current_sstatus_raw, mode);
         break;
     }
 
+    if (!res.ok()) { return { vaddr, 0, nullptr, get_current_cause(mode.opkind()) }; }
+
     if (res.pte_was_written) {
         if (pt_walk_mem == mem) {
             mem_writes += 1;
         } else {
             ptw_writes += 1;
         }
-        emit memory_writes_update(get_write_count());
+        if (!headless) { emit memory_writes_update(get_write_count()); }
     }
-    mem_reads += 1;
-    emit memory_reads_update(get_read_count());
-
-    // Cache the resolved mapping in the TLB
-    uint64_t phys_base = res.phys.get_raw() & ~PAGE_MASK;
+    mem_reads += res.pte_reads;
+    if (!headless) { emit memory_reads_update(get_read_count()); }
+
+    // Cache the resolved mapping in the TLB, a superpage is held by a single entry
+    auto lvl = static_cast<unsigned>(res.level);
+    uint64_t vpn_mask = (1ULL << (lvl * vpn_bits())) - 1;
+    uint64_t page_bytes = (vpn_mask + 1) << PAGE_SHIFT;
+    uint64_t page_off = res.phys.get_raw() & (page_bytes - 1);
+    uint64_t phys_base = res.phys.get_raw() - page_off;
+    size_t s = set_index(vpn, lvl);
     size_t victim = repl_policy->select_way(s);
     auto &ent = table[s][victim];
     ent.valid = true;
     ent.asid = asid;
-    ent.vpn = vpn;
+    ent.vpn = vpn & ~vpn_mask;
     ent.phys = Address { phys_base };
+    ent.level = static_cast<uint8_t>(lvl);
+    ent.vpn_mask = vpn_mask;
     ent.pte_addr = res.pte_addr;
     switch (xlen) {
     case Xlen::_32:
@@ -283,25 +306,28 @@ TLB::TranslationResult TLB::translate_virtual_to_physical(AddressWithMode vaddr)
         ent.pte_bytes = sizeof(uint64_t); // 8
         break;
     }
-    ent.R = res.leaf_pte->r();
-    ent.W = res.leaf_pte->w();
-    ent.X = res.leaf_pte->x();
-    ent.U = res.leaf_pte->u();
-    ent.G = res.leaf_pte->g();
-    ent.A = res.leaf_pte->a();
-    ent.D = res.leaf_pte->d();
+    ent.R = res.r();
+    ent.W = res.w();
+    ent.X = res.x();
+    ent.U = res.u();
+    ent.G = res.g();
+    ent.A = res.a();
+    ent.D = res.d();
     repl_policy->notify_access(s, victim, /*valid=*/true);
     miss_count_++;
-    emit miss_update(miss_count_);
-    emit tlb_update(
-        static_cast<unsigned>(victim), static_cast<unsigned>(s), true, ent.asid, ent.vpn, phys_base,
-        ent.r(), ent.w(), ent.x(), ent.u(), ent.g(), ent.a(), ent.d());
+    if (lvl > 0) { superpage_miss_count_++; }
+    if (!headless) {
+        emit miss_update(miss_count_);
+        emit tlb_update(
+            static_cast<unsigned>(victim), static_cast<unsigned>(s), true, ent.asid, ent.vpn,
+            phys_base, ent.r(), ent.w(), ent.x(), ent.u(), ent.g(), ent.a(), ent.d());
+    }
 
     DEBUG(
         "TLB[%s]: cached VA=0x%llx -> PA=0x%llx (ASID=%u) on miss", tag, (unsigned long long)virt,
         (unsigned long long)phys_base, asid);
     update_all_statistics();
-    return { Address { phys_base + off }, static_cast<size_t>(PAGE_BYTES - off), &ent };
+    return { Address { phys_base + page_off }, static_cast<size_t>(page_bytes - page_off), &ent };
 }
 
 WriteResult TLB::write(AddressWithMode dst, const void *src, size_t sz, WriteOptions opts) {
@@ -323,6 +349,9 @@ WriteResult TLB::translate_and_write(AddressWithMode dst, const void *src, size_
     while (remaining > 0) {
         AddressWithMode cur_va(Address { cur_virt }, dst.access_mode());
         auto tr = translate_virtual_to_physical(cur_va);
+        if (tr.fault != EXCAUSE_NONE) {
+            return { .n_bytes = total_written, .changed = any_changed, .fault = tr.fault };
+        }
 
         bool satp_mode_on = is_mode_enabled_in_satp(current_satp_raw);
         if (vm_enabled && satp_mode_on
@@ -359,6 +388,7 @@ ReadResult TLB::translate_and_read(void *dst, AddressWithMode src, size_t sz, Re
     while (remaining > 0) {
         AddressWithMode cur_va(Address { cur_virt }, src.access_mode());
         auto tr = translate_virtual_to_physical(cur_va);
+        if (tr.fault != EXCAUSE_NONE) { return { .n_bytes = total_read, .fault = tr.fault }; }
 
         bool satp_mode_on = is_mode_enabled_in_satp(current_satp_raw);
         if (vm_enabled && satp_mode_on
@@ -382,14 +412,19 @@ ReadResult TLB::translate_and_read(void *dst, AddressWithMode src, size_t sz, Re
     return { .n_bytes = total_read };
 }
 
+byte *TLB::direct_access(Address address, size_t size) const {
+    if (vm_enabled && is_mode_enabled_in_satp(current_satp_raw)) { return nullptr; }
+    return mem->direct_access(address, size);
+}
+
 bool TLB::reverse_lookup(Address paddr, VirtualAddress &out_va) const {
     uint64_t ppn = paddr.get_raw() >> 12;
     uint64_t offset = paddr.get_raw() & 0xFFF;
     for (size_t s = 0; s < num_sets_; s++) {
         for (size_t w = 0; w < associativity_; w++) {
             auto &e = table[s][w];
-            if (e.valid && (e.phys.get_raw() >> 12) == ppn) {
-                out_va = VirtualAddress { (e.vpn << 12) | offset };
+            if (e.valid && (e.phys.get_raw() >> 12) == (ppn & ~e.vpn_mask)) {
+                out_va = VirtualAddress { ((e.vpn | (ppn & e.vpn_mask)) << 12) | offset };
                 return true;
             }
         }
@@ -413,6 +448,16 @@ uint32_t TLB::get_stall_count() const {
     return st_cycles;
 }
 
+uint32_t TLB::take_access_latency(bool below_cache) {
+    (void)below_cache;
+    const uint32_t stalls = get_stall_count();
+    uint32_t latency = stalls - latency_mark;
+    latency_mark = stalls;
+    latency += mem->take_access_latency();
+    if (pt_walk_mem != mem) { latency += pt_walk_mem->take_access_latency(); }
+    return latency;
+}
+
 const TLBConfig &TLB::get_config() const {
     return tlb_config;
 }
@@ -433,6 +478,7 @@ double TLB::get_speed_improvement() const {
 }
 
 void TLB::update_all_statistics() {
+    if (headless) { return; }
     emit statistics_update(get_stall_count(), get_speed_improvement(), get_hit_rate());
 }
 
@@ -453,11 +499,15 @@ void TLB::reset() {
 
     hit_count_ = 0;
     miss_count_ = 0;
+    superpage_hit_count_ = 0;
+    superpage_miss_count_ = 0;
+    pwc.reset();
     mem_reads = 0;
     mem_writes = 0;
     burst_reads = 0;
     burst_writes = 0;
     change_counter = 0;
+    latency_mark = 0;
 
     emit hit_update(get_hit_count());
     emit miss_update(get_miss_count());
@@ -4,6 +4,7 @@
 #include "common/logging.h"
 #include "csr/address.h"
 #include "memory/frontend_memory.h"
+#include "memory/virtual/page_walk_cache.h"
 #include "memory/virtual/sv32.h"
 #include "memory/virtual/virtual_address.h"
 #include "tlb_policy.h"
@@ -28,8 +29,13 @@ public:
     struct Entry {
         bool valid = false;
         uint16_t asid = 0;
+        // First 4 KiB VPN and physical base of the mapped (super)page.
         uint64_t vpn = 0;
         Address phys = Address { 0 };
+        // Level of the leaf PTE (0 for 4 KiB pages) and the mask of the 4 KiB VPN bits
+        // covered by the entry.
+        uint8_t level = 0;
+        uint64_t vpn_mask = 0;
         Address pte_addr = Address { 0 };
         uint8_t pte_bytes = 0;
         uint32_t lru = 0;
@@ -54,12 +60,16 @@ public:
         [[nodiscard]] bool a() const { return A; }
 
         [[nodiscard]] bool d() const { return D; }
+
+        [[nodiscard]] bool covers(uint64_t vpn_) const { return (vpn_ & ~vpn_mask) == vpn; }
     };
 
     struct TranslationResult {
         Address phys;
         size_t bytes_until_page_end;
         Entry *entry = nullptr;
+        /** Page fault cause, when the translation failed. Other fields are not valid then. */
+        ExceptionCause fault = EXCAUSE_NONE;
     };
 
     TLB(FrontendMemory *memory,
@@ -92,6 +102,16 @@ public:
 
     ReadResult read(void *dst, AddressWithMode src, size_t sz, ReadOptions opts) const override;
 
+    /**
+     * Forwarded only when translation is off, mapping is not known without the access mode.
+     */
+    byte *direct_access(Address address, size_t size) const override;
+
+    void set_access_pc(Address pc) override { mem->set_access_pc(pc); }
+
+    /** Page walk stalls (see `get_stall_count`) and latency of the memory below. */
+    uint32_t take_access_latency(bool below_cache = false) override;
+
     uint32_t get_change_counter() const override {
         uint32_t base = mem->get_change_counter();
         if (pt_walk_mem != mem) base += pt_walk_mem->get_change_counter();
@@ -112,6 +132,10 @@ public:
 
     unsigned get_hit_count() const { return hit_count_; }
     unsigned get_miss_count() const { return miss_count_; }
+    unsigned get_superpage_hit_count() const { return superpage_hit_count_; }
+    unsigned get_superpage_miss_count() const { return superpage_miss_count_; }
+    uint64_t get_walk_cache_hit_count() const { return pwc.get_hit_count(); }
+    uint64_t get_walk_cache_miss_count() const { return pwc.get_miss_count(); }
     double get_hit_rate() const;
     uint32_t get_read_count() const { return mem_reads + (pt_walk_mem == mem ? 0 : ptw_reads); }
     uint32_t get_write_count() const { return mem_writes + (pt_walk_mem == mem ? 0 : ptw_writes); }
@@ -161,6 +185,7 @@ private:
     size_t associativity_;
     std::vector<std::vector<Entry>> table;
     std::unique_ptr<TLBPolicy> repl_policy;
+    PageWalkCache pwc;
 
     const uint32_t access_pen_r;
     const uint32_t access_pen_w;
@@ -169,6 +194,8 @@ private:
 
     mutable unsigned hit_count_ = 0;
     mutable unsigned miss_count_ = 0;
+    mutable unsigned superpage_hit_count_ = 0;
+    mutable unsigned superpage_miss_count_ = 0;
     mutable uint32_t mem_reads = 0;
     mutable uint32_t mem_writes = 0;
     mutable uint32_t ptw_reads = 0;
@@ -176,6 +203,8 @@ private:
     mutable uint32_t burst_reads = 0;
     mutable uint32_t burst_writes = 0;
     mutable uint32_t change_counter = 0;
+    /** Stall count at the previous `take_access_latency`. */
+    uint32_t latency_mark = 0;
 
     WriteResult translate_and_write(AddressWithMode dst, const void *src, size_t sz, WriteOptions opts);
     ReadResult translate_and_read(void *dst, AddressWithMode src, size_t sz, ReadOptions opts);
@@ -183,6 +212,14 @@ private:
     template<typename RawPte>
     UpdateStatus ensure_ad_bits_impl(Entry &e, AccessOp op);
     inline size_t set_index(uint64_t vpn) const { return vpn & (num_sets_ - 1); }
+    // Entries of level L are indexed by the VPN bits above the L lowest VPN fields.
+    inline size_t set_index(uint64_t vpn, unsigned level) const {
+        return set_index(vpn >> (level * vpn_bits()));
+    }
+    inline unsigned vpn_bits() const {
+        return xlen == Xlen::_64 ? Sv39Pte::VPN_BITS : Sv32Pte::VPN_BITS;
+    }
+    inline unsigned max_level() const { return xlen == Xlen::_64 ? 2 : 1; }
     inline bool is_mode_enabled_in_satp(uint64_t satp_raw) const {
         switch (xlen) {
         case Xlen::_32: return (satp_raw & (1u << 31)) != 0;
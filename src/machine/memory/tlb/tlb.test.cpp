@@ -0,0 +1,260 @@
+#include "tlb.test.h"
+
+#include "machine/csr/controlstate.h"
+#include "machine/machineconfig.h"
+#include "machine/memory/backend/memory.h"
+#include "machine/memory/memory_bus.h"
+#include "machine/memory/tlb/tlb.h"
+#include "machine/memory/virtual/page_table_walker.h"
+
+using namespace machine;
+
+namespace {
+
+constexpr uint64_t PTE_V = Sv39Pte::V_MASK;
+// Accessed and dirty leaves, so the TLB does not write page tables.
+constexpr uint64_t PTE_LEAF = PTE_V | Sv39Pte::R_MASK | Sv39Pte::W_MASK | Sv39Pte::A_MASK
+                              | Sv39Pte::D_MASK;
+constexpr uint64_t ROOT_PPN = 0x10;
+constexpr uint64_t SATP = (8ULL << 60) | ROOT_PPN;
+
+uint64_t pte(uint64_t ppn, uint64_t flags) {
+    return (ppn << Sv39Pte::PPN_SHIFT) | flags;
+}
+
+void set_pte(Memory &mem, uint64_t table_ppn, unsigned index, uint64_t value) {
+    memory_write_u64(&mem, (table_ppn << 12) + index * sizeof(uint64_t), value);
+}
+
+/**
+ * Sv39 tables with a gigapage at 0x40000000 -> 0x80000000, a megapage at
+ * 0x400000 -> 0x200000 and 4 KiB pages at 0x605000 -> 0x300000 and
+ * 0x606000 -> 0x301000.
+ */
+void prepare_tables(Memory &mem) {
+    set_pte(mem, ROOT_PPN, 1, pte(0x80000, PTE_LEAF));
+    set_pte(mem, ROOT_PPN, 0, pte(0x11, PTE_V));
+    set_pte(mem, 0x11, 2, pte(0x200, PTE_LEAF));
+    set_pte(mem, 0x11, 3, pte(0x12, PTE_V));
+    set_pte(mem, 0x12, 5, pte(0x300, PTE_LEAF));
+    set_pte(mem, 0x12, 6, pte(0x301, PTE_LEAF));
+}
+
+AccessMode mode(CSR::PrivilegeLevel priv, AccessOp op) {
+    return AccessMode::pack(0, priv, op);
+}
+
+AddressWithMode supervisor(uint64_t va, AccessOp op = AccessOp::READ) {
+    return AddressWithMode(va, AccessMode::pack(0, CSR::PrivilegeLevel::SUPERVISOR, op));
+}
+
+TLBConfig tlb_config() {
+    TLBConfig config;
+    config.set_tlb_num_sets(16);
+    config.set_tlb_associativity(4);
+    config.set_tlb_replacement_policy(TLBConfig::RP_LRU);
+    return config;
+}
+
+} // namespace
+
+void TestTLB::tlb_superpages() {
+    Memory mem(LITTLE);
+    TrivialBus bus(&mem);
+    const TLBConfig config = tlb_config();
+    TLB tlb(&bus, nullptr, DATA, &config, Xlen::_64);
+    prepare_tables(mem);
+    tlb.on_csr_write(CSR::Id::SATP, SATP);
+
+    // 1 GiB leaf is found at the root, one entry covers the whole gigapage.
+    memory_write_u32(&mem, 0x80001234, 0x11111111);
+    memory_write_u32(&mem, 0xbff00000, 0x22222222);
+    QCOMPARE(tlb.read_u32(supervisor(0x40001234)), 0x11111111u);
+    QCOMPARE(tlb.read_u32(supervisor(0x7ff00000)), 0x22222222u);
+    QCOMPARE(tlb.get_miss_count(), 1u);
+    QCOMPARE(tlb.get_hit_count(), 1u);
+    QCOMPARE(tlb.get_superpage_miss_count(), 1u);
+    QCOMPARE(tlb.get_superpage_hit_count(), 1u);
+    QCOMPARE(tlb.get_read_count(), 1u);
+
+    // 2 MiB leaf is found in the second level table.
+    memory_write_u32(&mem, 0x200010, 0x33333333);
+    memory_write_u32(&mem, 0x3ffff0, 0x44444444);
+    QCOMPARE(tlb.read_u32(supervisor(0x400010)), 0x33333333u);
+    QCOMPARE(tlb.read_u32(supervisor(0x5ffff0)), 0x44444444u);
+    QCOMPARE(tlb.get_superpage_miss_count(), 2u);
+    QCOMPARE(tlb.get_superpage_hit_count(), 2u);
+    QCOMPARE(tlb.get_read_count(), 3u);
+
+    // Translation is limited by the end of the superpage.
+    QCOMPARE(
+        tlb.translate_virtual_to_physical(supervisor(0x5ffffc)).bytes_until_page_end, size_t(4));
+
+    // Write is denied by the gigapage leaf without W.
+    set_pte(mem, ROOT_PPN, 2, pte(0xc0000, PTE_LEAF & ~Sv39Pte::W_MASK));
+    QCOMPARE(
+        tlb.translate_virtual_to_physical(supervisor(0x80000000, AccessOp::WRITE)).fault,
+        EXCAUSE_STORE_PAGE_FAULT);
+}
+
+void TestTLB::tlb_walk_cache() {
+    Memory mem(LITTLE);
+    TrivialBus bus(&mem);
+    const TLBConfig config = tlb_config();
+    TLB tlb(&bus, nullptr, DATA, &config, Xlen::_64);
+    prepare_tables(mem);
+    tlb.on_csr_write(CSR::Id::SATP, SATP);
+
+    // Walk to the megapage caches the step to the second level table.
+    (void)tlb.read_u32(supervisor(0x400000));
+    QCOMPARE(tlb.get_walk_cache_miss_count(), uint64_t(1));
+    QCOMPARE(tlb.get_read_count(), 2u);
+
+    // Walk to a 4 KiB page starts at the second level and caches the step to the last one.
+    (void)tlb.read_u32(supervisor(0x605000));
+    QCOMPARE(tlb.get_walk_cache_hit_count(), uint64_t(1));
+    QCOMPARE(tlb.get_read_count(), 4u);
+
+    // Neighbouring page needs the leaf PTE only.
+    (void)tlb.read_u32(supervisor(0x606000));
+    QCOMPARE(tlb.get_walk_cache_hit_count(), uint64_t(2));
+    QCOMPARE(tlb.get_read_count(), 5u);
+
+    // Fence drops cached steps, the next walk starts at the root again.
+    tlb.sfence_vma(0, 0);
+    (void)tlb.read_u32(supervisor(0x605000));
+    QCOMPARE(tlb.get_walk_cache_miss_count(), uint64_t(2));
+    QCOMPARE(tlb.get_read_count(), 8u);
+
+    // Steps are tagged by SATP, walk in another address space does not use them.
+    tlb.on_csr_write(CSR::Id::SATP, SATP | (uint64_t(1) << 44));
+    set_pte(mem, ROOT_PPN, 0, 0);
+    QCOMPARE(
+        tlb.translate_virtual_to_physical(supervisor(0x606000)).fault, EXCAUSE_LOAD_PAGE_FAULT);
+}
+
+void TestTLB::tlb_superpage_flush() {
+    Memory mem(LITTLE);
+    TrivialBus bus(&mem);
+    const TLBConfig config = tlb_config();
+    TLB tlb(&bus, nullptr, DATA, &config, Xlen::_64);
+    prepare_tables(mem);
+    tlb.on_csr_write(CSR::Id::SATP, SATP);
+
+    (void)tlb.read_u32(supervisor(0x40000000));
+    (void)tlb.read_u32(supervisor(0x400000));
+    QCOMPARE(tlb.get_miss_count(), 2u);
+
+    // Fence of any address within the gigapage removes its entry.
+    tlb.sfence_vma(0x7ff00000, 0);
+    (void)tlb.read_u32(supervisor(0x40000000));
+    (void)tlb.read_u32(supervisor(0x400000));
+    QCOMPARE(tlb.get_miss_count(), 3u);
+    QCOMPARE(tlb.get_hit_count(), 1u);
+
+    // Same for the megapage and a single address space fence.
+    tlb.flush_single(VirtualAddress { 0x5ff000 }, 0);
+    (void)tlb.read_u32(supervisor(0x400000));
+    QCOMPARE(tlb.get_miss_count(), 4u);
+
+    // Changed mapping is not seen until the fence.
+    set_pte(mem, ROOT_PPN, 1, pte(0xc0000, PTE_LEAF));
+    memory_write_u32(&mem, 0x80000000, 0x11111111);
+    memory_write_u32(&mem, 0xc0000000, 0x22222222);
+    QCOMPARE(tlb.read_u32(supervisor(0x40000000)), 0x11111111u);
+    tlb.sfence_vma(0, 0);
+    QCOMPARE(tlb.read_u32(supervisor(0x40000000)), 0x22222222u);
+    QCOMPARE(tlb.get_superpage_miss_count(), 5u);
+}
+
+void TestTLB::tlb_walk_faults() {
+    Memory mem(LITTLE);
+    TrivialBus bus(&mem);
+    prepare_tables(mem);
+    const PageTableWalker walker(&bus);
+    const auto walk = [&walker](uint64_t va, AccessMode access, uint64_t sstatus = 0) {
+        return walker.walk<Sv39Pte, 2>(VirtualAddress { va }, SATP, sstatus, access);
+    };
+    const AccessMode s_read = mode(CSR::PrivilegeLevel::SUPERVISOR, AccessOp::READ);
+    const AccessMode s_write = mode(CSR::PrivilegeLevel::SUPERVISOR, AccessOp::WRITE);
+    const AccessMode s_fetch = mode(CSR::PrivilegeLevel::SUPERVISOR, AccessOp::FETCH);
+    const AccessMode u_read = mode(CSR::PrivilegeLevel::UNPRIVILEGED, AccessOp::READ);
+
+    WalkResult res = walk(0x40000000, s_read);
+    QVERIFY(res.ok());
+    QCOMPARE(res.level, 2);
+    QCOMPARE(res.pte_reads, 1u);
+
+    // Walk stops at the first invalid PTE.
+    res = walk(0xc0000000, s_read);
+    QCOMPARE(res.status, WalkStatus::INVALID_PTE);
+    QCOMPARE(res.pte_reads, 1u);
+    res = walk(0x607000, s_read);
+    QCOMPARE(res.status, WalkStatus::INVALID_PTE);
+    QCOMPARE(res.pte_reads, 3u);
+
+    // W without R is reserved, also for pointers to the next level.
+    set_pte(mem, ROOT_PPN, 3, pte(0xc0000, PTE_V | Sv39Pte::W_MASK));
+    QCOMPARE(walk(0xc0000000, s_read).status, WalkStatus::INVALID_PTE);
+
+    // Gigapage has to be aligned to 1 GiB.
+    set_pte(mem, ROOT_PPN, 3, pte(0xc0200, PTE_LEAF));
+    QCOMPARE(walk(0xc0000000, s_read).status, WalkStatus::MISALIGNED_SUPERPAGE);
+
+    // Pointer to a next level in the last level table.
+    set_pte(mem, 0x12, 7, pte(0x13, PTE_V));
+    res = walk(0x607000, s_read);
+    QCOMPARE(res.status, WalkStatus::NO_LEAF);
+    QCOMPARE(res.pte_reads, 3u);
+
+    // Leaf permissions.
+    set_pte(mem, 0x12, 7, pte(0x302, PTE_LEAF & ~Sv39Pte::W_MASK));
+    QVERIFY(walk(0x607000, s_read).ok());
+    QCOMPARE(walk(0x607000, s_write).status, WalkStatus::ACCESS_DENIED);
+    QCOMPARE(walk(0x607000, s_fetch).status, WalkStatus::ACCESS_DENIED);
+    QCOMPARE(walk(0x607000, u_read).status, WalkStatus::ACCESS_DENIED);
+
+    // User page is accessible by supervisor loads only with SUM.
+    set_pte(mem, 0x12, 7, pte(0x302, PTE_LEAF | Sv39Pte::X_MASK | Sv39Pte::U_MASK));
+    const uint64_t sum = CSR::Field::sstatus::SUM.encode(1);
+    QVERIFY(walk(0x607000, u_read).ok());
+    QCOMPARE(walk(0x607000, s_read).status, WalkStatus::ACCESS_DENIED);
+    QVERIFY(walk(0x607000, s_read, sum).ok());
+}
+
+void TestTLB::tlb_fault_causes() {
+    Memory mem(LITTLE);
+    TrivialBus bus(&mem);
+    const TLBConfig config = tlb_config();
+    TLB tlb(&bus, nullptr, DATA, &config, Xlen::_64);
+    prepare_tables(mem);
+    tlb.on_csr_write(CSR::Id::SATP, SATP);
+    const auto fault = [&tlb](uint64_t va, AccessOp op) {
+        return tlb.translate_virtual_to_physical(supervisor(va, op)).fault;
+    };
+
+    // Cause depends on the access, not on the reason of the walk failure.
+    QCOMPARE(fault(0xc0000000, AccessOp::FETCH), EXCAUSE_INSN_PAGE_FAULT);
+    QCOMPARE(fault(0xc0000000, AccessOp::READ), EXCAUSE_LOAD_PAGE_FAULT);
+    QCOMPARE(fault(0xc0000000, AccessOp::WRITE), EXCAUSE_STORE_PAGE_FAULT);
+    set_pte(mem, ROOT_PPN, 3, pte(0xc0200, PTE_LEAF));
+    QCOMPARE(fault(0xc0000000, AccessOp::FETCH), EXCAUSE_INSN_PAGE_FAULT);
+    QCOMPARE(fault(0xc0000000, AccessOp::READ), EXCAUSE_LOAD_PAGE_FAULT);
+    QCOMPARE(fault(0xc0000000, AccessOp::WRITE), EXCAUSE_STORE_PAGE_FAULT);
+
+    // Permissions of a cached entry are checked on every access, without a new walk.
+    QCOMPARE(fault(0x605000, AccessOp::READ), EXCAUSE_NONE);
+    const unsigned misses = tlb.get_miss_count();
+    QCOMPARE(fault(0x605000, AccessOp::FETCH), EXCAUSE_INSN_PAGE_FAULT);
+    QCOMPARE(tlb.get_miss_count(), misses);
+
+    // Failed access is not performed.
+    memory_write_u32(&mem, 0xc0000000, 0x11111111);
+    uint32_t value = 0;
+    const ReadResult result = tlb.read(&value, supervisor(0xc0000000), sizeof(value), {});
+    QCOMPARE(result.fault, EXCAUSE_LOAD_PAGE_FAULT);
+    QCOMPARE(result.n_bytes, size_t(0));
+    QCOMPARE(value, 0u);
+}
+
+QTEST_APPLESS_MAIN(TestTLB)
@@ -0,0 +1,16 @@
+#ifndef TLB_TEST_H
+#define TLB_TEST_H
+
+#include <QtTest>
+
+class TestTLB : public QObject {
+    Q_OBJECT
+private slots:
+    static void tlb_superpages();
+    static void tlb_walk_cache();
+    static void tlb_superpage_flush();
+    static void tlb_walk_faults();
+    static void tlb_fault_causes();
+};
+
+#endif // TLB_TEST_H
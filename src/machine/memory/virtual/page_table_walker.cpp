@@ -9,103 +9,104 @@ LOG_CATEGORY("machine.PTW");
 
 namespace machine {
 
-PageTableWalker::PageTableWalker(
-    FrontendMemory *mem,
-    std::function<std::unique_ptr<GenericPte>(uint64_t)> pte_factory)
-    : memory(mem)
-    , pte_factory_(std::move(pte_factory)) {}
-
-std::function<std::unique_ptr<GenericPte>(uint64_t)> PageTableWalker::sv32_pte_factory() {
-    return
-        [](uint64_t raw) -> std::unique_ptr<GenericPte> { return std::make_unique<Sv32Pte>(raw); };
-}
-
-std::function<std::unique_ptr<GenericPte>(uint64_t)> PageTableWalker::sv39_pte_factory() {
-    return
-        [](uint64_t raw) -> std::unique_ptr<GenericPte> { return std::make_unique<Sv39Pte>(raw); };
-}
-
 template<typename PagingMode, int max_level_idx>
 WalkResult PageTableWalker::walk(
     const VirtualAddress &va,
     uint64_t raw_satp,
     uint64_t raw_sstatus,
-    const AccessMode &access_mode) {
+    const AccessMode &access_mode) const {
+    WalkResult res;
+    uint64_t va_raw = va.get_raw();
+
     if (!(raw_satp & PagingMode::SATP_MODE_MASK)) {
-        return WalkResult { Address { va.get_raw() }, nullptr };
+        res.phys = Address { va_raw };
+        return res;
     }
 
     uint64_t ppn = raw_satp & PagingMode::SATP_PPN_MASK;
-    uint64_t va_raw = va.get_raw();
-    WalkResult res;
+    int start_lvl = max_level_idx;
+
+    if (pwc) {
+        static_assert(max_level_idx <= int(PageWalkCache::MAX_LEVELS));
+        for (int lvl = 0; lvl < max_level_idx; ++lvl) {
+            uint64_t va_tag = va_raw >> (PagingMode::PAGE_SHIFT + (lvl + 1) * PagingMode::VPN_BITS);
+            if (pwc->lookup(lvl, raw_satp, va_tag, ppn)) {
+                start_lvl = lvl;
+                break;
+            }
+        }
+        pwc->record_walk(start_lvl != max_level_idx);
+    }
 
-    for (int lvl = max_level_idx; lvl >= 0; --lvl) {
+    for (int lvl = start_lvl; lvl >= 0; --lvl) {
         uint32_t vpn_idx = (va_raw >> (PagingMode::PAGE_SHIFT + (lvl * PagingMode::VPN_BITS)))
                            & PagingMode::VPN_MASK;
         Address pte_addr { (ppn << PagingMode::PAGE_SHIFT)
                            + (vpn_idx * sizeof(typename PagingMode::RawType)) };
         typename PagingMode::RawType raw_pte = 0;
         memory->read(&raw_pte, pte_addr, sizeof(raw_pte), { .type = AccessEffects::REGULAR });
+        res.pte_reads++;
         DEBUG(
             "PTW: L%u PTE@0x%08" PRIx64 " = 0x%08" PRIx64, lvl, pte_addr.get_raw(),
             (uint64_t)raw_pte);
-        std::unique_ptr<GenericPte> pte = pte_factory_(uint64_t(raw_pte));
+        const PagingMode pte(raw_pte);
+        res.pte_addr = pte_addr;
 
-        if (!pte->is_valid()) {
-            throw SIMULATOR_EXCEPTION(
-                PageFault, "PTW: page fault, leaf PTE invalid",
-                QString::number(pte_addr.get_raw(), 16), get_current_cause(access_mode.opkind()));
+        if (!pte.is_valid()) {
+            DEBUG("PTW: page fault, PTE invalid");
+            res.status = WalkStatus::INVALID_PTE;
+            return res;
         }
-        if (pte->is_leaf()) {
+        if (pte.is_leaf()) {
             uint64_t mask = (1ull << (lvl * PagingMode::VPN_BITS)) - 1;
-            if (lvl > 0 && (pte->ppn() & mask) != 0) {
-                throw SIMULATOR_EXCEPTION(
-                    PageFault, "PTW: misaligned superpage", "",
-                    get_current_cause(access_mode.opkind()));
+            if (lvl > 0 && (pte.ppn() & mask) != 0) {
+                DEBUG("PTW: page fault, misaligned superpage");
+                res.status = WalkStatus::MISALIGNED_SUPERPAGE;
+                return res;
             }
 
-            if (!check_permissions(*pte, raw_sstatus, access_mode.priv(), access_mode.opkind())) {
-                throw SIMULATOR_EXCEPTION(
-                    PageFault, "PTW: access fault (permission check failed)", "",
-                    get_current_cause(access_mode.opkind()));
+            if (!check_permissions(pte, raw_sstatus, access_mode.priv(), access_mode.opkind())) {
+                DEBUG("PTW: page fault, permission check failed");
+                res.status = WalkStatus::ACCESS_DENIED;
+                return res;
             }
 
-            Address pa = pte->make_phys(va_raw, lvl);
+            Address pa = pte.make_phys(va_raw, lvl);
             DEBUG("PTW: L%u leaf → PA=0x%08" PRIx64, lvl, pa.get_raw());
             res.phys = pa;
-            res.pte_addr = pte_addr;
-            res.leaf_pte = std::move(pte);
+            res.leaf_pte = pte.to_uint();
+            res.level = lvl;
             return res;
         }
 
-        if (pte->r() || pte->w() || pte->x()) {
-            throw SIMULATOR_EXCEPTION(
-                PageFault, "PTW: invalid non-leaf", QString::number(raw_pte, 16),
-                get_current_cause(access_mode.opkind()));
+        if (pte.r() || pte.w() || pte.x()) {
+            DEBUG("PTW: page fault, invalid non-leaf");
+            res.status = WalkStatus::INVALID_NON_LEAF;
+            return res;
         }
 
-        ppn = pte->ppn();
+        ppn = pte.ppn();
+        if (pwc && lvl > 0) {
+            pwc->insert(
+                lvl - 1, raw_satp,
+                va_raw >> (PagingMode::PAGE_SHIFT + lvl * PagingMode::VPN_BITS), ppn);
+        }
     }
 
-    throw SIMULATOR_EXCEPTION(
-        PageFault, "PTW: no leaf found", "", get_current_cause(access_mode.opkind()));
+    DEBUG("PTW: page fault, no leaf found");
+    res.status = WalkStatus::NO_LEAF;
+    return res;
 }
 
 template WalkResult PageTableWalker::walk<Sv32Pte, 1>(
     const VirtualAddress &va,
     uint64_t raw_satp,
     uint64_t raw_sstatus,
-    const AccessMode &access_mode);
+    const AccessMode &access_mode) const;
 template WalkResult PageTableWalker::walk<Sv39Pte, 2>(
     const VirtualAddress &va,
     uint64_t raw_satp,
     uint64_t raw_sstatus,
-    const AccessMode &access_mode);
-
-template bool check_permissions<GenericPte>(
-    const GenericPte &pte,
-    uint64_t raw_sstatus,
-    CSR::PrivilegeLevel priv,
-    AccessOp op);
+    const AccessMode &access_mode) const;
 
 } // namespace machine
@@ -2,56 +2,67 @@
 #define PAGE_TABLE_WALKER_H
 
 #include "memory/frontend_memory.h"
+#include "page_walk_cache.h"
 #include "sv32.h"
 #include "sv39.h"
 #include "virtual_address.h"
 
 #include <inttypes.h>
-#include <memory>
 
 namespace machine {
 
+enum class WalkStatus {
+    OK,
+    INVALID_PTE,          // V == 0 or reserved W without R combination
+    MISALIGNED_SUPERPAGE, // Leaf above level 0 with nonzero low PPN bits
+    ACCESS_DENIED,        // Leaf permissions do not allow the access
+    INVALID_NON_LEAF,     // Non-leaf PTE with some of R/W/X set
+    NO_LEAF,              // Last level reached without finding a leaf
+};
+
+// Flags share their bit positions in all supported PTE formats.
+static_assert(Sv32Pte::R_MASK == Sv39Pte::R_MASK && Sv32Pte::D_MASK == Sv39Pte::D_MASK);
+
 struct WalkResult {
+    WalkStatus status = WalkStatus::OK;
     Address phys;
     Address pte_addr;
-    std::unique_ptr<GenericPte> leaf_pte;
+    uint64_t leaf_pte = 0;  // Raw value of the leaf PTE
+    int level = 0;          // Level of the leaf PTE, above 0 for superpages
+    unsigned pte_reads = 0; // Number of PTEs read from memory during the walk
     bool pte_was_written = false;
 
-    WalkResult() = default;
-    WalkResult(Address phys_, std::unique_ptr<GenericPte> leaf_pte_)
-        : phys(phys_)
-        , leaf_pte(std::move(leaf_pte_)) {}
+    [[nodiscard]] bool ok() const { return status == WalkStatus::OK; }
+
+    [[nodiscard]] bool r() const { return leaf_pte & Sv32Pte::R_MASK; }
+    [[nodiscard]] bool w() const { return leaf_pte & Sv32Pte::W_MASK; }
+    [[nodiscard]] bool x() const { return leaf_pte & Sv32Pte::X_MASK; }
+    [[nodiscard]] bool u() const { return leaf_pte & Sv32Pte::U_MASK; }
+    [[nodiscard]] bool g() const { return leaf_pte & Sv32Pte::G_MASK; }
+    [[nodiscard]] bool a() const { return leaf_pte & Sv32Pte::A_MASK; }
+    [[nodiscard]] bool d() const { return leaf_pte & Sv32Pte::D_MASK; }
 };
 
-// Performs multi-level page-table walks (SV32) in memory to resolve a virtual address to a physical
-// one.
+// Performs multi-level page-table walks (Sv32, Sv39) in memory to resolve a virtual address to a
+// physical one. PTEs are handled as values of the given PTE type, the walk does not allocate and
+// reports page faults through the result status instead of throwing. When a page-walk cache is
+// provided, the walk starts at the deepest cached non-leaf level.
 class PageTableWalker {
 public:
-    explicit PageTableWalker(
-        FrontendMemory *mem,
-        std::function<std::unique_ptr<GenericPte>(uint64_t)> pte_factory = sv32_pte_factory());
+    explicit PageTableWalker(FrontendMemory *mem, PageWalkCache *pwc = nullptr)
+        : memory(mem)
+        , pwc(pwc) {}
 
-    template<typename T, int max_level_idx>
+    template<typename PTE, int max_level_idx>
     WalkResult walk(
         const VirtualAddress &va,
         uint64_t raw_satp,
         uint64_t raw_sstatus,
-        const AccessMode &access_mode);
-
-    static std::function<std::unique_ptr<GenericPte>(uint64_t)> sv32_pte_factory();
-    static std::function<std::unique_ptr<GenericPte>(uint64_t)> sv39_pte_factory();
-
-    [[nodiscard]] const std::function<std::unique_ptr<GenericPte>(uint64_t)> &pte_factory() const {
-        return pte_factory_;
-    }
-
-    void set_pte_factory(std::function<std::unique_ptr<GenericPte>(uint64_t)> pte_factory) {
-        pte_factory_ = std::move(pte_factory);
-    }
+        const AccessMode &access_mode) const;
 
 private:
     FrontendMemory *memory;
-    std::function<std::unique_ptr<GenericPte>(uint64_t)> pte_factory_;
+    PageWalkCache *pwc;
 };
 
 } // namespace machine
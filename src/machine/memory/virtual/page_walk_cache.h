@@ -0,0 +1,87 @@
+#ifndef PAGE_WALK_CACHE_H
+#define PAGE_WALK_CACHE_H
+
+#include <array>
+#include <cstdint>
+
+namespace machine {
+
+// Small cache of intermediate (non-leaf) page-table walk steps.
+//
+// An entry for level L remembers the PPN of the level L page table, which is reached from the
+// root table given by SATP through the VPN fields above level L. A walk can then start directly
+// at the deepest cached level instead of re-reading all upper-level PTEs from memory.
+// Entries are tagged by the whole SATP value (mode, ASID and root PPN) and by the VA bits above
+// level L, so SATP switches need no flush. Modification of non-leaf PTEs is only guaranteed to
+// be observed after SFENCE.VMA, which flushes this cache completely.
+class PageWalkCache {
+public:
+    // Number of levels with cached steps. Root level is never cached as it is given by SATP.
+    static constexpr unsigned MAX_LEVELS = 2;
+    // Number of direct mapped entries per level.
+    static constexpr unsigned ENTRIES_PER_LEVEL = 16;
+
+    // Returns true and stores the table PPN to `ppn` when the step to `level` is cached.
+    bool lookup(unsigned level, uint64_t satp, uint64_t va_tag, uint64_t &ppn) {
+        const Entry &e = slot(level, va_tag);
+        if (e.valid && e.satp == satp && e.va_tag == va_tag) {
+            ppn = e.ppn;
+            return true;
+        }
+        return false;
+    }
+
+    // Statistics are accounted once per walk, not per probed level.
+    void record_walk(bool hit) {
+        if (hit) {
+            hit_count++;
+        } else {
+            miss_count++;
+        }
+    }
+
+    void insert(unsigned level, uint64_t satp, uint64_t va_tag, uint64_t ppn) {
+        Entry &e = slot(level, va_tag);
+        e.valid = true;
+        e.satp = satp;
+        e.va_tag = va_tag;
+        e.ppn = ppn;
+    }
+
+    void flush() {
+        for (auto &level : entries) {
+            for (auto &e : level) {
+                e.valid = false;
+            }
+        }
+    }
+
+    void reset() {
+        flush();
+        hit_count = 0;
+        miss_count = 0;
+    }
+
+    [[nodiscard]] uint64_t get_hit_count() const { return hit_count; }
+    [[nodiscard]] uint64_t get_miss_count() const { return miss_count; }
+
+private:
+    struct Entry {
+        bool valid = false;
+        uint64_t satp = 0;
+        uint64_t va_tag = 0;
+        uint64_t ppn = 0;
+    };
+
+    Entry &slot(unsigned level, uint64_t va_tag) {
+        return entries[level][va_tag & (ENTRIES_PER_LEVEL - 1)];
+    }
+
+    std::array<std::array<Entry, ENTRIES_PER_LEVEL>, MAX_LEVELS> entries {};
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+};
+
+} // namespace machine
+
+#endif // PAGE_WALK_CACHE_H
@@ -88,23 +88,22 @@ struct Sv32Pte : public GenericPte {
     static constexpr uint64_t PPN_MASK32 = ((PPN_MASK) << PPN_SHIFT);
 
     static Sv32Pte from_uint(uint64_t r) { return Sv32Pte(r); }
-    uint64_t to_uint() const noexcept override { return raw; }
 
     // Flag accessors
-    bool v() const noexcept override { return (raw >> V_SHIFT) & 0x1u; }
-    bool r() const noexcept override { return (raw >> R_SHIFT) & 0x1u; }
-    bool w() const noexcept override { return (raw >> W_SHIFT) & 0x1u; }
-    bool x() const noexcept override { return (raw >> X_SHIFT) & 0x1u; }
-    bool u() const noexcept override { return (raw >> U_SHIFT) & 0x1u; }
-    bool g() const noexcept override { return (raw >> G_SHIFT) & 0x1u; }
-    bool a() const noexcept override { return (raw >> A_SHIFT) & 0x1u; }
-    bool d() const noexcept override { return (raw >> D_SHIFT) & 0x1u; }
+    bool v() const noexcept { return (raw >> V_SHIFT) & 0x1u; }
+    bool r() const noexcept { return (raw >> R_SHIFT) & 0x1u; }
+    bool w() const noexcept { return (raw >> W_SHIFT) & 0x1u; }
+    bool x() const noexcept { return (raw >> X_SHIFT) & 0x1u; }
+    bool u() const noexcept { return (raw >> U_SHIFT) & 0x1u; }
+    bool g() const noexcept { return (raw >> G_SHIFT) & 0x1u; }
+    bool a() const noexcept { return (raw >> A_SHIFT) & 0x1u; }
+    bool d() const noexcept { return (raw >> D_SHIFT) & 0x1u; }
     uint64_t rsw() const noexcept { return (raw >> RSW_SHIFT) & 0x3u; }
-    uint64_t ppn() const noexcept override { return (raw >> PPN_SHIFT) & PPN_MASK; }
+    uint64_t ppn() const noexcept { return (raw >> PPN_SHIFT) & PPN_MASK; }
 
     // Convenience methods used by the page-table walker
-    bool is_leaf() const noexcept override { return r() || x(); }
-    bool is_valid() const noexcept override { return v() && (!w() || r()); }
+    bool is_leaf() const noexcept { return r() || x(); }
+    bool is_valid() const noexcept { return v() && (!w() || r()); }
 
     // Helper to construct a PTE from fields.
     static Sv32Pte make(
@@ -131,7 +130,9 @@ struct Sv32Pte : public GenericPte {
         r |= ((ppn_ & PPN_MASK) << PPN_SHIFT);
         return Sv32Pte(r);
     }
-    Address make_phys(uint64_t va_raw, int level) const override;
+    // Construct the physical address for a leaf PTE given the full VA and the level where
+    // the leaf was found (level numbering: top .. 0).
+    Address make_phys(uint64_t va_raw, int level) const;
 };
 
 inline Address Sv32Pte::make_phys(uint64_t va_raw, int level) const {
@@ -90,23 +90,22 @@ struct Sv39Pte : public GenericPte {
     static constexpr std::uint64_t PPN_MASK64 = (PPN_MASK << PPN_SHIFT);
 
     static Sv39Pte from_uint(uint64_t r) { return Sv39Pte(r); }
-    uint64_t to_uint() const noexcept override { return raw; }
 
     // Flag accessors
-    bool v() const noexcept override { return (raw >> V_SHIFT) & 0x1ull; }
-    bool r() const noexcept override { return (raw >> R_SHIFT) & 0x1ull; }
-    bool w() const noexcept override { return (raw >> W_SHIFT) & 0x1ull; }
-    bool x() const noexcept override { return (raw >> X_SHIFT) & 0x1ull; }
-    bool u() const noexcept override { return (raw >> U_SHIFT) & 0x1ull; }
-    bool g() const noexcept override { return (raw >> G_SHIFT) & 0x1ull; }
-    bool a() const noexcept override { return (raw >> A_SHIFT) & 0x1ull; }
-    bool d() const noexcept override { return (raw >> D_SHIFT) & 0x1ull; }
+    bool v() const noexcept { return (raw >> V_SHIFT) & 0x1ull; }
+    bool r() const noexcept { return (raw >> R_SHIFT) & 0x1ull; }
+    bool w() const noexcept { return (raw >> W_SHIFT) & 0x1ull; }
+    bool x() const noexcept { return (raw >> X_SHIFT) & 0x1ull; }
+    bool u() const noexcept { return (raw >> U_SHIFT) & 0x1ull; }
+    bool g() const noexcept { return (raw >> G_SHIFT) & 0x1ull; }
+    bool a() const noexcept { return (raw >> A_SHIFT) & 0x1ull; }
+    bool d() const noexcept { return (raw >> D_SHIFT) & 0x1ull; }
     uint64_t rsw() const noexcept { return (raw >> RSW_SHIFT) & 0x3ull; }
-    uint64_t ppn() const noexcept override { return (raw >> PPN_SHIFT) & PPN_MASK; }
+    uint64_t ppn() const noexcept { return (raw >> PPN_SHIFT) & PPN_MASK; }
 
     // Convenience methods used by the page-table walker
-    bool is_leaf() const noexcept override { return r() || x(); }
-    bool is_valid() const noexcept override { return v() && (!w() || r()); }
+    bool is_leaf() const noexcept { return r() || x(); }
+    bool is_valid() const noexcept { return v() && (!w() || r()); }
 
     // Helper to construct a PTE from fields.
     static Sv39Pte make(
@@ -133,7 +132,9 @@ struct Sv39Pte : public GenericPte {
         r |= ((ppn_ & PPN_MASK) << PPN_SHIFT);
         return Sv39Pte(r);
     }
-    Address make_phys(uint64_t va_raw, int level) const override;
+    // Construct the physical address for a leaf PTE given the full VA and the level where
+    // the leaf was found (level numbering: top .. 0).
+    Address make_phys(uint64_t va_raw, int level) const;
 };
 
 inline Address Sv39Pte::make_phys(uint64_t va_raw, int level) const {
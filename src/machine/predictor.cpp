@@ -114,7 +114,7 @@ void BranchHistoryRegister::update(const BranchResult result) {
     // Set all bits outside of the scope of the register to zero
     value = value & register_mask;
 
-    emit bhr_updated(number_of_bits, value);
+    if (!headless) { emit bhr_updated(number_of_bits, value); }
 }
 
 void BranchHistoryRegister::clear() {
@@ -122,6 +122,10 @@ void BranchHistoryRegister::clear() {
     emit bhr_updated(number_of_bits, value);
 }
 
+void BranchHistoryRegister::set_headless(bool value) {
+    headless = value;
+}
+
 //////////////////////////////
 // BranchTargetBuffer class //
 //////////////////////////////
@@ -184,7 +188,7 @@ void BranchTargetBuffer::update(
     btb.at(btb_index) = btb_entry;
 
     // Send signal with the data
-    emit btb_row_updated(btb_index, btb_entry);
+    if (!headless) { emit btb_row_updated(btb_index, btb_entry); }
 }
 
 void BranchTargetBuffer::clear() {
@@ -194,6 +198,10 @@ void BranchTargetBuffer::clear() {
     }
 }
 
+void BranchTargetBuffer::set_headless(bool value) {
+    headless = value;
+}
+
 /////////////////////
 // Predictor class //
 /////////////////////
@@ -258,7 +266,7 @@ void Predictor::update_stats(bool prediction_was_correct) {
         stats.wrong += 1;
     }
     stats.accuracy = ((stats.correct * 100) / stats.total);
-    emit stats_updated(stats);
+    if (!headless) { emit stats_updated(stats); }
 }
 
 void Predictor::update_bht_stats(uint16_t bht_index, bool prediction_was_correct) {
@@ -275,7 +283,7 @@ void Predictor::update_bht_stats(uint16_t bht_index, bool prediction_was_correct
     }
     bht.at(bht_index).stats.accuracy
         = ((bht.at(bht_index).stats.correct * 100) / bht.at(bht_index).stats.total);
-    emit bht_row_updated(bht_index, bht.at(bht_index));
+    if (!headless) { emit bht_row_updated(bht_index, bht.at(bht_index)); }
 }
 
 // Calculate index for addressing Branch History Table from BHR and instruction address
@@ -317,6 +325,10 @@ void Predictor::flush() {
     clear_bht_state();
 }
 
+void Predictor::set_headless(bool value) {
+    headless = value;
+}
+
 // Always Not Taken
 // ################
 
@@ -407,7 +419,7 @@ void PredictorSmith1Bit::update(PredictionFeedback feedback) {
     } else {
         WARN("Smith 1 bit predictor has received invalid prediction result");
     }
-    emit bht_row_updated(index, bht.at(index));
+    if (!headless) { emit bht_row_updated(index, bht.at(index)); }
 }
 
 // Smith 2 Bit
@@ -471,7 +483,7 @@ void PredictorSmith2Bit::update(PredictionFeedback feedback) {
     } else {
         WARN("Smith 2 bit predictor has received invalid prediction result");
     }
-    emit bht_row_updated(index, bht.at(index));
+    if (!headless) { emit bht_row_updated(index, bht.at(index)); }
 }
 
 // Smith 2 Bit with hysteresis
@@ -535,7 +547,7 @@ void PredictorSmith2BitHysteresis::update(PredictionFeedback feedback) {
     } else {
         WARN("Smith 2 bit hysteresis predictor has received invalid prediction result");
     }
-    emit bht_row_updated(index, bht.at(index));
+    if (!headless) { emit bht_row_updated(index, bht.at(index)); }
 }
 
 ///////////////////////////
@@ -707,7 +719,7 @@ void BranchPredictor::increment_jumps() {
     if (total_stats.total > 0) {
         total_stats.accuracy = ((total_stats.correct * 100) / total_stats.total);
     }
-    emit total_stats_updated(total_stats);
+    if (!headless) { emit total_stats_updated(total_stats); }
 }
 
 void BranchPredictor::increment_mispredictions() {
@@ -716,7 +728,7 @@ void BranchPredictor::increment_mispredictions() {
     if (total_stats.total > 0) {
         total_stats.accuracy = ((total_stats.correct * 100) / total_stats.total);
     }
-    emit total_stats_updated(total_stats);
+    if (!headless) { emit total_stats_updated(total_stats); }
 }
 
 Address BranchPredictor::predict_next_pc_address(
@@ -744,10 +756,12 @@ Address BranchPredictor::predict_next_pc_address(
         predicted_result = BranchResult::TAKEN;
     }
 
-    emit prediction_done(
-        btb->calculate_index(instruction_address),
-        predictor->calculate_bht_index(bhr->get_value(), instruction_address), prediction_input,
-        predicted_result, btb_entry.branch_type);
+    if (!headless) {
+        emit prediction_done(
+            btb->calculate_index(instruction_address),
+            predictor->calculate_bht_index(bhr->get_value(), instruction_address),
+            prediction_input, predicted_result, btb_entry.branch_type);
+    }
 
     // If the branch was predicted Taken
     if (predicted_result == BranchResult::TAKEN) { return btb_entry.target_address; }
@@ -780,9 +794,12 @@ void BranchPredictor::update(
 
     increment_jumps();
 
-    emit update_done(
-        btb->calculate_index(instruction_address),
-        predictor->calculate_bht_index(bhr->get_value(), instruction_address), prediction_feedback);
+    if (!headless) {
+        emit update_done(
+            btb->calculate_index(instruction_address),
+            predictor->calculate_bht_index(bhr->get_value(), instruction_address),
+            prediction_feedback);
+    }
 
     // Update global branch history
     bhr->update(result);
@@ -801,3 +818,10 @@ void BranchPredictor::flush() {
     predictor->flush();
     emit flushed();
 }
+
+void BranchPredictor::set_headless(bool value) {
+    headless = value;
+    bhr->set_headless(value);
+    btb->set_headless(value);
+    predictor->set_headless(value);
+}
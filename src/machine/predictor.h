@@ -43,6 +43,7 @@ public: // General functions
     uint16_t get_value() const;
     void update(const BranchResult result);
     void clear();
+    void set_headless(bool value);
 
 signals:
     void bhr_updated(uint8_t number_of_bhr_bits, uint16_t register_value);
@@ -51,6 +52,7 @@ private: // Internal variables
     const uint8_t number_of_bits;
     const uint16_t register_mask;
     uint16_t value { 0 };
+    bool headless { false };
 };
 
 /////////////////////////////
@@ -82,6 +84,7 @@ public: // General functions
         const Address target_address,
         const BranchType branch_type);
     void clear();
+    void set_headless(bool value);
 
 signals:
     void btb_row_updated(uint16_t index, BranchTargetBufferEntry btb_entry) const;
@@ -89,6 +92,7 @@ signals:
 private: // Internal variables
     const uint8_t number_of_bits;
     std::vector<BranchTargetBufferEntry> btb;
+    bool headless { false };
 };
 
 /////////////////////
@@ -152,6 +156,7 @@ public: // General functions
     void clear_bht_state();
     void clear();
     void flush();
+    void set_headless(bool value);
 
 signals:
     void stats_updated(PredictionStatistics stats) const;
@@ -164,6 +169,7 @@ protected:                                 // Internal variables
     const PredictorState initial_state;
     PredictionStatistics stats;               // Total predictor statistics
     std::vector<BranchHistoryTableEntry> bht; // Branch History Table (BHT)
+    bool headless { false };                  // Per-event signals are suppressed
 };
 
 //  Static Predictor - Always predicts not taking the branch
@@ -286,6 +292,11 @@ public: // General functions
         const BranchResult result);
     void clear();
     void flush();
+    /**
+     * In headless mode, per-prediction and per-update signals are not emitted. The state is
+     * still kept up to date and can be read using the getters. Clear and flush always notify.
+     */
+    void set_headless(bool value);
 
 signals:
     void total_stats_updated(PredictionStatistics total_stats);
@@ -305,6 +316,7 @@ signals:
 
 private: // Internal variables
     bool enabled { false };
+    bool headless { false };
     PredictionStatistics total_stats;
     Predictor *predictor;
     BranchHistoryRegister *bhr;
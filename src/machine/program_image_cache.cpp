@@ -0,0 +1,104 @@
+#include "program_image_cache.h"
+
+#include "common/logging.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <utility>
+
+LOG_CATEGORY("machine.ProgramImageCache");
+
+namespace machine {
+
+ProgramImageCache &ProgramImageCache::instance() {
+    static ProgramImageCache cache;
+    return cache;
+}
+
+std::shared_ptr<const ProgramImage> ProgramImageCache::load(const QString &file_name) {
+    const QFileInfo info(file_name);
+    const QString path = info.absoluteFilePath();
+    const qint64 size = info.size();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto iter = entries.begin(); iter != entries.end();) {
+            if (iter->path != path) {
+                ++iter;
+            } else if (iter->size == size && iter->modified == modified) {
+                entries.splice(entries.begin(), entries, iter);
+                DEBUG("Executable %s found in image cache", qPrintable(file_name));
+                return entries.front().image;
+            } else {
+                // File was changed, its old content must not be matched by hash.
+                iter = entries.erase(iter);
+            }
+        }
+    }
+
+    auto executable = std::make_shared<const ExecutableFile>(file_name);
+    QByteArray hash;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = find_content(*executable, hash);
+        if (found != entries.end()) {
+            DEBUG("Executable %s shares image of %s", qPrintable(file_name),
+                  qPrintable(found->path));
+            auto image = found->image;
+            insert({ path, size, modified, std::move(executable), hash, image });
+            return image;
+        }
+    }
+
+    // Loading is done without the lock, concurrent loads of the same file only waste work.
+    ProgramLoader program(executable);
+    auto image = std::make_shared<ProgramImage>();
+    image->endian = program.get_endian();
+    image->architecture = program.get_architecture_type();
+    image->entry = program.get_executable_entry();
+    image->end = program.end();
+    auto memory = std::make_shared<Memory>(image->endian);
+    program.to_memory(memory.get(), true);
+    image->memory = std::move(memory);
+    image->symbol_table.reset(program.get_symbol_table());
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (const auto &entry : entries) {
+        // Loaded by another thread meanwhile, share its image.
+        if (entry.path == path && entry.size == size && entry.modified == modified) {
+            return entry.image;
+        }
+    }
+    insert({ path, size, modified, std::move(executable), hash, image });
+    return image;
+}
+
+std::list<ProgramImageCache::Entry>::iterator
+ProgramImageCache::find_content(const ExecutableFile &executable, QByteArray &hash) {
+    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+        // Content can match only when sizes do.
+        if (iter->executable->size() != executable.size()) { continue; }
+        if (hash.isEmpty()) { hash = executable.content_hash(); }
+        if (iter->hash.isEmpty()) { iter->hash = iter->executable->content_hash(); }
+        if (iter->hash == hash) { return iter; }
+    }
+    return entries.end();
+}
+
+void ProgramImageCache::insert(Entry entry) {
+    entries.push_front(std::move(entry));
+    if (entries.size() > MAX_ENTRIES) { entries.pop_back(); }
+}
+
+void ProgramImageCache::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    entries.clear();
+}
+
+size_t ProgramImageCache::size() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+} // namespace machine
@@ -0,0 +1,85 @@
+#ifndef PROGRAM_IMAGE_CACHE_H
+#define PROGRAM_IMAGE_CACHE_H
+
+#include "common/endian.h"
+#include "memory/address.h"
+#include "memory/backend/memory.h"
+#include "programloader.h"
+#include "symboltable.h"
+
+#include <QByteArray>
+#include <QString>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace machine {
+
+/**
+ * Loaded executable, immutable once created.
+ *
+ * Machines copy the memory (sections are shared copy-on-write) and use the
+ * symbol table until they modify it.
+ */
+struct ProgramImage {
+    std::shared_ptr<const Memory> memory;
+    std::shared_ptr<const SymbolTable> symbol_table;
+    Endian endian;
+    ArchitectureType architecture;
+    Address entry;
+    Address end;
+};
+
+/**
+ * Process-wide cache of loaded executables.
+ *
+ * Images are identified by path, size and modification time of the file, so
+ * a rebuilt executable is loaded again while a repeated load (machine reload,
+ * batch of simulations of the same program) skips ELF parsing and symbol table
+ * construction. Content hash is computed only when another cached file has the
+ * same size, an identical copy then shares the image. Endian and XLEN of the
+ * machine are taken from the ELF header, therefore they are covered too.
+ *
+ * Cache is safe to use from multiple threads.
+ */
+class ProgramImageCache {
+public:
+    static constexpr size_t MAX_ENTRIES = 8;
+
+    static ProgramImageCache &instance();
+
+    /** Error is reported by `SimulatorExceptionInput`. */
+    std::shared_ptr<const ProgramImage> load(const QString &file_name);
+
+    /** Forget all images, machines keep the ones they use. */
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    ProgramImageCache() = default;
+
+    struct Entry {
+        QString path;
+        qint64 size;
+        qint64 modified;
+        std::shared_ptr<const ExecutableFile> executable;
+        /** Content hash, empty until needed. */
+        QByteArray hash;
+        std::shared_ptr<const ProgramImage> image;
+    };
+
+    /** Find an entry with the same content, hashes are computed on demand. */
+    std::list<Entry>::iterator find_content(const ExecutableFile &executable, QByteArray &hash);
+    /** New entry becomes the most recently used one, the least recently used is dropped. */
+    void insert(Entry entry);
+
+    mutable std::mutex lock;
+    /** Most recently used first. */
+    std::list<Entry> entries;
+};
+
+} // namespace machine
+
+#endif // PROGRAM_IMAGE_CACHE_H
@@ -0,0 +1,141 @@
+#include "program_image_cache.test.h"
+
+#include "machine/memory/memory_utils.h"
+#include "machine/program_image_cache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace machine;
+
+namespace {
+
+constexpr uint32_t PC_INIT = 0x200;
+
+/** Minimal little endian RV32 executable with a single loadable segment at `PC_INIT`. */
+void write_executable(const QString &path, const std::vector<uint32_t> &words) {
+    constexpr uint32_t EHDR_SIZE = 52, PHDR_SIZE = 32;
+    const auto segment_size = uint32_t(words.size() * sizeof(uint32_t));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    // ELF header: ELFCLASS32, ELFDATA2LSB, EV_CURRENT, ET_EXEC, EM_RISCV
+    out << quint8(0x7f) << quint8('E') << quint8('L') << quint8('F');
+    out << quint8(1) << quint8(1) << quint8(1);
+    for (int i = 7; i < 16; i++) {
+        out << quint8(0);
+    }
+    out << quint16(2) << quint16(243) << quint32(1) << quint32(PC_INIT);
+    out << quint32(EHDR_SIZE) << quint32(0) << quint32(0);
+    out << quint16(EHDR_SIZE) << quint16(PHDR_SIZE) << quint16(1);
+    out << quint16(40) << quint16(0) << quint16(0);
+    // Program header: PT_LOAD, readable and executable
+    out << quint32(1) << quint32(EHDR_SIZE + PHDR_SIZE) << quint32(PC_INIT) << quint32(PC_INIT);
+    out << quint32(segment_size) << quint32(segment_size) << quint32(5) << quint32(4);
+    for (uint32_t word : words) {
+        out << quint32(word);
+    }
+}
+
+uint32_t first_word(const ProgramImage &image) {
+    return memory_read_u32(image.memory.get(), Offset(PC_INIT));
+}
+
+} // namespace
+
+void TestProgramImageCache::program_image_cache_hit() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto &cache = ProgramImageCache::instance();
+    cache.clear();
+
+    const QString path = dir.filePath("program");
+    write_executable(path, { 0x00600093, 0x00100073 });
+    auto image = cache.load(path);
+    QCOMPARE(image->entry.get_raw(), uint64_t(PC_INIT));
+    QCOMPARE(image->endian, LITTLE);
+    QCOMPARE(image->architecture, ARCH32);
+    QCOMPARE(first_word(*image), uint32_t(0x00600093));
+
+    QCOMPARE(cache.load(path), image);
+    QCOMPARE(cache.size(), size_t(1));
+}
+
+void TestProgramImageCache::program_image_cache_bound() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto &cache = ProgramImageCache::instance();
+    cache.clear();
+
+    // Files of the same size with different content, each one is hashed.
+    std::vector<std::shared_ptr<const ProgramImage>> images;
+    for (uint32_t i = 0; i <= ProgramImageCache::MAX_ENTRIES; i++) {
+        const QString path = dir.filePath(QString("program%1").arg(i));
+        write_executable(path, { i, 0x00100073 });
+        images.push_back(cache.load(path));
+        QCOMPARE(first_word(*images.back()), i);
+    }
+    QCOMPARE(cache.size(), ProgramImageCache::MAX_ENTRIES);
+
+    // The least recently used image was dropped, the others are kept.
+    auto reloaded = cache.load(dir.filePath("program0"));
+    QVERIFY(reloaded != images[0]);
+    QCOMPARE(first_word(*reloaded), uint32_t(0));
+    for (uint32_t i = 2; i <= ProgramImageCache::MAX_ENTRIES; i++) {
+        QCOMPARE(cache.load(dir.filePath(QString("program%1").arg(i))), images[i]);
+    }
+    QCOMPARE(cache.size(), ProgramImageCache::MAX_ENTRIES);
+}
+
+void TestProgramImageCache::program_image_cache_file_change() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto &cache = ProgramImageCache::instance();
+    cache.clear();
+
+    const QString path = dir.filePath("program");
+    write_executable(path, { 0x00600093, 0x00100073 });
+    auto image = cache.load(path);
+
+    // Same size, only the modification time tells the files apart.
+    write_executable(path, { 0x00700093, 0x00100073 });
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(
+            QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+    }
+    auto rebuilt = cache.load(path);
+    QVERIFY(rebuilt != image);
+    QCOMPARE(first_word(*rebuilt), uint32_t(0x00700093));
+    QCOMPARE(first_word(*image), uint32_t(0x00600093));
+    QCOMPARE(cache.size(), size_t(1));
+
+    // Different size is a change as well.
+    write_executable(path, { 0x00800093, 0x00000013, 0x00100073 });
+    auto grown = cache.load(path);
+    QVERIFY(grown != rebuilt);
+    QCOMPARE(first_word(*grown), uint32_t(0x00800093));
+    QCOMPARE(cache.size(), size_t(1));
+}
+
+void TestProgramImageCache::program_image_cache_copy() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto &cache = ProgramImageCache::instance();
+    cache.clear();
+
+    write_executable(dir.filePath("program"), { 0x00600093, 0x00100073 });
+    write_executable(dir.filePath("copy"), { 0x00600093, 0x00100073 });
+    write_executable(dir.filePath("other"), { 0x00700093, 0x00100073 });
+    auto image = cache.load(dir.filePath("program"));
+    QCOMPARE(cache.load(dir.filePath("copy")), image);
+    QVERIFY(cache.load(dir.filePath("other")) != image);
+    QCOMPARE(cache.size(), size_t(3));
+}
+
+QTEST_APPLESS_MAIN(TestProgramImageCache)
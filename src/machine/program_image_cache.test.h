@@ -0,0 +1,15 @@
+#ifndef PROGRAM_IMAGE_CACHE_TEST_H
+#define PROGRAM_IMAGE_CACHE_TEST_H
+
+#include <QtTest>
+
+class TestProgramImageCache : public QObject {
+    Q_OBJECT
+private slots:
+    static void program_image_cache_hit();
+    static void program_image_cache_bound();
+    static void program_image_cache_file_change();
+    static void program_image_cache_copy();
+};
+
+#endif // PROGRAM_IMAGE_CACHE_TEST_H
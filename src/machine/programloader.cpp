@@ -4,9 +4,11 @@
 #include "common/logging.h"
 #include "simulator_exception.h"
 
+#include <QCryptographicHash>
 #include <exception>
 #include <stdexcept>
 #include <sys/types.h>
+#include <utility>
 
 // This is a workaround to ignore libelfin ref-counting cycle.
 #ifdef __SANITIZE_ADDRESS__
@@ -19,52 +21,57 @@ using namespace machine;
 
 constexpr int EM_RISCV = 243;
 
+ExecutableFile::ExecutableFile(const QString &file_name) {
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw SIMULATOR_EXCEPTION(
+            Input, QString("Can't open input elf file for reading (") + file_name + QString(")"),
+            file.errorString());
+    }
+    // Private copy stays valid when the file is rebuilt in place, a shared mapping would not.
+    content = file.readAll();
+    if (content.size() != file.size()) {
+        throw SIMULATOR_EXCEPTION(
+            Input, QString("Can't read input elf file (") + file_name + QString(")"),
+            file.errorString());
+    }
+}
+
+QByteArray ExecutableFile::content_hash() const {
+    return QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+}
+
 class MemLoader : public elf::loader {
 public:
-    MemLoader(const QString &fname) : file(fname), mapped(nullptr), size(0) {
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
-            throw SIMULATOR_EXCEPTION(
-                Input, QString("Can't open input elf file for reading (") + fname + QString(")"),
-                file.errorString());
-        }
-        size = file.size();
-        mapped = file.map(0, size);
-        if (mapped == nullptr) {
-            throw SIMULATOR_EXCEPTION(
-                Input, QString("Can't mmap input elf file (") + fname + QString(")"),
-                file.errorString());
-        }
-    }
+    explicit MemLoader(std::shared_ptr<const ExecutableFile> executable)
+        : executable(std::move(executable)) {}
 
     ~MemLoader() override { close(); }
 
-    void close() {
-        if (mapped != nullptr) {
-            file.unmap(mapped);
-            mapped = nullptr;
-        }
-        if (file.isOpen()) { file.close(); }
-    }
+    /** Release the file, the loader itself may be kept alive by libelfin reference cycle. */
+    void close() { executable.reset(); }
 
     const void *load(off_t offset, size_t len) override {
-        if ((size_t)offset + len > (size_t)size) {
+        if (executable == nullptr || (size_t)offset + len > executable->size()) {
             throw SANITY_EXCEPTION("ELF loader requested offset exceeds file size");
         }
-        return mapped + offset;
+        return executable->data() + offset;
     }
 
 private:
-    QFile file;
-    unsigned char *mapped;
-    std::int64_t size;
+    std::shared_ptr<const ExecutableFile> executable;
 };
 
-ProgramLoader::ProgramLoader(const QString &file) {
+ProgramLoader::ProgramLoader(const QString &file)
+    : ProgramLoader(std::make_shared<const ExecutableFile>(file)) {}
+
+ProgramLoader::ProgramLoader(std::shared_ptr<const ExecutableFile> executable_file)
+    : executable(std::move(executable_file)) {
     try {
 #ifdef __SANITIZE_ADDRESS__
         __lsan_disable();
 #endif
-        elf_file = elf::elf(std::make_shared<MemLoader>(file));
+        elf_file = elf::elf(std::make_shared<MemLoader>(executable));
 #ifdef __SANITIZE_ADDRESS__
         __lsan_enable();
 #endif
@@ -117,14 +124,27 @@ ProgramLoader::~ProgramLoader() {
     }
 }
 
-void ProgramLoader::to_memory(Memory *mem) {
-    for (const auto &seg : load_segments) {
-        uint64_t base_address = seg.get_hdr().vaddr;
-        const char *data = (const char *)seg.data();
-        size_t filesz = seg.get_hdr().filesz;
-        for (size_t i = 0; i < filesz; i++) {
-            memory_write_u8(mem, base_address + i, (uint8_t)data[i]);
+void ProgramLoader::to_memory(Memory *mem, bool lazy) {
+    if (lazy) {
+        // Content is not part of the libelfin reference cycle, it is released with the last
+        // memory (or loader) using it.
+        std::vector<MemorySegment> segments;
+        for (const auto &seg : load_segments) {
+            const auto &hdr = seg.get_hdr();
+            if (hdr.filesz == 0) { continue; }
+            if (hdr.offset > executable->size() || hdr.filesz > executable->size() - hdr.offset) {
+                throw SIMULATOR_EXCEPTION(Input, "Loadable segment exceeds file size", "");
+            }
+            segments.push_back(
+                { Offset(hdr.vaddr), executable->data() + hdr.offset, hdr.filesz });
         }
+        // Rest of the segment (.bss) reads as zero, as any memory without content.
+        mem->set_lazy_content(std::move(segments), executable);
+        return;
+    }
+    for (const auto &seg : load_segments) {
+        const auto &hdr = seg.get_hdr();
+        mem->write(Offset(hdr.vaddr), seg.data(), hdr.filesz, {});
     }
 }
 
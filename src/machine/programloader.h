@@ -5,9 +5,11 @@
 #include "memory/backend/memory.h"
 #include "symboltable.h"
 
+#include <QByteArray>
 #include <QFile>
 #include <cstdint>
 #include <elf/elf++.hh>
+#include <memory>
 #include <qstring.h>
 #include <qvector.h>
 
@@ -18,14 +20,48 @@ enum ArchitectureType {
     ARCH64,
 };
 
+/**
+ * Read-only copy of an executable file content.
+ *
+ * Shared by the ELF parser and by memories with lazily loaded content, the
+ * copy is released with the last of them. It is read whole when the file is
+ * opened, so later changes of the file do not affect it.
+ */
+class ExecutableFile {
+public:
+    /** Error is reported by `SimulatorExceptionInput`. */
+    explicit ExecutableFile(const QString &file_name);
+
+    ExecutableFile(const ExecutableFile &) = delete;
+    ExecutableFile &operator=(const ExecutableFile &) = delete;
+
+    [[nodiscard]] const byte *data() const {
+        return reinterpret_cast<const byte *>(content.constData());
+    }
+    [[nodiscard]] size_t size() const { return content.size(); }
+
+    /** Cryptographic hash of the whole content, identifies the executable. */
+    [[nodiscard]] QByteArray content_hash() const;
+
+private:
+    QByteArray content;
+};
+
 class ProgramLoader {
 public:
     explicit ProgramLoader(const char *file);
     explicit ProgramLoader(const QString &file);
+    explicit ProgramLoader(std::shared_ptr<const ExecutableFile> executable);
     ~ProgramLoader();
 
-    void to_memory(Memory *mem); // Writes all loaded sections to memory TODO:
-                                 // really to memory ???
+    /**
+     * Write all loadable segments to memory.
+     *
+     * With `lazy` set, segments are not copied. Memory keeps the loaded
+     * executable content and fills its sections from it on first access (see
+     * `Memory::set_lazy_content`).
+     */
+    void to_memory(Memory *mem, bool lazy = false);
     Address end();               // Return address after which there is no more code for
                                  // sure
     Address get_executable_entry() const;
@@ -37,6 +73,7 @@ public:
     ArchitectureType get_architecture_type() const;
 
 private:
+    std::shared_ptr<const ExecutableFile> executable;
     elf::elf elf_file;
     ArchitectureType architecture_type;
     Address executable_entry;
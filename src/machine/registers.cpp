@@ -32,7 +32,7 @@ void Registers::write_pc(machine::Address address) {
             QString::number(address.get_raw(), 16));
     }
     this->pc = address;
-    emit pc_update(this->pc);
+    if (!headless) { emit pc_update(this->pc); }
 }
 
 RegisterValue Registers::read_gp(RegisterId reg) const {
@@ -41,7 +41,7 @@ RegisterValue Registers::read_gp(RegisterId reg) const {
     }
 
     RegisterValue value = read_gp_internal(reg);
-    emit gp_read(reg, value);
+    if (!headless) { emit gp_read(reg, value); }
     return value;
 }
 
@@ -58,7 +58,11 @@ void Registers::write_gp(RegisterId reg, RegisterValue value) {
     }
 
     this->gp.at(reg) = value;
-    emit gp_update(reg, value);
+    if (!headless) { emit gp_update(reg, value); }
+}
+
+void Registers::set_headless(bool value) {
+    headless = value;
 }
 
 bool Registers::operator==(const Registers &c) const {
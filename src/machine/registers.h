@@ -69,6 +69,9 @@ public:
 
     void reset(); // Reset all values to zero (except pc)
 
+    /** Suppresses per access signals, values are pulled by observers instead. */
+    void set_headless(bool value);
+
 signals:
     void pc_update(Address val);
     void gp_update(RegisterId reg, RegisterValue val);
@@ -83,6 +86,7 @@ private:
      */
     std::array<RegisterValue, REGISTER_COUNT> gp {};
     Address pc {}; // program counter
+    bool headless = false;
 };
 
 } // namespace machine
@@ -66,9 +66,10 @@ private:
  *   - Permissions violation (access type not allowed by PTE: read/write/execute).
  *   - Malformed or unexpected PTE contents (e.g. non-leaf with R/W/X set).
  *   - Wrong privilege level or ASID mismatch.
- *  PageFault is a runtime exception raised by the page-table walker and
- *  is recoverable after the page-fault handler allocates pages or installs
- *  mappings (demand paging).
+ *  The page-table walker and TLB report faults by result, PageFault is
+ *  raised by the frontend memory accessors, which do not take a fault
+ *  output argument. It is recoverable after the page-fault handler
+ *  allocates pages or installs mappings (demand paging).
  */
 #define SIMULATOR_EXCEPTIONS                                                                       \
     EXCEPTION(Input, )                                                                             \
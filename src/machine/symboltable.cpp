@@ -1,5 +1,6 @@
 #include "symboltable.h"
 
+#include <QHash>
 #include <utility>
 
 using namespace machine;
@@ -49,6 +50,26 @@ void SymbolTable::remove_symbol(const QString &name) {
     delete p_entry;
 }
 
+SymbolTable *SymbolTable::copy() const {
+    auto *p_st = new SymbolTable();
+    // Maps are copied as a whole and entries replaced, so the order of equal keys is kept.
+    QHash<const SymbolTableEntry *, SymbolTableEntry *> copies;
+    p_st->map_value_to_symbol = map_value_to_symbol;
+    for (auto iter = p_st->map_value_to_symbol.begin(); iter != p_st->map_value_to_symbol.end();
+         ++iter) {
+        const SymbolTableEntry *p_entry = iter.value();
+        iter.value() = new SymbolTableEntry(
+            p_entry->name, p_entry->value, p_entry->size, p_entry->info, p_entry->other);
+        copies.insert(p_entry, iter.value());
+    }
+    p_st->map_name_to_symbol = map_name_to_symbol;
+    for (auto iter = p_st->map_name_to_symbol.begin(); iter != p_st->map_name_to_symbol.end();
+         ++iter) {
+        iter.value() = copies.value(iter.value());
+    }
+    return p_st;
+}
+
 void SymbolTable::set_symbol(
     const QString &name,
     SymbolValue value,
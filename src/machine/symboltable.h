@@ -60,6 +60,9 @@ public:
 
     void remove_symbol(const QString &name);
 
+    /** Independent table with the same symbols. Caller takes ownership. */
+    [[nodiscard]] SymbolTable *copy() const;
+
     QStringList names() const;
 public slots:
     bool name_to_value(SymbolValue &value, const QString &name) const;
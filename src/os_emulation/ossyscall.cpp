@@ -6,9 +6,11 @@
 #include "syscall_nr.h"
 #include "target_errno.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cinttypes>
 #include <cstdio>
+#include <cstring>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -649,11 +651,7 @@ int32_t OsSyscallExceptionHandler::write_mem(
     uint32_t count) {
     if ((uint32_t)data.size() < count) count = data.size();
 
-    for (uint32_t i = 0; i < count; i++) {
-        mem->write_u8(addr, data[i]);
-        addr += 1;
-    }
-    return count;
+    return mem->write_block(addr, data.data(), count);
 }
 
 int32_t OsSyscallExceptionHandler::read_mem(
@@ -662,10 +660,8 @@ int32_t OsSyscallExceptionHandler::read_mem(
     QVector<uint8_t> &data,
     uint32_t count) {
     data.resize(count);
-    for (uint32_t i = 0; i < count; i++) {
-        data[i] = mem->read_u8(addr);
-        addr += 1;
-    }
+    count = mem->read_block(data.data(), addr, count);
+    data.resize(count);
     return count;
 }
 
@@ -682,6 +678,47 @@ int32_t OsSyscallExceptionHandler::write_io(int fd, const QVector<uint8_t> &data
     return result_errno_if_error(count);
 }
 
+int32_t OsSyscallExceptionHandler::write_io_from_mem(
+    int fd,
+    machine::FrontendMemory *mem,
+    Address addr,
+    uint32_t count) {
+    if (fd == FD_UNUSED || fd == FD_TERMINAL) {
+        QVector<uint8_t> data;
+        read_mem(mem, addr, data, count);
+        return write_io(fd, data, count);
+    }
+
+    // Pass the host pointer into guest memory directly, copy only when not possible.
+    QVector<uint8_t> bounce;
+    uint32_t done = 0;
+    while (done < count) {
+        const uint32_t chunk = std::min<uint64_t>(
+            count - done, FrontendMemory::BLOCK_CHUNK_SIZE
+                              - ((addr + done).get_raw() & (FrontendMemory::BLOCK_CHUNK_SIZE - 1)));
+        const void *src = mem->direct_access(addr + done, chunk);
+        uint32_t available = chunk;
+        if (src == nullptr) {
+            bounce.resize(chunk);
+            available = mem->read_block(bounce.data(), addr + done, chunk);
+            // Bytes before a fault are written, the fault is reported only when there are none.
+            if (available == 0) {
+                if (done > 0) { break; }
+                return -TARGET_EFAULT;
+            }
+            src = bounce.data();
+        }
+        ssize_t written = write(fd, src, available);
+        if (written < 0) {
+            if (done > 0) { break; }
+            return result_errno_if_error(written);
+        }
+        done += written;
+        if ((uint32_t)written < chunk) { break; }
+    }
+    return done;
+}
+
 int32_t OsSyscallExceptionHandler::read_io(
     int fd,
     QVector<uint8_t> &data,
@@ -877,9 +914,6 @@ int OsSyscallExceptionHandler::do_sys_writev(
     int iovcnt = a3;
     FrontendMemory *mem = core->get_mem_data();
     int32_t count;
-    QVector<uint8_t> data;
-
-    printf("sys_writev to fd %d\n", fd);
 
     fd = targetfd_to_fd(fd);
     if (fd == FD_INVALID) {
@@ -892,8 +926,7 @@ int OsSyscallExceptionHandler::do_sys_writev(
         uint32_t iov_len = mem->read_u32(iov + 4);
         iov += 8;
 
-        read_mem(mem, iov_base, data, iov_len);
-        count = write_io(fd, data, iov_len);
+        count = write_io_from_mem(fd, mem, iov_base, iov_len);
         if (count >= 0) {
             result += count;
         } else {
@@ -931,9 +964,6 @@ int OsSyscallExceptionHandler::do_sys_write(
     int size = core->get_xlen_from_reg(a3);
     FrontendMemory *mem = core->get_mem_data();
     int32_t count;
-    QVector<uint8_t> data;
-
-    printf("sys_write to fd %d\n", fd);
 
     fd = targetfd_to_fd(fd);
     if (fd == FD_INVALID) {
@@ -941,8 +971,7 @@ int OsSyscallExceptionHandler::do_sys_write(
         return 0;
     }
 
-    read_mem(mem, buf, data, size);
-    count = write_io(fd, data, size);
+    count = write_io_from_mem(fd, mem, buf, size);
 
     result = count;
 
@@ -977,8 +1006,6 @@ int OsSyscallExceptionHandler::do_sys_readv(
     int32_t count;
     QVector<uint8_t> data;
 
-    printf("sys_readv to fd %d\n", fd);
-
     fd = targetfd_to_fd(fd);
     if (fd == FD_INVALID) {
         result = -TARGET_EINVAL;
@@ -1031,8 +1058,6 @@ int OsSyscallExceptionHandler::do_sys_read(
     int32_t count;
     QVector<uint8_t> data;
 
-    printf("sys_read to fd %d\n", fd);
-
     fd = targetfd_to_fd(fd);
     if (fd == FD_INVALID) {
         result = -TARGET_EINVAL;
@@ -1077,18 +1102,27 @@ int OsSyscallExceptionHandler::do_sys_openat(
     Address pathname_ptr = Address(core->get_xlen_from_reg(a2));
     int flags = a3;
     int mode = a4;
-    uint32_t ch;
     FrontendMemory *mem = core->get_mem_data();
 
     printf("sys_open filename\n");
 
-    QString fname;
+    // Copy the path by chunks, which do not cross a page boundary past the terminator.
+    QByteArray fname_bytes;
+    char chunk[256];
     while (true) {
-        ch = mem->read_u8(pathname_ptr);
-        pathname_ptr += 1;
-        if (ch == 0) break;
-        fname.append(QChar(ch));
+        const size_t n = std::min<uint64_t>(
+            sizeof(chunk), FrontendMemory::BLOCK_CHUNK_SIZE
+                               - (pathname_ptr.get_raw() & (FrontendMemory::BLOCK_CHUNK_SIZE - 1)));
+        if (mem->read_block(chunk, pathname_ptr, n) < n) {
+            result = -TARGET_EFAULT;
+            return 0;
+        }
+        const char *end = static_cast<const char *>(memchr(chunk, 0, n));
+        fname_bytes.append(chunk, end != nullptr ? int(end - chunk) : int(n));
+        if (end != nullptr) break;
+        pathname_ptr += n;
     }
+    QString fname = QString::fromLatin1(fname_bytes);
 
     result = file_open(fname, flags, mode);
 
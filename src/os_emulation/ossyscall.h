@@ -82,6 +82,11 @@ private:
         QVector<uint8_t> &data,
         uint32_t count);
     int32_t write_io(int fd, const QVector<uint8_t> &data, uint32_t count);
+    int32_t write_io_from_mem(
+        int fd,
+        machine::FrontendMemory *mem,
+        machine::Address addr,
+        uint32_t count);
     int32_t read_io(int fd, QVector<uint8_t> &data, uint32_t count, bool add_nl_at_eof = false);
     int allocate_fd(int val = FD_UNUSED);
     int file_open(QString fname, int flags, int mode);